@@ -134,6 +134,9 @@ macro(write_configtable)
   string(APPEND out "Emulation FdNetDevice         : ")
   check_on_or_off("${ENABLE_EMU}" "${ENABLE_EMUNETDEV}")
 
+  string(APPEND out "Event free lists              : ")
+  check_on_or_off("${NS3_EVENT_FREE_LIST}" "ON")
+
   string(APPEND out "Examples                      : ")
   check_on_or_off("${ENABLE_EXAMPLES}" "${ENABLE_EXAMPLES}")
 
@@ -152,6 +155,9 @@ macro(write_configtable)
   string(APPEND out "MPI Support                   : ")
   check_on_or_off("${NS3_MPI}" "${MPI_FOUND}")
 
+  string(APPEND out "Multithreaded simulation      : ")
+  check_on_or_off("${NS3_MTP}" "ON")
+
   string(APPEND out "ns-3 Click Integration        : ")
   check_on_or_off("ON" "${NS3_CLICK}")
 
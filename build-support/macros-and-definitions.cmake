@@ -925,6 +925,17 @@ macro(process_options)
     endif()
   endif()
 
+  if(${NS3_MTP})
+    # Thread-safe reference counts and packet buffers for
+    # MultithreadedSimulatorImpl
+    add_definitions(-DNS3_MTP)
+  endif()
+
+  if(NOT ${NS3_EVENT_FREE_LIST})
+    # Allocate every event on its own so that memory checkers see them
+    add_definitions(-DNS3_NO_EVENT_FREE_LIST)
+  endif()
+
   mark_as_advanced(Boost_INCLUDE_DIR)
   find_package(Boost)
   if(${Boost_FOUND})
@@ -29,6 +29,8 @@
 
 #include <functional>
 #include <memory>
+#include <tuple>
+#include <type_traits>
 #include <typeinfo>
 #include <utility>
 #include <vector>
@@ -144,10 +146,10 @@ class CallbackComponentBase
     /**
      * Equality test
      *
-     * \param [in] other CallbackComponent Ptr
+     * \param [in] other CallbackComponent pointer
      * \return \c true if we are equal
      */
-    virtual bool IsEqual(std::shared_ptr<const CallbackComponentBase> other) const = 0;
+    virtual bool IsEqual(const CallbackComponentBase* other) const = 0;
 };
 
 /**
@@ -176,12 +178,12 @@ class CallbackComponent : public CallbackComponentBase
     /**
      * Equality test between the values of two components
      *
-     * \param [in] other CallbackComponentBase Ptr
+     * \param [in] other CallbackComponentBase pointer
      * \return \c true if we are equal
      */
-    bool IsEqual(std::shared_ptr<const CallbackComponentBase> other) const override
+    bool IsEqual(const CallbackComponentBase* other) const override
     {
-        auto p = std::dynamic_pointer_cast<const CallbackComponent<T>>(other);
+        auto p = dynamic_cast<const CallbackComponent<T>*>(other);
 
         // other must have the same type and value as ours
         if (p == nullptr || p->m_comp != m_comp)
@@ -192,6 +194,12 @@ class CallbackComponent : public CallbackComponentBase
         return true;
     }
 
+    /** \return The value of the callback component */
+    const T& Get() const
+    {
+        return m_comp;
+    }
+
   private:
     T m_comp; //!< the value of the callback component
 };
@@ -201,9 +209,9 @@ class CallbackComponent : public CallbackComponentBase
  * Partial specialization of class CallbackComponent with isComparable equal
  * to false. This is required to handle callable objects (such as lambdas and
  * objects returned by std::function and std::bind) that do not provide the
- * equality operator. Given that these objects cannot be compared and the only
- * purpose of the class CallbackComponent is to compare values, no object is
- * stored in this specialized class.
+ * equality operator. These objects are only equal to themselves: two
+ * callbacks share such a component when one is a copy of the other or
+ * was bound from it.
  *
  * \tparam T The type of the callback component.
  */
@@ -217,28 +225,47 @@ class CallbackComponent<T, false> : public CallbackComponentBase
      * \param [in] t The value of the callback component
      */
     CallbackComponent(const T& t)
+        : m_comp(t)
     {
     }
 
     /**
      * Equality test between functions
      *
-     * \param [in] other CallbackParam Ptr
+     * \param [in] other CallbackParam pointer
      * \return \c true if we are equal
      */
-    bool IsEqual(std::shared_ptr<const CallbackComponentBase> other) const override
+    bool IsEqual(const CallbackComponentBase* other) const override
     {
         return false;
     }
+
+    /**
+     * \return The callable object, which may change its state when
+     * called, as the target of a std::function does.
+     */
+    T& Get() const
+    {
+        return m_comp;
+    }
+
+  private:
+    mutable T m_comp; //!< the value of the callback component
 };
 
-/// Vector of callback components
-typedef std::vector<std::shared_ptr<CallbackComponentBase>> CallbackComponentVector;
+/// Vector of callback components, owned by the callback implementations
+typedef std::vector<const CallbackComponentBase*> CallbackComponentVector;
 
 /**
  * \ingroup callbackimpl
  * CallbackImpl class with varying numbers of argument types
  *
+ * The callable object and the bound arguments, if any, are stored in the
+ * derived classes CallbackFunctorImpl and CallbackBoundImpl, in the same
+ * allocation as the reference count. A call goes through a single
+ * function pointer to a function which calls the callable object
+ * directly.
+ *
  * \tparam R \explicit The return type of the Callback.
  * \tparam UArgs \explicit The types of any arguments to the Callback.
  */
@@ -247,34 +274,14 @@ class CallbackImpl : public CallbackImplBase
 {
   public:
     /**
-     * Constructor.
+     * Get the callback components: the callable object followed by the
+     * bound arguments, including those of the callbacks this one was
+     * bound from.
      *
-     * \param func the callable object
-     * \param components the callback components (callable object and bound arguments)
+     * \param [in,out] components The vector to append the components to;
+     * they are valid as long as this object is.
      */
-    CallbackImpl(std::function<R(UArgs...)> func, const CallbackComponentVector& components)
-        : m_func(func),
-          m_components(components)
-    {
-    }
-
-    /**
-     * Get the stored function.
-     * \return A const reference to the stored function.
-     */
-    const std::function<R(UArgs...)>& GetFunction() const
-    {
-        return m_func;
-    }
-
-    /**
-     * Get the vector of callback components.
-     * \return A const reference to the vector of callback components.
-     */
-    const CallbackComponentVector& GetComponents() const
-    {
-        return m_components;
-    }
+    virtual void GetComponents(CallbackComponentVector& components) const = 0;
 
     /**
      * Function call operator.
@@ -284,7 +291,7 @@ class CallbackImpl : public CallbackImplBase
      */
     R operator()(UArgs... uargs) const
     {
-        return m_func(uargs...);
+        return m_invoke(this, std::forward<UArgs>(uargs)...);
     }
 
     bool IsEqual(Ptr<const CallbackImplBase> other) const override
@@ -296,26 +303,35 @@ class CallbackImpl : public CallbackImplBase
         {
             return false;
         }
+        if (otherDerived == this)
+        {
+            return true;
+        }
+
+        CallbackComponentVector components;
+        CallbackComponentVector otherComponents;
+        GetComponents(components);
+        otherDerived->GetComponents(otherComponents);
 
         // if the two callback implementations are made of a distinct number of
         // components, they are different
-        if (m_components.size() != otherDerived->GetComponents().size())
+        if (components.size() != otherComponents.size())
         {
             return false;
         }
 
-        // the two functions are equal if they compare equal or the shared pointers
-        // point to the same locations
-        if (!m_components.at(0)->IsEqual(otherDerived->GetComponents().at(0)) &&
-            m_components.at(0) != otherDerived->GetComponents().at(0))
+        // the two functions are equal if they compare equal or are the
+        // same object
+        if (!components.at(0)->IsEqual(otherComponents.at(0)) &&
+            components.at(0) != otherComponents.at(0))
         {
             return false;
         }
 
         // check if the remaining components are equal one by one
-        for (std::size_t i = 1; i < m_components.size(); i++)
+        for (std::size_t i = 1; i < components.size(); i++)
         {
-            if (!m_components.at(i)->IsEqual(otherDerived->GetComponents().at(i)))
+            if (!components.at(i)->IsEqual(otherComponents.at(i)))
             {
                 return false;
             }
@@ -348,12 +364,196 @@ class CallbackImpl : public CallbackImplBase
         return id;
     }
 
+  protected:
+    /** Type of the functions calling the callable object of a derived class */
+    typedef R (*Invoke)(const CallbackImpl<R, UArgs...>*, UArgs...);
+
+    /**
+     * Constructor.
+     *
+     * \param invoke The function calling the callable object
+     */
+    CallbackImpl(Invoke invoke)
+        : m_invoke(invoke)
+    {
+    }
+
+  private:
+    /// Calls the callable object of the derived class
+    Invoke m_invoke;
+};
+
+/**
+ * \ingroup callbackimpl
+ * Call a callable object with bound arguments followed by the arguments
+ * of the call.
+ *
+ * The bound arguments are passed by const reference, or as copies when
+ * the callable object takes some of them by non-const reference.
+ *
+ * \tparam R \explicit The return type of the Callback.
+ * \tparam F \deduced The type of the callable object.
+ * \tparam BArgs \deduced The types of the bound arguments.
+ * \tparam UArgs \deduced The types of the arguments of the call.
+ * \param f The callable object
+ * \param bargs The bound arguments
+ * \param uargs The arguments of the call
+ * \return The value returned by the callable object
+ */
+template <typename R, typename F, typename... BArgs, typename... UArgs>
+R
+CallbackInvoke(F&& f, const std::tuple<CallbackComponent<BArgs>...>& bargs, UArgs&&... uargs)
+{
+    return std::apply(
+        [&f, &uargs...](const CallbackComponent<BArgs>&... b) -> R {
+            auto call = [&f, &uargs...](auto&&... a) -> R {
+                if constexpr (std::is_void_v<R>)
+                {
+                    std::invoke(std::forward<F>(f), a..., std::forward<UArgs>(uargs)...);
+                }
+                else
+                {
+                    return std::invoke(std::forward<F>(f), a..., std::forward<UArgs>(uargs)...);
+                }
+            };
+            if constexpr (std::is_invocable_v<F, const BArgs&..., UArgs...>)
+            {
+                return call(b.Get()...);
+            }
+            else
+            {
+                return [&call](BArgs... copies) -> R { return call(copies...); }(b.Get()...);
+            }
+        },
+        bargs);
+}
+
+/**
+ * \ingroup callbackimpl
+ * Callback implementation storing a callable object and bound arguments.
+ *
+ * \tparam R \explicit The return type of the Callback.
+ * \tparam F \explicit The type of the callable object.
+ * \tparam BArgs \explicit A std::tuple of the types of the bound arguments.
+ * \tparam UArgs \explicit The types of any arguments to the Callback.
+ */
+template <typename R, typename F, typename BArgs, typename... UArgs>
+class CallbackFunctorImpl;
+
+/**
+ * \ingroup callbackimpl
+ * \copydoc CallbackFunctorImpl
+ */
+template <typename R, typename F, typename... BArgs, typename... UArgs>
+class CallbackFunctorImpl<R, F, std::tuple<BArgs...>, UArgs...> : public CallbackImpl<R, UArgs...>
+{
+  public:
+    /**
+     * Constructor.
+     *
+     * \param func The callable object
+     * \param bargs The values of the bound arguments
+     */
+    CallbackFunctorImpl(F func, BArgs... bargs)
+        : CallbackImpl<R, UArgs...>(&DoInvoke),
+          m_function(func),
+          m_bargs(bargs...)
+    {
+    }
+
+    void GetComponents(CallbackComponentVector& components) const override
+    {
+        components.push_back(&m_function);
+        std::apply([&components](const auto&... b) { (components.push_back(&b), ...); },
+                   m_bargs);
+    }
+
   private:
-    /// Stores the callable object associated with this callback (as a lambda)
-    std::function<R(UArgs...)> m_func;
+    /**
+     * Call the callable object.
+     *
+     * \param impl This object
+     * \param uargs The arguments to the Callback
+     * \return Callback value
+     */
+    static R DoInvoke(const CallbackImpl<R, UArgs...>* impl, UArgs... uargs)
+    {
+        auto self = static_cast<const CallbackFunctorImpl*>(impl);
+        return CallbackInvoke<R>(self->m_function.Get(),
+                                 self->m_bargs,
+                                 std::forward<UArgs>(uargs)...);
+    }
+
+    /// The original function is comparable if it is a function pointer or
+    /// a pointer to a member function or a pointer to a member data.
+    static constexpr bool IS_COMPARABLE =
+        std::is_function_v<std::remove_pointer_t<F>> || std::is_member_pointer_v<F>;
 
-    /// Stores the original callable object and the bound arguments, if any
-    std::vector<std::shared_ptr<CallbackComponentBase>> m_components;
+    /// The callable object
+    CallbackComponent<F, IS_COMPARABLE> m_function;
+    /// The bound arguments
+    std::tuple<CallbackComponent<BArgs>...> m_bargs;
+};
+
+/**
+ * \ingroup callbackimpl
+ * Callback implementation binding arguments to another callback.
+ *
+ * \tparam R \explicit The return type of the Callback.
+ * \tparam Inner \explicit The type of the implementation of the other callback.
+ * \tparam BArgs \explicit A std::tuple of the types of the bound arguments.
+ * \tparam UArgs \explicit The types of any arguments to the Callback.
+ */
+template <typename R, typename Inner, typename BArgs, typename... UArgs>
+class CallbackBoundImpl;
+
+/**
+ * \ingroup callbackimpl
+ * \copydoc CallbackBoundImpl
+ */
+template <typename R, typename Inner, typename... BArgs, typename... UArgs>
+class CallbackBoundImpl<R, Inner, std::tuple<BArgs...>, UArgs...>
+    : public CallbackImpl<R, UArgs...>
+{
+  public:
+    /**
+     * Constructor.
+     *
+     * \param callback The callback to bind arguments to
+     * \param bargs The values of the bound arguments
+     */
+    CallbackBoundImpl(Ptr<const Inner> callback, BArgs... bargs)
+        : CallbackImpl<R, UArgs...>(&DoInvoke),
+          m_callback(callback),
+          m_bargs(bargs...)
+    {
+    }
+
+    void GetComponents(CallbackComponentVector& components) const override
+    {
+        m_callback->GetComponents(components);
+        std::apply([&components](const auto&... b) { (components.push_back(&b), ...); },
+                   m_bargs);
+    }
+
+  private:
+    /**
+     * Call the callback with the bound arguments.
+     *
+     * \param impl This object
+     * \param uargs The arguments to the Callback
+     * \return Callback value
+     */
+    static R DoInvoke(const CallbackImpl<R, UArgs...>* impl, UArgs... uargs)
+    {
+        auto self = static_cast<const CallbackBoundImpl*>(impl);
+        return CallbackInvoke<R>(*self->m_callback, self->m_bargs, std::forward<UArgs>(uargs)...);
+    }
+
+    /// The callback the arguments are bound to
+    Ptr<const Inner> m_callback;
+    /// The bound arguments
+    std::tuple<CallbackComponent<BArgs>...> m_bargs;
 };
 
 /**
@@ -423,6 +623,10 @@ class CallbackBase
  *   - the pimpl idiom: the Callback class is passed around by
  *     value and delegates the crux of the work to its pimpl
  *     pointer.
+ *   - a pimpl typed on the callable object and the bound arguments,
+ *     which it stores inline: building a callback makes a single
+ *     allocation, and calling it a single indirect call, even when
+ *     arguments are bound with MakeCallback or MakeBoundCallback.
  *   - a reference list implementation to implement the Callback's
  *     value semantics.
  *
@@ -466,17 +670,11 @@ class Callback : public CallbackBase
     template <typename... BArgs>
     Callback(const CallbackBase& cb, BArgs... bargs)
     {
-        auto cbDerived =
-            static_cast<const CallbackImpl<R, BArgs..., UArgs...>*>(PeekPointer(cb.GetImpl()));
+        typedef CallbackImpl<R, BArgs..., UArgs...> Inner;
+        Ptr<const Inner> cbDerived(static_cast<const Inner*>(PeekPointer(cb.GetImpl())));
 
-        std::function<R(BArgs..., UArgs...)> f(cbDerived->GetFunction());
-
-        CallbackComponentVector components(cbDerived->GetComponents());
-        components.insert(components.end(), {std::make_shared<CallbackComponent<BArgs>>(bargs)...});
-
-        m_impl = Create<CallbackImpl<R, UArgs...>>(
-            [f, bargs...](UArgs... uargs) -> R { return f(bargs..., uargs...); },
-            components);
+        m_impl =
+            Create<CallbackBoundImpl<R, Inner, std::tuple<BArgs...>, UArgs...>>(cbDerived, bargs...);
     }
 
     /**
@@ -496,20 +694,7 @@ class Callback : public CallbackBase
               typename... BArgs>
     Callback(T func, BArgs... bargs)
     {
-        // store the function in a std::function object
-        std::function<R(BArgs..., UArgs...)> f(func);
-
-        // The original function is comparable if it is a function pointer or
-        // a pointer to a member function or a pointer to a member data.
-        constexpr bool isComp =
-            std::is_function_v<std::remove_pointer_t<T>> || std::is_member_pointer_v<T>;
-
-        CallbackComponentVector components({std::make_shared<CallbackComponent<T, isComp>>(func),
-                                            std::make_shared<CallbackComponent<BArgs>>(bargs)...});
-
-        m_impl = Create<CallbackImpl<R, UArgs...>>(
-            [f, bargs...](UArgs... uargs) -> R { return f(bargs..., uargs...); },
-            components);
+        m_impl = Create<CallbackFunctorImpl<R, T, std::tuple<BArgs...>, UArgs...>>(func, bargs...);
     }
 
   private:
@@ -527,9 +712,20 @@ class Callback : public CallbackBase
     template <std::size_t... INDEX, typename... BoundArgs>
     auto BindImpl(std::index_sequence<INDEX...> seq, BoundArgs... bargs)
     {
-        return Callback<R, std::tuple_element_t<sizeof...(bargs) + INDEX, std::tuple<UArgs...>>...>(
-            *this,
+        // the arguments are bound to the declared types of the parameters,
+        // which may differ from the types of the values
+        typedef CallbackImpl<R, UArgs...> Inner;
+        typedef CallbackImpl<R, std::tuple_element_t<sizeof...(bargs) + INDEX, std::tuple<UArgs...>>...>
+            BoundImpl;
+        Ptr<BoundImpl> impl = Create<CallbackBoundImpl<
+            R,
+            Inner,
+            std::tuple<BoundArgs...>,
+            std::tuple_element_t<sizeof...(bargs) + INDEX, std::tuple<UArgs...>>...>>(
+            Ptr<const Inner>(DoPeekImpl()),
             bargs...);
+        return Callback<R, std::tuple_element_t<sizeof...(bargs) + INDEX, std::tuple<UArgs...>>...>(
+            impl);
     }
 
   public:
@@ -751,7 +947,9 @@ template <typename R, typename... Args, typename... BArgs>
 auto
 MakeBoundCallback(R (*fnPtr)(Args...), BArgs... bargs)
 {
-    return Callback<R, Args...>(fnPtr).Bind(bargs...);
+    // same type as Bind() would return, with a single level of binding
+    using BoundCallback = decltype(Callback<R, Args...>().Bind(bargs...));
+    return BoundCallback(fnPtr, bargs...);
 }
 
 /**
@@ -772,14 +970,16 @@ template <typename T, typename OBJ, typename R, typename... Args, typename... BA
 auto
 MakeCallback(R (T::*memPtr)(Args...), OBJ objPtr, BArgs... bargs)
 {
-    return Callback<R, Args...>(memPtr, objPtr).Bind(bargs...);
+    using BoundCallback = decltype(Callback<R, Args...>().Bind(bargs...));
+    return BoundCallback(memPtr, objPtr, bargs...);
 }
 
 template <typename T, typename OBJ, typename R, typename... Args, typename... BArgs>
 auto
 MakeCallback(R (T::*memPtr)(Args...) const, OBJ objPtr, BArgs... bargs)
 {
-    return Callback<R, Args...>(memPtr, objPtr).Bind(bargs...);
+    using BoundCallback = decltype(Callback<R, Args...>().Bind(bargs...));
+    return BoundCallback(memPtr, objPtr, bargs...);
 }
 
 /**@}*/
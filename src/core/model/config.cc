@@ -26,7 +26,9 @@
 #include "pointer.h"
 #include "singleton.h"
 
+#include <limits>
 #include <sstream>
+#include <unordered_map>
 
 /**
  * \file
@@ -197,6 +199,9 @@ MatchContainer::DisconnectWithoutContext(std::string name, const CallbackBase& c
 /**
  * \ingroup config-impl
  * Helper to test if an array entry matches a config path specification.
+ *
+ * The specification is parsed once, into the ranges of the indices it
+ * matches, so that testing an index does not depend on its syntax.
  */
 class ArrayMatcher
 {
@@ -214,8 +219,19 @@ class ArrayMatcher
      * \returns \c true if the index matches the Config Path.
      */
     bool Matches(std::size_t i) const;
+    /**
+     * \returns \c true if the specification matches some indices, that is,
+     *          if it can select array entries at all.
+     */
+    bool IsIndex() const;
 
   private:
+    /**
+     * Parse one of the '|' separated alternatives of the specification.
+     *
+     * \param [in] element The alternative.
+     */
+    void Parse(std::string element);
     /**
      * Convert a string to an \c uint32_t.
      *
@@ -226,6 +242,8 @@ class ArrayMatcher
     bool StringToUint32(std::string str, uint32_t* value) const;
     /** The Config path element. */
     std::string m_element;
+    /** The ranges of matching indices, bounds included. */
+    std::vector<std::pair<std::size_t, std::size_t>> m_ranges;
 
 }; // class ArrayMatcher
 
@@ -233,70 +251,72 @@ ArrayMatcher::ArrayMatcher(std::string element)
     : m_element(element)
 {
     NS_LOG_FUNCTION(this << element);
+    std::string::size_type start = 0;
+    std::string::size_type bar = element.find('|');
+    while (bar != std::string::npos)
+    {
+        Parse(element.substr(start, bar - start));
+        start = bar + 1;
+        bar = element.find('|', start);
+    }
+    Parse(element.substr(start));
 }
 
-bool
-ArrayMatcher::Matches(std::size_t i) const
+void
+ArrayMatcher::Parse(std::string element)
 {
-    NS_LOG_FUNCTION(this << i);
-    if (m_element == "*")
-    {
-        NS_LOG_DEBUG("Array " << i << " matches *");
-        return true;
-    }
-    std::string::size_type tmp;
-    tmp = m_element.find('|');
-    if (tmp != std::string::npos)
+    NS_LOG_FUNCTION(this << element);
+    if (element == "*")
     {
-        std::string left = m_element.substr(0, tmp - 0);
-        std::string right = m_element.substr(tmp + 1, m_element.size() - (tmp + 1));
-        ArrayMatcher matcher = ArrayMatcher(left);
-        if (matcher.Matches(i))
-        {
-            NS_LOG_DEBUG("Array " << i << " matches " << left);
-            return true;
-        }
-        matcher = ArrayMatcher(right);
-        if (matcher.Matches(i))
-        {
-            NS_LOG_DEBUG("Array " << i << " matches " << right);
-            return true;
-        }
-        NS_LOG_DEBUG("Array " << i << " does not match " << m_element);
-        return false;
+        m_ranges.emplace_back(0, std::numeric_limits<std::size_t>::max());
+        return;
     }
-    std::string::size_type leftBracket = m_element.find('[');
-    std::string::size_type rightBracket = m_element.find(']');
-    std::string::size_type dash = m_element.find('-');
-    if (leftBracket == 0 && rightBracket == m_element.size() - 1 && dash > leftBracket &&
+    std::string::size_type leftBracket = element.find('[');
+    std::string::size_type rightBracket = element.find(']');
+    std::string::size_type dash = element.find('-');
+    if (leftBracket == 0 && rightBracket == element.size() - 1 && dash > leftBracket &&
         dash < rightBracket)
     {
-        std::string lowerBound = m_element.substr(leftBracket + 1, dash - (leftBracket + 1));
-        std::string upperBound = m_element.substr(dash + 1, rightBracket - (dash + 1));
+        std::string lowerBound = element.substr(leftBracket + 1, dash - (leftBracket + 1));
+        std::string upperBound = element.substr(dash + 1, rightBracket - (dash + 1));
         uint32_t min;
         uint32_t max;
-        if (StringToUint32(lowerBound, &min) && StringToUint32(upperBound, &max) && i >= min &&
-            i <= max)
-        {
-            NS_LOG_DEBUG("Array " << i << " matches " << m_element);
-            return true;
-        }
-        else
+        if (StringToUint32(lowerBound, &min) && StringToUint32(upperBound, &max) && min <= max)
         {
-            NS_LOG_DEBUG("Array " << i << " does not " << m_element);
-            return false;
+            m_ranges.emplace_back(min, max);
         }
+        return;
     }
     uint32_t value;
-    if (StringToUint32(m_element, &value) && i == value)
+    if (StringToUint32(element, &value))
     {
-        NS_LOG_DEBUG("Array " << i << " matches " << m_element);
-        return true;
+        m_ranges.emplace_back(value, value);
+    }
+}
+
+bool
+ArrayMatcher::Matches(std::size_t i) const
+{
+    NS_LOG_FUNCTION(this << i);
+    for (const auto& range : m_ranges)
+    {
+        if (i >= range.first && i <= range.second)
+        {
+            NS_LOG_DEBUG("Array " << i << " matches " << m_element);
+            return true;
+        }
     }
     NS_LOG_DEBUG("Array " << i << " does not match " << m_element);
     return false;
 }
 
+bool
+ArrayMatcher::IsIndex() const
+{
+    NS_LOG_FUNCTION(this);
+    return !m_ranges.empty();
+}
+
 bool
 ArrayMatcher::StringToUint32(std::string str, uint32_t* value) const
 {
@@ -315,11 +335,12 @@ class Resolver
 {
   public:
     /**
-     * Construct from a base Config path.
+     * Construct from a parsed Config path.
      *
      * \param [in] path The Config path.
+     * \param [in] n The number of leading elements of the path to resolve.
      */
-    Resolver(std::string path);
+    Resolver(const Path& path, std::size_t n);
     /** Destructor. */
     virtual ~Resolver();
 
@@ -331,25 +352,40 @@ class Resolver
      *                  in the Config path.
      */
     void Resolve(Ptr<Object> root);
+    /**
+     * Parse the rest of the stored Config path, beginning at an object
+     * matching its first elements.
+     *
+     * \param [in] object The object matching the first elements.
+     * \param [in] first The number of elements matched by the object.
+     * \param [in] path The Config path matched by the object.
+     */
+    void ResolveFrom(Ptr<Object> object, std::size_t first, std::string path);
+    /**
+     * Also report the objects matching the first elements of the path,
+     * through DoPrefix().
+     *
+     * \param [in] n The number of leading elements, below the number of
+     *               elements resolved.
+     */
+    void SetPrefix(std::size_t n);
 
   private:
-    /** Ensure the Config path starts and ends with a '/'. */
-    void Canonicalize();
     /**
      * Parse the next element in the Config path.
      *
-     * \param [in] path The remaining portion of the Config path.
+     * \param [in] i The index of the next element.
      * \param [in] root The object corresponding to the current position
      *                  in the Config path.
      */
-    void DoResolve(std::string path, Ptr<Object> root);
+    void DoResolve(std::size_t i, Ptr<Object> root);
     /**
      * Parse an index on the Config path.
      *
-     * \param [in] path The remaining Config path.
+     * \param [in] i The index of the element holding the array index.
      * \param [in,out] vector The resulting list of matching objects.
      */
-    void DoArrayResolve(std::string path, const ObjectPtrContainerValue& vector);
+    void DoArrayResolve(std::size_t i, const ObjectPtrContainerValue& vector);
     /**
      * Handle one object found on the path.
      *
@@ -369,19 +405,41 @@ class Resolver
      * \param [in] path The matching Config path context.
      */
     virtual void DoOne(Ptr<Object> object, std::string path) = 0;
+    /**
+     * Handle one object matching the prefix set by SetPrefix().
+     *
+     * \param [in] object The found object.
+     * \param [in] path The matching Config path context.
+     */
+    virtual void DoPrefix(Ptr<Object> object, std::string path);
 
     /** Current list of path tokens. */
     std::vector<std::string> m_workStack;
-    /** The Config path. */
-    std::string m_path;
+    /** The Config path matched before the path tokens. */
+    std::string m_base;
+    /** The elements of the Config path. */
+    std::vector<std::string> m_elements;
+    /** The elements of the Config path, as array indices. */
+    std::vector<ArrayMatcher> m_matchers;
+    /** The TypeIds named by the elements of the Config path, once looked up. */
+    std::vector<TypeId> m_tids;
+    /** The number of elements of the prefix reported through DoPrefix(). */
+    std::size_t m_prefix;
 
 }; // class Resolver
 
-Resolver::Resolver(std::string path)
-    : m_path(path)
+Resolver::Resolver(const Path& path, std::size_t n)
+    : m_base("/"),
+      m_tids(n),
+      m_prefix(n)
 {
-    NS_LOG_FUNCTION(this << path);
-    Canonicalize();
+    NS_LOG_FUNCTION(this << path.GetPath() << n);
+    NS_ASSERT(n <= path.GetN());
+    for (std::size_t i = 0; i < n; i++)
+    {
+        m_elements.push_back(path.Get(i));
+        m_matchers.emplace_back(m_elements.back());
+    }
 }
 
 Resolver::~Resolver()
@@ -390,31 +448,36 @@ Resolver::~Resolver()
 }
 
 void
-Resolver::Canonicalize()
+Resolver::Resolve(Ptr<Object> root)
 {
-    NS_LOG_FUNCTION(this);
+    NS_LOG_FUNCTION(this << root);
 
-    // ensure that we start and end with a '/'
-    std::string::size_type tmp = m_path.find('/');
-    if (tmp != 0)
-    {
-        // no slash at start
-        m_path = "/" + m_path;
-    }
-    tmp = m_path.find_last_of('/');
-    if (tmp != (m_path.size() - 1))
-    {
-        // no slash at end
-        m_path = m_path + "/";
-    }
+    m_base = "/";
+    DoResolve(0, root);
 }
 
 void
-Resolver::Resolve(Ptr<Object> root)
+Resolver::ResolveFrom(Ptr<Object> object, std::size_t first, std::string path)
 {
-    NS_LOG_FUNCTION(this << root);
+    NS_LOG_FUNCTION(this << object << first << path);
+    NS_ASSERT(first <= m_elements.size());
+
+    m_base = path;
+    DoResolve(first, object);
+}
 
-    DoResolve(m_path, root);
+void
+Resolver::SetPrefix(std::size_t n)
+{
+    NS_LOG_FUNCTION(this << n);
+    NS_ASSERT(n < m_elements.size());
+    m_prefix = n;
+}
+
+void
+Resolver::DoPrefix(Ptr<Object> object, std::string path)
+{
+    NS_LOG_FUNCTION(this << object << path);
 }
 
 std::string
@@ -422,7 +485,7 @@ Resolver::GetResolvedPath() const
 {
     NS_LOG_FUNCTION(this);
 
-    std::string fullPath = "/";
+    std::string fullPath = m_base;
     for (std::vector<std::string>::const_iterator i = m_workStack.begin(); i != m_workStack.end();
          i++)
     {
@@ -441,13 +504,11 @@ Resolver::DoResolveOne(Ptr<Object> object)
 }
 
 void
-Resolver::DoResolve(std::string path, Ptr<Object> root)
+Resolver::DoResolve(std::size_t i, Ptr<Object> root)
 {
-    NS_LOG_FUNCTION(this << path << root);
-    NS_ASSERT((path.find('/')) == 0);
-    std::string::size_type next = path.find('/', 1);
+    NS_LOG_FUNCTION(this << i << root);
 
-    if (next == std::string::npos)
+    if (i == m_elements.size())
     {
         //
         // If root is zero, we're beginning to see if we can use the object name
@@ -463,8 +524,11 @@ Resolver::DoResolve(std::string path, Ptr<Object> root)
         }
         return;
     }
-    std::string item = path.substr(1, next - 1);
-    std::string pathLeft = path.substr(next, path.size() - next);
+    if (i == m_prefix && root)
+    {
+        DoPrefix(root, GetResolvedPath());
+    }
+    const std::string& item = m_elements[i];
 
     //
     // If root is zero, we're beginning to see if we can use the object name
@@ -475,11 +539,11 @@ Resolver::DoResolve(std::string path, Ptr<Object> root)
     //
     if (!root)
     {
-        std::string::size_type offset = path.find("/Names");
+        std::string::size_type offset = item.find("Names");
         if (offset == 0)
         {
             m_workStack.push_back(item);
-            DoResolve(pathLeft, root);
+            DoResolve(i + 1, root);
             m_workStack.pop_back();
             return;
         }
@@ -496,7 +560,7 @@ Resolver::DoResolve(std::string path, Ptr<Object> root)
     {
         NS_LOG_DEBUG("Name system resolved item = " << item << " to " << namedObject);
         m_workStack.push_back(item);
-        DoResolve(pathLeft, namedObject);
+        DoResolve(i + 1, namedObject);
         m_workStack.pop_back();
         return;
     }
@@ -518,15 +582,18 @@ Resolver::DoResolve(std::string path, Ptr<Object> root)
         // This is a call to GetObject
         std::string tidString = item.substr(1, item.size() - 1);
         NS_LOG_DEBUG("GetObject=" << tidString << " on path=" << GetResolvedPath());
-        TypeId tid = TypeId::LookupByName(tidString);
-        Ptr<Object> object = root->GetObject<Object>(tid);
+        if (m_tids[i].GetUid() == 0)
+        {
+            m_tids[i] = TypeId::LookupByName(tidString);
+        }
+        Ptr<Object> object = root->GetObject<Object>(m_tids[i]);
         if (!object)
         {
             NS_LOG_DEBUG("GetObject (" << tidString << ") failed on path=" << GetResolvedPath());
             return;
         }
         m_workStack.push_back(item);
-        DoResolve(pathLeft, object);
+        DoResolve(i + 1, object);
         m_workStack.pop_back();
     }
     else
@@ -540,10 +607,10 @@ Resolver::DoResolve(std::string path, Ptr<Object> root)
         {
             tid = nextTid;
 
-            for (uint32_t i = 0; i < tid.GetAttributeN(); i++)
+            for (uint32_t j = 0; j < tid.GetAttributeN(); j++)
             {
                 struct TypeId::AttributeInformation info;
-                info = tid.GetAttribute(i);
+                info = tid.GetAttribute(j);
                 if (info.name != item && item != "*")
                 {
                     continue;
@@ -568,7 +635,7 @@ Resolver::DoResolve(std::string path, Ptr<Object> root)
                     }
                     foundMatch = true;
                     m_workStack.push_back(info.name);
-                    DoResolve(pathLeft, object);
+                    DoResolve(i + 1, object);
                     m_workStack.pop_back();
                 }
                 // attempt to cast to an object vector.
@@ -576,13 +643,13 @@ Resolver::DoResolve(std::string path, Ptr<Object> root)
                     dynamic_cast<const ObjectPtrContainerChecker*>(PeekPointer(info.checker));
                 if (vectorChecker != nullptr)
                 {
-                    NS_LOG_DEBUG("GetAttribute(vector)=" << info.name << " on path="
-                                                         << GetResolvedPath() << pathLeft);
+                    NS_LOG_DEBUG("GetAttribute(vector)=" << info.name
+                                                         << " on path=" << GetResolvedPath());
                     foundMatch = true;
                     ObjectPtrContainerValue vector;
                     root->GetAttribute(info.name, vector);
                     m_workStack.push_back(info.name);
-                    DoArrayResolve(pathLeft, vector);
+                    DoArrayResolve(i + 1, vector);
                     m_workStack.pop_back();
                 }
                 // this could be anything else and we don't know what to do with it.
@@ -602,29 +669,22 @@ Resolver::DoResolve(std::string path, Ptr<Object> root)
 }
 
 void
-Resolver::DoArrayResolve(std::string path, const ObjectPtrContainerValue& container)
+Resolver::DoArrayResolve(std::size_t i, const ObjectPtrContainerValue& container)
 {
-    NS_LOG_FUNCTION(this << path << &container);
-    NS_ASSERT(path != "");
-    NS_ASSERT((path.find('/')) == 0);
-    std::string::size_type next = path.find('/', 1);
-    if (next == std::string::npos)
+    NS_LOG_FUNCTION(this << i << &container);
+    if (i == m_elements.size())
     {
         return;
     }
-    std::string item = path.substr(1, next - 1);
-    std::string pathLeft = path.substr(next, path.size() - next);
 
-    ArrayMatcher matcher = ArrayMatcher(item);
+    const ArrayMatcher& matcher = m_matchers[i];
     ObjectPtrContainerValue::Iterator it;
     for (it = container.Begin(); it != container.End(); ++it)
     {
         if (matcher.Matches((*it).first))
         {
-            std::ostringstream oss;
-            oss << (*it).first;
-            m_workStack.push_back(oss.str());
-            DoResolve(pathLeft, (*it).second);
+            m_workStack.push_back(std::to_string((*it).first));
+            DoResolve(i + 1, (*it).second);
             m_workStack.pop_back();
         }
     }
@@ -639,20 +699,47 @@ class ConfigImpl : public Singleton<ConfigImpl>
   public:
     // Keep Set and SetFailSafe since their errors are triggered
     // by the underlying ObjecBase functions.
-    /** \copydoc ns3::Config::Set() */
-    void Set(std::string path, const AttributeValue& value);
-    /** \copydoc ns3::Config::SetFailSafe() */
-    bool SetFailSafe(std::string path, const AttributeValue& value);
-    /** \copydoc ns3::Config::ConnectWithoutContextFailSafe() */
-    bool ConnectWithoutContextFailSafe(std::string path, const CallbackBase& cb);
-    /** \copydoc ns3::Config::ConnectFailSafe() */
-    bool ConnectFailSafe(std::string path, const CallbackBase& cb);
-    /** \copydoc ns3::Config::DisconnectWithoutContext() */
-    void DisconnectWithoutContext(std::string path, const CallbackBase& cb);
-    /** \copydoc ns3::Config::Disconnect() */
-    void Disconnect(std::string path, const CallbackBase& cb);
-    /** \copydoc ns3::Config::LookupMatches() */
-    MatchContainer LookupMatches(std::string path);
+    /**
+     * \copydoc ns3::Config::Set(const Path&,const AttributeValue&)
+     * \param [in] cached Whether to use the cached matches.
+     */
+    void Set(const Path& path, const AttributeValue& value, bool cached);
+    /**
+     * \copydoc ns3::Config::SetFailSafe(const Path&,const AttributeValue&)
+     * \param [in] cached Whether to use the cached matches.
+     */
+    bool SetFailSafe(const Path& path, const AttributeValue& value, bool cached);
+    /**
+     * \copydoc ns3::Config::ConnectWithoutContextFailSafe(const Path&,const CallbackBase&)
+     * \param [in] cached Whether to use the cached matches.
+     */
+    bool ConnectWithoutContextFailSafe(const Path& path, const CallbackBase& cb, bool cached);
+    /**
+     * \copydoc ns3::Config::ConnectFailSafe(const Path&,const CallbackBase&)
+     * \param [in] cached Whether to use the cached matches.
+     */
+    bool ConnectFailSafe(const Path& path, const CallbackBase& cb, bool cached);
+    /**
+     * \copydoc ns3::Config::DisconnectWithoutContext(const Path&,const CallbackBase&)
+     * \param [in] cached Whether to use the cached matches.
+     */
+    void DisconnectWithoutContext(const Path& path, const CallbackBase& cb, bool cached);
+    /**
+     * \copydoc ns3::Config::Disconnect(const Path&,const CallbackBase&)
+     * \param [in] cached Whether to use the cached matches.
+     */
+    void Disconnect(const Path& path, const CallbackBase& cb, bool cached);
+    /**
+     * Find the objects matching the first elements of a path.
+     *
+     * \param [in] path The path.
+     * \param [in] n The number of leading elements of the path to match.
+     * \param [in] cached Whether to use, and fill, the cached matches.
+     * \returns The matching objects.
+     */
+    MatchContainer LookupMatches(const Path& path, std::size_t n, bool cached);
+    /** \copydoc ns3::Config::InvalidateMatches() */
+    void InvalidateMatches();
 
     /** \copydoc ns3::Config::RegisterRootNamespaceObject() */
     void RegisterRootNamespaceObject(Ptr<Object> obj);
@@ -666,128 +753,119 @@ class ConfigImpl : public Singleton<ConfigImpl>
 
   private:
     /**
-     * Break a Config path into the leading path and the last leaf token.
-     * \param [in] path The Config path.
-     * \param [in,out] root The leading part of the \pname{path},
-     *   up to the final slash.
-     * \param [in,out] leaf The trailing part of the \pname{path}.
+     * Find the objects matching all the elements of a path but the last,
+     * which names an attribute or a trace source.
+     *
+     * \param [in] path The path.
+     * \param [in] cached Whether to use, and fill, the cached matches.
+     * \returns The matching objects.
+     */
+    MatchContainer LookupParentMatches(const Path& path, bool cached);
+    /**
+     * Warn that a path to disconnect from matches no object.
+     * \param [in] path The path.
      */
-    void ParsePath(std::string path, std::string* root, std::string* leaf) const;
+    void WarnNoMatch(const Path& path) const;
 
     /** Container type to hold the root Config path tokens. */
     typedef std::vector<Ptr<Object>> Roots;
 
     /** The list of Config path roots. */
     Roots m_roots;
+    /** The cached matches, by canonical path. */
+    std::unordered_map<std::string, MatchContainer> m_matches;
 
 }; // class ConfigImpl
 
-void
-ConfigImpl::ParsePath(std::string path, std::string* root, std::string* leaf) const
+MatchContainer
+ConfigImpl::LookupParentMatches(const Path& path, bool cached)
 {
-    NS_LOG_FUNCTION(this << path << root << leaf);
+    NS_LOG_FUNCTION(this << path.GetPath() << cached);
+    NS_ASSERT(path.GetN() > 0);
+    return LookupMatches(path, path.GetN() - 1, cached);
+}
 
-    std::string::size_type slash = path.find_last_of('/');
-    NS_ASSERT(slash != std::string::npos);
-    *root = path.substr(0, slash);
-    *leaf = path.substr(slash + 1, path.size() - (slash + 1));
-    NS_LOG_FUNCTION(path << *root << *leaf);
+void
+ConfigImpl::WarnNoMatch(const Path& path) const
+{
+    NS_LOG_FUNCTION(this << path.GetPath());
+    std::size_t n = path.GetN() - 1;
+    std::string root = n > 0 ? path.GetPrefix(n - 1) : "/";
+    std::string name = n > 0 ? path.Get(n - 1) : "";
+    NS_LOG_WARN("Failed to disconnect " << path.Get(n) << ", the Requested object name = " << name
+                                        << " does not exits on path " << root);
 }
 
 void
-ConfigImpl::Set(std::string path, const AttributeValue& value)
+ConfigImpl::Set(const Path& path, const AttributeValue& value, bool cached)
 {
-    NS_LOG_FUNCTION(this << path << &value);
+    NS_LOG_FUNCTION(this << path.GetPath() << &value << cached);
 
-    std::string root;
-    std::string leaf;
-    ParsePath(path, &root, &leaf);
-    MatchContainer container = LookupMatches(root);
-    container.Set(leaf, value);
+    MatchContainer container = LookupParentMatches(path, cached);
+    container.Set(path.Get(path.GetN() - 1), value);
 }
 
 bool
-ConfigImpl::SetFailSafe(std::string path, const AttributeValue& value)
+ConfigImpl::SetFailSafe(const Path& path, const AttributeValue& value, bool cached)
 {
-    NS_LOG_FUNCTION(this << path << &value);
+    NS_LOG_FUNCTION(this << path.GetPath() << &value << cached);
 
-    std::string root;
-    std::string leaf;
-    ParsePath(path, &root, &leaf);
-    MatchContainer container = LookupMatches(root);
-    return container.SetFailSafe(leaf, value);
+    MatchContainer container = LookupParentMatches(path, cached);
+    return container.SetFailSafe(path.Get(path.GetN() - 1), value);
 }
 
 bool
-ConfigImpl::ConnectWithoutContextFailSafe(std::string path, const CallbackBase& cb)
+ConfigImpl::ConnectWithoutContextFailSafe(const Path& path, const CallbackBase& cb, bool cached)
 {
-    NS_LOG_FUNCTION(this << path << &cb);
-    std::string root;
-    std::string leaf;
-    ParsePath(path, &root, &leaf);
-    MatchContainer container = LookupMatches(root);
-    return container.ConnectWithoutContextFailSafe(leaf, cb);
+    NS_LOG_FUNCTION(this << path.GetPath() << &cb << cached);
+    MatchContainer container = LookupParentMatches(path, cached);
+    return container.ConnectWithoutContextFailSafe(path.Get(path.GetN() - 1), cb);
 }
 
 void
-ConfigImpl::DisconnectWithoutContext(std::string path, const CallbackBase& cb)
+ConfigImpl::DisconnectWithoutContext(const Path& path, const CallbackBase& cb, bool cached)
 {
-    NS_LOG_FUNCTION(this << path << &cb);
-    std::string root;
-    std::string leaf;
-    ParsePath(path, &root, &leaf);
-    MatchContainer container = LookupMatches(root);
+    NS_LOG_FUNCTION(this << path.GetPath() << &cb << cached);
+    MatchContainer container = LookupParentMatches(path, cached);
     if (container.GetN() == 0)
     {
-        std::size_t lastFwdSlash = root.rfind('/');
-        NS_LOG_WARN("Failed to disconnect "
-                    << leaf << ", the Requested object name = " << root.substr(lastFwdSlash + 1)
-                    << " does not exits on path " << root.substr(0, lastFwdSlash));
+        WarnNoMatch(path);
     }
-    container.DisconnectWithoutContext(leaf, cb);
+    container.DisconnectWithoutContext(path.Get(path.GetN() - 1), cb);
 }
 
 bool
-ConfigImpl::ConnectFailSafe(std::string path, const CallbackBase& cb)
+ConfigImpl::ConnectFailSafe(const Path& path, const CallbackBase& cb, bool cached)
 {
-    NS_LOG_FUNCTION(this << path << &cb);
+    NS_LOG_FUNCTION(this << path.GetPath() << &cb << cached);
 
-    std::string root;
-    std::string leaf;
-    ParsePath(path, &root, &leaf);
-    MatchContainer container = LookupMatches(root);
-    return container.ConnectFailSafe(leaf, cb);
+    MatchContainer container = LookupParentMatches(path, cached);
+    return container.ConnectFailSafe(path.Get(path.GetN() - 1), cb);
 }
 
 void
-ConfigImpl::Disconnect(std::string path, const CallbackBase& cb)
+ConfigImpl::Disconnect(const Path& path, const CallbackBase& cb, bool cached)
 {
-    NS_LOG_FUNCTION(this << path << &cb);
+    NS_LOG_FUNCTION(this << path.GetPath() << &cb << cached);
 
-    std::string root;
-    std::string leaf;
-    ParsePath(path, &root, &leaf);
-    MatchContainer container = LookupMatches(root);
+    MatchContainer container = LookupParentMatches(path, cached);
     if (container.GetN() == 0)
     {
-        std::size_t lastFwdSlash = root.rfind('/');
-        NS_LOG_WARN("Failed to disconnect "
-                    << leaf << ", the Requested object name = " << root.substr(lastFwdSlash + 1)
-                    << " does not exits on path " << root.substr(0, lastFwdSlash));
+        WarnNoMatch(path);
     }
-    container.Disconnect(leaf, cb);
+    container.Disconnect(path.Get(path.GetN() - 1), cb);
 }
 
 MatchContainer
-ConfigImpl::LookupMatches(std::string path)
+ConfigImpl::LookupMatches(const Path& path, std::size_t n, bool cached)
 {
-    NS_LOG_FUNCTION(this << path);
+    NS_LOG_FUNCTION(this << path.GetPath() << n << cached);
 
     class LookupMatchesResolver : public Resolver
     {
       public:
-        LookupMatchesResolver(std::string path)
-            : Resolver(path)
+        LookupMatchesResolver(const Path& path, std::size_t n)
+            : Resolver(path, n)
         {
         }
 
@@ -797,23 +875,100 @@ ConfigImpl::LookupMatches(std::string path)
             m_contexts.push_back(path);
         }
 
+        void DoPrefix(Ptr<Object> object, std::string path) override
+        {
+            m_prefixObjects.push_back(object);
+            m_prefixContexts.push_back(path);
+        }
+
         std::vector<Ptr<Object>> m_objects;
         std::vector<std::string> m_contexts;
-    } resolver = LookupMatchesResolver(path);
+        std::vector<Ptr<Object>> m_prefixObjects;
+        std::vector<std::string> m_prefixContexts;
+    } resolver = LookupMatchesResolver(path, n);
 
-    for (Roots::const_iterator i = m_roots.begin(); i != m_roots.end(); i++)
+    std::string prefixPath = path.GetPrefix(n);
+    if (!cached)
     {
-        resolver.Resolve(*i);
+        for (Roots::const_iterator i = m_roots.begin(); i != m_roots.end(); i++)
+        {
+            resolver.Resolve(*i);
+        }
+
+        //
+        // See if we can do something with the object name service.  Starting with
+        // the root pointer zeroed indicates to the resolver that it should start
+        // looking at the root of the "/Names" namespace during this go.
+        //
+        resolver.Resolve(nullptr);
+
+        return MatchContainer(resolver.m_objects, resolver.m_contexts, prefixPath);
+    }
+
+    auto found = m_matches.find(prefixPath);
+    if (found != m_matches.end())
+    {
+        NS_LOG_DEBUG("cached matches for " << prefixPath);
+        return found->second;
     }
 
     //
-    // See if we can do something with the object name service.  Starting with
-    // the root pointer zeroed indicates to the resolver that it should start
-    // looking at the root of the "/Names" namespace during this go.
+    // The objects matching the path up to its last array index, such as
+    // /NodeList/*/DeviceList/*, are shared by many paths: keep them too,
+    // and start from them when they are known.
     //
-    resolver.Resolve(nullptr);
+    std::size_t prefix = n;
+    while (prefix > 0 && !ArrayMatcher(path.Get(prefix - 1)).IsIndex())
+    {
+        prefix--;
+    }
+    if (prefix == n)
+    {
+        prefix = 0;
+    }
+    found = prefix > 0 ? m_matches.find(path.GetPrefix(prefix)) : m_matches.end();
+    if (found != m_matches.end())
+    {
+        NS_LOG_DEBUG("cached matches for " << path.GetPrefix(prefix));
+        MatchContainer prefixMatches = found->second;
+        for (std::size_t i = 0; i < prefixMatches.GetN(); i++)
+        {
+            resolver.ResolveFrom(prefixMatches.Get(i), prefix, prefixMatches.GetMatchedPath(i));
+        }
+    }
+    else
+    {
+        if (prefix > 0)
+        {
+            resolver.SetPrefix(prefix);
+        }
+        for (Roots::const_iterator i = m_roots.begin(); i != m_roots.end(); i++)
+        {
+            resolver.Resolve(*i);
+        }
+        resolver.Resolve(nullptr);
+        if (prefix > 0)
+        {
+            m_matches[path.GetPrefix(prefix)] = MatchContainer(resolver.m_prefixObjects,
+                                                               resolver.m_prefixContexts,
+                                                               path.GetPrefix(prefix));
+        }
+    }
+
+    MatchContainer matches(resolver.m_objects, resolver.m_contexts, prefixPath);
+    m_matches[prefixPath] = matches;
+    return matches;
+}
 
-    return MatchContainer(resolver.m_objects, resolver.m_contexts, path);
+void
+ConfigImpl::InvalidateMatches()
+{
+    NS_LOG_FUNCTION(this);
+    if (!m_matches.empty())
+    {
+        NS_LOG_DEBUG("drop " << m_matches.size() << " cached matches");
+        m_matches.clear();
+    }
 }
 
 void
@@ -821,6 +976,7 @@ ConfigImpl::RegisterRootNamespaceObject(Ptr<Object> obj)
 {
     NS_LOG_FUNCTION(this << obj);
     m_roots.push_back(obj);
+    InvalidateMatches();
 }
 
 void
@@ -833,6 +989,7 @@ ConfigImpl::UnregisterRootNamespaceObject(Ptr<Object> obj)
         if (*i == obj)
         {
             m_roots.erase(i);
+            InvalidateMatches();
             return;
         }
     }
@@ -852,6 +1009,66 @@ ConfigImpl::GetRootNamespaceObject(std::size_t i) const
     return m_roots[i];
 }
 
+Path::Path(std::string path)
+{
+    NS_LOG_FUNCTION(this << path);
+
+    // ensure that we start and end with a '/'
+    std::string::size_type tmp = path.find('/');
+    if (tmp != 0)
+    {
+        // no slash at start
+        path = "/" + path;
+    }
+    tmp = path.find_last_of('/');
+    if (tmp != (path.size() - 1))
+    {
+        // no slash at end
+        path = path + "/";
+    }
+    m_path = path;
+
+    std::string::size_type start = 1;
+    std::string::size_type next = m_path.find('/', start);
+    while (next != std::string::npos)
+    {
+        m_elements.push_back(m_path.substr(start, next - start));
+        m_ends.push_back(next + 1);
+        start = next + 1;
+        next = m_path.find('/', start);
+    }
+}
+
+std::string
+Path::GetPath() const
+{
+    NS_LOG_FUNCTION(this);
+    return m_path;
+}
+
+std::size_t
+Path::GetN() const
+{
+    NS_LOG_FUNCTION(this);
+    return m_elements.size();
+}
+
+std::string
+Path::Get(std::size_t i) const
+{
+    NS_LOG_FUNCTION(this << i);
+    NS_ASSERT(i < m_elements.size());
+    return m_elements[i];
+}
+
+std::string
+Path::GetPrefix(std::size_t n) const
+{
+    NS_LOG_FUNCTION(this << n);
+    NS_ASSERT(n <= m_elements.size());
+    return n == 0 ? "/" : m_path.substr(0, m_ends[n - 1]);
+}
+
 void
 Reset()
 {
@@ -877,14 +1094,14 @@ void
 Set(std::string path, const AttributeValue& value)
 {
     NS_LOG_FUNCTION(path << &value);
-    ConfigImpl::Get()->Set(path, value);
+    ConfigImpl::Get()->Set(Path(path), value, false);
 }
 
 bool
 SetFailSafe(std::string path, const AttributeValue& value)
 {
     NS_LOG_FUNCTION(path << &value);
-    return ConfigImpl::Get()->SetFailSafe(path, value);
+    return ConfigImpl::Get()->SetFailSafe(Path(path), value, false);
 }
 
 void
@@ -961,14 +1178,14 @@ bool
 ConnectWithoutContextFailSafe(std::string path, const CallbackBase& cb)
 {
     NS_LOG_FUNCTION(path << &cb);
-    return ConfigImpl::Get()->ConnectWithoutContextFailSafe(path, cb);
+    return ConfigImpl::Get()->ConnectWithoutContextFailSafe(Path(path), cb, false);
 }
 
 void
 DisconnectWithoutContext(std::string path, const CallbackBase& cb)
 {
     NS_LOG_FUNCTION(path << &cb);
-    ConfigImpl::Get()->DisconnectWithoutContext(path, cb);
+    ConfigImpl::Get()->DisconnectWithoutContext(Path(path), cb, false);
 }
 
 void
@@ -985,21 +1202,145 @@ bool
 ConnectFailSafe(std::string path, const CallbackBase& cb)
 {
     NS_LOG_FUNCTION(path << &cb);
-    return ConfigImpl::Get()->ConnectFailSafe(path, cb);
+    return ConfigImpl::Get()->ConnectFailSafe(Path(path), cb, false);
 }
 
 void
 Disconnect(std::string path, const CallbackBase& cb)
 {
     NS_LOG_FUNCTION(path << &cb);
-    ConfigImpl::Get()->Disconnect(path, cb);
+    ConfigImpl::Get()->Disconnect(Path(path), cb, false);
 }
 
 MatchContainer
 LookupMatches(std::string path)
 {
     NS_LOG_FUNCTION(path);
-    return ConfigImpl::Get()->LookupMatches(path);
+    Path compiled(path);
+    return ConfigImpl::Get()->LookupMatches(compiled, compiled.GetN(), false);
+}
+
+void
+Set(const Path& path, const AttributeValue& value)
+{
+    NS_LOG_FUNCTION(path.GetPath() << &value);
+    ConfigImpl::Get()->Set(path, value, true);
+}
+
+bool
+SetFailSafe(const Path& path, const AttributeValue& value)
+{
+    NS_LOG_FUNCTION(path.GetPath() << &value);
+    return ConfigImpl::Get()->SetFailSafe(path, value, true);
+}
+
+void
+ConnectWithoutContext(const Path& path, const CallbackBase& cb)
+{
+    NS_LOG_FUNCTION(path.GetPath() << &cb);
+    if (!ConnectWithoutContextFailSafe(path, cb))
+    {
+        NS_FATAL_ERROR("Could not connect callback to " << path.GetPath());
+    }
+}
+
+bool
+ConnectWithoutContextFailSafe(const Path& path, const CallbackBase& cb)
+{
+    NS_LOG_FUNCTION(path.GetPath() << &cb);
+    return ConfigImpl::Get()->ConnectWithoutContextFailSafe(path, cb, true);
+}
+
+void
+DisconnectWithoutContext(const Path& path, const CallbackBase& cb)
+{
+    NS_LOG_FUNCTION(path.GetPath() << &cb);
+    ConfigImpl::Get()->DisconnectWithoutContext(path, cb, true);
+}
+
+void
+Connect(const Path& path, const CallbackBase& cb)
+{
+    NS_LOG_FUNCTION(path.GetPath() << &cb);
+    if (!ConnectFailSafe(path, cb))
+    {
+        NS_FATAL_ERROR("Could not connect callback to " << path.GetPath());
+    }
+}
+
+bool
+ConnectFailSafe(const Path& path, const CallbackBase& cb)
+{
+    NS_LOG_FUNCTION(path.GetPath() << &cb);
+    return ConfigImpl::Get()->ConnectFailSafe(path, cb, true);
+}
+
+void
+Disconnect(const Path& path, const CallbackBase& cb)
+{
+    NS_LOG_FUNCTION(path.GetPath() << &cb);
+    ConfigImpl::Get()->Disconnect(path, cb, true);
+}
+
+MatchContainer
+LookupMatches(const Path& path)
+{
+    NS_LOG_FUNCTION(path.GetPath());
+    return ConfigImpl::Get()->LookupMatches(path, path.GetN(), true);
+}
+
+void
+SetAll(const Path& path,
+       std::initializer_list<std::pair<std::string, const AttributeValue&>> values)
+{
+    NS_LOG_FUNCTION(path.GetPath() << values.size());
+    MatchContainer container = ConfigImpl::Get()->LookupMatches(path, path.GetN(), true);
+    for (MatchContainer::Iterator i = container.Begin(); i != container.End(); ++i)
+    {
+        for (const auto& value : values)
+        {
+            // Let ObjectBase::SetAttribute raise any errors
+            (*i)->SetAttribute(value.first, value.second);
+        }
+    }
+}
+
+void
+ConnectAll(const Path& path,
+           std::initializer_list<std::pair<std::string, const CallbackBase&>> sinks)
+{
+    NS_LOG_FUNCTION(path.GetPath() << sinks.size());
+    MatchContainer container = ConfigImpl::Get()->LookupMatches(path, path.GetN(), true);
+    std::vector<bool> connected(sinks.size(), false);
+    for (std::size_t i = 0; i < container.GetN(); i++)
+    {
+        Ptr<Object> object = container.Get(i);
+        std::string context = container.GetMatchedPath(i);
+        std::size_t j = 0;
+        for (const auto& sink : sinks)
+        {
+            if (object->TraceConnect(sink.first, context + sink.first, sink.second))
+            {
+                connected[j] = true;
+            }
+            j++;
+        }
+    }
+    std::size_t j = 0;
+    for (const auto& sink : sinks)
+    {
+        if (!connected[j++])
+        {
+            NS_FATAL_ERROR("Could not connect callback to " << path.GetPath() << sink.first);
+        }
+    }
+}
+
+void
+InvalidateMatches()
+{
+    NS_LOG_FUNCTION_NOARGS();
+    ConfigImpl::Get()->InvalidateMatches();
 }
 
 void
@@ -21,7 +21,9 @@
 
 #include "ptr.h"
 
+#include <initializer_list>
 #include <string>
+#include <utility>
 #include <vector>
 
 /**
@@ -390,6 +392,152 @@ std::size_t GetRootNamespaceObjectN();
  */
 Ptr<Object> GetRootNamespaceObject(uint32_t i);
 
+/**
+ * \ingroup config
+ * \brief A Config path, parsed once.
+ *
+ * The functions taking a Path rather than a string do not parse the path
+ * again, and cache the objects it matches: resolving a path such as
+ * \c /NodeList/[i]/DeviceList/[i]/$ns3::WifiNetDevice/Phy walks every node,
+ * which is what makes configuring large topologies slow when it is done
+ * over and over. The objects matching the path up to its last array
+ * index, here \c /NodeList/[i]/DeviceList/[i], are cached as well, and
+ * shared with the other paths starting the same way.
+ *
+ * The cached matches are dropped when root namespace objects are
+ * (un)registered, names are added, objects are aggregated, Pointer
+ * attributes are set, and nodes, channels, devices or applications are
+ * added. Other changes to the objects found along a path, such as new
+ * sockets in a SocketList, are not tracked: call InvalidateMatches()
+ * before reusing a Path that goes through them. The functions taking a
+ * string never use the cache.
+ */
+class Path
+{
+  public:
+    /**
+     * Parse a Config path.
+     *
+     * \param [in] path The Config path; the leading and trailing '/'
+     *                  are optional.
+     */
+    explicit Path(std::string path);
+
+    /**
+     * \returns The path, starting and ending with a '/'.
+     */
+    std::string GetPath() const;
+    /**
+     * \returns The number of elements of the path.
+     */
+    std::size_t GetN() const;
+    /**
+     * \param [in] i Index of the element ([0,n[)
+     * \returns The element of the path.
+     */
+    std::string Get(std::size_t i) const;
+    /**
+     * \param [in] n The number of leading elements ([0,n]).
+     * \returns The path made of the first \pname{n} elements, starting and
+     *          ending with a '/'.
+     */
+    std::string GetPrefix(std::size_t n) const;
+
+  private:
+    /** The path, starting and ending with a '/'. */
+    std::string m_path;
+    /** The elements of the path, between the '/'. */
+    std::vector<std::string> m_elements;
+    /** The position in m_path following each element and its '/'. */
+    std::vector<std::size_t> m_ends;
+};
+
+/**
+ * \ingroup config
+ * \copydoc Set(std::string,const AttributeValue&)
+ */
+void Set(const Path& path, const AttributeValue& value);
+/**
+ * \ingroup config
+ * \copydoc SetFailSafe(std::string,const AttributeValue&)
+ */
+bool SetFailSafe(const Path& path, const AttributeValue& value);
+/**
+ * \ingroup config
+ * \copydoc ConnectWithoutContext(std::string,const CallbackBase&)
+ */
+void ConnectWithoutContext(const Path& path, const CallbackBase& cb);
+/**
+ * \ingroup config
+ * \copydoc ConnectWithoutContextFailSafe(std::string,const CallbackBase&)
+ */
+bool ConnectWithoutContextFailSafe(const Path& path, const CallbackBase& cb);
+/**
+ * \ingroup config
+ * \copydoc DisconnectWithoutContext(std::string,const CallbackBase&)
+ */
+void DisconnectWithoutContext(const Path& path, const CallbackBase& cb);
+/**
+ * \ingroup config
+ * \copydoc Connect(std::string,const CallbackBase&)
+ */
+void Connect(const Path& path, const CallbackBase& cb);
+/**
+ * \ingroup config
+ * \copydoc ConnectFailSafe(std::string,const CallbackBase&)
+ */
+bool ConnectFailSafe(const Path& path, const CallbackBase& cb);
+/**
+ * \ingroup config
+ * \copydoc Disconnect(std::string,const CallbackBase&)
+ */
+void Disconnect(const Path& path, const CallbackBase& cb);
+/**
+ * \ingroup config
+ * \copydoc LookupMatches(std::string)
+ */
+MatchContainer LookupMatches(const Path& path);
+
+/**
+ * \ingroup config
+ * \param [in] path The path of the objects, without attribute name.
+ * \param [in] values The names of the attributes and their values.
+ *
+ * Set several attributes of all the objects matching the path, which is
+ * resolved once:
+ * \code
+ *   Config::SetAll(Config::Path("/NodeList/[0-999]/DeviceList/0/$ns3::PointToPointNetDevice"),
+ *                  {{"DataRate", StringValue("10Mbps")}, {"Mtu", UintegerValue(1400)}});
+ * \endcode
+ * This function will raise a fatal error if an attribute does not exist
+ * or cannot be set on one of the objects.
+ */
+void SetAll(const Path& path,
+            std::initializer_list<std::pair<std::string, const AttributeValue&>> values);
+/**
+ * \ingroup config
+ * \param [in] path The path of the objects, without trace source name.
+ * \param [in] sinks The names of the trace sources and the sinks to connect
+ *                   to them.
+ *
+ * Connect several trace sources of all the objects matching the path,
+ * which is resolved once. Each sink receives the path of the trace source
+ * as its context, as with Connect(). This function will raise a fatal
+ * error if a trace source could not be connected on any object.
+ */
+void ConnectAll(const Path& path,
+                std::initializer_list<std::pair<std::string, const CallbackBase&>> sinks);
+
+/**
+ * \ingroup config
+ *
+ * Drop the objects matched by the Config paths parsed into a Path, so that
+ * they are resolved again when next used. This is called when the object
+ * graph changes in ways that the Config system can see; call it after
+ * other changes, such as adding objects to a container attribute.
+ */
+void InvalidateMatches();
+
 } // namespace Config
 
 } // namespace ns3
@@ -19,10 +19,13 @@
 
 #include "default-simulator-impl.h"
 
+#include "abort.h"
 #include "assert.h"
 #include "log.h"
 #include "scheduler.h"
 #include "simulator.h"
+#include "string.h"
+#include "uinteger.h"
 
 #include <cmath>
 
@@ -48,7 +51,22 @@ DefaultSimulatorImpl::GetTypeId()
     static TypeId tid = TypeId("ns3::DefaultSimulatorImpl")
                             .SetParent<SimulatorImpl>()
                             .SetGroupName("Core")
-                            .AddConstructor<DefaultSimulatorImpl>();
+                            .AddConstructor<DefaultSimulatorImpl>()
+                            .AddAttribute("ProfileFile",
+                                          "The file to write the wall clock time profile "
+                                          "of the events to at Simulator::Destroy, in the "
+                                          "folded stack format of flame graph tools; "
+                                          "empty for no profiling.",
+                                          StringValue(""),
+                                          MakeStringAccessor(&DefaultSimulatorImpl::m_profileFile),
+                                          MakeStringChecker())
+                            .AddAttribute("ProfilePeriod",
+                                          "The mean number of events per event timed "
+                                          "by the profiler.",
+                                          UintegerValue(64),
+                                          MakeUintegerAccessor(
+                                              &DefaultSimulatorImpl::m_profilePeriod),
+                                          MakeUintegerChecker<uint32_t>(1));
     return tid;
 }
 
@@ -64,6 +82,7 @@ DefaultSimulatorImpl::DefaultSimulatorImpl()
     m_eventCount = 0;
     m_eventsWithContextEmpty = true;
     m_mainThreadId = std::this_thread::get_id();
+    m_profilePeriod = 64;
 }
 
 DefaultSimulatorImpl::~DefaultSimulatorImpl()
@@ -100,6 +119,12 @@ DefaultSimulatorImpl::Destroy()
             ev->Invoke();
         }
     }
+    if (m_profiler.IsEnabled())
+    {
+        m_profiler.Write(m_profileStream);
+        m_profileStream.close();
+        m_profiler.Disable();
+    }
 }
 
 void
@@ -141,7 +166,16 @@ DefaultSimulatorImpl::ProcessOneEvent()
     m_currentTs = next.key.m_ts;
     m_currentContext = next.key.m_context;
     m_currentUid = next.key.m_uid;
-    next.impl->Invoke();
+    if (m_profiler.Sample())
+    {
+        uint64_t start = EventProfiler::Now();
+        next.impl->Invoke();
+        m_profiler.Record(next.impl, next.key.m_context, EventProfiler::Now() - start);
+    }
+    else
+    {
+        next.impl->Invoke();
+    }
     next.impl->Unref();
 
     ProcessEventsWithContext();
@@ -191,6 +225,13 @@ DefaultSimulatorImpl::Run()
     m_mainThreadId = std::this_thread::get_id();
     ProcessEventsWithContext();
     m_stop = false;
+    if (!m_profileFile.empty() && !m_profiler.IsEnabled())
+    {
+        m_profileStream.open(m_profileFile);
+        NS_ABORT_MSG_UNLESS(m_profileStream.is_open(),
+                            "Cannot open the event profile file " << m_profileFile);
+        m_profiler.Enable(m_profilePeriod);
+    }
 
     while (!m_events->IsEmpty() && !m_stop)
     {
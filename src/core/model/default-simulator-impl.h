@@ -20,8 +20,10 @@
 #ifndef DEFAULT_SIMULATOR_IMPL_H
 #define DEFAULT_SIMULATOR_IMPL_H
 
+#include "event-profiler.h"
 #include "simulator-impl.h"
 
+#include <fstream>
 #include <list>
 #include <mutex>
 #include <thread>
@@ -135,6 +137,15 @@ class DefaultSimulatorImpl : public SimulatorImpl
 
     /** Main execution thread. */
     std::thread::id m_mainThreadId;
+
+    /** The event profiler. */
+    EventProfiler m_profiler;
+    /** The file of the event profile, empty for no profiling. */
+    std::string m_profileFile;
+    /** The mean number of events per sampled event. */
+    uint32_t m_profilePeriod;
+    /** The stream of the event profile. */
+    std::ofstream m_profileStream;
 };
 
 } // namespace ns3
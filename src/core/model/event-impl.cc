@@ -21,6 +21,9 @@
 
 #include "log.h"
 
+#include <new>
+#include <thread>
+
 /**
  * \file
  * \ingroup events
@@ -67,4 +70,122 @@ EventImpl::IsCancelled()
     return m_cancel;
 }
 
+std::string
+EventImpl::GetTargetName() const
+{
+    return std::string();
+}
+
+#ifdef EVENT_IMPL_FREE_LIST
+
+namespace
+{
+
+/** Granularity of the event size classes, in bytes. */
+constexpr std::size_t EVENT_SIZE_STEP = 16;
+/** Number of size classes; larger events use the global allocator. */
+constexpr std::size_t EVENT_SIZE_CLASSES = 16;
+/** Maximum number of free blocks kept per size class. */
+constexpr uint32_t EVENT_FREE_LIST_MAX = 4096;
+
+/** A free block, linked through its first bytes. */
+struct FreeBlock
+{
+    FreeBlock* next; //!< Next free block of the same size class.
+};
+
+/** The free blocks of one size class. */
+struct FreeList
+{
+    FreeBlock* head; //!< First free block.
+    uint32_t size;   //!< Number of free blocks.
+};
+
+/**
+ * The free lists, one per size class. Zero initialized and never
+ * destroyed, so events may still be released by objects destroyed after
+ * the lists were emptied.
+ */
+FreeList g_freeLists[EVENT_SIZE_CLASSES];
+/** Set once the free lists have been emptied at exit. */
+bool g_freeListsDestroyed = false;
+/**
+ * The thread which loaded the library, normally the main thread, and the
+ * only one using the free lists. Other threads, such as those scheduling
+ * events with Simulator::ScheduleWithContext(), use the global allocator.
+ */
+const std::thread::id g_freeListsOwner = std::this_thread::get_id();
+
+/**
+ * \param [in] size The size of an event object.
+ * \returns The index of its size class.
+ */
+inline std::size_t
+GetSizeClass(std::size_t size)
+{
+    return (size - 1) / EVENT_SIZE_STEP;
+}
+
+/** Release the free blocks at exit. */
+struct LocalStaticDestructor
+{
+    /** Destructor. */
+    ~LocalStaticDestructor()
+    {
+        for (FreeList& list : g_freeLists)
+        {
+            while (list.head)
+            {
+                FreeBlock* block = list.head;
+                list.head = block->next;
+                ::operator delete(block);
+            }
+            list.size = 0;
+        }
+        g_freeListsDestroyed = true;
+    }
+} g_localStaticDestructor; //!< Empties the free lists at exit.
+
+} // unnamed namespace
+
+void*
+EventImpl::operator new(std::size_t size)
+{
+    std::size_t sizeClass = GetSizeClass(size);
+    if (sizeClass >= EVENT_SIZE_CLASSES)
+    {
+        return ::operator new(size);
+    }
+    FreeList& list = g_freeLists[sizeClass];
+    if (std::this_thread::get_id() == g_freeListsOwner && list.head)
+    {
+        FreeBlock* block = list.head;
+        list.head = block->next;
+        list.size--;
+        return block;
+    }
+    // any event of the size class may reuse the block
+    return ::operator new((sizeClass + 1) * EVENT_SIZE_STEP);
+}
+
+void
+EventImpl::operator delete(void* p, std::size_t size)
+{
+    std::size_t sizeClass = GetSizeClass(size);
+    // other threads must not even look at the lists
+    if (sizeClass >= EVENT_SIZE_CLASSES || std::this_thread::get_id() != g_freeListsOwner ||
+        g_freeListsDestroyed || g_freeLists[sizeClass].size >= EVENT_FREE_LIST_MAX)
+    {
+        ::operator delete(p);
+        return;
+    }
+    FreeList& list = g_freeLists[sizeClass];
+    FreeBlock* block = static_cast<FreeBlock*>(p);
+    block->next = list.head;
+    list.head = block;
+    list.size++;
+}
+
+#endif /* EVENT_IMPL_FREE_LIST */
+
 } // namespace ns3
@@ -21,7 +21,19 @@
 
 #include "simple-ref-count.h"
 
+#include <cstddef>
 #include <stdint.h>
+#include <string>
+
+#ifndef NS3_NO_EVENT_FREE_LIST
+/**
+ * \ingroup events
+ * Recycle the memory of events through free lists. Configure with
+ * NS3_EVENT_FREE_LIST=OFF, which defines NS3_NO_EVENT_FREE_LIST, to track
+ * memory errors in events with tools such as valgrind.
+ */
+#define EVENT_IMPL_FREE_LIST 1
+#endif
 
 /**
  * \file
@@ -41,6 +53,12 @@ namespace ns3
  * when it reaches the time associated to this event. Most subclasses
  * are usually created by one of the many Simulator::Schedule
  * methods.
+ *
+ * The arguments bound to an event are stored in the event object itself.
+ * With EVENT_IMPL_FREE_LIST, the memory of event objects is recycled
+ * through free lists, one per size class, so scheduling an event and
+ * releasing it once it has run on the main thread usually does not call
+ * the system allocator.
  */
 class EventImpl : public SimpleRefCount<EventImpl>
 {
@@ -66,6 +84,32 @@ class EventImpl : public SimpleRefCount<EventImpl>
      * Checked by the simulation engine before calling Invoke().
      */
     bool IsCancelled();
+    /**
+     * \returns The name of what the event calls: the TypeId name of the
+     * Object a member function is called on, or the symbol of a function,
+     * or an empty string if the event does not tell.
+     *
+     * Used by the EventProfiler to attribute the time of the events of
+     * the same type to their targets.
+     */
+    virtual std::string GetTargetName() const;
+
+#ifdef EVENT_IMPL_FREE_LIST
+    /**
+     * Allocate an event from the free list of its size class.
+     *
+     * \param [in] size The size of the event object.
+     * \returns The memory for the event.
+     */
+    static void* operator new(std::size_t size);
+    /**
+     * Return the memory of an event to the free list of its size class.
+     *
+     * \param [in] p The memory of the event.
+     * \param [in] size The size of the event object.
+     */
+    static void operator delete(void* p, std::size_t size);
+#endif /* EVENT_IMPL_FREE_LIST */
 
   protected:
     /**
@@ -0,0 +1,208 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "event-profiler.h"
+
+#include "assert.h"
+#include "event-impl.h"
+#include "log.h"
+#include "simulator.h"
+
+#include <algorithm>
+#include <map>
+#include <tuple>
+
+#if (__GNUC__ >= 3)
+#include <cstdlib>
+#include <cxxabi.h>
+#endif
+
+/**
+ * \file
+ * \ingroup simulator
+ * ns3::EventProfiler implementation.
+ */
+
+namespace ns3
+{
+
+NS_LOG_COMPONENT_DEFINE("EventProfiler");
+
+/**
+ * \ingroup simulator
+ * The readable name of an event type.
+ *
+ * The events made by MakeEvent() are local classes of its instances,
+ * named after the template arguments, or the parameter of the only
+ * MakeEvent() which is not a template, which are kept; the argument
+ * types of the function are dropped.
+ *
+ * \param [in] type The event type.
+ * \return The name.
+ */
+static std::string
+GetEventName(const std::type_index& type)
+{
+    std::string name = type.name();
+#if (__GNUC__ >= 3)
+    int status;
+    char* demangled = abi::__cxa_demangle(name.c_str(), nullptr, nullptr, &status);
+    if (status == 0)
+    {
+        name = demangled;
+    }
+    std::free(demangled);
+#endif
+    const std::string prefix = "ns3::MakeEvent";
+    if (name.compare(0, prefix.size(), prefix) == 0 && prefix.size() < name.size() &&
+        (name[prefix.size()] == '<' || name[prefix.size()] == '('))
+    {
+        int depth = 0;
+        for (std::size_t i = prefix.size(); i < name.size(); i++)
+        {
+            if (name[i] == '<' || name[i] == '(')
+            {
+                depth++;
+            }
+            else if ((name[i] == '>' || name[i] == ')') && --depth == 0)
+            {
+                name = name.substr(5, i - 4);
+                break;
+            }
+        }
+    }
+    // ';' separates the frames of a folded stack
+    std::replace(name.begin(), name.end(), ';', ',');
+    return name;
+}
+
+EventProfiler::EventProfiler()
+    : m_period(0),
+      m_countdown(0),
+      m_drawn(0),
+      m_sampleCount(0),
+      m_random(0x2545f4914f6cdd1dULL),
+      m_startTicks(0)
+{
+    NS_LOG_FUNCTION(this);
+}
+
+void
+EventProfiler::Enable(uint32_t period)
+{
+    NS_LOG_FUNCTION(this << period);
+    NS_ASSERT_MSG(period > 0, "The profiler needs at least one event per sample");
+    m_period = period;
+    m_drawn = 0;
+    m_sampleCount = 0;
+    m_samples.clear();
+    m_startTicks = Now();
+    m_startTime = std::chrono::steady_clock::now();
+    NextCountdown();
+}
+
+void
+EventProfiler::Disable()
+{
+    NS_LOG_FUNCTION(this);
+    m_period = 0;
+    m_samples.clear();
+}
+
+void
+EventProfiler::NextCountdown()
+{
+    // xorshift64, uniform over [1, 2 * period - 1]: mean period
+    m_random ^= m_random << 13;
+    m_random ^= m_random >> 7;
+    m_random ^= m_random << 17;
+    m_countdown = 1 + m_random % (2 * uint64_t(m_period) - 1);
+    m_drawn += m_countdown;
+}
+
+void
+EventProfiler::Record(const EventImpl* event, uint32_t context, uint64_t ticks)
+{
+    Samples& samples = m_samples[Key{typeid(*event), event->GetTargetName(), context}];
+    samples.count++;
+    samples.ticks += ticks;
+    m_sampleCount++;
+    NextCountdown();
+}
+
+uint64_t
+EventProfiler::GetEventCount() const
+{
+    return m_drawn - m_countdown;
+}
+
+uint64_t
+EventProfiler::GetSampleCount() const
+{
+    return m_sampleCount;
+}
+
+void
+EventProfiler::Write(std::ostream& os) const
+{
+    NS_LOG_FUNCTION(this);
+    if (m_sampleCount == 0)
+    {
+        return;
+    }
+    // nanoseconds per tick, from the ticks and wall clock time since Enable()
+    double elapsed = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() -
+                                                             m_startTime)
+                         .count();
+    uint64_t ticks = Now() - m_startTicks;
+    double scale = ticks > 0 ? elapsed / ticks : 1;
+    // events per sample
+    scale *= double(GetEventCount()) / m_sampleCount;
+
+    // sorted by name, then target and context, so that the report is stable
+    std::map<std::type_index, std::string> names;
+    std::map<std::tuple<std::string, std::string, uint32_t>, uint64_t> folded;
+    for (const auto& i : m_samples)
+    {
+        auto name = names.find(i.first.type);
+        if (name == names.end())
+        {
+            name = names.emplace(i.first.type, GetEventName(i.first.type)).first;
+        }
+        std::string target = i.first.target;
+        std::replace(target.begin(), target.end(), ';', ',');
+        folded[{name->second, target, i.first.context}] += i.second.ticks;
+    }
+    for (const auto& i : folded)
+    {
+        os << std::get<0>(i.first) << ";";
+        if (!std::get<1>(i.first).empty())
+        {
+            os << std::get<1>(i.first) << ";";
+        }
+        if (std::get<2>(i.first) == Simulator::NO_CONTEXT)
+        {
+            os << "no context";
+        }
+        else
+        {
+            os << "node " << std::get<2>(i.first);
+        }
+        os << " " << static_cast<uint64_t>(i.second * scale + 0.5) << "\n";
+    }
+    NS_LOG_INFO("Profiled " << GetEventCount() << " events with " << m_sampleCount << " samples");
+}
+
+} // namespace ns3
@@ -0,0 +1,195 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef EVENT_PROFILER_H
+#define EVENT_PROFILER_H
+
+#include <chrono>
+#include <functional>
+#include <ostream>
+#include <stdint.h>
+#include <string>
+#include <typeindex>
+#include <unordered_map>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+/**
+ * \file
+ * \ingroup simulator
+ * ns3::EventProfiler declaration.
+ */
+
+namespace ns3
+{
+
+class EventImpl;
+
+/**
+ * \ingroup simulator
+ *
+ * Sample the wall clock time spent in the events of a simulation.
+ *
+ * One event out of about Period is timed, with the time stamp counter
+ * of the processor where available, and its time is attributed to the
+ * dynamic type of its EventImpl, which names the object class and the
+ * member function signature of the events made by MakeEvent(), to its
+ * target, the TypeId name of the object or the symbol of the function it
+ * calls (EventImpl::GetTargetName()), and to its context, the node id. The periods between samples are
+ * randomized around Period, so that periodic event patterns do not bias
+ * the samples.
+ * The events which are not sampled only cost a counter decrement.
+ *
+ * The report estimates the time of each (type, target, context) triple
+ * as its sampled time scaled by the number of events run per sample, in
+ * the folded stack format of flame graph tools:
+ * \verbatim
+   <event type>;<target>;node <context> <nanoseconds>
+   \endverbatim
+ * with the target left out for the events without one, such as lambdas
+ * or members of classes which are not an ObjectBase, and with
+ * \c "no context" for the events scheduled without a context. Keyed on
+ * names rather than addresses, the samples of all the objects of a class
+ * are merged, and the report does not change from run to run.
+ */
+class EventProfiler
+{
+  public:
+    /** Constructor; the profiler is disabled. */
+    EventProfiler();
+
+    /**
+     * Start sampling, forgetting the previous samples.
+     * \param [in] period The mean number of events per sample, at least 1.
+     */
+    void Enable(uint32_t period);
+
+    /** Stop sampling, forgetting the samples. */
+    void Disable();
+
+    /** \return \c true if the profiler is sampling. */
+    bool IsEnabled() const
+    {
+        return m_period != 0;
+    }
+
+    /**
+     * Count an event about to run.
+     * \return \c true if the event should be timed, and given to Record().
+     */
+    bool Sample()
+    {
+        return m_period != 0 && --m_countdown == 0;
+    }
+
+    /**
+     * \return The current time, in the unit of Record(), for timing an event.
+     */
+    static uint64_t Now()
+    {
+#if defined(__x86_64__) || defined(__i386__)
+        return __rdtsc();
+#else
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                   std::chrono::steady_clock::now().time_since_epoch())
+            .count();
+#endif
+    }
+
+    /**
+     * Record a sampled event.
+     * \param [in] event The event, not yet released.
+     * \param [in] context The context of the event.
+     * \param [in] ticks The time spent in the event, as a difference of Now().
+     */
+    void Record(const EventImpl* event, uint32_t context, uint64_t ticks);
+
+    /** \return The number of events counted since Enable(). */
+    uint64_t GetEventCount() const;
+
+    /** \return The number of sampled events since Enable(). */
+    uint64_t GetSampleCount() const;
+
+    /**
+     * Write the report, in the folded stack format.
+     * \param [in] os The output stream.
+     */
+    void Write(std::ostream& os) const;
+
+  private:
+    /** Draw the number of events until the next sample. */
+    void NextCountdown();
+
+    /** Key of the samples: event type, target and context. */
+    struct Key
+    {
+        std::type_index type; //!< The dynamic type of the event.
+        std::string target;   //!< The target name of the event.
+        uint32_t context;     //!< The context of the event.
+
+        /**
+         * \param [in] other The other key.
+         * \return \c true if the keys are equal.
+         */
+        bool operator==(const Key& other) const
+        {
+            return type == other.type && target == other.target && context == other.context;
+        }
+    };
+
+    /** Hash of a Key. */
+    struct KeyHash
+    {
+        /**
+         * \param [in] key The key.
+         * \return The hash of the key.
+         */
+        std::size_t operator()(const Key& key) const
+        {
+            return std::hash<std::type_index>()(key.type) ^ std::hash<std::string>()(key.target) ^
+                   (key.context * 0x9e3779b97f4a7c15ULL);
+        }
+    };
+
+    /** The samples of one key. */
+    struct Samples
+    {
+        uint64_t count; //!< Number of samples.
+        uint64_t ticks; //!< Sum of the sampled times.
+    };
+
+    /** Mean number of events per sample, 0 when disabled. */
+    uint32_t m_period;
+    /** Number of events until the next sample. */
+    uint32_t m_countdown;
+    /** Sum of the countdowns drawn since Enable(). */
+    uint64_t m_drawn;
+    /** Number of samples since Enable(). */
+    uint64_t m_sampleCount;
+    /** State of the xorshift generator of the countdowns. */
+    uint64_t m_random;
+    /** Now() at Enable(). */
+    uint64_t m_startTicks;
+    /** Wall clock time at Enable(). */
+    std::chrono::steady_clock::time_point m_startTime;
+    /** The samples, by event type, target and context. */
+    std::unordered_map<Key, Samples, KeyHash> m_samples;
+};
+
+} // namespace ns3
+
+#endif /* EVENT_PROFILER_H */
@@ -79,6 +79,9 @@ void UnregisterStream(std::ostream* stream);
  *
  * \brief Flush all currently registered streams.
  *
+ * The pending records of the binary log file, if any, are written
+ * first; see LogSetBinaryFile().
+ *
  * This function iterates through each registered stream and
  * unregisters them. The default \c SIGSEGV handler is overridden
  * when this function is being executed, and will be restored
@@ -25,6 +25,8 @@
 #include "event-impl.h"
 #include "log.h"
 
+#include <algorithm>
+
 /**
  * \file
  * \ingroup scheduler
@@ -221,26 +223,54 @@ HeapScheduler::RemoveNext()
     Exch(Root(), Last());
     m_heap.pop_back();
     TopDown(Root());
+    PopRemoved();
     return next;
 }
 
+void
+HeapScheduler::PopRemoved()
+{
+    NS_LOG_FUNCTION(this);
+    while (!m_removed.empty() && !IsEmpty() && m_removed.erase(m_heap[Root()].key.m_uid) > 0)
+    {
+        Exch(Root(), Last());
+        m_heap.pop_back();
+        TopDown(Root());
+    }
+}
+
+void
+HeapScheduler::Compact()
+{
+    NS_LOG_FUNCTION(this << m_heap.size() << m_removed.size());
+    auto end = std::remove_if(m_heap.begin() + Root(), m_heap.end(), [this](const Event& ev) {
+        return m_removed.count(ev.key.m_uid) > 0;
+    });
+    m_heap.erase(end, m_heap.end());
+    m_removed.clear();
+    for (std::size_t i = Parent(Last()); i >= Root(); i--)
+    {
+        TopDown(i);
+    }
+}
+
 void
 HeapScheduler::Remove(const Event& ev)
 {
     NS_LOG_FUNCTION(this << &ev);
-    std::size_t uid = ev.key.m_uid;
-    for (std::size_t i = 1; i < m_heap.size(); i++)
+    NS_ASSERT(!IsEmpty());
+    if (ev.key.m_uid == m_heap[Root()].key.m_uid)
     {
-        if (uid == m_heap[i].key.m_uid)
-        {
-            NS_ASSERT(m_heap[i].impl == ev.impl);
-            Exch(i, Last());
-            m_heap.pop_back();
-            TopDown(i);
-            return;
-        }
+        RemoveNext();
+        return;
+    }
+    // the event stays in the heap until it reaches the root
+    [[maybe_unused]] bool inserted = m_removed.insert(ev.key.m_uid).second;
+    NS_ASSERT(inserted);
+    if (2 * m_removed.size() >= Last())
+    {
+        Compact();
     }
-    NS_ASSERT(false);
 }
 
 } // namespace ns3
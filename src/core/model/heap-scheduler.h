@@ -23,6 +23,7 @@
 #include "scheduler.h"
 
 #include <stdint.h>
+#include <unordered_set>
 #include <vector>
 
 /**
@@ -52,6 +53,11 @@ namespace ns3
  *    the index of the root is 1.
  *  - It uses a slightly non-standard while loop for top-down heapify
  *    to move one if statement out of the loop.
+ *  - Remove() does not search the heap: it records the uid of the event
+ *    as a tombstone, and removed events are discarded when they reach the
+ *    root. When tombstones make up half of the heap, they are all dropped
+ *    and the heap is rebuilt, so memory stays bounded by twice the number
+ *    of live events.
  *
  * \par Time Complexity
  *
@@ -60,7 +66,7 @@ namespace ns3
  * Insert()     | Logarithmic     | Heapify
  * IsEmpty()    | Constant        | Explicit queue size
  * PeekNext()   | Constant        | Heap kept sorted
- * Remove()     | Logarithmic     | Search, heapify
+ * Remove()     | ~Constant       | Tombstone, amortized compaction
  * RemoveNext() | Logarithmic     | Heapify
  *
  * \par Memory Complexity
@@ -69,6 +75,7 @@ namespace ns3
  * :-------- | :------------------------------- | :-----
  * Overhead  | 3 x `sizeof (*)`<br/>(24 bytes)  | `std::vector`
  * Per Event | 0                                | Events stored in `std::vector` directly
+ * Removed   | 1 to 2 x `sizeof (Event)`        | Until compaction; `std::unordered_set` node
  */
 class HeapScheduler : public Scheduler
 {
@@ -179,9 +186,15 @@ class HeapScheduler : public Scheduler
      * \param [in] start Starting entry.
      */
     void TopDown(std::size_t start);
+    /** Pop the removed events off the root, so that the root is live. */
+    void PopRemoved();
+    /** Drop all the removed events and rebuild the heap. */
+    void Compact();
 
     /** The event list. */
     BinaryHeap m_heap;
+    /** Uids of the events removed but still in the heap. */
+    std::unordered_set<uint32_t> m_removed;
 };
 
 } // namespace ns3
@@ -0,0 +1,276 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ladder-scheduler.h"
+
+#include "assert.h"
+#include "event-impl.h"
+#include "log.h"
+#include "type-id.h"
+#include "uinteger.h"
+
+#include <algorithm>
+
+/**
+ * \file
+ * \ingroup scheduler
+ * ns3::LadderScheduler implementation.
+ */
+
+namespace ns3
+{
+
+NS_LOG_COMPONENT_DEFINE("LadderScheduler");
+
+NS_OBJECT_ENSURE_REGISTERED(LadderScheduler);
+
+/**
+ * Order of the events in Bottom: decreasing, so the next one is last.
+ * \param [in] a The first event.
+ * \param [in] b The second event.
+ * \returns \c true if \c a runs after \c b.
+ */
+static bool
+Later(const Scheduler::Event& a, const Scheduler::Event& b)
+{
+    return a.key > b.key;
+}
+
+uint64_t
+LadderScheduler::Rung::GetCurrentStart() const
+{
+    return start + current * width;
+}
+
+uint32_t
+LadderScheduler::Rung::GetIndex(uint64_t ts) const
+{
+    uint64_t index = (ts - start) / width;
+    NS_ASSERT(ts >= start && index < buckets.size());
+    return index;
+}
+
+TypeId
+LadderScheduler::GetTypeId()
+{
+    static TypeId tid =
+        TypeId("ns3::LadderScheduler")
+            .SetParent<Scheduler>()
+            .SetGroupName("Core")
+            .AddConstructor<LadderScheduler>()
+            .AddAttribute("Threshold",
+                          "Largest bucket sorted as is; larger buckets are split into a new rung",
+                          UintegerValue(50),
+                          MakeUintegerAccessor(&LadderScheduler::m_threshold),
+                          MakeUintegerChecker<uint32_t>(1))
+            .AddAttribute("MaxRungs",
+                          "Maximum number of rungs of the ladder",
+                          UintegerValue(8),
+                          MakeUintegerAccessor(&LadderScheduler::m_maxRungs),
+                          MakeUintegerChecker<uint32_t>(1));
+    return tid;
+}
+
+LadderScheduler::LadderScheduler()
+    : m_topStart(0),
+      m_size(0),
+      m_threshold(50),
+      m_maxRungs(8)
+{
+    NS_LOG_FUNCTION(this);
+}
+
+LadderScheduler::~LadderScheduler()
+{
+    NS_LOG_FUNCTION(this);
+}
+
+uint64_t
+LadderScheduler::AddRung(uint64_t start, uint64_t end, Bucket& events)
+{
+    NS_LOG_FUNCTION(this << start << end << events.size());
+    NS_ASSERT(start < end && !events.empty());
+    // about one event per bucket
+    uint64_t span = end - start;
+    uint64_t width = std::max<uint64_t>(1, (span + events.size() - 1) / events.size());
+
+    Rung rung;
+    rung.start = start;
+    rung.width = width;
+    rung.current = 0;
+    rung.size = events.size();
+    rung.buckets.resize((span + width - 1) / width);
+    for (auto& ev : events)
+    {
+        rung.buckets[rung.GetIndex(ev.key.m_ts)].push_back(ev);
+    }
+    events.clear();
+    m_rungs.push_back(std::move(rung));
+    NS_LOG_LOGIC("rung " << m_rungs.size() << ": " << m_rungs.back().buckets.size()
+                         << " buckets of width " << width);
+    return start + m_rungs.back().buckets.size() * width;
+}
+
+LadderScheduler::Rung*
+LadderScheduler::FindRung(uint64_t ts)
+{
+    // finer rungs cover the start of the span of coarser ones
+    for (auto& rung : m_rungs)
+    {
+        if (ts >= rung.GetCurrentStart())
+        {
+            return &rung;
+        }
+    }
+    return nullptr;
+}
+
+void
+LadderScheduler::InsertBottom(const Scheduler::Event& ev)
+{
+    m_bottom.insert(std::upper_bound(m_bottom.begin(), m_bottom.end(), ev, Later), ev);
+
+    // events keep landing before the ladder: give them a rung of their own
+    if (m_bottom.size() > m_threshold && m_rungs.size() < m_maxRungs &&
+        m_bottom.front().key.m_ts > m_bottom.back().key.m_ts)
+    {
+        uint64_t end = m_rungs.empty() ? m_topStart : m_rungs.back().GetCurrentStart();
+        AddRung(m_bottom.back().key.m_ts, end, m_bottom);
+    }
+}
+
+void
+LadderScheduler::Insert(const Event& ev)
+{
+    NS_LOG_FUNCTION(this << ev.impl << ev.key.m_ts << ev.key.m_uid);
+    uint64_t ts = ev.key.m_ts;
+    if (ts >= m_topStart)
+    {
+        m_top.push_back(ev);
+    }
+    else if (Rung* rung = FindRung(ts))
+    {
+        rung->buckets[rung->GetIndex(ts)].push_back(ev);
+        rung->size++;
+    }
+    else
+    {
+        InsertBottom(ev);
+    }
+    m_size++;
+}
+
+bool
+LadderScheduler::IsEmpty() const
+{
+    NS_LOG_FUNCTION(this);
+    return m_size == 0;
+}
+
+void
+LadderScheduler::FillBottom()
+{
+    while (m_bottom.empty() && m_size > 0)
+    {
+        if (m_rungs.empty())
+        {
+            // everything left is in Top
+            NS_ASSERT(!m_top.empty());
+            auto [min, max] = std::minmax_element(m_top.begin(), m_top.end());
+            m_topStart = AddRung(min->key.m_ts, max->key.m_ts + 1, m_top);
+            continue;
+        }
+
+        Rung& rung = m_rungs.back();
+        if (rung.size == 0)
+        {
+            m_rungs.pop_back();
+            continue;
+        }
+        while (rung.buckets[rung.current].empty())
+        {
+            rung.current++;
+        }
+        uint64_t start = rung.GetCurrentStart();
+        uint64_t width = rung.width;
+        Bucket& bucket = rung.buckets[rung.current];
+        rung.size -= bucket.size();
+        rung.current++;
+
+        if (bucket.size() > m_threshold && width > 1 && m_rungs.size() < m_maxRungs)
+        {
+            Bucket events;
+            events.swap(bucket);
+            AddRung(start, start + width, events);
+        }
+        else
+        {
+            m_bottom.swap(bucket);
+            std::sort(m_bottom.begin(), m_bottom.end(), Later);
+        }
+    }
+}
+
+Scheduler::Event
+LadderScheduler::PeekNext() const
+{
+    NS_LOG_FUNCTION(this);
+    NS_ASSERT(!IsEmpty());
+    // moving events down the ladder does not change the event set
+    const_cast<LadderScheduler*>(this)->FillBottom();
+    return m_bottom.back();
+}
+
+Scheduler::Event
+LadderScheduler::RemoveNext()
+{
+    NS_LOG_FUNCTION(this);
+    NS_ASSERT(!IsEmpty());
+    FillBottom();
+    Scheduler::Event ev = m_bottom.back();
+    m_bottom.pop_back();
+    m_size--;
+    NS_LOG_DEBUG("remove " << ev.key.m_ts << ", " << ev.key.m_uid);
+    return ev;
+}
+
+void
+LadderScheduler::Remove(const Event& ev)
+{
+    NS_LOG_FUNCTION(this << ev.impl << ev.key.m_ts << ev.key.m_uid);
+    uint64_t ts = ev.key.m_ts;
+    Rung* rung = ts < m_topStart ? FindRung(ts) : nullptr;
+    if (ts < m_topStart && !rung)
+    {
+        auto it = std::lower_bound(m_bottom.begin(), m_bottom.end(), ev, Later);
+        NS_ASSERT(it != m_bottom.end() && *it == ev);
+        m_bottom.erase(it);
+        m_size--;
+        return;
+    }
+
+    Bucket& bucket = rung ? rung->buckets[rung->GetIndex(ts)] : m_top;
+    auto it = std::find(bucket.begin(), bucket.end(), ev);
+    NS_ASSERT(it != bucket.end());
+    *it = bucket.back();
+    bucket.pop_back();
+    if (rung)
+    {
+        rung->size--;
+    }
+    m_size--;
+}
+
+} // namespace ns3
@@ -0,0 +1,165 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef LADDER_SCHEDULER_H
+#define LADDER_SCHEDULER_H
+
+#include "scheduler.h"
+
+#include <stdint.h>
+#include <vector>
+
+/**
+ * \file
+ * \ingroup scheduler
+ * ns3::LadderScheduler declaration.
+ */
+
+namespace ns3
+{
+
+/**
+ * \ingroup scheduler
+ * \brief a ladder queue event scheduler
+ *
+ * This event scheduler implements the ladder queue of
+ * ["Ladder Queue: An O(1) Priority Queue Structure for Large-Scale
+ * Discrete Event Simulation" by Wai Teng Tang, Rick Siow Mong Goh and
+ * Ian Li-Jin Thng][Tang].
+ *
+ * [Tang]: https://doi.org/10.1145/1103323.1103324 "Tang"
+ *
+ * Events are kept in three tiers:
+ *
+ * - *Top*, an unsorted vector of the events beyond the range of the
+ *   ladder, which is where most new events land.
+ * - The *ladder*, a stack of rungs of unsorted buckets. The first rung
+ *   is built from Top when everything before it has been dequeued, with
+ *   one bucket per event on average over the span of their timestamps.
+ *   When the bucket to dequeue next holds more than \c Threshold events,
+ *   it is split into a finer rung below instead of being sorted, so the
+ *   bucket widths adapt to bursts of close timestamps.
+ * - *Bottom*, a short sorted vector of the events to run next.
+ *
+ * Unlike the CalendarScheduler there is no resize: an event is moved at
+ * most once per rung before it reaches Bottom.
+ *
+ * \par Time Complexity
+ *
+ * Operation    | Amortized %Time | Reason
+ * :----------- | :-------------- | :-----
+ * Insert()     | ~Constant       | Append to Top or a bucket; Bottom holds few events
+ * IsEmpty()    | Constant        | Explicit queue size
+ * PeekNext()   | ~Constant       | Sort at most \c Threshold events into Bottom
+ * Remove()     | ~Constant       | Search within one bucket
+ * RemoveNext() | ~Constant       | Sort at most \c Threshold events into Bottom
+ *
+ * \par Memory Complexity
+ *
+ * Category  | Memory                           | Reason
+ * :-------- | :------------------------------- | :-----
+ * Overhead  | 3 x `std::vector`<br/>(72 bytes) | Top, ladder and Bottom
+ * Per Event | 0 to 2 x `sizeof (*)`            | Spare capacity of the vectors
+ *
+ */
+class LadderScheduler : public Scheduler
+{
+  public:
+    /**
+     *  Register this type.
+     *  \return The object TypeId.
+     */
+    static TypeId GetTypeId();
+
+    /** Constructor. */
+    LadderScheduler();
+    /** Destructor. */
+    ~LadderScheduler() override;
+
+    // Inherited
+    void Insert(const Scheduler::Event& ev) override;
+    bool IsEmpty() const override;
+    Scheduler::Event PeekNext() const override;
+    Scheduler::Event RemoveNext() override;
+    void Remove(const Scheduler::Event& ev) override;
+
+  private:
+    /** Bucket type: unsorted events. */
+    typedef std::vector<Scheduler::Event> Bucket;
+
+    /** A rung of the ladder: buckets of equal width over a time span. */
+    struct Rung
+    {
+        uint64_t start;              //!< Timestamp at the start of the first bucket.
+        uint64_t width;              //!< Width of a bucket, in dimensionless time units.
+        uint32_t current;            //!< Index of the next bucket to dequeue.
+        uint32_t size;               //!< Number of events in the buckets.
+        std::vector<Bucket> buckets; //!< The buckets.
+
+        /** \return The start of the next bucket to dequeue. */
+        uint64_t GetCurrentStart() const;
+        /**
+         * \param [in] ts A timestamp covered by the rung.
+         * \return The index of the bucket holding it.
+         */
+        uint32_t GetIndex(uint64_t ts) const;
+    };
+
+    /**
+     * Add a rung below the others, spanning a time range.
+     *
+     * \param [in] start The first timestamp of the range.
+     * \param [in] end The end of the range, exclusive.
+     * \param [in,out] events The events to spread over the buckets, all in
+     * the range; emptied.
+     * \returns The end of the time span covered by the new rung.
+     */
+    uint64_t AddRung(uint64_t start, uint64_t end, Bucket& events);
+    /**
+     * Find the rung an event belongs in.
+     *
+     * \param [in] ts The timestamp of the event, before the start of Top.
+     * \returns The rung, or null for Bottom.
+     */
+    Rung* FindRung(uint64_t ts);
+    /**
+     * Insert into Bottom, keeping it sorted.
+     *
+     * \param [in] ev The event.
+     */
+    void InsertBottom(const Scheduler::Event& ev);
+    /** Refill an empty Bottom from the ladder, or from Top. */
+    void FillBottom();
+
+    /** Events beyond the ladder. */
+    Bucket m_top;
+    /** First timestamp belonging to Top. */
+    uint64_t m_topStart;
+    /** The rungs, coarsest first. */
+    std::vector<Rung> m_rungs;
+    /** Sorted in decreasing order, the next event last. */
+    Bucket m_bottom;
+    /** Total number of events. */
+    uint32_t m_size;
+
+    /** Largest bucket sorted into Bottom rather than split into a rung. */
+    uint32_t m_threshold;
+    /** Maximum number of rungs. */
+    uint32_t m_maxRungs;
+};
+
+} // namespace ns3
+
+#endif /* LADDER_SCHEDULER_H */
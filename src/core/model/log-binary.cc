@@ -0,0 +1,661 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "log-binary.h"
+
+#include "fatal-error.h"
+#include "log.h"
+#include "nstime.h"
+#include "simulator.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef> // offsetof
+#include <cstdio>
+#include <cstdlib> // getenv
+#include <cstring>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+
+/**
+ * \file
+ * \ingroup logging
+ * ns3::LogRecorder, ns3::LogBinaryReader and the binary log file
+ * implementations.
+ */
+
+namespace ns3
+{
+
+static_assert(sizeof(LogRecord) == LogRecord::SIZE, "LogRecord must fill exactly SIZE bytes");
+
+std::atomic<bool> LogRecorder::m_enabled(false);
+
+/**
+ * \ingroup logging
+ * The ring buffer of the records of one thread.
+ *
+ * Written by its thread only, drained by the writer thread only.
+ */
+struct LogRing
+{
+    /** Number of records, a power of 2. */
+    static constexpr uint32_t SIZE = 4096;
+
+    /** The records. */
+    LogRecord records[SIZE];
+    /** Count of the records committed by the thread. */
+    std::atomic<uint64_t> head{0};
+    /** Count of the records written to the file. */
+    std::atomic<uint64_t> tail{0};
+    /** Index of the thread. */
+    uint16_t thread{0};
+};
+
+/**
+ * \ingroup logging
+ * The message being captured by a thread.
+ */
+struct LogWriter
+{
+    LogRing* ring{nullptr};   //!< The ring of the thread.
+    LogRecord* slot{nullptr}; //!< The record being filled, null outside of messages.
+    uint32_t total{0};        //!< Length of the text captured so far.
+};
+
+/**
+ * \ingroup logging
+ * The message being captured by the calling thread.
+ */
+static thread_local LogWriter g_logWriter;
+
+/**
+ * \ingroup logging
+ * The binary log file, its writer thread and the rings of all threads.
+ *
+ * This is private to the logging implementation.
+ */
+class LogBinarySink : public std::streambuf
+{
+  public:
+    /** Constructor, opens the \c NS_LOG_BINARY file if set. */
+    LogBinarySink();
+    /** Destructor, closes the file. */
+    ~LogBinarySink() override;
+
+    /**
+     * Open a file and start capturing the log messages.
+     * \param [in] filename The file name.
+     */
+    void Open(const std::string& filename);
+    /** Drain the rings, close the file and go back to text. */
+    void Close();
+    /**
+     * Drain the rings into the file and flush it.
+     *
+     * Gives up after a second if the writer thread is stuck, as it
+     * might be when called on a fatal error.
+     */
+    void Flush();
+
+    /** \return A new ring for the calling thread. */
+    LogRing* AddRing();
+    /** Wake up the writer thread. */
+    void Wake();
+
+  private:
+    /**
+     * Capture characters written on \c std::clog.
+     * \param [in] s The characters.
+     * \param [in] n The number of characters.
+     * \return The number of characters written.
+     */
+    std::streamsize xsputn(const char* s, std::streamsize n) override;
+    /**
+     * Capture a character written on \c std::clog.
+     * \param [in] c The character.
+     * \return The character, or \c EOF on error.
+     */
+    int_type overflow(int_type c) override;
+    /**
+     * Flush \c std::clog.
+     * \return 0 on success.
+     */
+    int sync() override;
+
+    /** Main loop of the writer thread. */
+    void WriterLoop();
+    /** Write the committed records of all rings to the file; m_mutex is held. */
+    void Drain();
+    /**
+     * Write a STRING record for an id, if not done yet.
+     * \param [in] id The id, the address of the string.
+     */
+    void WriteString(uint64_t id);
+
+    /** Protects the rings, the file and the strings. */
+    std::timed_mutex m_mutex;
+    /** Wakes up the writer thread. */
+    std::condition_variable_any m_wake;
+    /** The rings, never freed while the program runs. */
+    std::vector<std::unique_ptr<LogRing>> m_rings;
+    /** The file, null when closed. */
+    std::FILE* m_file;
+    /** The ids of the strings written to the file. */
+    std::unordered_set<uint64_t> m_strings;
+    /** The writer thread. */
+    std::thread m_writer;
+    /** Tells the writer thread to exit. */
+    bool m_stop;
+    /** The stream buffer of \c std::clog, receiving the text. */
+    std::streambuf* m_clog;
+};
+
+/**
+ * \ingroup logging
+ * \return The binary log sink.
+ */
+static LogBinarySink&
+GetLogBinarySink()
+{
+    static LogBinarySink sink;
+    return sink;
+}
+
+/**
+ * \ingroup logging
+ * Open the \c NS_LOG_BINARY file at startup.
+ */
+static LogBinarySink& g_logBinarySink [[maybe_unused]] = GetLogBinarySink();
+
+LogBinarySink::LogBinarySink()
+    : m_file(nullptr),
+      m_stop(false),
+      m_clog(nullptr)
+{
+    const char* envVar = std::getenv("NS_LOG_BINARY");
+    if (envVar != nullptr && std::strlen(envVar) != 0)
+    {
+        Open(envVar);
+    }
+}
+
+LogBinarySink::~LogBinarySink()
+{
+    Close();
+}
+
+void
+LogBinarySink::Open(const std::string& filename)
+{
+    Close();
+    m_file = std::fopen(filename.c_str(), "wb");
+    if (m_file == nullptr)
+    {
+        NS_FATAL_ERROR("Cannot open the binary log file \"" << filename << "\"");
+    }
+    {
+        // drop what was logged while no file was open
+        std::lock_guard<std::timed_mutex> lock(m_mutex);
+        for (auto& ring : m_rings)
+        {
+            ring->tail.store(ring->head.load(std::memory_order_acquire));
+        }
+    }
+    uint32_t size = LogRecord::SIZE;
+    std::fwrite(LogRecord::MAGIC, sizeof(LogRecord::MAGIC), 1, m_file);
+    std::fwrite(&size, sizeof(size), 1, m_file);
+    m_strings.clear();
+
+    m_clog = std::clog.rdbuf(this);
+    m_stop = false;
+    m_writer = std::thread(&LogBinarySink::WriterLoop, this);
+    LogRecorder::m_enabled.store(true, std::memory_order_relaxed);
+}
+
+void
+LogBinarySink::Close()
+{
+    if (m_file == nullptr)
+    {
+        return;
+    }
+    LogRecorder::m_enabled.store(false, std::memory_order_relaxed);
+    {
+        std::lock_guard<std::timed_mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_wake.notify_one();
+    m_writer.join();
+
+    std::lock_guard<std::timed_mutex> lock(m_mutex);
+    Drain();
+    std::fclose(m_file);
+    m_file = nullptr;
+    std::clog.rdbuf(m_clog);
+    m_clog = nullptr;
+}
+
+void
+LogBinarySink::Flush()
+{
+    std::unique_lock<std::timed_mutex> lock(m_mutex, std::chrono::seconds(1));
+    if (lock.owns_lock() && m_file != nullptr)
+    {
+        Drain();
+        std::fflush(m_file);
+    }
+}
+
+LogRing*
+LogBinarySink::AddRing()
+{
+    std::lock_guard<std::timed_mutex> lock(m_mutex);
+    m_rings.push_back(std::make_unique<LogRing>());
+    m_rings.back()->thread = m_rings.size() - 1;
+    return m_rings.back().get();
+}
+
+void
+LogBinarySink::Wake()
+{
+    m_wake.notify_one();
+}
+
+void
+LogBinarySink::WriterLoop()
+{
+    std::unique_lock<std::timed_mutex> lock(m_mutex);
+    while (!m_stop)
+    {
+        Drain();
+        m_wake.wait_for(lock, std::chrono::milliseconds(10));
+    }
+}
+
+void
+LogBinarySink::WriteString(uint64_t id)
+{
+    if (id == 0 || !m_strings.insert(id).second)
+    {
+        return;
+    }
+    const char* s = reinterpret_cast<const char*>(id);
+    std::size_t length = std::strlen(s);
+    LogRecord record;
+    std::memset(&record, 0, sizeof(record));
+    record.component = id;
+    record.kind = LogRecord::STRING;
+    record.thread = 0xffff;
+    do
+    {
+        record.length = std::min<std::size_t>(length, LogRecord::TEXT_SIZE);
+        std::memcpy(record.text, s, record.length);
+        s += record.length;
+        length -= record.length;
+        record.flags = length > 0 ? LogRecord::MORE : 0;
+        std::fwrite(&record, sizeof(record), 1, m_file);
+    } while (length > 0);
+}
+
+void
+LogBinarySink::Drain()
+{
+    for (auto& ring : m_rings)
+    {
+        uint64_t tail = ring->tail.load(std::memory_order_relaxed);
+        uint64_t head = ring->head.load(std::memory_order_acquire);
+        if (tail == head)
+        {
+            continue;
+        }
+        for (uint64_t i = tail; i != head; i++)
+        {
+            const LogRecord& record = ring->records[i % LogRing::SIZE];
+            WriteString(record.component);
+            WriteString(record.function);
+        }
+        // at most two contiguous spans
+        uint64_t first = tail % LogRing::SIZE;
+        uint64_t n = std::min<uint64_t>(head - tail, LogRing::SIZE - first);
+        std::fwrite(&ring->records[first], sizeof(LogRecord), n, m_file);
+        std::fwrite(&ring->records[0], sizeof(LogRecord), head - tail - n, m_file);
+        ring->tail.store(head, std::memory_order_release);
+    }
+}
+
+/**
+ * \ingroup logging
+ * Get a free record in the ring of the calling thread, waiting for the
+ * writer thread if it is full.
+ * \param [in] writer The state of the calling thread.
+ * \return The record.
+ */
+static LogRecord*
+AcquireRecord(LogWriter& writer)
+{
+    LogRing* ring = writer.ring;
+    uint64_t head = ring->head.load(std::memory_order_relaxed);
+    while (head - ring->tail.load(std::memory_order_acquire) >= LogRing::SIZE)
+    {
+        GetLogBinarySink().Wake();
+        std::this_thread::yield();
+    }
+    return &ring->records[head % LogRing::SIZE];
+}
+
+/**
+ * \ingroup logging
+ * Commit the record being filled by the calling thread.
+ * \param [in] writer The state of the calling thread.
+ */
+static void
+CommitRecord(LogWriter& writer)
+{
+    LogRing* ring = writer.ring;
+    uint64_t head = ring->head.load(std::memory_order_relaxed) + 1;
+    ring->head.store(head, std::memory_order_release);
+    if (head - ring->tail.load(std::memory_order_relaxed) == LogRing::SIZE / 2)
+    {
+        GetLogBinarySink().Wake();
+    }
+}
+
+std::streamsize
+LogBinarySink::xsputn(const char* s, std::streamsize n)
+{
+    LogWriter& writer = g_logWriter;
+    if (writer.slot == nullptr)
+    {
+        return m_clog->sputn(s, n);
+    }
+    std::streamsize left = n;
+    while (left > 0)
+    {
+        LogRecord* slot = writer.slot;
+        if (slot->length == LogRecord::TEXT_SIZE)
+        {
+            // continue in the next record, with the same header
+            slot->flags |= LogRecord::MORE;
+            CommitRecord(writer);
+            writer.slot = AcquireRecord(writer);
+            std::memcpy(writer.slot, slot, offsetof(LogRecord, text));
+            writer.slot->flags &= ~LogRecord::MORE;
+            writer.slot->length = 0;
+            slot = writer.slot;
+        }
+        std::streamsize count = std::min<std::streamsize>(left, LogRecord::TEXT_SIZE - slot->length);
+        std::memcpy(slot->text + slot->length, s, count);
+        slot->length += count;
+        writer.total += count;
+        s += count;
+        left -= count;
+    }
+    return n;
+}
+
+LogBinarySink::int_type
+LogBinarySink::overflow(int_type c)
+{
+    if (traits_type::eq_int_type(c, traits_type::eof()))
+    {
+        return traits_type::not_eof(c);
+    }
+    char ch = traits_type::to_char_type(c);
+    return xsputn(&ch, 1) == 1 ? c : traits_type::eof();
+}
+
+int
+LogBinarySink::sync()
+{
+    if (g_logWriter.slot == nullptr)
+    {
+        return m_clog->pubsync();
+    }
+    return 0;
+}
+
+bool
+LogRecorder::Begin(const LogComponent& component,
+                   int32_t level,
+                   const char* function,
+                   uint8_t kind)
+{
+    LogWriter& writer = g_logWriter;
+    if (writer.slot != nullptr)
+    {
+        return false;
+    }
+    if (writer.ring == nullptr)
+    {
+        writer.ring = GetLogBinarySink().AddRing();
+    }
+    LogRecord* slot = AcquireRecord(writer);
+    slot->component = reinterpret_cast<uint64_t>(component.Name());
+    slot->function = reinterpret_cast<uint64_t>(function);
+    slot->level = level;
+    for (auto prefix : {LOG_PREFIX_FUNC, LOG_PREFIX_TIME, LOG_PREFIX_NODE, LOG_PREFIX_LEVEL})
+    {
+        if (component.IsEnabled(prefix))
+        {
+            slot->level |= prefix;
+        }
+    }
+    slot->thread = writer.ring->thread;
+    slot->contextLength = 0;
+    slot->length = 0;
+    slot->kind = kind;
+    slot->flags = 0;
+    slot->time = 0;
+    slot->context = Simulator::NO_CONTEXT;
+    slot->resolution = 0;
+    writer.slot = slot;
+    writer.total = 0;
+
+    // as the text prefixes, only once the simulator exists; not before,
+    // as the Time resolution itself logs while it is initialized
+    if (LogGetTimePrinter() != nullptr)
+    {
+        slot->time = Simulator::Now().GetTimeStep();
+        slot->resolution = Time::GetResolution();
+        slot->flags |= LogRecord::HAS_TIME;
+    }
+    if (LogGetNodePrinter() != nullptr)
+    {
+        slot->context = Simulator::GetContext();
+        slot->flags |= LogRecord::HAS_NODE;
+    }
+    return true;
+}
+
+void
+LogRecorder::DoEndContext()
+{
+    LogWriter& writer = g_logWriter;
+    writer.slot->contextLength = writer.total;
+}
+
+void
+LogRecorder::End()
+{
+    LogWriter& writer = g_logWriter;
+    CommitRecord(writer);
+    writer.slot = nullptr;
+}
+
+void
+LogSetBinaryFile(const std::string& filename)
+{
+    if (filename.empty())
+    {
+        GetLogBinarySink().Close();
+    }
+    else
+    {
+        GetLogBinarySink().Open(filename);
+    }
+}
+
+void
+LogFlushBinary()
+{
+    // also called by the static destructors, maybe after the sink's
+    if (LogRecorder::m_enabled.load(std::memory_order_relaxed))
+    {
+        GetLogBinarySink().Flush();
+    }
+}
+
+bool
+LogBinaryReader::Open(const std::string& filename)
+{
+    m_file.open(filename, std::ios::binary);
+    char magic[sizeof(LogRecord::MAGIC)];
+    uint32_t size = 0;
+    m_file.read(magic, sizeof(magic));
+    m_file.read(reinterpret_cast<char*>(&size), sizeof(size));
+    m_strings.clear();
+    m_pending.clear();
+    return m_file && std::memcmp(magic, LogRecord::MAGIC, sizeof(magic)) == 0 &&
+           size == LogRecord::SIZE;
+}
+
+bool
+LogBinaryReader::ReadRecord(LogRecord& record)
+{
+    return bool(m_file.read(reinterpret_cast<char*>(&record), sizeof(record)));
+}
+
+bool
+LogBinaryReader::Read(Message& message)
+{
+    LogRecord record;
+    while (ReadRecord(record))
+    {
+        auto it = m_pending.find(record.thread);
+        if (it == m_pending.end())
+        {
+            it = m_pending.emplace(record.thread, Message()).first;
+            Message& first = it->second;
+            first.time = record.time;
+            first.context = record.context;
+            first.level = record.level;
+            first.thread = record.thread;
+            first.kind = record.kind;
+            first.flags = record.flags & ~LogRecord::MORE;
+            first.resolution = record.resolution;
+            if (record.kind != LogRecord::STRING)
+            {
+                first.component = m_strings[record.component];
+                first.function = m_strings[record.function];
+            }
+        }
+        Message& pending = it->second;
+        pending.contextLength = record.contextLength;
+        pending.text.append(record.text, record.length);
+        if (record.flags & LogRecord::MORE)
+        {
+            continue;
+        }
+
+        if (record.kind == LogRecord::STRING)
+        {
+            m_strings[record.component] = pending.text;
+            m_pending.erase(it);
+            continue;
+        }
+        message = std::move(pending);
+        m_pending.erase(it);
+        return true;
+    }
+    return false;
+}
+
+std::string
+LogBinaryReader::Format(const Message& message)
+{
+    std::ostringstream os;
+    if ((message.level & LOG_PREFIX_TIME) && (message.flags & LogRecord::HAS_TIME))
+    {
+        std::ios_base::fmtflags ff = os.flags();
+        std::streamsize oldPrecision = os.precision();
+        auto resolution = static_cast<Time::Unit>(message.resolution);
+        if (Time::GetResolution() != resolution)
+        {
+            Time::SetResolution(resolution);
+        }
+        // as DefaultTimePrinter
+        os << std::fixed;
+        switch (resolution)
+        {
+        case Time::US:
+            os << std::setprecision(6);
+            break;
+        case Time::NS:
+            os << std::setprecision(9);
+            break;
+        case Time::PS:
+            os << std::setprecision(12);
+            break;
+        case Time::FS:
+            os << std::setprecision(15);
+            break;
+        default:
+            os << std::setprecision(5);
+        }
+        os << TimeStep(message.time).As(Time::S) << " ";
+        os << std::setprecision(oldPrecision);
+        os.flags(ff);
+    }
+    if ((message.level & LOG_PREFIX_NODE) && (message.flags & LogRecord::HAS_NODE))
+    {
+        if (message.context == Simulator::NO_CONTEXT)
+        {
+            os << "-1 ";
+        }
+        else
+        {
+            os << message.context << " ";
+        }
+    }
+    std::size_t contextLength = std::min<std::size_t>(message.contextLength, message.text.size());
+    os << message.text.substr(0, contextLength);
+    if (message.kind == LogRecord::FUNCTION)
+    {
+        os << message.component << ":" << message.function << "("
+           << message.text.substr(contextLength) << ")";
+    }
+    else
+    {
+        if (message.level & LOG_PREFIX_FUNC)
+        {
+            os << message.component << ":" << message.function << "(): ";
+        }
+        if (message.level & LOG_PREFIX_LEVEL)
+        {
+            auto level = static_cast<LogLevel>(message.level & ~LOG_PREFIX_ALL);
+            os << "[" << LogComponent::GetLevelLabel(level) << "] ";
+        }
+        os << message.text.substr(contextLength);
+    }
+    return os.str();
+}
+
+} // namespace ns3
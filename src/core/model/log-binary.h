@@ -0,0 +1,284 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef NS3_LOG_BINARY_H
+#define NS3_LOG_BINARY_H
+
+#include <atomic>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <stdint.h>
+#include <string>
+#include <unordered_map>
+
+/**
+ * \file
+ * \ingroup logging
+ * ns3::LogRecord, ns3::LogRecorder and ns3::LogBinaryReader declarations.
+ */
+
+namespace ns3
+{
+
+class LogComponent;
+
+/**
+ * \ingroup logging
+ *
+ * Write the log messages to a binary file rather than as text on \c std::clog.
+ *
+ * Each message is stored as one or more fixed-size LogRecord, holding the
+ * log component, level, function, simulation time and context, and the
+ * formatted message. The prefixes are not formatted: they are rendered
+ * by the \c log-decode utility, which prints the file in the text format
+ * of \c std::clog and can filter it. The records are written into a ring
+ * buffer per thread, which a background thread drains into the file.
+ *
+ * Same as running your program with the \c NS_LOG_BINARY environment
+ * variable set to the file name. The log components are still enabled
+ * with \c NS_LOG or LogComponentEnable().
+ *
+ * Custom TimePrinter and NodePrinter functions do not apply to the
+ * binary file, which always holds the simulation time and context.
+ * NS_LOG_UNCOND() messages, and anything else written on \c std::clog,
+ * are still written as text.
+ *
+ * This should be called while no other thread is logging.
+ *
+ * \param [in] filename The file to write, truncated; empty to close the
+ * current file and go back to text.
+ */
+void LogSetBinaryFile(const std::string& filename);
+
+/**
+ * \ingroup logging
+ *
+ * Write the pending binary log records to the file.
+ *
+ * Called on fatal errors, before the program aborts, and when a
+ * LogComponent is destroyed, since the records refer to its name.
+ */
+void LogFlushBinary();
+
+/**
+ * \ingroup logging
+ *
+ * A fixed-size record of a binary log file.
+ *
+ * A file starts with the 8 bytes of MAGIC followed by the record size
+ * as an \c uint32_t, then holds the records in host byte order. The
+ * log component and function names are referenced by an id, defined by
+ * a STRING record before the first record using it. A message longer
+ * than a record continues in the next records of the same thread,
+ * which might be interleaved with records of other threads.
+ */
+struct LogRecord
+{
+    /** Record kinds. */
+    enum Kind : uint8_t
+    {
+        MESSAGE = 0,  //!< NS_LOG() and friends.
+        FUNCTION = 1, //!< NS_LOG_FUNCTION() and NS_LOG_FUNCTION_NOARGS().
+        STRING = 2,   //!< Definition of the string \c component.
+    };
+
+    /** Record flags. */
+    enum Flags : uint8_t
+    {
+        MORE = 0x01,     //!< The text continues in the next record of the thread.
+        HAS_TIME = 0x02, //!< The simulation time was available.
+        HAS_NODE = 0x04, //!< The context was available.
+    };
+
+    /** Size of a record, in bytes. */
+    static constexpr uint32_t SIZE = 256;
+    /** Size of the text of a record, in bytes. */
+    static constexpr uint32_t TEXT_SIZE = SIZE - 42;
+    /** First bytes of a binary log file. */
+    static constexpr char MAGIC[8] = {'n', 's', '3', 'b', 'l', 'o', 'g', '1'};
+
+    int64_t time;           //!< Simulation time, in time steps.
+    uint64_t component;     //!< Log component name id, or id defined by a STRING.
+    uint64_t function;      //!< Function name id.
+    uint32_t context;       //!< Simulation context.
+    uint32_t level;         //!< Log level, with the prefixes enabled for the component.
+    uint16_t thread;        //!< Index of the thread which logged the message.
+    uint16_t contextLength; //!< Length of the text written by NS_LOG_APPEND_CONTEXT.
+    uint16_t length;        //!< Length of the text in this record.
+    uint8_t kind;           //!< Record kind.
+    uint8_t flags;          //!< Record flags.
+    uint8_t resolution;     //!< Time::Unit of the time steps.
+    uint8_t reserved;       //!< Padding.
+    char text[TEXT_SIZE];   //!< Message text, not null-terminated.
+};
+
+/**
+ * \ingroup logging
+ *
+ * Capture one log message into the binary log file.
+ *
+ * The logging macros make one on the stack for the duration of each
+ * message. When a binary log file is open, the text written on
+ * \c std::clog by the calling thread is captured into the records of
+ * the message, and the time, node, function and level prefixes are left
+ * to the decoder. Otherwise the message is written as text, terminated
+ * by \c std::endl when the LogRecorder goes out of scope.
+ *
+ * \internal
+ * Logging implementation class; should not be used directly.
+ */
+class LogRecorder
+{
+  public:
+    /**
+     * Start a message.
+     *
+     * \param [in] component The log component.
+     * \param [in] level The log level.
+     * \param [in] function The function name, a string literal.
+     * \param [in] kind The LogRecord::Kind of the message.
+     */
+    LogRecorder(const LogComponent& component, int32_t level, const char* function, uint8_t kind)
+        : m_active(m_enabled.load(std::memory_order_relaxed))
+    {
+        if (m_active)
+        {
+            m_active = Begin(component, level, function, kind);
+        }
+    }
+
+    /** End the message. */
+    ~LogRecorder()
+    {
+        if (m_active)
+        {
+            End();
+        }
+        else
+        {
+            std::clog << std::endl;
+        }
+    }
+
+    /** \return Whether the message is captured into the binary file. */
+    bool IsActive() const
+    {
+        return m_active;
+    }
+
+    /** Mark the end of the text written by NS_LOG_APPEND_CONTEXT. */
+    void EndContext()
+    {
+        if (m_active)
+        {
+            DoEndContext();
+        }
+    }
+
+  private:
+    friend class LogBinarySink;
+    friend void LogFlushBinary();
+
+    /**
+     * Start capturing a message.
+     * \param [in] component The log component.
+     * \param [in] level The log level.
+     * \param [in] function The function name.
+     * \param [in] kind The LogRecord::Kind of the message.
+     * \return \c false when the thread is already capturing a message,
+     * which then gets the text of this one.
+     */
+    bool Begin(const LogComponent& component, int32_t level, const char* function, uint8_t kind);
+    /** Commit the captured message. */
+    void End();
+    /** Implementation of EndContext(). */
+    void DoEndContext();
+
+    /** Whether the message is captured. */
+    bool m_active;
+    /** Whether a binary log file is open. */
+    static std::atomic<bool> m_enabled;
+};
+
+/**
+ * \ingroup logging
+ *
+ * Read the messages of a binary log file.
+ */
+class LogBinaryReader
+{
+  public:
+    /** A log message, reassembled from its records. */
+    struct Message
+    {
+        int64_t time;           //!< Simulation time, in time steps.
+        uint32_t context;       //!< Simulation context.
+        uint32_t level;         //!< Log level and enabled prefixes.
+        uint16_t thread;        //!< Index of the thread which logged the message.
+        uint8_t kind;           //!< LogRecord::Kind.
+        uint8_t flags;          //!< LogRecord::Flags, without MORE.
+        uint8_t resolution;     //!< Time::Unit of the time steps.
+        uint32_t contextLength; //!< Length of the text written by NS_LOG_APPEND_CONTEXT.
+        std::string component;  //!< Log component name.
+        std::string function;   //!< Function name.
+        std::string text;       //!< Message text.
+    };
+
+    /**
+     * Open a binary log file.
+     * \param [in] filename The file name.
+     * \return \c false if the file cannot be read or is not a binary log file.
+     */
+    bool Open(const std::string& filename);
+
+    /**
+     * Read the next message.
+     * \param [out] message The message.
+     * \return \c false at the end of the file.
+     */
+    bool Read(Message& message);
+
+    /**
+     * Render a message in the text format of \c std::clog, without the
+     * final newline.
+     *
+     * The simulation time is rendered at the resolution of the message,
+     * which becomes the Time resolution of the calling program.
+     *
+     * \param [in] message The message.
+     * \return The text.
+     */
+    static std::string Format(const Message& message);
+
+  private:
+    /**
+     * Read the next record.
+     * \param [out] record The record.
+     * \return \c false at the end of the file.
+     */
+    bool ReadRecord(LogRecord& record);
+
+    /** The file. */
+    std::ifstream m_file;
+    /** The strings defined so far, by id. */
+    std::unordered_map<uint64_t, std::string> m_strings;
+    /** The messages continued in later records, by thread. */
+    std::map<uint16_t, Message> m_pending;
+};
+
+} // namespace ns3
+
+#endif /* NS3_LOG_BINARY_H */
@@ -184,12 +184,20 @@
     {                                                                                              \
         if (g_log.IsEnabled(level))                                                                \
         {                                                                                          \
-            NS_LOG_APPEND_TIME_PREFIX;                                                             \
-            NS_LOG_APPEND_NODE_PREFIX;                                                             \
+            ns3::LogRecorder ns3LogRecorder(g_log, level, __FUNCTION__, ns3::LogRecord::MESSAGE);  \
+            if (!ns3LogRecorder.IsActive())                                                        \
+            {                                                                                      \
+                NS_LOG_APPEND_TIME_PREFIX;                                                         \
+                NS_LOG_APPEND_NODE_PREFIX;                                                         \
+            }                                                                                      \
             NS_LOG_APPEND_CONTEXT;                                                                 \
-            NS_LOG_APPEND_FUNC_PREFIX;                                                             \
-            NS_LOG_APPEND_LEVEL_PREFIX(level);                                                     \
-            std::clog << msg << std::endl;                                                         \
+            ns3LogRecorder.EndContext();                                                           \
+            if (!ns3LogRecorder.IsActive())                                                        \
+            {                                                                                      \
+                NS_LOG_APPEND_FUNC_PREFIX;                                                         \
+                NS_LOG_APPEND_LEVEL_PREFIX(level);                                                 \
+            }                                                                                      \
+            std::clog << msg;                                                                      \
         }                                                                                          \
     } while (false)
 
@@ -207,10 +215,21 @@
     {                                                                                              \
         if (g_log.IsEnabled(ns3::LOG_FUNCTION))                                                    \
         {                                                                                          \
-            NS_LOG_APPEND_TIME_PREFIX;                                                             \
-            NS_LOG_APPEND_NODE_PREFIX;                                                             \
+            ns3::LogRecorder ns3LogRecorder(g_log,                                                 \
+                                            ns3::LOG_FUNCTION,                                     \
+                                            __FUNCTION__,                                          \
+                                            ns3::LogRecord::FUNCTION);                             \
+            if (!ns3LogRecorder.IsActive())                                                        \
+            {                                                                                      \
+                NS_LOG_APPEND_TIME_PREFIX;                                                         \
+                NS_LOG_APPEND_NODE_PREFIX;                                                         \
+            }                                                                                      \
             NS_LOG_APPEND_CONTEXT;                                                                 \
-            std::clog << g_log.Name() << ":" << __FUNCTION__ << "()" << std::endl;                 \
+            ns3LogRecorder.EndContext();                                                           \
+            if (!ns3LogRecorder.IsActive())                                                        \
+            {                                                                                      \
+                std::clog << g_log.Name() << ":" << __FUNCTION__ << "()";                          \
+            }                                                                                      \
         }                                                                                          \
     } while (false)
 
@@ -241,12 +260,26 @@
     {                                                                                              \
         if (g_log.IsEnabled(ns3::LOG_FUNCTION))                                                    \
         {                                                                                          \
-            NS_LOG_APPEND_TIME_PREFIX;                                                             \
-            NS_LOG_APPEND_NODE_PREFIX;                                                             \
+            ns3::LogRecorder ns3LogRecorder(g_log,                                                 \
+                                            ns3::LOG_FUNCTION,                                     \
+                                            __FUNCTION__,                                          \
+                                            ns3::LogRecord::FUNCTION);                             \
+            if (!ns3LogRecorder.IsActive())                                                        \
+            {                                                                                      \
+                NS_LOG_APPEND_TIME_PREFIX;                                                         \
+                NS_LOG_APPEND_NODE_PREFIX;                                                         \
+            }                                                                                      \
             NS_LOG_APPEND_CONTEXT;                                                                 \
-            std::clog << g_log.Name() << ":" << __FUNCTION__ << "(";                               \
+            ns3LogRecorder.EndContext();                                                           \
+            if (!ns3LogRecorder.IsActive())                                                        \
+            {                                                                                      \
+                std::clog << g_log.Name() << ":" << __FUNCTION__ << "(";                           \
+            }                                                                                      \
             ns3::ParameterLogger(std::clog) << parameters;                                         \
-            std::clog << ")" << std::endl;                                                         \
+            if (!ns3LogRecorder.IsActive())                                                        \
+            {                                                                                      \
+                std::clog << ")";                                                                  \
+            }                                                                                      \
         }                                                                                          \
     } while (false)
 
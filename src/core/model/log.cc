@@ -275,6 +275,11 @@ LogComponent::EnvVarCheck()
     }
 }
 
+LogComponent::~LogComponent()
+{
+    LogFlushBinary();
+}
+
 bool
 LogComponent::IsEnabled(const enum LogLevel level) const
 {
@@ -20,6 +20,7 @@
 #ifndef NS3_LOG_H
 #define NS3_LOG_H
 
+#include "log-binary.h"
 #include "log-macros-disabled.h"
 #include "log-macros-enabled.h"
 #include "node-printer.h"
@@ -81,6 +82,16 @@
  *   NS_LOG_FUNCTION (this << arg1 << args);
  * \endcode
  * Use NS_LOG_FUNCTION_NOARGS() only in static functions with no arguments.
+ *
+ * Formatting every message on \c std::clog is slow. To log a lot, set the
+ * \c NS_LOG_BINARY environment variable to a file name, or call
+ * ns3::LogSetBinaryFile: the messages are then written to that file in a
+ * compact binary format, without their prefixes, by a background thread.
+ * The \c log-decode utility prints the file as text, optionally filtered:
+ * \code
+ *   $ NS_LOG='*=level_debug|prefix_all' NS_LOG_BINARY=run.log ./ns3 run ...
+ *   $ ./ns3 run "log-decode --file=run.log --component=Ipv4L3Protocol"
+ * \endcode
  */
 /** @{ */
 
@@ -339,6 +350,13 @@ class LogComponent
     LogComponent(const std::string& name,
                  const std::string& file,
                  const enum LogLevel mask = LOG_NONE);
+    /**
+     * Destructor.
+     *
+     * Writes the pending binary log records, which refer to the name
+     * of the component.
+     */
+    ~LogComponent();
     /**
      * Check if this LogComponent is enabled for \c level
      *
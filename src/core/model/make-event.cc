@@ -20,10 +20,22 @@
 
 #include "log.h"
 
+#include <sstream>
+#include <unordered_map>
+
+#ifndef __WIN32__
+#include <dlfcn.h>
+#endif
+
+#if (__GNUC__ >= 3)
+#include <cstdlib>
+#include <cxxabi.h>
+#endif
+
 /**
  * \file
  * \ingroup events
- * ns3::MakeEvent(void(*f)()) implementation.
+ * ns3::MakeEvent(void(*f)()) and ns3::GetEventFunctionName() implementations.
  */
 
 namespace ns3
@@ -31,6 +43,49 @@ namespace ns3
 
 NS_LOG_COMPONENT_DEFINE("MakeEvent");
 
+std::string
+GetEventFunctionName(const void* function)
+{
+    // the symbol tables are searched once per function
+    static thread_local std::unordered_map<const void*, std::string> names;
+    auto it = names.find(function);
+    if (it != names.end())
+    {
+        return it->second;
+    }
+
+    std::string name;
+#ifndef __WIN32__
+    Dl_info info;
+    if (dladdr(function, &info) != 0)
+    {
+        if (info.dli_sname != nullptr)
+        {
+            name = info.dli_sname;
+#if (__GNUC__ >= 3)
+            int status;
+            char* demangled = abi::__cxa_demangle(name.c_str(), nullptr, nullptr, &status);
+            if (status == 0)
+            {
+                name = demangled;
+            }
+            std::free(demangled);
+#endif
+        }
+        else if (info.dli_fname != nullptr)
+        {
+            // unlike the address, the offset does not change from run to run
+            std::ostringstream oss;
+            oss << info.dli_fname << "+0x" << std::hex
+                << static_cast<const char*>(function) - static_cast<const char*>(info.dli_fbase);
+            name = oss.str();
+        }
+    }
+#endif
+    names.emplace(function, name);
+    return name;
+}
+
 // This is the only non-templated version of MakeEvent.
 EventImpl*
 MakeEvent(void (*f)())
@@ -58,6 +113,11 @@ MakeEvent(void (*f)())
             (*m_function)();
         }
 
+        std::string GetTargetName() const override
+        {
+            return GetEventFunctionName(reinterpret_cast<const void*>(m_function));
+        }
+
       private:
         F m_function;
     }* ev = new EventFunctionImpl0(f);
@@ -351,8 +351,12 @@ EventImpl* MakeEvent(T function);
  ********************************************************************/
 
 #include "event-impl.h"
+#include "object-base.h"
 #include "type-traits.h"
 
+#include <string>
+#include <type_traits>
+
 namespace ns3
 {
 
@@ -392,6 +396,39 @@ struct EventMemberImplObjTraits<T*>
     }
 };
 
+/**
+ * \ingroup makeeventmemptr
+ * The target name of the events which call a class method.
+ *
+ * \tparam T \deduced The class type.
+ * \param [in] obj The object the method is called on.
+ * \return The TypeId name of \pname{obj} if it is an ObjectBase, else an
+ *         empty string, the event type already naming the class.
+ */
+template <typename T>
+std::string
+GetEventTargetName(const T& obj)
+{
+    if constexpr (std::is_base_of<ObjectBase, T>::value)
+    {
+        return obj.GetInstanceTypeId().GetName();
+    }
+    else
+    {
+        return std::string();
+    }
+}
+
+/**
+ * \ingroup makeeventfnptr
+ * The target name of the events which call a function.
+ *
+ * \param [in] function The address of the function.
+ * \return The demangled symbol of the function or, for a function without
+ *         one in the dynamic symbol table, its offset in the file holding it.
+ */
+std::string GetEventFunctionName(const void* function);
+
 template <typename MEM, typename OBJ>
 EventImpl*
 MakeEvent(MEM mem_ptr, OBJ obj)
@@ -416,6 +453,11 @@ MakeEvent(MEM mem_ptr, OBJ obj)
             (EventMemberImplObjTraits<OBJ>::GetReference(m_obj).*m_function)();
         }
 
+        std::string GetTargetName() const override
+        {
+            return GetEventTargetName(EventMemberImplObjTraits<OBJ>::GetReference(m_obj));
+        }
+
         OBJ m_obj;
         MEM m_function;
     }* ev = new EventMemberImpl0(obj, mem_ptr);
@@ -449,6 +491,11 @@ MakeEvent(MEM mem_ptr, OBJ obj, T1 a1)
             (EventMemberImplObjTraits<OBJ>::GetReference(m_obj).*m_function)(m_a1);
         }
 
+        std::string GetTargetName() const override
+        {
+            return GetEventTargetName(EventMemberImplObjTraits<OBJ>::GetReference(m_obj));
+        }
+
         OBJ m_obj;
         MEM m_function;
         typename TypeTraits<T1>::ReferencedType m_a1;
@@ -484,6 +531,11 @@ MakeEvent(MEM mem_ptr, OBJ obj, T1 a1, T2 a2)
             (EventMemberImplObjTraits<OBJ>::GetReference(m_obj).*m_function)(m_a1, m_a2);
         }
 
+        std::string GetTargetName() const override
+        {
+            return GetEventTargetName(EventMemberImplObjTraits<OBJ>::GetReference(m_obj));
+        }
+
         OBJ m_obj;
         MEM m_function;
         typename TypeTraits<T1>::ReferencedType m_a1;
@@ -521,6 +573,11 @@ MakeEvent(MEM mem_ptr, OBJ obj, T1 a1, T2 a2, T3 a3)
             (EventMemberImplObjTraits<OBJ>::GetReference(m_obj).*m_function)(m_a1, m_a2, m_a3);
         }
 
+        std::string GetTargetName() const override
+        {
+            return GetEventTargetName(EventMemberImplObjTraits<OBJ>::GetReference(m_obj));
+        }
+
         OBJ m_obj;
         MEM m_function;
         typename TypeTraits<T1>::ReferencedType m_a1;
@@ -561,6 +618,11 @@ MakeEvent(MEM mem_ptr, OBJ obj, T1 a1, T2 a2, T3 a3, T4 a4)
              m_function)(m_a1, m_a2, m_a3, m_a4);
         }
 
+        std::string GetTargetName() const override
+        {
+            return GetEventTargetName(EventMemberImplObjTraits<OBJ>::GetReference(m_obj));
+        }
+
         OBJ m_obj;
         MEM m_function;
         typename TypeTraits<T1>::ReferencedType m_a1;
@@ -609,6 +671,11 @@ MakeEvent(MEM mem_ptr, OBJ obj, T1 a1, T2 a2, T3 a3, T4 a4, T5 a5)
              m_function)(m_a1, m_a2, m_a3, m_a4, m_a5);
         }
 
+        std::string GetTargetName() const override
+        {
+            return GetEventTargetName(EventMemberImplObjTraits<OBJ>::GetReference(m_obj));
+        }
+
         OBJ m_obj;
         MEM m_function;
         typename TypeTraits<T1>::ReferencedType m_a1;
@@ -660,6 +727,11 @@ MakeEvent(MEM mem_ptr, OBJ obj, T1 a1, T2 a2, T3 a3, T4 a4, T5 a5, T6 a6)
              m_function)(m_a1, m_a2, m_a3, m_a4, m_a5, m_a6);
         }
 
+        std::string GetTargetName() const override
+        {
+            return GetEventTargetName(EventMemberImplObjTraits<OBJ>::GetReference(m_obj));
+        }
+
         OBJ m_obj;
         MEM m_function;
         typename TypeTraits<T1>::ReferencedType m_a1;
@@ -700,6 +772,11 @@ MakeEvent(void (*f)(U1), T1 a1)
             (*m_function)(m_a1);
         }
 
+        std::string GetTargetName() const override
+        {
+            return GetEventFunctionName(reinterpret_cast<const void*>(m_function));
+        }
+
         F m_function;
         typename TypeTraits<T1>::ReferencedType m_a1;
     }* ev = new EventFunctionImpl1(f, a1);
@@ -735,6 +812,11 @@ MakeEvent(void (*f)(U1, U2), T1 a1, T2 a2)
             (*m_function)(m_a1, m_a2);
         }
 
+        std::string GetTargetName() const override
+        {
+            return GetEventFunctionName(reinterpret_cast<const void*>(m_function));
+        }
+
         F m_function;
         typename TypeTraits<T1>::ReferencedType m_a1;
         typename TypeTraits<T2>::ReferencedType m_a2;
@@ -772,6 +854,11 @@ MakeEvent(void (*f)(U1, U2, U3), T1 a1, T2 a2, T3 a3)
             (*m_function)(m_a1, m_a2, m_a3);
         }
 
+        std::string GetTargetName() const override
+        {
+            return GetEventFunctionName(reinterpret_cast<const void*>(m_function));
+        }
+
         F m_function;
         typename TypeTraits<T1>::ReferencedType m_a1;
         typename TypeTraits<T2>::ReferencedType m_a2;
@@ -818,6 +905,11 @@ MakeEvent(void (*f)(U1, U2, U3, U4), T1 a1, T2 a2, T3 a3, T4 a4)
             (*m_function)(m_a1, m_a2, m_a3, m_a4);
         }
 
+        std::string GetTargetName() const override
+        {
+            return GetEventFunctionName(reinterpret_cast<const void*>(m_function));
+        }
+
         F m_function;
         typename TypeTraits<T1>::ReferencedType m_a1;
         typename TypeTraits<T2>::ReferencedType m_a2;
@@ -868,6 +960,11 @@ MakeEvent(void (*f)(U1, U2, U3, U4, U5), T1 a1, T2 a2, T3 a3, T4 a4, T5 a5)
             (*m_function)(m_a1, m_a2, m_a3, m_a4, m_a5);
         }
 
+        std::string GetTargetName() const override
+        {
+            return GetEventFunctionName(reinterpret_cast<const void*>(m_function));
+        }
+
         F m_function;
         typename TypeTraits<T1>::ReferencedType m_a1;
         typename TypeTraits<T2>::ReferencedType m_a2;
@@ -922,6 +1019,11 @@ MakeEvent(void (*f)(U1, U2, U3, U4, U5, U6), T1 a1, T2 a2, T3 a3, T4 a4, T5 a5,
             (*m_function)(m_a1, m_a2, m_a3, m_a4, m_a5, m_a6);
         }
 
+        std::string GetTargetName() const override
+        {
+            return GetEventFunctionName(reinterpret_cast<const void*>(m_function));
+        }
+
         F m_function;
         typename TypeTraits<T1>::ReferencedType m_a1;
         typename TypeTraits<T2>::ReferencedType m_a2;
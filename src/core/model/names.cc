@@ -19,6 +19,7 @@
 
 #include "abort.h"
 #include "assert.h"
+#include "config.h"
 #include "log.h"
 #include "object.h"
 #include "singleton.h"
@@ -778,6 +779,7 @@ Names::Add(std::string name, Ptr<Object> object)
     NS_LOG_FUNCTION(name << object);
     bool result = NamesPriv::Get()->Add(name, object);
     NS_ABORT_MSG_UNLESS(result, "Names::Add(): Error adding name " << name);
+    Config::InvalidateMatches();
 }
 
 void
@@ -786,6 +788,7 @@ Names::Rename(std::string oldpath, std::string newname)
     NS_LOG_FUNCTION(oldpath << newname);
     bool result = NamesPriv::Get()->Rename(oldpath, newname);
     NS_ABORT_MSG_UNLESS(result, "Names::Rename(): Error renaming " << oldpath << " to " << newname);
+    Config::InvalidateMatches();
 }
 
 void
@@ -794,6 +797,7 @@ Names::Add(std::string path, std::string name, Ptr<Object> object)
     NS_LOG_FUNCTION(path << name << object);
     bool result = NamesPriv::Get()->Add(path, name, object);
     NS_ABORT_MSG_UNLESS(result, "Names::Add(): Error adding " << path << " " << name);
+    Config::InvalidateMatches();
 }
 
 void
@@ -804,6 +808,7 @@ Names::Rename(std::string path, std::string oldname, std::string newname)
     NS_ABORT_MSG_UNLESS(result,
                         "Names::Rename (): Error renaming " << path << " " << oldname << " to "
                                                             << newname);
+    Config::InvalidateMatches();
 }
 
 void
@@ -814,6 +819,7 @@ Names::Add(Ptr<Object> context, std::string name, Ptr<Object> object)
     NS_ABORT_MSG_UNLESS(result,
                         "Names::Add(): Error adding name " << name << " under context "
                                                            << &context);
+    Config::InvalidateMatches();
 }
 
 void
@@ -824,6 +830,7 @@ Names::Rename(Ptr<Object> context, std::string oldname, std::string newname)
     NS_ABORT_MSG_UNLESS(result,
                         "Names::Rename (): Error renaming " << oldname << " to " << newname
                                                             << " under context " << &context);
+    Config::InvalidateMatches();
 }
 
 std::string
@@ -844,7 +851,8 @@ void
 Names::Clear()
 {
     NS_LOG_FUNCTION_NOARGS();
-    return NamesPriv::Get()->Clear();
+    NamesPriv::Get()->Clear();
+    Config::InvalidateMatches();
 }
 
 Ptr<Object>
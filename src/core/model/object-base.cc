@@ -19,7 +19,9 @@
 #include "object-base.h"
 
 #include "attribute-construction-list.h"
+#include "config.h"
 #include "log.h"
+#include "pointer.h"
 #include "string.h"
 #include "trace-source-accessor.h"
 
@@ -98,6 +100,22 @@ EnvDictionary(std::string key)
     return {found, value};
 }
 
+/**
+ * Drop the objects cached by the Config paths when an attribute pointing
+ * to another object was set, since it changes the objects reachable
+ * through it.
+ *
+ * \param [in] info The attribute which was set.
+ */
+void
+NotifyAttributeSet(const TypeId::AttributeInformation& info)
+{
+    if (dynamic_cast<const PointerChecker*>(PeekPointer(info.checker)) != nullptr)
+    {
+        Config::InvalidateMatches();
+    }
+}
+
 } // unnamed namespace
 
 /**
@@ -275,6 +293,7 @@ ObjectBase::SetAttribute(std::string name, const AttributeValue& value)
         NS_FATAL_ERROR("Attribute name=" << name << " could not be set for this object: tid="
                                          << tid.GetName());
     }
+    NotifyAttributeSet(info);
 }
 
 bool
@@ -291,7 +310,12 @@ ObjectBase::SetAttributeFailSafe(std::string name, const AttributeValue& value)
     {
         return false;
     }
-    return DoSet(info.accessor, info.checker, value);
+    if (!DoSet(info.accessor, info.checker, value))
+    {
+        return false;
+    }
+    NotifyAttributeSet(info);
+    return true;
 }
 
 void
@@ -22,6 +22,7 @@
 
 #include "assert.h"
 #include "attribute.h"
+#include "config.h"
 #include "log.h"
 #include "object-factory.h"
 #include "string.h"
@@ -96,11 +97,12 @@ Object::Object()
     : m_tid(Object::GetTypeId()),
       m_disposed(false),
       m_initialized(false),
-      m_aggregates((struct Aggregates*)std::malloc(sizeof(struct Aggregates))),
-      m_getObjectCount(0)
+      m_aggregates((struct Aggregates*)std::malloc(sizeof(struct Aggregates)))
 {
     NS_LOG_FUNCTION(this);
     m_aggregates->n = 1;
+    m_aggregates->mask = 0;
+    m_aggregates->index = nullptr;
     m_aggregates->buffer[0] = this;
 }
 
@@ -124,8 +126,14 @@ Object::~Object()
     // delete the aggregate list
     if (m_aggregates->n == 0)
     {
+        std::free(m_aggregates->index);
         std::free(m_aggregates);
     }
+    else
+    {
+        // the objects left may be looked up while they are deleted
+        UpdateIndex(m_aggregates);
+    }
     m_aggregates = nullptr;
 }
 
@@ -133,10 +141,11 @@ Object::Object(const Object& o)
     : m_tid(o.m_tid),
       m_disposed(false),
       m_initialized(false),
-      m_aggregates((struct Aggregates*)std::malloc(sizeof(struct Aggregates))),
-      m_getObjectCount(0)
+      m_aggregates((struct Aggregates*)std::malloc(sizeof(struct Aggregates)))
 {
     m_aggregates->n = 1;
+    m_aggregates->mask = 0;
+    m_aggregates->index = nullptr;
     m_aggregates->buffer[0] = this;
 }
 
@@ -153,33 +162,88 @@ Object::DoGetObject(TypeId tid) const
     NS_LOG_FUNCTION(this << tid);
     NS_ASSERT(CheckLoose());
 
-    uint32_t n = m_aggregates->n;
-    TypeId objectTid = Object::GetTypeId();
-    for (uint32_t i = 0; i < n; i++)
+    if (m_aggregates->index == nullptr)
     {
-        Object* current = m_aggregates->buffer[i];
+        Object* current = m_aggregates->buffer[0];
+        TypeId objectTid = Object::GetTypeId();
         TypeId cur = current->GetInstanceTypeId();
         while (cur != tid && cur != objectTid)
         {
             cur = cur.GetParent();
         }
-        if (cur == tid)
+        return cur == tid ? current : nullptr;
+    }
+
+    uint16_t uid = tid.GetUid();
+    for (uint32_t i = uid & m_aggregates->mask;; i = (i + 1) & m_aggregates->mask)
+    {
+        const IndexEntry& entry = m_aggregates->index[i];
+        if (entry.object == nullptr || entry.uid == uid)
         {
-            // This is an attempt to 'cache' the result of this lookup.
-            // the idea is that if we perform a lookup for a TypeId on this object,
-            // we are likely to perform the same lookup later so, we make sure
-            // that the aggregate array is sorted by the number of accesses
-            // to each object.
-
-            // first, increment the access count
-            current->m_getObjectCount++;
-            // then, update the sort
-            UpdateSortedArray(m_aggregates, i);
-            // finally, return the match
-            return const_cast<Object*>(current);
+            return entry.object;
+        }
+    }
+}
+
+void
+Object::UpdateIndex(struct Aggregates* aggregates)
+{
+    NS_LOG_FUNCTION(aggregates);
+    std::free(aggregates->index);
+    aggregates->index = nullptr;
+    aggregates->mask = 0;
+    if (aggregates->n < 2)
+    {
+        return;
+    }
+
+    // count the TypeIds of the objects and of their parents, with duplicates
+    TypeId objectTid = Object::GetTypeId();
+    uint32_t entries = 0;
+    for (uint32_t i = 0; i < aggregates->n; i++)
+    {
+        TypeId cur = aggregates->buffer[i]->GetInstanceTypeId();
+        entries++;
+        while (cur != objectTid)
+        {
+            cur = cur.GetParent();
+            entries++;
+        }
+    }
+    // keep the table at most half full
+    uint32_t size = 4;
+    while (size < 2 * entries)
+    {
+        size *= 2;
+    }
+    aggregates->mask = size - 1;
+    aggregates->index = (struct IndexEntry*)std::calloc(size, sizeof(struct IndexEntry));
+
+    for (uint32_t i = 0; i < aggregates->n; i++)
+    {
+        Object* current = aggregates->buffer[i];
+        TypeId cur = current->GetInstanceTypeId();
+        while (true)
+        {
+            uint16_t uid = cur.GetUid();
+            uint32_t j = uid & aggregates->mask;
+            while (aggregates->index[j].object != nullptr && aggregates->index[j].uid != uid)
+            {
+                j = (j + 1) & aggregates->mask;
+            }
+            // the first object of a type in the list is the one found
+            if (aggregates->index[j].object == nullptr)
+            {
+                aggregates->index[j].uid = uid;
+                aggregates->index[j].object = current;
+            }
+            if (cur == objectTid)
+            {
+                break;
+            }
+            cur = cur.GetParent();
         }
     }
-    return nullptr;
 }
 
 void
@@ -188,10 +252,9 @@ Object::Initialize()
     /**
      * Note: the code here is a bit tricky because we need to protect ourselves from
      * modifications in the aggregate array while DoInitialize is called. The user's
-     * implementation of the DoInitialize method could call GetObject (which could
-     * reorder the array) and it could call AggregateObject which would add an
-     * object at the end of the array. To be safe, we restart iteration over the
-     * array whenever we call some user code, just in case.
+     * implementation of the DoInitialize method could call AggregateObject which
+     * would add an object at the end of the array. To be safe, we restart iteration
+     * over the array whenever we call some user code, just in case.
      */
     NS_LOG_FUNCTION(this);
 restart:
@@ -221,8 +284,8 @@ Object::Dispose()
     /**
      * Note: the code here is a bit tricky because we need to protect ourselves from
      * modifications in the aggregate array while DoDispose is called. The user's
-     * DoDispose implementation could call GetObject (which could reorder the array)
-     * and it could call AggregateObject which would add an object at the end of the array.
+     * DoDispose implementation could call AggregateObject which would add an object
+     * at the end of the array.
      * So, to be safe, we restart the iteration over the array whenever we call some
      * user code.
      */
@@ -241,20 +304,6 @@ restart:
     }
 }
 
-void
-Object::UpdateSortedArray(struct Aggregates* aggregates, uint32_t j) const
-{
-    NS_LOG_FUNCTION(this << aggregates << j);
-    while (j > 0 &&
-           aggregates->buffer[j]->m_getObjectCount > aggregates->buffer[j - 1]->m_getObjectCount)
-    {
-        Object* tmp = aggregates->buffer[j - 1];
-        aggregates->buffer[j - 1] = aggregates->buffer[j];
-        aggregates->buffer[j] = tmp;
-        j--;
-    }
-}
-
 void
 Object::AggregateObject(Ptr<Object> o)
 {
@@ -287,8 +336,9 @@ Object::AggregateObject(Ptr<Object> o)
                            "Multiple aggregation of objects of type "
                            << other->GetInstanceTypeId() << " on objects of type " << typeId);
         }
-        UpdateSortedArray(aggregates, m_aggregates->n + i);
     }
+    aggregates->index = nullptr;
+    UpdateIndex(aggregates);
 
     // keep track of the old aggregate buffers for the iteration
     // of NotifyNewAggregates
@@ -320,8 +370,13 @@ Object::AggregateObject(Ptr<Object> o)
     }
 
     // Now that we are done with them, we can free our old aggregate buffers
+    std::free(a->index);
     std::free(a);
+    std::free(b->index);
     std::free(b);
+
+    // new objects can be reached through $TypeId path elements
+    Config::InvalidateMatches();
 }
 
 /**
@@ -331,6 +331,13 @@ class Object : public SimpleRefCount<Object, ObjectBase, ObjectDeleter>
 
     /**@}*/
 
+    /** An entry of Aggregates::index. */
+    struct IndexEntry
+    {
+        uint16_t uid;   //!< The uid of the TypeId, if \c object is not null.
+        Object* object; //!< The first Object of the aggregate of this TypeId.
+    };
+
     /**
      * The list of Objects aggregated to this one.
      *
@@ -342,11 +349,21 @@ class Object : public SimpleRefCount<Object, ObjectBase, ObjectDeleter>
      * chunk of memory than the struct to allow space for a larger
      * variable sized buffer whose size is indicated by the element
      * \c n
+     *
+     * When several Objects are aggregated, \c index maps the uid of the
+     * TypeId of each of them, and of each of its parents, to the first
+     * such Object in \c buffer. It is built by AggregateObject, so that
+     * GetObject is a lookup which does not write to the aggregate and can
+     * be run by several threads at once.
      */
     struct Aggregates
     {
         /** The number of entries in \c buffer. */
         uint32_t n;
+        /** The number of entries in \c index minus one; a power of two minus one. */
+        uint32_t mask;
+        /** Open addressing hash table of the Objects, null for a lone Object. */
+        struct IndexEntry* index;
         /** The array of Objects. */
         Object* buffer[1];
     };
@@ -399,12 +416,12 @@ class Object : public SimpleRefCount<Object, ObjectBase, ObjectDeleter>
     void Construct(const AttributeConstructionList& attributes);
 
     /**
-     * Keep the list of aggregates in most-recently-used order
+     * Build the index of a list of aggregates by TypeId, replacing the
+     * previous one.
      *
      * \param [in,out] aggregates The list of aggregated Objects.
-     * \param [in] i The most recently used entry in the list.
      */
-    void UpdateSortedArray(struct Aggregates* aggregates, uint32_t i) const;
+    static void UpdateIndex(struct Aggregates* aggregates);
     /**
      * Attempt to delete this Object.
      *
@@ -436,14 +453,6 @@ class Object : public SimpleRefCount<Object, ObjectBase, ObjectDeleter>
      * so the size of the array is indirectly a reference count.
      */
     struct Aggregates* m_aggregates;
-    /**
-     * The number of times the Object was accessed with a
-     * call to GetObject().
-     *
-     * This integer is used to implement a heuristic to sort
-     * the array of aggregates in most-frequently accessed order.
-     */
-    uint32_t m_getObjectCount;
 };
 
 template <typename T>
@@ -470,14 +479,17 @@ template <typename T>
 Ptr<T>
 Object::GetObject() const
 {
-    // This is an optimization: if the cast works (which is likely),
-    // things will be pretty fast.
-    T* result = dynamic_cast<T*>(m_aggregates->buffer[0]);
-    if (result != nullptr)
+    // This is an optimization: if the Object is alone and the cast works
+    // (which is likely), things will be pretty fast.
+    if (m_aggregates->n == 1)
     {
-        return Ptr<T>(result);
+        T* result = dynamic_cast<T*>(m_aggregates->buffer[0]);
+        if (result != nullptr)
+        {
+            return Ptr<T>(result);
+        }
     }
-    // if the cast does not work, we try to do a full type check.
+    // otherwise, we try to do a full type check.
     Ptr<Object> found = DoGetObject(T::GetTypeId());
     if (found)
     {
@@ -87,30 +87,49 @@ PriorityQueueScheduler::RemoveNext()
     NS_LOG_FUNCTION(this);
     Scheduler::Event ev = m_queue.top();
     m_queue.pop();
+    PopRemoved();
     return ev;
 }
 
-bool
-PriorityQueueScheduler::EventPriorityQueue::remove(const Scheduler::Event& ev)
+void
+PriorityQueueScheduler::PopRemoved()
 {
-    auto it = std::find(this->c.begin(), this->c.end(), ev);
-    if (it != this->c.end())
-    {
-        this->c.erase(it);
-        std::make_heap(this->c.begin(), this->c.end(), this->comp);
-        return true;
-    }
-    else
+    NS_LOG_FUNCTION(this);
+    while (!m_removed.empty() && !m_queue.empty() && m_removed.erase(m_queue.top().key.m_uid) > 0)
     {
-        return false;
+        m_queue.pop();
     }
 }
 
+void
+PriorityQueueScheduler::EventPriorityQueue::remove(const std::unordered_set<uint32_t>& uids)
+{
+    auto end = std::remove_if(this->c.begin(), this->c.end(), [&uids](const Scheduler::Event& ev) {
+        return uids.count(ev.key.m_uid) > 0;
+    });
+    this->c.erase(end, this->c.end());
+    std::make_heap(this->c.begin(), this->c.end(), this->comp);
+}
+
 void
 PriorityQueueScheduler::Remove(const Scheduler::Event& ev)
 {
-    NS_LOG_FUNCTION(this);
-    m_queue.remove(ev);
+    NS_LOG_FUNCTION(this << ev.impl << ev.key.m_ts << ev.key.m_uid);
+    NS_ASSERT(!m_queue.empty());
+    if (ev.key.m_uid == m_queue.top().key.m_uid)
+    {
+        RemoveNext();
+        return;
+    }
+    // the event stays in the queue until it reaches the top
+    [[maybe_unused]] bool inserted = m_removed.insert(ev.key.m_uid).second;
+    NS_ASSERT(inserted);
+    if (2 * m_removed.size() >= m_queue.size())
+    {
+        NS_LOG_LOGIC("compact " << m_removed.size() << " of " << m_queue.size());
+        m_queue.remove(m_removed);
+        m_removed.clear();
+    }
 }
 
 } // namespace ns3
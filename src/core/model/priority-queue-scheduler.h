@@ -26,6 +26,7 @@
 #include <functional>
 #include <queue>
 #include <stdint.h>
+#include <unordered_set>
 #include <utility>
 
 /**
@@ -44,6 +45,10 @@ namespace ns3
  * This class implements an event scheduler using
  * `std::priority_queue` on a `std::vector`.
  *
+ * Removed events are left in the queue as tombstones and discarded when
+ * they reach the top. When tombstones make up half of the queue, they
+ * are all dropped and the heap is rebuilt.
+ *
  * \par Time Complexity
  *
  * Operation    | Amortized %Time  | Reason
@@ -51,7 +56,7 @@ namespace ns3
  * Insert()     | Logarithmic      | `std::push_heap()`
  * IsEmpty()    | Constant         | `std::vector::empty()`
  * PeekNext()   | Constant         | `std::vector::front()`
- * Remove()     | Linear           | `std::find()` and `std::make_heap()`
+ * Remove()     | ~Constant        | Tombstone, amortized `std::make_heap()`
  * RemoveNext() | Logarithmic      | `std::pop_heap()`
  *
  * \par Memory Complexity
@@ -60,6 +65,7 @@ namespace ns3
  * :-------- | :------------------------------- | :-----
  * Overhead  | 3 x `sizeof (*)`<br/>(24 bytes)  | `std::vector`
  * Per Event | 0                                | Events stored in `std::vector` directly
+ * Removed   | 1 to 2 x `sizeof (Event)`        | Until compaction; `std::unordered_set` node
  *
  */
 class PriorityQueueScheduler : public Scheduler
@@ -94,15 +100,21 @@ class PriorityQueueScheduler : public Scheduler
     {
       public:
         /**
-         * \copydoc PriorityQueueScheduler::Remove()
-         * \returns \c true if the event was found, false otherwise.
+         * Drop events and rebuild the heap.
+         *
+         * \param [in] uids The uids of the events to drop.
          */
-        bool remove(const Scheduler::Event& ev);
+        void remove(const std::unordered_set<uint32_t>& uids);
 
     }; // class EventPriorityQueue
 
+    /** Pop the removed events off the top, so that the top is live. */
+    void PopRemoved();
+
     /** The event queue. */
     EventPriorityQueue m_queue;
+    /** Uids of the events removed but still in the queue. */
+    std::unordered_set<uint32_t> m_removed;
 
 }; // class PriorityQueueScheduler
 
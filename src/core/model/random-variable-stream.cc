@@ -49,6 +49,13 @@ namespace ns3
 
 NS_LOG_COMPONENT_DEFINE("RandomVariableStream");
 
+/**
+ * \ingroup randomvariable
+ * Maximum number of uniforms drawn at once by the GetValues() overrides;
+ * even, for the pairs of NormalRandomVariable.
+ */
+static const std::size_t UNIFORM_BLOCK = 64;
+
 NS_OBJECT_ENSURE_REGISTERED(RandomVariableStream);
 
 TypeId
@@ -142,6 +149,16 @@ RandomVariableStream::Peek() const
     return m_rng;
 }
 
+void
+RandomVariableStream::GetValues(double* values, std::size_t count)
+{
+    NS_LOG_FUNCTION(this << values << count);
+    for (std::size_t i = 0; i < count; i++)
+    {
+        values[i] = GetValue();
+    }
+}
+
 NS_OBJECT_ENSURE_REGISTERED(UniformRandomVariable);
 
 TypeId
@@ -219,6 +236,22 @@ UniformRandomVariable::GetInteger()
     return (uint32_t)GetValue(m_min, m_max + 1);
 }
 
+void
+UniformRandomVariable::GetValues(double* values, std::size_t count)
+{
+    NS_LOG_FUNCTION(this << values << count);
+    Peek()->RandU01(values, count);
+    for (std::size_t i = 0; i < count; i++)
+    {
+        double v = m_min + values[i] * (m_max - m_min);
+        if (IsAntithetic())
+        {
+            v = m_min + (m_max - v);
+        }
+        values[i] = v;
+    }
+}
+
 NS_OBJECT_ENSURE_REGISTERED(ConstantRandomVariable);
 
 TypeId
@@ -469,6 +502,38 @@ ExponentialRandomVariable::GetInteger()
     return (uint32_t)GetValue(m_mean, m_bound);
 }
 
+void
+ExponentialRandomVariable::GetValues(double* values, std::size_t count)
+{
+    NS_LOG_FUNCTION(this << values << count);
+    double uniforms[UNIFORM_BLOCK];
+    std::size_t drawn = 0;
+    std::size_t next = 0;
+    std::size_t i = 0;
+    while (i < count)
+    {
+        if (next == drawn)
+        {
+            // Each value takes at least one uniform: never draw more
+            // than GetValue() would have.
+            drawn = std::min(count - i, UNIFORM_BLOCK);
+            next = 0;
+            Peek()->RandU01(uniforms, drawn);
+        }
+        // Same as GetValue(), with the uniforms of the block.
+        double v = uniforms[next++];
+        if (IsAntithetic())
+        {
+            v = (1 - v);
+        }
+        double r = -m_mean * std::log(v);
+        if (m_bound == 0 || r <= m_bound)
+        {
+            values[i++] = r;
+        }
+    }
+}
+
 NS_OBJECT_ENSURE_REGISTERED(ParetoRandomVariable);
 
 TypeId
@@ -811,6 +876,66 @@ NormalRandomVariable::GetInteger()
     return (uint32_t)GetValue(m_mean, m_variance, m_bound);
 }
 
+void
+NormalRandomVariable::GetValues(double* values, std::size_t count)
+{
+    NS_LOG_FUNCTION(this << values << count);
+    double uniforms[UNIFORM_BLOCK];
+    std::size_t drawn = 0;
+    std::size_t next = 0;
+    std::size_t i = 0;
+    while (i < count)
+    {
+        // Same as GetValue(), with the uniforms of the block.
+        if (m_nextValid)
+        {
+            m_nextValid = false;
+            double x2 = m_mean + m_v2 * m_y * std::sqrt(m_variance);
+            if (std::fabs(x2 - m_mean) <= m_bound)
+            {
+                values[i++] = x2;
+                continue;
+            }
+        }
+        if (next == drawn)
+        {
+            // Each pair gives at most two values: never draw more
+            // than GetValue() would have.
+            drawn = std::min(2 * ((count - i + 1) / 2), UNIFORM_BLOCK);
+            next = 0;
+            Peek()->RandU01(uniforms, drawn);
+        }
+        double u1 = uniforms[next++];
+        double u2 = uniforms[next++];
+        if (IsAntithetic())
+        {
+            u1 = (1 - u1);
+            u2 = (1 - u2);
+        }
+        double v1 = 2 * u1 - 1;
+        double v2 = 2 * u2 - 1;
+        double w = v1 * v1 + v2 * v2;
+        if (w <= 1.0)
+        {
+            double y = std::sqrt((-2 * std::log(w)) / w);
+            double x1 = m_mean + v1 * y * std::sqrt(m_variance);
+            if (std::fabs(x1 - m_mean) <= m_bound)
+            {
+                m_nextValid = true;
+                m_y = y;
+                m_v2 = v2;
+                values[i++] = x1;
+                continue;
+            }
+            double x2 = m_mean + v2 * y * std::sqrt(m_variance);
+            if (std::fabs(x2 - m_mean) <= m_bound)
+            {
+                values[i++] = x2;
+            }
+        }
+    }
+}
+
 NS_OBJECT_ENSURE_REGISTERED(LogNormalRandomVariable);
 
 TypeId
@@ -29,6 +29,7 @@
 #include "object.h"
 #include "type-id.h"
 
+#include <cstddef>
 #include <stdint.h>
 
 /**
@@ -154,6 +155,18 @@ class RandomVariableStream : public Object
      */
     virtual uint32_t GetInteger() = 0;
 
+    /**
+     * \brief Get the next random values as doubles drawn from the distribution.
+     *
+     * The values are the same as those of as many calls to GetValue().
+     * Some distributions draw the underlying uniforms from the RngStream
+     * in blocks, which is much faster when many values are needed at once.
+     *
+     * \param [out] values The floating point random values.
+     * \param [in] count The number of values.
+     */
+    virtual void GetValues(double* values, std::size_t count);
+
   protected:
     /**
      * \brief Get the pointer to the underlying RngStream.
@@ -277,6 +290,7 @@ class UniformRandomVariable : public RandomVariableStream
      * \note The upper limit is included in the output range.
      */
     uint32_t GetInteger() override;
+    void GetValues(double* values, std::size_t count) override;
 
   private:
     /** The lower bound on values that can be returned by this RNG stream. */
@@ -566,6 +580,7 @@ class ExponentialRandomVariable : public RandomVariableStream
     // Inherited from RandomVariableStream
     double GetValue() override;
     uint32_t GetInteger() override;
+    void GetValues(double* values, std::size_t count) override;
 
   private:
     /** The mean value of the unbounded exponential distribution. */
@@ -1222,6 +1237,9 @@ class NormalRandomVariable : public RandomVariableStream
      */
     uint32_t GetInteger() override;
 
+    // Inherited from RandomVariableStream
+    void GetValues(double* values, std::size_t count) override;
+
   private:
     /** The mean value for the normal distribution returned by this RNG stream. */
     double m_mean;
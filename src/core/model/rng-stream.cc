@@ -328,6 +328,43 @@ void PowerOfTwoMatrix (int n, Matrix a1p, Matrix a2p)
     }
 }
 
+/** Number of randoms generated at once by RngStream::RandU01(double*, std::size_t). */
+const int blockSize = 16;
+
+/**
+ * The coefficients of the newest state value after 1 to blockSize steps:
+ * the last rows of the transition matrices raised to these powers, as
+ * integers, indexed by column then by power.
+ */
+struct BlockConstants
+{
+  uint64_t a1[3][blockSize];  //!< First component coefficients.
+  uint64_t a2[3][blockSize];  //!< Second component coefficients.
+};
+
+/**
+ * Compute the coefficients of the block generator.
+ *
+ * \returns The coefficients.
+ */
+struct BlockConstants BlockCoefficients ()
+{
+  struct BlockConstants constants;
+  for (int j = 0; j < blockSize; j++)
+    {
+      Matrix a1p;
+      Matrix a2p;
+      MatPowModM (A1p0, a1p, m1, j + 1);
+      MatPowModM (A2p0, a2p, m2, j + 1);
+      for (int i = 0; i < 3; i++)
+        {
+          constants.a1[i][j] = static_cast<uint64_t> (a1p[2][i]);
+          constants.a2[i][j] = static_cast<uint64_t> (a2p[2][i]);
+        }
+    }
+  return constants;
+}
+
 } // namespace MRG32k3a
 
 // clang-format on
@@ -375,6 +412,130 @@ RngStream::RandU01()
     return u;
 }
 
+/**
+ * \ingroup rngimpl
+ * Fold a value modulo 2<sup>32</sup> - \pname{d}, using
+ * 2<sup>32</sup> = \pname{d} modulo 2<sup>32</sup> - \pname{d}.
+ *
+ * \param [in] x The value.
+ * \param [in] d The difference between the modulus and 2<sup>32</sup>.
+ * \returns A value below 2<sup>32</sup> * (\pname{d} + 1), congruent to \pname{x}.
+ */
+static inline uint64_t
+Fold(uint64_t x, uint64_t d)
+{
+    return (x >> 32) * d + (x & 0xffffffff);
+}
+
+/**
+ * \ingroup rngimpl
+ * Compute <tt>(a0*s0 + a1*s1 + a2*s2) MOD m</tt> exactly, with
+ * m = 2<sup>32</sup> - \pname{d} and all products below 2<sup>64</sup>.
+ *
+ * \param [in] p0 The first product.
+ * \param [in] p1 The second product.
+ * \param [in] p2 The third product.
+ * \param [in] d The difference between the modulus and 2<sup>32</sup>,
+ * below 2<sup>15</sup>.
+ * \returns The sum of the products modulo m.
+ */
+static inline uint64_t
+SumModM(uint64_t p0, uint64_t p1, uint64_t p2, uint64_t d)
+{
+    // below 3 * 2^47, then 2^33, then 2^32 + d
+    uint64_t v = Fold(Fold(Fold(p0, d) + Fold(p1, d) + Fold(p2, d), d), d);
+    uint64_t m = (uint64_t(1) << 32) - d;
+    return v >= m ? v - m : v;
+}
+
+/**
+ * \ingroup rngimpl
+ * Compute the next block of randoms of a stream.
+ *
+ * Unlike RngStream::RandU01(), the values of the block do not depend
+ * on each other, which lets the compiler vectorize the loops. The
+ * arithmetic is exact, so the values are the same.
+ *
+ * \param [in] constants The coefficients of the block generator.
+ * \param [in,out] s1 The first component of the state.
+ * \param [in,out] s2 The second component of the state.
+ * \param [out] values The blockSize randoms.
+ */
+#if defined(__GNUC__) && !defined(__clang__) && defined(__x86_64__) && defined(__linux__)
+// also compiled for AVX2, picked at load time where supported
+__attribute__((target_clones("avx2", "default")))
+#endif
+static void
+RandU01Block(const struct BlockConstants& constants,
+             uint64_t s1[3],
+             uint64_t s2[3],
+             double values[blockSize])
+{
+    const uint64_t d1 = (uint64_t(1) << 32) - static_cast<uint64_t>(m1);
+    const uint64_t d2 = (uint64_t(1) << 32) - static_cast<uint64_t>(m2);
+    uint64_t x1[blockSize];
+    uint64_t x2[blockSize];
+    for (int j = 0; j < blockSize; j++)
+    {
+        x1[j] = SumModM(constants.a1[0][j] * s1[0],
+                        constants.a1[1][j] * s1[1],
+                        constants.a1[2][j] * s1[2],
+                        d1);
+    }
+    for (int j = 0; j < blockSize; j++)
+    {
+        x2[j] = SumModM(constants.a2[0][j] * s2[0],
+                        constants.a2[1][j] * s2[1],
+                        constants.a2[2][j] * s2[2],
+                        d2);
+    }
+    for (int j = 0; j < blockSize; j++)
+    {
+        // as in RandU01()
+        int64_t diff = static_cast<int64_t>(x1[j]) - static_cast<int64_t>(x2[j]);
+        if (diff <= 0)
+        {
+            diff += static_cast<int64_t>(m1);
+        }
+        values[j] = static_cast<double>(diff) * norm;
+    }
+    for (int i = 0; i < 3; i++)
+    {
+        s1[i] = x1[blockSize - 3 + i];
+        s2[i] = x2[blockSize - 3 + i];
+    }
+}
+
+void
+RngStream::RandU01(double* values, std::size_t count)
+{
+    std::size_t i = 0;
+    if (count >= static_cast<std::size_t>(blockSize))
+    {
+        static const struct BlockConstants constants = BlockCoefficients();
+        uint64_t s1[3];
+        uint64_t s2[3];
+        for (int j = 0; j < 3; j++)
+        {
+            s1[j] = static_cast<uint64_t>(m_currentState[j]);
+            s2[j] = static_cast<uint64_t>(m_currentState[3 + j]);
+        }
+        for (; i + blockSize <= count; i += blockSize)
+        {
+            RandU01Block(constants, s1, s2, values + i);
+        }
+        for (int j = 0; j < 3; j++)
+        {
+            m_currentState[j] = static_cast<double>(s1[j]);
+            m_currentState[3 + j] = static_cast<double>(s2[j]);
+        }
+    }
+    for (; i < count; i++)
+    {
+        values[i] = RandU01();
+    }
+}
+
 RngStream::RngStream(uint32_t seedNumber, uint64_t stream, uint64_t substream)
 {
     if (seedNumber >= m1 || seedNumber >= m2 || seedNumber == 0)
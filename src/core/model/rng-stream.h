@@ -18,6 +18,7 @@
 
 #ifndef RNGSTREAM_H
 #define RNGSTREAM_H
+#include <cstddef>
 #include <stdint.h>
 #include <string>
 
@@ -70,6 +71,19 @@ class RngStream
      * \returns The next random.
      */
     double RandU01();
+    /**
+     * Generate the next randoms for this stream.
+     *
+     * The values are those which as many calls to RandU01() would return,
+     * computed several at a time: each value of a block is derived from
+     * the state at the start of the block with the transition matrices
+     * raised to the corresponding power, so the block is computed in
+     * parallel, in SIMD registers where the compiler and processor allow.
+     *
+     * \param [out] values The randoms, uniformly distributed between 0 and 1.
+     * \param [in] count The number of randoms.
+     */
+    void RandU01(double* values, std::size_t count);
 
   private:
     /**
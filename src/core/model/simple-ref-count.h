@@ -27,6 +27,10 @@
 #include <limits>
 #include <stdint.h>
 
+#ifdef NS3_MTP
+#include <atomic>
+#endif
+
 /**
  * \file
  * \ingroup ptr
@@ -114,7 +118,11 @@ class SimpleRefCount : public PARENT
     inline void Ref() const
     {
         NS_ASSERT(m_count < std::numeric_limits<uint32_t>::max());
+#ifdef NS3_MTP
+        m_count.fetch_add(1, std::memory_order_relaxed);
+#else
         m_count++;
+#endif
     }
 
     /**
@@ -125,8 +133,11 @@ class SimpleRefCount : public PARENT
      */
     inline void Unref() const
     {
-        m_count--;
-        if (m_count == 0)
+#ifdef NS3_MTP
+        if (m_count.fetch_sub(1, std::memory_order_acq_rel) == 1)
+#else
+        if (--m_count == 0)
+#endif
         {
             DELETER::Delete(static_cast<T*>(const_cast<SimpleRefCount*>(this)));
         }
@@ -149,9 +160,14 @@ class SimpleRefCount : public PARENT
      *
      * \internal
      * Note we make this mutable so that the const methods can still
-     * change it.
+     * change it. Built with NS3_MTP, objects may be shared by the
+     * threads of MultithreadedSimulatorImpl and the count is atomic.
      */
+#ifdef NS3_MTP
+    mutable std::atomic<uint32_t> m_count;
+#else
     mutable uint32_t m_count;
+#endif
 };
 
 } // namespace ns3
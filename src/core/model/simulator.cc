@@ -19,6 +19,7 @@
 #include "simulator.h"
 
 #include "assert.h"
+#include "config.h"
 #include "des-metrics.h"
 #include "event-impl.h"
 #include "global-value.h"
@@ -156,6 +157,8 @@ Simulator::Destroy()
     (*pimpl)->Destroy();
     (*pimpl)->Unref();
     *pimpl = nullptr;
+    // release the simulated objects held by the Config path cache
+    Config::InvalidateMatches();
 }
 
 void
@@ -896,6 +896,16 @@ CallbackEqualityTestCase::DoRun()
     Callback<int> target6c = target4b.Bind(1.5, 3);
     NS_TEST_ASSERT_MSG_EQ(target6c.IsEqual(target6b), false, "Equality test failed");
 
+    //
+    // Make sure that callbacks made with bound arguments in one step compare
+    // equal to those bound afterwards.
+    //
+    Callback<int, int> target5c = MakeBoundCallback(&CallbackEqualityTarget, 1.5);
+    NS_TEST_ASSERT_MSG_EQ(target5c.IsEqual(target5b), true, "Equality test failed");
+    Callback<int> target3d = MakeCallback(&CallbackEqualityTestCase::TargetMember, this, 1.5, 2);
+    NS_TEST_ASSERT_MSG_EQ(target3d.IsEqual(target3b), true, "Equality test failed");
+    NS_TEST_ASSERT_MSG_EQ(target3d.IsEqual(target3c), false, "Equality test failed");
+
     //
     // Check that we cannot compare lambdas.
     //
@@ -864,6 +864,158 @@ SearchAttributesOfParentObjectsTestCase::DoRun()
     NS_TEST_ASSERT_MSG_EQ(iv.Get(), 42, "Object Attribute \"X\" not settable in derived class");
 }
 
+/**
+ * \ingroup config-tests
+ * Test for the paths parsed once into a Config::Path, and the objects they
+ * match, which are cached.
+ */
+class CompiledPathConfigTestCase : public TestCase
+{
+  public:
+    /** Constructor. */
+    CompiledPathConfigTestCase();
+
+    /** Destructor. */
+    ~CompiledPathConfigTestCase() override
+    {
+    }
+
+    /**
+     * Trace callback with context path.
+     * \param path The context path.
+     * \param old The old value.
+     * \param newValue The new value.
+     */
+    void TraceWithPath(std::string path, int16_t old [[maybe_unused]], int16_t newValue)
+    {
+        m_newValue = newValue;
+        m_path = path;
+    }
+
+  private:
+    void DoRun() override;
+
+    int16_t m_newValue; //!< Flag to detect tracing result.
+    std::string m_path; //!< The context path.
+};
+
+CompiledPathConfigTestCase::CompiledPathConfigTestCase()
+    : TestCase("Check the parsed Config paths and their cached matches")
+{
+}
+
+void
+CompiledPathConfigTestCase::DoRun()
+{
+    IntegerValue iv;
+
+    Config::Path path("Names/Compiled/NodeB/NodesB/*/A");
+    NS_TEST_ASSERT_MSG_EQ(path.GetPath(),
+                          "/Names/Compiled/NodeB/NodesB/*/A/",
+                          "Path not canonicalized");
+    NS_TEST_ASSERT_MSG_EQ(path.GetN(), 6, "Wrong number of path elements");
+    NS_TEST_ASSERT_MSG_EQ(path.Get(4), "*", "Wrong path element");
+    NS_TEST_ASSERT_MSG_EQ(path.GetPrefix(0), "/", "Wrong empty path prefix");
+    NS_TEST_ASSERT_MSG_EQ(path.GetPrefix(3), "/Names/Compiled/NodeB/", "Wrong path prefix");
+
+    //
+    // Name an object, so that the objects of the other test cases, under
+    // their root namespace objects, do not match.
+    //
+    Ptr<ConfigTestObject> a = CreateObject<ConfigTestObject>();
+    Names::Add("Compiled", a);
+    Ptr<ConfigTestObject> b = CreateObject<ConfigTestObject>();
+    a->SetNodeB(b);
+    Ptr<ConfigTestObject> obj0 = CreateObject<ConfigTestObject>();
+    Ptr<ConfigTestObject> obj1 = CreateObject<ConfigTestObject>();
+    Ptr<ConfigTestObject> obj2 = CreateObject<ConfigTestObject>();
+    b->AddNodeB(obj0);
+    b->AddNodeB(obj1);
+    b->AddNodeB(obj2);
+    Ptr<ConfigTestObject> c = CreateObject<ConfigTestObject>();
+    obj1->SetNodeA(c);
+
+    Config::Set(path, IntegerValue(-3));
+    obj0->GetAttribute("A", iv);
+    NS_TEST_ASSERT_MSG_EQ(iv.Get(), -3, "Object Attribute \"A\" not set as expected");
+    obj2->GetAttribute("A", iv);
+    NS_TEST_ASSERT_MSG_EQ(iv.Get(), -3, "Object Attribute \"A\" not set as expected");
+
+    //
+    // The matches are the same as with a path string
+    //
+    Config::Path vector("/Names/Compiled/NodeB/NodesB/*");
+    Config::MatchContainer compiled = Config::LookupMatches(vector);
+    Config::MatchContainer matches = Config::LookupMatches("/Names/Compiled/NodeB/NodesB/*");
+    NS_TEST_ASSERT_MSG_EQ(compiled.GetN(), 3, "Wrong number of matches");
+    NS_TEST_ASSERT_MSG_EQ(matches.GetN(), 3, "Wrong number of matches");
+    for (uint32_t i = 0; i < matches.GetN(); i++)
+    {
+        NS_TEST_ASSERT_MSG_EQ(compiled.Get(i), matches.Get(i), "Wrong object matched");
+        NS_TEST_ASSERT_MSG_EQ(compiled.GetMatchedPath(i),
+                              matches.GetMatchedPath(i),
+                              "Wrong context of the object matched");
+    }
+    NS_TEST_ASSERT_MSG_EQ(compiled.GetMatchedPath(1),
+                          "/Names/Compiled/NodeB/NodesB/1/",
+                          "Wrong context of the object matched");
+
+    //
+    // A path going further than the cached one starts from its matches.
+    //
+    Config::Set(Config::Path("/Names/Compiled/NodeB/NodesB/*/NodeA/A"), IntegerValue(-5));
+    c->GetAttribute("A", iv);
+    NS_TEST_ASSERT_MSG_EQ(iv.Get(), -5, "Object Attribute \"A\" not set as expected");
+    obj1->GetAttribute("A", iv);
+    NS_TEST_ASSERT_MSG_EQ(iv.Get(), -3, "Object Attribute \"A\" unexpectedly set");
+
+    //
+    // Objects added to a vector are not seen until the matches are
+    // invalidated; aggregated objects are.
+    //
+    Ptr<ConfigTestObject> obj3 = CreateObject<ConfigTestObject>();
+    b->AddNodeB(obj3);
+    NS_TEST_ASSERT_MSG_EQ(Config::LookupMatches(vector).GetN(), 3, "Matches not cached");
+    Config::InvalidateMatches();
+    NS_TEST_ASSERT_MSG_EQ(Config::LookupMatches(vector).GetN(), 4, "Matches not invalidated");
+
+    Config::Path derivedPath("/Names/Compiled/NodeB/NodesB/*/$DerivedConfigObject");
+    NS_TEST_ASSERT_MSG_EQ(Config::LookupMatches(derivedPath).GetN(), 0, "Unexpected match");
+    obj3->AggregateObject(CreateObject<DerivedConfigObject>());
+    NS_TEST_ASSERT_MSG_EQ(Config::LookupMatches(derivedPath).GetN(),
+                          1,
+                          "Aggregated object not matched");
+
+    //
+    // Bulk operations
+    //
+    Config::SetAll(vector, {{"A", IntegerValue(1)}, {"B", IntegerValue(2)}});
+    obj0->GetAttribute("A", iv);
+    NS_TEST_ASSERT_MSG_EQ(iv.Get(), 1, "Object Attribute \"A\" not set as expected");
+    obj3->GetAttribute("B", iv);
+    NS_TEST_ASSERT_MSG_EQ(iv.Get(), 2, "Object Attribute \"B\" not set as expected");
+
+    Config::ConnectAll(
+        Config::Path("/Names/Compiled/NodeB/NodesB/0|3"),
+        {{"Source", MakeCallback(&CompiledPathConfigTestCase::TraceWithPath, this)}});
+    m_newValue = 0;
+    obj3->SetAttribute("Source", IntegerValue(-6));
+    NS_TEST_ASSERT_MSG_EQ(m_newValue, -6, "Trace sink not connected");
+    NS_TEST_ASSERT_MSG_EQ(m_path,
+                          "/Names/Compiled/NodeB/NodesB/3/Source",
+                          "Wrong context of the trace");
+    m_newValue = 0;
+    obj2->SetAttribute("Source", IntegerValue(-7));
+    NS_TEST_ASSERT_MSG_EQ(m_newValue, 0, "Trace sink unexpectedly connected");
+
+    Config::Disconnect(Config::Path("/Names/Compiled/NodeB/NodesB/0|3/Source"),
+                       MakeCallback(&CompiledPathConfigTestCase::TraceWithPath, this));
+    obj3->SetAttribute("Source", IntegerValue(-8));
+    NS_TEST_ASSERT_MSG_EQ(m_newValue, 0, "Trace sink not disconnected");
+
+    Names::Clear();
+}
+
 /**
  * \ingroup config-tests
  * The Test Suite that glues all of the Test Cases together.
@@ -882,6 +1034,7 @@ ConfigTestSuite::ConfigTestSuite()
     AddTestCase(new UnderRootNamespaceConfigTestCase);
     AddTestCase(new ObjectVectorConfigTestCase);
     AddTestCase(new SearchAttributesOfParentObjectsTestCase);
+    AddTestCase(new CompiledPathConfigTestCase);
 }
 
 /**
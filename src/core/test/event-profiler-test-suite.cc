@@ -0,0 +1,267 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/config.h"
+#include "ns3/event-impl.h"
+#include "ns3/event-profiler.h"
+#include "ns3/make-event.h"
+#include "ns3/object.h"
+#include "ns3/simulator.h"
+#include "ns3/string.h"
+#include "ns3/test.h"
+#include "ns3/uinteger.h"
+
+#include <fstream>
+#include <set>
+#include <sstream>
+#include <string>
+
+/**
+ * \file
+ * \ingroup core-tests
+ * \ingroup simulator
+ * \ingroup event-profiler-tests
+ * EventProfiler test suite.
+ */
+
+/**
+ * \ingroup core-tests
+ * \defgroup event-profiler-tests EventProfiler tests
+ */
+
+namespace ns3
+{
+
+namespace tests
+{
+
+/**
+ * \ingroup event-profiler-tests
+ * An object with events to profile.
+ */
+class ProfiledObject : public Object
+{
+  public:
+    /**
+     * \brief Get the type ID.
+     * \return The object TypeId.
+     */
+    static TypeId GetTypeId()
+    {
+        static TypeId tid = TypeId("ns3::tests::ProfiledObject").SetParent<Object>();
+        return tid;
+    }
+
+    /** An event. */
+    void Work()
+    {
+        m_count++;
+    }
+
+    /** Another event. */
+    void OtherWork()
+    {
+        m_count += 2;
+    }
+
+    /** Something for the events to do. */
+    uint64_t m_count{0};
+};
+
+/**
+ * \ingroup event-profiler-tests
+ * A subclass, whose events are scheduled through the base class.
+ */
+class ProfiledSubObject : public ProfiledObject
+{
+  public:
+    /**
+     * \brief Get the type ID.
+     * \return The object TypeId.
+     */
+    static TypeId GetTypeId()
+    {
+        static TypeId tid =
+            TypeId("ns3::tests::ProfiledSubObject").SetParent<ProfiledObject>();
+        return tid;
+    }
+};
+
+/** Calls to ProfiledFunction(). */
+static uint32_t g_functionCalls = 0;
+
+/**
+ * \ingroup event-profiler-tests
+ * A function event, with external linkage so that it has a symbol.
+ */
+void
+ProfiledFunction()
+{
+    g_functionCalls++;
+}
+
+/**
+ * \ingroup event-profiler-tests
+ * Profile every event of a simulation into a file, and read it back.
+ */
+class EventProfilerTestCase : public TestCase
+{
+  public:
+    /** Constructor. */
+    EventProfilerTestCase();
+
+  private:
+    void DoRun() override;
+};
+
+EventProfilerTestCase::EventProfilerTestCase()
+    : TestCase("Check the event profile of a simulation")
+{
+}
+
+void
+EventProfilerTestCase::DoRun()
+{
+    std::string filename = CreateTempDirFilename("profile.folded");
+    Simulator::Destroy();
+    Config::SetDefault("ns3::DefaultSimulatorImpl::ProfileFile", StringValue(filename));
+    Config::SetDefault("ns3::DefaultSimulatorImpl::ProfilePeriod", UintegerValue(1));
+
+    Ptr<ProfiledObject> object = CreateObject<ProfiledObject>();
+    Ptr<ProfiledObject> same = CreateObject<ProfiledObject>();
+    Ptr<ProfiledObject> other = CreateObject<ProfiledSubObject>();
+    g_functionCalls = 0;
+    for (uint32_t i = 0; i < 10; i++)
+    {
+        Simulator::ScheduleWithContext(7, Seconds(i), &ProfiledObject::Work, PeekPointer(object));
+        Simulator::Schedule(Seconds(i), &ProfiledObject::OtherWork, PeekPointer(object));
+        Simulator::ScheduleWithContext(7, Seconds(i), &ProfiledObject::Work, PeekPointer(same));
+        Simulator::ScheduleWithContext(7, Seconds(i), &ProfiledObject::Work, PeekPointer(other));
+        Simulator::Schedule(Seconds(i), &ProfiledFunction);
+    }
+    Simulator::Run();
+    Simulator::Destroy();
+
+    Config::SetDefault("ns3::DefaultSimulatorImpl::ProfileFile", StringValue(""));
+    Config::SetDefault("ns3::DefaultSimulatorImpl::ProfilePeriod", UintegerValue(64));
+    NS_TEST_ASSERT_MSG_EQ(object->m_count, 30, "Wrong events run");
+    NS_TEST_ASSERT_MSG_EQ(same->m_count, 10, "Wrong events run");
+    NS_TEST_ASSERT_MSG_EQ(other->m_count, 10, "Wrong events run");
+    NS_TEST_ASSERT_MSG_EQ(g_functionCalls, 10, "Wrong events run");
+
+    // the stacks without their times
+    std::ifstream file(filename);
+    std::set<std::string> stacks;
+    std::string line;
+    while (std::getline(file, line))
+    {
+        stacks.insert(line.substr(0, line.rfind(' ')));
+    }
+    // one per event type, target class and context, the objects of the
+    // same class sharing theirs
+    std::string type = "MakeEvent<void (ns3::tests::ProfiledObject::*)(), "
+                       "ns3::tests::ProfiledObject*>;";
+    std::set<std::string> expected{type + "ns3::tests::ProfiledObject;node 7",
+                                   type + "ns3::tests::ProfiledObject;no context",
+                                   type + "ns3::tests::ProfiledSubObject;node 7",
+                                   "MakeEvent(void (*)());ns3::tests::ProfiledFunction();no context"};
+    for (const auto& stack : stacks)
+    {
+        NS_TEST_EXPECT_MSG_EQ(expected.count(stack), 1, "Unexpected stack " << stack);
+    }
+    NS_TEST_EXPECT_MSG_EQ(stacks.size(), expected.size(), "Wrong number of stacks");
+}
+
+/**
+ * \ingroup event-profiler-tests
+ * Sample the events of one type in two contexts.
+ */
+class EventProfilerSamplingTestCase : public TestCase
+{
+  public:
+    /** Constructor. */
+    EventProfilerSamplingTestCase();
+
+  private:
+    void DoRun() override;
+};
+
+EventProfilerSamplingTestCase::EventProfilerSamplingTestCase()
+    : TestCase("Check the sampling of the events")
+{
+}
+
+void
+EventProfilerSamplingTestCase::DoRun()
+{
+    EventProfiler profiler;
+    NS_TEST_ASSERT_MSG_EQ(profiler.Sample(), false, "Disabled profiler sampled an event");
+    profiler.Enable(8);
+    Ptr<ProfiledObject> object = CreateObject<ProfiledObject>();
+    EventImpl* event = MakeEvent(&ProfiledObject::Work, PeekPointer(object));
+    const uint32_t n = 80000;
+    for (uint32_t i = 0; i < n; i++)
+    {
+        if (profiler.Sample())
+        {
+            profiler.Record(event, i % 2, 10);
+        }
+    }
+    event->Unref();
+    NS_TEST_ASSERT_MSG_EQ(profiler.GetEventCount(), n, "Wrong number of events");
+    NS_TEST_ASSERT_MSG_EQ_TOL(profiler.GetSampleCount(), n / 8, n / 80, "Wrong number of samples");
+
+    std::ostringstream os;
+    profiler.Write(os);
+    std::string expected = "MakeEvent<void (ns3::tests::ProfiledObject::*)(), "
+                           "ns3::tests::ProfiledObject*>;ns3::tests::ProfiledObject;node ";
+    std::istringstream is(os.str());
+    std::string line;
+    uint32_t node = 0;
+    while (std::getline(is, line))
+    {
+        NS_TEST_EXPECT_MSG_EQ(line.substr(0, expected.size() + 2),
+                              expected + std::to_string(node) + " ",
+                              "Wrong stack " << line);
+        node++;
+    }
+    NS_TEST_ASSERT_MSG_EQ(node, 2, "Wrong number of stacks");
+}
+
+/**
+ * \ingroup event-profiler-tests
+ * EventProfiler test suite.
+ */
+class EventProfilerTestSuite : public TestSuite
+{
+  public:
+    /** Constructor. */
+    EventProfilerTestSuite()
+        : TestSuite("event-profiler")
+    {
+        AddTestCase(new EventProfilerSamplingTestCase());
+        AddTestCase(new EventProfilerTestCase());
+    }
+};
+
+/**
+ * \ingroup event-profiler-tests
+ * EventProfilerTestSuite instance variable.
+ */
+static EventProfilerTestSuite g_eventProfilerTestSuite;
+
+} // namespace tests
+
+} // namespace ns3
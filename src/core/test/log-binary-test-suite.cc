@@ -0,0 +1,147 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/** Prefix of the messages of this file, as set by many models. */
+#define NS_LOG_APPEND_CONTEXT std::clog << "[ctx] ";
+
+#include "ns3/log.h"
+#include "ns3/simulator.h"
+#include "ns3/test.h"
+
+#include <algorithm>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * \file
+ * \ingroup core-tests
+ * \ingroup logging
+ * \ingroup logging-tests
+ * Binary log file test suite.
+ */
+
+/**
+ * \ingroup core-tests
+ * \defgroup logging-tests Logging tests
+ */
+
+namespace ns3
+{
+
+NS_LOG_COMPONENT_DEFINE("LogBinaryTestSuite");
+
+namespace tests
+{
+
+/**
+ * \ingroup logging-tests
+ * Write log messages of all kinds to a binary file and read them back.
+ */
+class LogBinaryTestCase : public TestCase
+{
+  public:
+    /** Constructor. */
+    LogBinaryTestCase();
+
+  private:
+    void DoRun() override;
+
+    /**
+     * Log the messages, from an event.
+     * \param [in] value A value to log.
+     */
+    static void LogMessages(int value);
+};
+
+LogBinaryTestCase::LogBinaryTestCase()
+    : TestCase("Check the log messages written to a binary file")
+{
+}
+
+void
+LogBinaryTestCase::LogMessages(int value)
+{
+    NS_LOG_FUNCTION(value << 2);
+    NS_LOG_DEBUG("value=" << value);
+    // longer than a record, continued while another thread logs
+    std::thread other([]() { NS_LOG_INFO(std::string(300, 'b')); });
+    NS_LOG_WARN(std::string(500, 'a'));
+    other.join();
+}
+
+void
+LogBinaryTestCase::DoRun()
+{
+#ifdef NS3_LOG_ENABLE
+    std::string filename = CreateTempDirFilename("log-binary.bin");
+    LogComponentEnable("LogBinaryTestSuite", LogLevel(LOG_LEVEL_ALL | LOG_PREFIX_ALL));
+    LogSetBinaryFile(filename);
+    Simulator::ScheduleWithContext(3, Seconds(1), &LogBinaryTestCase::LogMessages, 7);
+    Simulator::Run();
+    Simulator::Destroy();
+    LogSetBinaryFile("");
+    LogComponentDisable("LogBinaryTestSuite", LOG_LEVEL_ALL);
+
+    LogBinaryReader reader;
+    NS_TEST_ASSERT_MSG_EQ(reader.Open(filename), true, "Cannot read " << filename);
+    std::vector<std::string> lines;
+    LogBinaryReader::Message message;
+    while (reader.Read(message))
+    {
+        lines.push_back(LogBinaryReader::Format(message));
+    }
+
+    // the messages of the two threads may be in either order
+    std::vector<std::string> expected = {
+        "+1.000000000s 3 [ctx] LogBinaryTestSuite:LogMessages(7, 2)",
+        "+1.000000000s 3 [ctx] LogBinaryTestSuite:LogMessages(): [DEBUG] value=7",
+        "+1.000000000s 3 [ctx] LogBinaryTestSuite:LogMessages(): [WARN ] " + std::string(500, 'a'),
+        "+1.000000000s 3 [ctx] LogBinaryTestSuite:operator()(): [INFO ] " + std::string(300, 'b'),
+    };
+    std::sort(lines.begin(), lines.end());
+    std::sort(expected.begin(), expected.end());
+    NS_TEST_ASSERT_MSG_EQ(lines.size(), expected.size(), "Wrong number of messages");
+    for (std::size_t i = 0; i < std::min(lines.size(), expected.size()); i++)
+    {
+        NS_TEST_EXPECT_MSG_EQ(lines[i], expected[i], "Wrong message " << i);
+    }
+#endif /* NS3_LOG_ENABLE */
+}
+
+/**
+ * \ingroup logging-tests
+ * Binary log file test suite.
+ */
+class LogBinaryTestSuite : public TestSuite
+{
+  public:
+    /** Constructor. */
+    LogBinaryTestSuite()
+        : TestSuite("log-binary")
+    {
+        AddTestCase(new LogBinaryTestCase());
+    }
+};
+
+/**
+ * \ingroup logging-tests
+ * LogBinaryTestSuite instance variable.
+ */
+static LogBinaryTestSuite g_logBinaryTestSuite;
+
+} // namespace tests
+
+} // namespace ns3
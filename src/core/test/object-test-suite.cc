@@ -446,6 +446,35 @@ AggregateObjectTestCase::DoRun()
                           nullptr,
                           "Cannot GetObject (through baseB) for BaseB Object");
 
+    //
+    // Aggregate two aggregates, each with a base and a derived Object.  A
+    // request for a base type finds the first Object of that type which was
+    // aggregated, whatever the Object it is made through.
+    //
+    Ptr<BaseA> firstA = CreateObject<BaseA>();
+    Ptr<DerivedA> secondA = CreateObject<DerivedA>();
+    firstA->AggregateObject(secondA);
+    Ptr<BaseB> firstB = CreateObject<BaseB>();
+    Ptr<DerivedB> secondB = CreateObject<DerivedB>();
+    firstB->AggregateObject(secondB);
+    secondA->AggregateObject(secondB);
+
+    NS_TEST_ASSERT_MSG_EQ(secondB->GetObject<BaseA>(),
+                          firstA,
+                          "GetObject (through secondB) for BaseA found the wrong Object");
+    NS_TEST_ASSERT_MSG_EQ(secondB->GetObject<DerivedA>(),
+                          secondA,
+                          "GetObject (through secondB) for DerivedA found the wrong Object");
+    NS_TEST_ASSERT_MSG_EQ(firstA->GetObject<BaseB>(),
+                          firstB,
+                          "GetObject (through firstA) for BaseB found the wrong Object");
+    NS_TEST_ASSERT_MSG_EQ(firstA->GetObject<DerivedB>(),
+                          secondB,
+                          "GetObject (through firstA) for DerivedB found the wrong Object");
+    NS_TEST_ASSERT_MSG_EQ(firstA->GetObject<BaseA>(),
+                          firstA,
+                          "GetObject (through firstA) for BaseA found the wrong Object");
+
     //
     // Make sure reference counting works in the aggregate.  Create two Objects
     // and aggregate them, then release one of them.  The aggregation should
@@ -2565,6 +2565,113 @@ NormalCachingTestCase::DoRun()
     NS_TEST_ASSERT_MSG_GT(v2, 0, "Incorrect value returned, expected > 0");
 }
 
+/**
+ * \ingroup rng-tests
+ * Test that GetValues() draws the same values as repeated GetValue().
+ */
+class GetValuesTestCase : public TestCaseBase
+{
+  public:
+    // Constructor
+    GetValuesTestCase();
+
+  private:
+    // Inherited
+    void DoRun() override;
+
+    /**
+     * Draw values from two streams of the same random variable, in batches
+     * from the first one and one by one from the second one.
+     * \param [in] name The name of the random variable, for the messages.
+     * \param [in] batch The first random variable.
+     * \param [in] single The second random variable.
+     */
+    void Compare(std::string name,
+                 Ptr<RandomVariableStream> batch,
+                 Ptr<RandomVariableStream> single);
+};
+
+GetValuesTestCase::GetValuesTestCase()
+    : TestCaseBase("GetValues draws the values of GetValue")
+{
+}
+
+void
+GetValuesTestCase::Compare(std::string name,
+                           Ptr<RandomVariableStream> batch,
+                           Ptr<RandomVariableStream> single)
+{
+    batch->SetStream(5);
+    single->SetStream(5);
+    // counts around the block sizes, and single draws in between
+    for (std::size_t count : {1, 17, 100, 0, 3, 64, 250, 2})
+    {
+        std::vector<double> values(count);
+        batch->GetValues(values.data(), count);
+        for (std::size_t i = 0; i < count; i++)
+        {
+            NS_TEST_ASSERT_MSG_EQ(values[i],
+                                  single->GetValue(),
+                                  name << ": wrong value " << i << " of " << count);
+        }
+        NS_TEST_ASSERT_MSG_EQ(batch->GetValue(), single->GetValue(), name << ": wrong next value");
+    }
+}
+
+void
+GetValuesTestCase::DoRun()
+{
+    NS_LOG_FUNCTION(this);
+    SetTestSuiteSeed();
+
+    for (bool antithetic : {false, true})
+    {
+        std::string suffix = antithetic ? " antithetic" : "";
+
+        Ptr<UniformRandomVariable> u[2];
+        for (auto& x : u)
+        {
+            x = CreateObject<UniformRandomVariable>();
+            x->SetAttribute("Min", DoubleValue(2));
+            x->SetAttribute("Max", DoubleValue(5));
+            x->SetAttribute("Antithetic", BooleanValue(antithetic));
+        }
+        Compare("Uniform" + suffix, u[0], u[1]);
+
+        // values above the bound are discarded
+        Ptr<ExponentialRandomVariable> e[2];
+        for (auto& x : e)
+        {
+            x = CreateObject<ExponentialRandomVariable>();
+            x->SetAttribute("Mean", DoubleValue(3));
+            x->SetAttribute("Bound", DoubleValue(4));
+            x->SetAttribute("Antithetic", BooleanValue(antithetic));
+        }
+        Compare("Exponential" + suffix, e[0], e[1]);
+
+        // pairs are discarded, or only give one value
+        Ptr<NormalRandomVariable> n[2];
+        for (auto& x : n)
+        {
+            x = CreateObject<NormalRandomVariable>();
+            x->SetAttribute("Mean", DoubleValue(1));
+            x->SetAttribute("Variance", DoubleValue(4));
+            x->SetAttribute("Bound", DoubleValue(2));
+            x->SetAttribute("Antithetic", BooleanValue(antithetic));
+        }
+        Compare("Normal" + suffix, n[0], n[1]);
+
+        // the default implementation
+        Ptr<ParetoRandomVariable> p[2];
+        for (auto& x : p)
+        {
+            x = CreateObject<ParetoRandomVariable>();
+            x->SetAttribute("Antithetic", BooleanValue(antithetic));
+        }
+        Compare("Pareto" + suffix, p[0], p[1]);
+    }
+}
+
 /**
  * \ingroup rng-tests
  * RandomVariableStream test suite, covering all random number variable
@@ -2617,6 +2724,7 @@ RandomVariableSuite::RandomVariableSuite()
     AddTestCase(new EmpiricalAntitheticTestCase);
     /// Issue #302:  NormalRandomVariable produces stale values
     AddTestCase(new NormalCachingTestCase);
+    AddTestCase(new GetValuesTestCase);
 }
 
 static RandomVariableSuite randomVariableSuite; //!< Static variable for test initialization
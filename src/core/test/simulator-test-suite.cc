@@ -18,12 +18,17 @@
  */
 #include "ns3/calendar-scheduler.h"
 #include "ns3/heap-scheduler.h"
+#include "ns3/ladder-scheduler.h"
 #include "ns3/list-scheduler.h"
 #include "ns3/map-scheduler.h"
 #include "ns3/priority-queue-scheduler.h"
+#include "ns3/random-variable-stream.h"
 #include "ns3/simulator.h"
 #include "ns3/test.h"
 
+#include <set>
+#include <vector>
+
 using namespace ns3;
 
 /**
@@ -717,6 +722,137 @@ SimulatorTemplateTestCase::DoRun()
     Simulator::Destroy();
 }
 
+/**
+ * \ingroup simulator-tests
+ *
+ * \brief Check the order of the events of a scheduler under a bursty load.
+ *
+ * The scheduler is driven directly with a mix of near, far and
+ * simultaneous events, and random removals, then with timers restarted
+ * over and over, and must always return the same next event as an
+ * ordered set of the keys.
+ */
+class SchedulerOrderTestCase : public TestCase
+{
+  public:
+    /**
+     * Constructor.
+     * \param schedulerFactory Scheduler factory.
+     */
+    SchedulerOrderTestCase(ObjectFactory schedulerFactory);
+    void DoRun() override;
+
+  private:
+    ObjectFactory m_schedulerFactory; //!< Scheduler factory.
+};
+
+SchedulerOrderTestCase::SchedulerOrderTestCase(ObjectFactory schedulerFactory)
+    : TestCase("Check the event order of " + schedulerFactory.GetTypeId().GetName() +
+               " under a bursty load"),
+      m_schedulerFactory(schedulerFactory)
+{
+}
+
+void
+SchedulerOrderTestCase::DoRun()
+{
+    Ptr<Scheduler> scheduler = m_schedulerFactory.Create<Scheduler>();
+    Ptr<UniformRandomVariable> rng = CreateObject<UniformRandomVariable>();
+    rng->SetStream(1);
+
+    std::set<Scheduler::EventKey> expected;
+    std::vector<Scheduler::EventKey> pending;
+    uint64_t now = 0;
+    uint32_t uid = 0;
+    for (uint32_t i = 0; i < 20000; i++)
+    {
+        uint32_t op = rng->GetInteger(0, 99);
+        if (op < 55 || expected.empty())
+        {
+            Scheduler::Event ev;
+            ev.impl = nullptr;
+            ev.key.m_uid = uid++;
+            ev.key.m_context = 0;
+            if (op < 20)
+            {
+                ev.key.m_ts = now + rng->GetInteger(0, 10);
+            }
+            else if (op < 35)
+            {
+                // a burst of simultaneous events
+                ev.key.m_ts = now + 500;
+            }
+            else if (op < 50)
+            {
+                ev.key.m_ts = now + rng->GetInteger(0, 100000);
+            }
+            else
+            {
+                ev.key.m_ts = now + rng->GetInteger(0, 1000000000);
+            }
+            scheduler->Insert(ev);
+            expected.insert(ev.key);
+            pending.push_back(ev.key);
+        }
+        else if (op < 65)
+        {
+            uint32_t index = rng->GetInteger(0, pending.size() - 1);
+            std::swap(pending[index], pending.back());
+            Scheduler::EventKey key = pending.back();
+            pending.pop_back();
+            if (expected.erase(key) > 0)
+            {
+                Scheduler::Event ev;
+                ev.impl = nullptr;
+                ev.key = key;
+                scheduler->Remove(ev);
+            }
+        }
+        else
+        {
+            NS_TEST_ASSERT_MSG_EQ(scheduler->PeekNext().key.m_uid,
+                                  expected.begin()->m_uid,
+                                  "Wrong next event");
+            Scheduler::Event ev = scheduler->RemoveNext();
+            NS_TEST_ASSERT_MSG_EQ(ev.key.m_uid, expected.begin()->m_uid, "Wrong event removed");
+            now = ev.key.m_ts;
+            expected.erase(expected.begin());
+        }
+        NS_TEST_ASSERT_MSG_EQ(scheduler->IsEmpty(), expected.empty(), "Wrong emptiness");
+    }
+    // timers restarted over and over: most events end up removed
+    for (uint32_t i = 0; i < 20000 && !pending.empty(); i++)
+    {
+        uint32_t index = rng->GetInteger(0, pending.size() - 1);
+        Scheduler::EventKey key = pending[index];
+        if (expected.erase(key) > 0)
+        {
+            Scheduler::Event ev;
+            ev.impl = nullptr;
+            ev.key = key;
+            scheduler->Remove(ev);
+        }
+        Scheduler::Event ev;
+        ev.impl = nullptr;
+        ev.key.m_uid = uid++;
+        ev.key.m_context = 0;
+        ev.key.m_ts = now + rng->GetInteger(0, 1000000);
+        scheduler->Insert(ev);
+        expected.insert(ev.key);
+        pending[index] = ev.key;
+        NS_TEST_ASSERT_MSG_EQ(scheduler->PeekNext().key.m_uid,
+                              expected.begin()->m_uid,
+                              "Wrong next event after a restart");
+    }
+    while (!expected.empty())
+    {
+        Scheduler::Event ev = scheduler->RemoveNext();
+        NS_TEST_ASSERT_MSG_EQ(ev.key.m_uid, expected.begin()->m_uid, "Wrong event drained");
+        expected.erase(expected.begin());
+    }
+    NS_TEST_EXPECT_MSG_EQ(scheduler->IsEmpty(), true, "Events left");
+}
+
 /**
  * \ingroup simulator-tests
  *
@@ -740,6 +876,19 @@ class SimulatorTestSuite : public TestSuite
         AddTestCase(new SimulatorEventsTestCase(factory), TestCase::QUICK);
         factory.SetTypeId(PriorityQueueScheduler::GetTypeId());
         AddTestCase(new SimulatorEventsTestCase(factory), TestCase::QUICK);
+        factory.SetTypeId(LadderScheduler::GetTypeId());
+        AddTestCase(new SimulatorEventsTestCase(factory), TestCase::QUICK);
+
+        for (TypeId tid : {ListScheduler::GetTypeId(),
+                           MapScheduler::GetTypeId(),
+                           HeapScheduler::GetTypeId(),
+                           CalendarScheduler::GetTypeId(),
+                           PriorityQueueScheduler::GetTypeId(),
+                           LadderScheduler::GetTypeId()})
+        {
+            factory.SetTypeId(tid);
+            AddTestCase(new SchedulerOrderTestCase(factory), TestCase::QUICK);
+        }
     }
 };
 
@@ -0,0 +1,207 @@
+#include "ns3/core-module.h"
+#include "ns3/cybertwin-name-resolution-service.h"
+#include "ns3/internet-module.h"
+#include "ns3/network-module.h"
+#include "ns3/point-to-point-module.h"
+
+#include <algorithm>
+#include <chrono>
+#include <vector>
+
+// Hierarchical CNRS benchmark
+//
+//                 root CNRS
+//            ________|________
+//           |        |        |
+//      edge CNRS  edge CNRS  ...   (point-to-point links)
+//
+// Every edge registers its share of the twins with its own CNRS, which
+// reports them to the root in batches. Afterwards clients on the edges look
+// up random twins; names registered on another edge are resolved through the
+// root. The program prints the number of datagrams sent upstream per insert
+// and the query latency distribution.
+
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE("CybertwinCnrsBenchmark");
+
+static uint64_t g_upstreamReports = 0;
+static uint64_t g_upstreamQueries = 0;
+static uint64_t g_failedQueries = 0;
+static std::vector<double> g_latencies;
+
+static void
+UpstreamTx(Ptr<const Packet> packet)
+{
+    CybertwinCNRSHeader header;
+    packet->PeekHeader(header);
+    if (header.GetMethod() == CNRS_INSERT_BATCH)
+    {
+        g_upstreamReports++;
+    }
+    else
+    {
+        g_upstreamQueries++;
+    }
+}
+
+static void
+QueryAnswered(Time start, CYBERTWINID_t id, bool found, CybertwinInterface interface)
+{
+    if (!found)
+    {
+        g_failedQueries++;
+        return;
+    }
+    g_latencies.push_back((Simulator::Now() - start).GetSeconds() * 1e3);
+}
+
+static void
+StartQuery(Ptr<NameResolutionClient> client, CYBERTWINID_t id)
+{
+    client->Resolve(id, MakeBoundCallback(&QueryAnswered, Simulator::Now()));
+}
+
+static double
+Percentile(const std::vector<double>& sorted, double p)
+{
+    if (sorted.empty())
+    {
+        return 0;
+    }
+    return sorted[std::min<std::size_t>(sorted.size() - 1, sorted.size() * p)];
+}
+
+int
+main(int argc, char* argv[])
+{
+    uint32_t nEdges = 4;
+    uint32_t nTwins = 100000;
+    uint32_t nQueries = 10000;
+    double insertDuration = 10;
+    double queryDuration = 5;
+    uint32_t batchSize = 100;
+
+    CommandLine cmd(__FILE__);
+    cmd.AddValue("edges", "Number of edge name resolution services", nEdges);
+    cmd.AddValue("twins", "Number of cybertwins registered", nTwins);
+    cmd.AddValue("queries", "Number of lookups issued after registration", nQueries);
+    cmd.AddValue("insertDuration", "Seconds over which the twins are registered", insertDuration);
+    cmd.AddValue("queryDuration", "Seconds over which the lookups are issued", queryDuration);
+    cmd.AddValue("batchSize", "Records per upstream report datagram", batchSize);
+    cmd.Parse(argc, argv);
+
+    Config::SetDefault("ns3::NameResolutionService::ReportBatchSize", UintegerValue(batchSize));
+
+    NodeContainer root;
+    root.Create(1);
+    NodeContainer edges;
+    edges.Create(nEdges);
+
+    InternetStackHelper stack;
+    stack.Install(root);
+    stack.Install(edges);
+
+    PointToPointHelper p2p;
+    p2p.SetDeviceAttribute("DataRate", StringValue("1Gbps"));
+    p2p.SetChannelAttribute("Delay", StringValue("5ms"));
+
+    Ipv4AddressHelper address;
+    address.SetBase("10.0.0.0", "255.255.255.252");
+    Ipv4Address rootAddr;
+    for (uint32_t i = 0; i < nEdges; i++)
+    {
+        NetDeviceContainer devices = p2p.Install(root.Get(0), edges.Get(i));
+        Ipv4InterfaceContainer ifs = address.Assign(devices);
+        address.NewNetwork();
+        if (i == 0)
+        {
+            rootAddr = ifs.GetAddress(0);
+        }
+    }
+    Ipv4GlobalRoutingHelper::PopulateRoutingTables();
+
+    Ptr<NameResolutionService> rootCnrs = CreateObject<NameResolutionService>();
+    root.Get(0)->AddApplication(rootCnrs);
+
+    std::vector<Ptr<NameResolutionClient>> writers;
+    std::vector<Ptr<NameResolutionClient>> readers;
+    for (uint32_t i = 0; i < nEdges; i++)
+    {
+        Ptr<NameResolutionService> cnrs = CreateObject<NameResolutionService>();
+        cnrs->SetAttribute("SuperiorAddress", AddressValue(rootAddr));
+        edges.Get(i)->AddApplication(cnrs);
+
+        Ptr<NameResolutionClient> writer = CreateObject<NameResolutionClient>();
+        writer->SetAttribute("ServerAddress", AddressValue(Ipv4Address::GetLoopback()));
+        writer->SetNode(edges.Get(i));
+        writers.push_back(writer);
+
+        // no client-side caching, every lookup reaches the edge service
+        Ptr<NameResolutionClient> reader = CreateObject<NameResolutionClient>();
+        reader->SetAttribute("ServerAddress", AddressValue(Ipv4Address::GetLoopback()));
+        reader->SetAttribute("PositiveTtl", TimeValue(Seconds(0)));
+        reader->SetAttribute("NegativeTtl", TimeValue(Seconds(0)));
+        reader->SetNode(edges.Get(i));
+        readers.push_back(reader);
+    }
+
+    Config::ConnectWithoutContext("/NodeList/*/ApplicationList/*/$ns3::NameResolutionService/UpstreamTx",
+                                  MakeCallback(&UpstreamTx));
+
+    Ptr<UniformRandomVariable> rng = CreateObject<UniformRandomVariable>();
+    const CYBERTWINID_t firstId = 1000;
+    for (uint32_t i = 0; i < nTwins; i++)
+    {
+        Time at = Seconds(1 + insertDuration * i / nTwins);
+        Ipv4Address twinAddr(0x0b000000 + i);
+        Simulator::Schedule(at,
+                            &NameResolutionClient::Insert,
+                            writers[i % nEdges],
+                            firstId + i,
+                            twinAddr,
+                            static_cast<uint16_t>(GLOBAL_PORT_COUNTER_START +
+                                                  i % (GLOBAL_PORT_COUNTER_END -
+                                                       GLOBAL_PORT_COUNTER_START + 1)));
+    }
+
+    // give the last reports time to reach the root
+    double queryStart = 2 + insertDuration;
+    for (uint32_t i = 0; i < nQueries; i++)
+    {
+        Time at = Seconds(queryStart + queryDuration * i / nQueries);
+        CYBERTWINID_t id = firstId + rng->GetInteger(0, nTwins - 1);
+        Ptr<NameResolutionClient> reader = readers[rng->GetInteger(0, nEdges - 1)];
+        Simulator::Schedule(at, &StartQuery, reader, id);
+    }
+
+    auto wallStart = std::chrono::steady_clock::now();
+    Simulator::Stop(Seconds(queryStart + queryDuration + 2));
+    Simulator::Run();
+    double wallSeconds =
+        std::chrono::duration<double>(std::chrono::steady_clock::now() - wallStart).count();
+
+    std::sort(g_latencies.begin(), g_latencies.end());
+    double mean = 0;
+    for (double latency : g_latencies)
+    {
+        mean += latency;
+    }
+    mean = g_latencies.empty() ? 0 : mean / g_latencies.size();
+
+    std::cout << "twins " << nTwins << std::endl
+              << "root_items " << rootCnrs->GetNItems() << std::endl
+              << "upstream_reports " << g_upstreamReports << std::endl
+              << "upstream_reports_per_insert " << double(g_upstreamReports) / nTwins << std::endl
+              << "upstream_queries " << g_upstreamQueries << std::endl
+              << "queries_answered " << g_latencies.size() << std::endl
+              << "queries_failed " << g_failedQueries << std::endl
+              << "query_latency_mean_ms " << mean << std::endl
+              << "query_latency_p50_ms " << Percentile(g_latencies, 0.5) << std::endl
+              << "query_latency_p99_ms " << Percentile(g_latencies, 0.99) << std::endl
+              << "query_latency_max_ms " << Percentile(g_latencies, 1.0) << std::endl
+              << "wall_time_s " << wallSeconds << std::endl;
+
+    Simulator::Destroy();
+    return 0;
+}
@@ -0,0 +1,293 @@
+#include "ns3/applications-module.h"
+#include "ns3/core-module.h"
+#include "ns3/cybertwin-edge-server-helper.h"
+#include "ns3/cybertwin-edge-server.h"
+#include "ns3/cybertwin-frame-buffer.h"
+#include "ns3/internet-module.h"
+#include "ns3/network-module.h"
+#include "ns3/point-to-point-module.h"
+
+#include <chrono>
+#include <deque>
+
+// Cybertwin controller scale benchmark
+//
+//   provisioner -------------- edge server (CybertwinController)
+//               point-to-point
+//
+// The provisioner asks the controller to create a large number of
+// cybertwins at once, either one CYBERTWIN_CREATE message per device or
+// CYBERTWIN_CREATE_BATCH messages of batchSize devices, and reports how many
+// twins were created per simulated and per wall-clock second.
+
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE("CybertwinControllerBenchmark");
+
+class TwinProvisioner : public Application
+{
+  public:
+    TwinProvisioner();
+
+    void Setup(Address controller, uint16_t port, uint32_t nTwins, uint32_t batchSize);
+
+    uint32_t GetCreated() const;
+    uint32_t GetFailed() const;
+    Time GetFirstRequest() const;
+    Time GetLastResponse() const;
+
+  private:
+    void StartApplication() override;
+    void StopApplication() override;
+
+    void ConnectSucceeded(Ptr<Socket> socket);
+    void ConnectFailed(Ptr<Socket> socket);
+    void SendPending(Ptr<Socket> socket, uint32_t txSpace);
+    void Receive(Ptr<Socket> socket);
+    void CountResult(uint16_t status);
+
+    Ptr<Socket> m_socket;
+    Address m_controller;
+    uint16_t m_port;
+    uint32_t m_nTwins;
+    uint32_t m_batchSize;
+    std::deque<Ptr<Packet>> m_pending;
+    CybertwinFrameBuffer m_rxBuffer;
+    uint32_t m_created;
+    uint32_t m_failed;
+    Time m_firstRequest;
+    Time m_lastResponse;
+};
+
+TwinProvisioner::TwinProvisioner()
+    : m_socket(nullptr),
+      m_port(0),
+      m_nTwins(0),
+      m_batchSize(1),
+      m_created(0),
+      m_failed(0)
+{
+}
+
+void
+TwinProvisioner::Setup(Address controller, uint16_t port, uint32_t nTwins, uint32_t batchSize)
+{
+    m_controller = controller;
+    m_port = port;
+    m_nTwins = nTwins;
+    m_batchSize = batchSize;
+}
+
+uint32_t
+TwinProvisioner::GetCreated() const
+{
+    return m_created;
+}
+
+uint32_t
+TwinProvisioner::GetFailed() const
+{
+    return m_failed;
+}
+
+Time
+TwinProvisioner::GetFirstRequest() const
+{
+    return m_firstRequest;
+}
+
+Time
+TwinProvisioner::GetLastResponse() const
+{
+    return m_lastResponse;
+}
+
+void
+TwinProvisioner::StartApplication()
+{
+    m_socket = Socket::CreateSocket(GetNode(), TcpSocketFactory::GetTypeId());
+    m_socket->Bind();
+    m_socket->SetConnectCallback(MakeCallback(&TwinProvisioner::ConnectSucceeded, this),
+                                 MakeCallback(&TwinProvisioner::ConnectFailed, this));
+    m_socket->Connect(InetSocketAddress(Ipv4Address::ConvertFrom(m_controller), m_port));
+}
+
+void
+TwinProvisioner::StopApplication()
+{
+    if (m_socket)
+    {
+        m_socket->Close();
+    }
+}
+
+void
+TwinProvisioner::ConnectSucceeded(Ptr<Socket> socket)
+{
+    socket->SetRecvCallback(MakeCallback(&TwinProvisioner::Receive, this));
+    socket->SetSendCallback(MakeCallback(&TwinProvisioner::SendPending, this));
+
+    for (uint32_t first = 0; first < m_nTwins; first += m_batchSize)
+    {
+        uint32_t last = std::min(m_nTwins, first + m_batchSize);
+        Ptr<Packet> packet = Create<Packet>(0);
+        if (m_batchSize == 1)
+        {
+            CybertwinControllerHeader header;
+            header.SetMethod(CYBERTWIN_CREATE);
+            header.SetDeviceName(first);
+            header.SetNetworkType(0);
+            packet->AddHeader(header);
+        }
+        else
+        {
+            CybertwinControllerBatchHeader header;
+            header.SetMethod(CYBERTWIN_CREATE_BATCH);
+            for (uint32_t dev = first; dev < last; dev++)
+            {
+                header.AddEntry(dev, 0, 0);
+            }
+            packet->AddHeader(header);
+        }
+        m_pending.push_back(packet);
+    }
+
+    m_firstRequest = Simulator::Now();
+    SendPending(socket, socket->GetTxAvailable());
+}
+
+void
+TwinProvisioner::ConnectFailed(Ptr<Socket> socket)
+{
+    NS_FATAL_ERROR("Provisioner failed to connect to the controller");
+}
+
+void
+TwinProvisioner::SendPending(Ptr<Socket> socket, uint32_t txSpace)
+{
+    while (!m_pending.empty() && socket->GetTxAvailable() >= m_pending.front()->GetSize())
+    {
+        socket->Send(m_pending.front());
+        m_pending.pop_front();
+    }
+}
+
+void
+TwinProvisioner::CountResult(uint16_t status)
+{
+    if (status == CYBERTWIN_CONTROLLER_SUCCESS)
+    {
+        m_created++;
+    }
+    else
+    {
+        m_failed++;
+    }
+    m_lastResponse = Simulator::Now();
+}
+
+void
+TwinProvisioner::Receive(Ptr<Socket> socket)
+{
+    Ptr<Packet> packet;
+    while ((packet = socket->Recv()))
+    {
+        m_rxBuffer.Append(packet);
+    }
+
+    const uint32_t singleSize = CybertwinControllerHeader().GetSerializedSize();
+    while (m_rxBuffer.GetSize() >= CybertwinControllerBatchHeader::GetFixedSize())
+    {
+        uint8_t prefix[4];
+        m_rxBuffer.CopyData(prefix, sizeof(prefix));
+        uint16_t method = (prefix[0] << 8) | prefix[1];
+        uint32_t size = singleSize;
+        if (method == CYBERTWIN_BATCH_RESPONSE)
+        {
+            size = CybertwinControllerBatchHeader::GetFixedSize() +
+                   ((prefix[2] << 8) | prefix[3]) * CybertwinControllerBatchHeader::GetEntrySize();
+        }
+        if (m_rxBuffer.GetSize() < size)
+        {
+            break;
+        }
+
+        Ptr<Packet> message = m_rxBuffer.Remove(size);
+        if (method == CYBERTWIN_BATCH_RESPONSE)
+        {
+            CybertwinControllerBatchHeader header;
+            message->RemoveHeader(header);
+            for (uint32_t i = 0; i < header.GetNEntries(); i++)
+            {
+                CountResult(header.GetStatus(i));
+            }
+        }
+        else
+        {
+            CountResult(method);
+        }
+    }
+}
+
+int
+main(int argc, char* argv[])
+{
+    uint32_t nTwins = 10000;
+    uint32_t batchSize = 100;
+    bool lazy = true;
+
+    CommandLine cmd(__FILE__);
+    cmd.AddValue("twins", "Number of cybertwins to create", nTwins);
+    cmd.AddValue("batchSize", "Devices per create message, 1 sends unbatched requests", batchSize);
+    cmd.AddValue("lazy", "Open the twins' global sockets only when their end host connects", lazy);
+    cmd.Parse(argc, argv);
+
+    NS_ABORT_MSG_IF(batchSize == 0, "batchSize must be at least 1");
+    Config::SetDefault("ns3::Cybertwin::LazyGlobalSocket", BooleanValue(lazy));
+
+    NodeContainer nodes;
+    nodes.Create(2);
+
+    PointToPointHelper p2p;
+    p2p.SetDeviceAttribute("DataRate", StringValue("1Gbps"));
+    p2p.SetChannelAttribute("Delay", StringValue("1ms"));
+    NetDeviceContainer devices = p2p.Install(nodes);
+
+    InternetStackHelper stack;
+    stack.Install(nodes);
+
+    Ipv4AddressHelper address;
+    address.SetBase("10.1.1.0", "255.255.255.0");
+    Ipv4InterfaceContainer interfaces = address.Assign(devices);
+
+    CybertwinEdgeServerHelper edgeServer(interfaces.GetAddress(1));
+    ApplicationContainer edgeApps = edgeServer.Install(nodes.Get(1));
+    edgeApps.Start(Seconds(0.0));
+
+    Ptr<TwinProvisioner> provisioner = CreateObject<TwinProvisioner>();
+    provisioner->Setup(interfaces.GetAddress(1), 443, nTwins, batchSize);
+    nodes.Get(0)->AddApplication(provisioner);
+    provisioner->SetStartTime(Seconds(1.0));
+
+    auto wallStart = std::chrono::steady_clock::now();
+    Simulator::Stop(Seconds(100));
+    Simulator::Run();
+    double wallSeconds =
+        std::chrono::duration<double>(std::chrono::steady_clock::now() - wallStart).count();
+
+    double simSeconds =
+        (provisioner->GetLastResponse() - provisioner->GetFirstRequest()).GetSeconds();
+    std::cout << "twins " << nTwins << std::endl
+              << "batch_size " << batchSize << std::endl
+              << "created " << provisioner->GetCreated() << std::endl
+              << "failed " << provisioner->GetFailed() << std::endl
+              << "events " << Simulator::GetEventCount() << std::endl
+              << "sim_time_s " << simSeconds << std::endl
+              << "wall_time_s " << wallSeconds << std::endl
+              << "twins_per_sim_second "
+              << (simSeconds > 0 ? provisioner->GetCreated() / simSeconds : 0) << std::endl
+              << "twins_per_wall_second " << provisioner->GetCreated() / wallSeconds << std::endl;
+
+    Simulator::Destroy();
+    return 0;
+}
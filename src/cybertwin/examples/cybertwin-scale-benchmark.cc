@@ -0,0 +1,249 @@
+#include "ns3/applications-module.h"
+#include "ns3/core-module.h"
+#include "ns3/cybertwin-bulk-client-helper.h"
+#include "ns3/cybertwin-bulk-client.h"
+#include "ns3/cybertwin-edge-server-helper.h"
+#include "ns3/cybertwin-name-resolution-service.h"
+#include "ns3/internet-module.h"
+#include "ns3/network-module.h"
+#include "ns3/point-to-point-module.h"
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <sys/resource.h>
+#include <vector>
+
+// Cybertwin end-to-end scale benchmark
+//
+//   host ... host      host ... host
+//      \     /            \     /
+//       edge 0    ...     edge N-1      (each edge runs a CybertwinController)
+//           \               /
+//            \____ core ___/            (core runs the CNRS)
+//
+// Every end host gets a cybertwin on its edge and streams to the host with
+// the same index on the next edge, through the two cybertwins. The program
+// reports simulator events per wall-clock second, wall time, peak RSS,
+// bytes forwarded end to end and the per-frame latency distribution, either
+// as "key value" lines or as a JSON object, so runs can be compared across
+// releases.
+
+using namespace ns3;
+
+NS_LOG_COMPONENT_DEFINE("CybertwinScaleBenchmark");
+
+static uint64_t g_txBytes = 0;
+static uint64_t g_txFrames = 0;
+static uint64_t g_rxBytes = 0;
+static uint64_t g_rxFrames = 0;
+static std::vector<double> g_latencies;
+
+static void
+FrameSent(Ptr<const Packet> packet)
+{
+    g_txBytes += packet->GetSize();
+    g_txFrames++;
+}
+
+static void
+FrameReceived(Ptr<const Packet> packet)
+{
+    g_rxBytes += packet->GetSize();
+    g_rxFrames++;
+}
+
+static void
+FrameStamped(Ptr<const Packet> packet, const SeqTsHeader& header)
+{
+    g_latencies.push_back((Simulator::Now() - header.GetTs()).GetSeconds() * 1e3);
+}
+
+static double
+Percentile(const std::vector<double>& sorted, double p)
+{
+    if (sorted.empty())
+    {
+        return 0;
+    }
+    return sorted[std::min<std::size_t>(sorted.size() - 1, sorted.size() * p)];
+}
+
+int
+main(int argc, char* argv[])
+{
+    uint32_t nEdges = 4;
+    uint32_t nHosts = 8;
+    uint32_t sendSize = 1024;
+    uint64_t maxBytes = 1000000;
+    double duration = 20;
+    std::string accessRate = "100Mbps";
+    std::string coreRate = "1Gbps";
+    std::string format = "text";
+    std::string output = "";
+
+    CommandLine cmd(__FILE__);
+    cmd.AddValue("edges", "Number of edge servers", nEdges);
+    cmd.AddValue("hosts", "Number of end hosts per edge server, each running one flow", nHosts);
+    cmd.AddValue("sendSize", "Payload bytes per frame", sendSize);
+    cmd.AddValue("maxBytes", "Payload bytes per flow, 0 streams until the end", maxBytes);
+    cmd.AddValue("duration", "Simulated seconds", duration);
+    cmd.AddValue("accessRate", "Data rate of the host to edge links", accessRate);
+    cmd.AddValue("coreRate", "Data rate of the edge to core links", coreRate);
+    cmd.AddValue("format", "Output format, text or json", format);
+    cmd.AddValue("output", "Write the results to this file instead of stdout", output);
+    cmd.Parse(argc, argv);
+
+    NS_ABORT_MSG_IF(nEdges == 0 || nHosts == 0, "Need at least one edge and one host");
+    NS_ABORT_MSG_IF(format != "text" && format != "json", "Unknown format " << format);
+
+    NodeContainer core;
+    core.Create(1);
+    NodeContainer edges;
+    edges.Create(nEdges);
+    std::vector<NodeContainer> hosts(nEdges);
+    for (auto& edgeHosts : hosts)
+    {
+        edgeHosts.Create(nHosts);
+    }
+
+    InternetStackHelper stack;
+    stack.Install(core);
+    stack.Install(edges);
+    for (auto& edgeHosts : hosts)
+    {
+        stack.Install(edgeHosts);
+    }
+
+    PointToPointHelper coreLink;
+    coreLink.SetDeviceAttribute("DataRate", StringValue(coreRate));
+    coreLink.SetChannelAttribute("Delay", StringValue("5ms"));
+    PointToPointHelper accessLink;
+    accessLink.SetDeviceAttribute("DataRate", StringValue(accessRate));
+    accessLink.SetChannelAttribute("Delay", StringValue("1ms"));
+
+    Ipv4AddressHelper address;
+    address.SetBase("10.0.0.0", "255.255.255.252");
+    Ipv4Address cnrsAddr;
+    std::vector<Ipv4Address> edgeAddrs;
+    for (uint32_t e = 0; e < nEdges; e++)
+    {
+        Ipv4InterfaceContainer ifs = address.Assign(coreLink.Install(core.Get(0), edges.Get(e)));
+        address.NewNetwork();
+        cnrsAddr = ifs.GetAddress(0);
+        edgeAddrs.push_back(ifs.GetAddress(1));
+    }
+
+    std::vector<std::vector<Ipv4Address>> hostAddrs(nEdges);
+    for (uint32_t e = 0; e < nEdges; e++)
+    {
+        for (uint32_t h = 0; h < nHosts; h++)
+        {
+            Ipv4InterfaceContainer ifs =
+                address.Assign(accessLink.Install(hosts[e].Get(h), edges.Get(e)));
+            address.NewNetwork();
+            hostAddrs[e].push_back(ifs.GetAddress(0));
+        }
+    }
+    Ipv4GlobalRoutingHelper::PopulateRoutingTables();
+
+    Ptr<NameResolutionService> cnrs = CreateObject<NameResolutionService>();
+    core.Get(0)->AddApplication(cnrs);
+
+    for (uint32_t e = 0; e < nEdges; e++)
+    {
+        CybertwinEdgeServerHelper edgeServer(edgeAddrs[e]);
+        edgeServer.SetAttribute("NameResolutionServer", AddressValue(cnrsAddr));
+        edgeServer.Install(edges.Get(e)).Start(Seconds(0.0));
+    }
+
+    Ptr<UniformRandomVariable> jitter = CreateObject<UniformRandomVariable>();
+    for (uint32_t e = 0; e < nEdges; e++)
+    {
+        for (uint32_t h = 0; h < nHosts; h++)
+        {
+            uint64_t guid = 1 + e * nHosts + h;
+            uint64_t peer = nEdges > 1 ? 1 + ((e + 1) % nEdges) * nHosts + h
+                                       : 1 + (h + 1) % nHosts;
+            CybertwinBulkClientHelper client(guid, peer, hostAddrs[e][h], edgeAddrs[e]);
+            client.SetAttribute("SendSize", UintegerValue(sendSize));
+            client.SetAttribute("MaxBytes", UintegerValue(maxBytes));
+            ApplicationContainer apps = client.Install(hosts[e].Get(h));
+            apps.Start(Seconds(1.0 + jitter->GetValue(0, 0.1)));
+        }
+    }
+
+    Config::ConnectWithoutContext("/NodeList/*/ApplicationList/*/$ns3::CybertwinBulkClient/Tx",
+                                  MakeCallback(&FrameSent));
+    Config::ConnectWithoutContext("/NodeList/*/ApplicationList/*/$ns3::CybertwinBulkClient/Rx",
+                                  MakeCallback(&FrameReceived));
+    Config::ConnectWithoutContext(
+        "/NodeList/*/ApplicationList/*/$ns3::CybertwinBulkClient/RxWithSeqTs",
+        MakeCallback(&FrameStamped));
+
+    auto wallStart = std::chrono::steady_clock::now();
+    Simulator::Stop(Seconds(duration));
+    Simulator::Run();
+    double wallSeconds =
+        std::chrono::duration<double>(std::chrono::steady_clock::now() - wallStart).count();
+    uint64_t events = Simulator::GetEventCount();
+
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+
+    std::sort(g_latencies.begin(), g_latencies.end());
+    double mean = 0;
+    for (double latency : g_latencies)
+    {
+        mean += latency;
+    }
+    mean = g_latencies.empty() ? 0 : mean / g_latencies.size();
+
+    std::vector<std::pair<std::string, double>> results = {
+        {"edges", nEdges},
+        {"flows", nEdges * nHosts},
+        {"send_size", sendSize},
+        {"sim_time_s", duration},
+        {"wall_time_s", wallSeconds},
+        {"events", events},
+        {"events_per_second", wallSeconds > 0 ? events / wallSeconds : 0},
+        {"peak_rss_kb", usage.ru_maxrss},
+        {"bytes_sent", g_txBytes},
+        {"frames_sent", g_txFrames},
+        {"bytes_forwarded", g_rxBytes},
+        {"frames_forwarded", g_rxFrames},
+        {"latency_mean_ms", mean},
+        {"latency_p50_ms", Percentile(g_latencies, 0.5)},
+        {"latency_p90_ms", Percentile(g_latencies, 0.9)},
+        {"latency_p99_ms", Percentile(g_latencies, 0.99)},
+        {"latency_max_ms", Percentile(g_latencies, 1.0)},
+    };
+
+    std::ofstream file;
+    if (!output.empty())
+    {
+        file.open(output);
+        NS_ABORT_MSG_IF(!file, "Cannot write " << output);
+    }
+    std::ostream& os = output.empty() ? std::cout : file;
+    os.precision(10);
+    if (format == "json")
+    {
+        os << "{";
+        for (std::size_t i = 0; i < results.size(); i++)
+        {
+            os << (i ? ", " : "") << "\"" << results[i].first << "\": " << results[i].second;
+        }
+        os << "}" << std::endl;
+    }
+    else
+    {
+        for (auto& result : results)
+        {
+            os << result.first << " " << result.second << std::endl;
+        }
+    }
+
+    Simulator::Destroy();
+    return 0;
+}
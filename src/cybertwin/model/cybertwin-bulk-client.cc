@@ -7,6 +7,8 @@
 #include "ns3/uinteger.h"
 #include "ns3/simulator.h"
 
+#include <algorithm>
+
 namespace ns3
 {
 NS_LOG_COMPONENT_DEFINE("CybertwinBulkClient");
@@ -25,6 +27,12 @@ CybertwinBulkClient::GetTypeId()
                           UintegerValue(512),
                           MakeUintegerAccessor(&CybertwinBulkClient::m_sendSize),
                           MakeUintegerChecker<uint32_t>(1))
+            .AddAttribute("MaxBytes",
+                          "The total number of payload bytes to send, 0 sends until the "
+                          "application stops",
+                          UintegerValue(0),
+                          MakeUintegerAccessor(&CybertwinBulkClient::m_maxBytes),
+                          MakeUintegerChecker<uint64_t>())
             .AddAttribute("EdgeAddress",
                           "The address of the edge server serving this LAN",
                           AddressValue(),
@@ -54,13 +62,28 @@ CybertwinBulkClient::GetTypeId()
                           "The Guid of the peer device",
                           UintegerValue(),
                           MakeUintegerAccessor(&CybertwinBulkClient::m_peerGuid),
-                          MakeUintegerChecker<uint64_t>());
+                          MakeUintegerChecker<uint64_t>())
+            .AddTraceSource("Tx",
+                            "The payload of a frame has been sent to the cybertwin",
+                            MakeTraceSourceAccessor(&CybertwinBulkClient::m_txTrace),
+                            "ns3::Packet::TracedCallback")
+            .AddTraceSource("Rx",
+                            "The payload of a frame has been received from the cybertwin",
+                            MakeTraceSourceAccessor(&CybertwinBulkClient::m_rxTrace),
+                            "ns3::Packet::TracedCallback")
+            .AddTraceSource("RxWithSeqTs",
+                            "A frame carrying a SeqTsHeader has been received",
+                            MakeTraceSourceAccessor(&CybertwinBulkClient::m_rxSeqTsTrace),
+                            "ns3::CybertwinBulkClient::SeqTsCallback");
     return tid;
 }
 
 CybertwinBulkClient::CybertwinBulkClient()
     : controllerSocket(nullptr),
     cybertwinSocket(nullptr),
+    m_totBytes(0),
+    m_seq(0),
+    m_txOffset(0),
     cybertwinID(0)
 {
     NS_LOG_FUNCTION(this);
@@ -76,6 +99,9 @@ CybertwinBulkClient::DoDispose()
 {
     NS_LOG_FUNCTION(this);
     controllerSocket = nullptr;
+    cybertwinSocket = nullptr;
+    m_txFrame = nullptr;
+    m_rxBuffer.Clear();
     Application::DoDispose();
 }
 
@@ -113,6 +139,12 @@ CybertwinBulkClient::StopApplication()
     {
         controllerSocket->Close();
     }
+    if (cybertwinSocket)
+    {
+        cybertwinSocket->SetSendCallback(MakeNullCallback<void, Ptr<Socket>, uint32_t>());
+        cybertwinSocket->SetRecvCallback(MakeNullCallback<void, Ptr<Socket>>());
+        cybertwinSocket->Close();
+    }
 }
 
 void
@@ -191,10 +223,18 @@ CybertwinBulkClient::Request2GenerateCybertwin()
     NS_LOG_DEBUG("Clinet Request to Generate a Cybertwin.");
     CybertwinControllerHeader header;
 
-    arc4random ();
     header.SetMethod(CYBERTWIN_CREATE);
-    header.SetDeviceName(rand()%1333333);
-    header.SetNetworkType(rand()%3);
+    if (m_localGuid)
+    {
+        // the controller derives the Cybertwin ID from the name, so peers can address us
+        header.SetDeviceName(m_localGuid);
+        header.SetNetworkType(0);
+    }else
+    {
+        arc4random ();
+        header.SetDeviceName(rand()%1333333);
+        header.SetNetworkType(rand()%3);
+    }
 
     Ptr<Packet> connPacket = Create<Packet>(0);
     
@@ -212,14 +252,87 @@ void
 CybertwinBulkClient::RequestNetworkService()
 {
     NS_LOG_DEBUG("CybertwinBulkClient request network service.");
-    // connect to cybertwin
-    Ptr<Packet> connPacket = Create<Packet>(128);
+    cybertwinSocket->SetSendCallback(MakeCallback(&CybertwinBulkClient::CybertwinSendCallback, this));
+    SendData();
+}
+
+void
+CybertwinBulkClient::SendData()
+{
     CybertwinPacketHeader reqHeader;
-    reqHeader.SetSrc(cybertwinID);
-    reqHeader.SetDst(cybertwinID + 1);
+    SeqTsHeader seqTs;
+
+    while (true)
+    {
+        if (!m_txFrame)
+        {
+            if (m_maxBytes > 0 && m_totBytes >= m_maxBytes)
+            {
+                break;
+            }
+            uint32_t size = m_sendSize;
+            if (m_maxBytes > 0 && m_maxBytes - m_totBytes < size)
+            {
+                size = m_maxBytes - m_totBytes;
+            }
+
+            // stamp the payload when it is large enough, for latency measurements
+            if (size >= seqTs.GetSerializedSize())
+            {
+                m_txFrame = Create<Packet>(size - seqTs.GetSerializedSize());
+                seqTs.SetSeq(m_seq++);
+                m_txFrame->AddHeader(seqTs);
+            }else
+            {
+                m_txFrame = Create<Packet>(size);
+            }
+
+            reqHeader.SetSrc(cybertwinID);
+            reqHeader.SetDst(m_peerGuid ? m_peerGuid : cybertwinID + 1);
+            // lets the cybertwin find the frame boundaries in the stream
+            reqHeader.SetSize(size);
+            m_txFrame->AddHeader(reqHeader);
+            m_txOffset = 0;
+            m_totBytes += size;
+        }
 
-    connPacket->AddHeader(reqHeader);
-    cybertwinSocket->Send(connPacket);
+        // a frame larger than the send buffer is written in pieces, the
+        // rest of it is sent from the send callback
+        uint32_t left = m_txFrame->GetSize() - m_txOffset;
+        uint32_t toSend = std::min(cybertwinSocket->GetTxAvailable(), left);
+        if (toSend == 0)
+        {
+            // wait for the send callback
+            break;
+        }
+        Ptr<Packet> piece = toSend == m_txFrame->GetSize()
+                                ? m_txFrame
+                                : m_txFrame->CreateFragment(m_txOffset, toSend);
+        int sent = cybertwinSocket->Send(piece);
+        if (sent <= 0)
+        {
+            break;
+        }
+        m_txOffset += sent;
+        if (m_txOffset == m_txFrame->GetSize())
+        {
+            // trace the payload only, the same as Rx reports it
+            if (!m_txTrace.IsEmpty())
+            {
+                CybertwinPacketHeader header;
+                Ptr<Packet> payload = m_txFrame->Copy();
+                payload->RemoveHeader(header);
+                m_txTrace(payload);
+            }
+            m_txFrame = nullptr;
+        }
+    }
+}
+
+void
+CybertwinBulkClient::CybertwinSendCallback(Ptr<Socket> socket, uint32_t txSpace)
+{
+    SendData();
 }
 
 void
@@ -282,6 +395,27 @@ void
 CybertwinBulkClient::RecvFromCybertwinCallback(Ptr<Socket> socket)
 {
     NS_LOG_DEBUG("- Client - : recv from Cybertwin.");
+    Ptr<Packet> packet;
+    while ((packet = socket->Recv()))
+    {
+        m_rxBuffer.Append(packet);
+    }
+
+    CybertwinPacketHeader header;
+    SeqTsHeader seqTs;
+    const uint32_t headerSize = header.GetSerializedSize();
+    while (m_rxBuffer.PeekHeader(header, headerSize) &&
+           m_rxBuffer.GetSize() >= headerSize + header.GetSize())
+    {
+        Ptr<Packet> frame = m_rxBuffer.Remove(headerSize + header.GetSize());
+        frame->RemoveHeader(header);
+        m_rxTrace(frame);
+        if (frame->GetSize() >= seqTs.GetSerializedSize())
+        {
+            frame->PeekHeader(seqTs);
+            m_rxSeqTsTrace(frame, seqTs);
+        }
+    }
 }
 
 } // namespace ns3
\ No newline at end of file
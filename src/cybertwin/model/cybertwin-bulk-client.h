@@ -3,9 +3,12 @@
 
 #include "cybertwin-packet-header.h"
 #include "cybertwin-common.h"
+#include "cybertwin-frame-buffer.h"
 
 #include "ns3/address.h"
 #include "ns3/application.h"
+#include "ns3/seq-ts-header.h"
+#include "ns3/traced-callback.h"
 #include <stdlib.h>
 #include <time.h>
 
@@ -37,6 +40,15 @@ class CybertwinBulkClient : public Application
 
     void RequestNetworkService();
 
+    /**
+     * TracedCallback signature for frames received with a sequence number
+     * and the time they were sent at.
+     *
+     * \param [in] packet The payload of the frame.
+     * \param [in] header The SeqTsHeader stamped by the sender.
+     */
+    typedef void (*SeqTsCallback)(Ptr<const Packet> packet, const SeqTsHeader& header);
+
   protected:
     void DoDispose() override;
 
@@ -45,6 +57,8 @@ class CybertwinBulkClient : public Application
     void StopApplication() override;
 
     void Connect();
+    void SendData();
+    void CybertwinSendCallback(Ptr<Socket> socket, uint32_t txSpace);
 
     Ptr<Socket> controllerSocket;
     Ptr<Socket> cybertwinSocket;
@@ -59,6 +73,16 @@ class CybertwinBulkClient : public Application
     uint64_t m_peerGuid;
 
     uint32_t m_sendSize;
+    uint64_t m_maxBytes;
+    uint64_t m_totBytes;
+    uint32_t m_seq;
+    Ptr<Packet> m_txFrame; // frame being written to the cybertwin socket
+    uint32_t m_txOffset;   // bytes of m_txFrame already written
+    CybertwinFrameBuffer m_rxBuffer; // partial frames from the cybertwin
+
+    TracedCallback<Ptr<const Packet>> m_txTrace;
+    TracedCallback<Ptr<const Packet>> m_rxTrace;
+    TracedCallback<Ptr<const Packet>, const SeqTsHeader&> m_rxSeqTsTrace;
 
     CYBERTWINID_t cybertwinID;
     uint16_t cybertwinPort;
@@ -0,0 +1,266 @@
+#include "cybertwin-cnrs-database.h"
+
+#include "ns3/log.h"
+
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <fstream>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace ns3
+{
+NS_LOG_COMPONENT_DEFINE("CnrsDatabase");
+
+namespace
+{
+
+const char CNRS_DB_MAGIC[8] = {'C', 'N', 'R', 'S', 'D', 'B', '0', '1'};
+
+struct CnrsDatabaseFileHeader
+{
+    char magic[8];
+    uint32_t recordSize;
+    uint32_t reserved;
+    uint64_t capacity;
+    uint64_t count;
+    uint8_t padding[32];
+};
+
+static_assert(sizeof(CnrsDatabaseFileHeader) == 64, "CNRS database header must be 64 bytes");
+static_assert(sizeof(CnrsDatabase::Record) == 16, "CNRS database records must be 16 bytes");
+
+} // namespace
+
+//********************************************************************
+//*                       CNRS Database                              *
+//********************************************************************
+
+CnrsDatabase::CnrsDatabase()
+    : m_map(nullptr),
+      m_mapSize(0),
+      m_records(nullptr),
+      m_capacity(0),
+      m_count(0)
+{
+}
+
+CnrsDatabase::~CnrsDatabase()
+{
+    Close();
+}
+
+uint64_t
+CnrsDatabase::Hash(CYBERTWINID_t id)
+{
+    // splitmix64 finalizer, sequential IDs land far apart
+    uint64_t x = id + 0x9E3779B97F4A7C15ULL;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+    return x ^ (x >> 31);
+}
+
+bool
+CnrsDatabase::Open(const std::string& path)
+{
+    NS_LOG_FUNCTION(this << path);
+    Close();
+
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+    {
+        NS_LOG_DEBUG("CNRS database " << path << " does not exist.");
+        return false;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) < 0 || static_cast<std::size_t>(st.st_size) < sizeof(CnrsDatabaseFileHeader))
+    {
+        NS_LOG_ERROR("CNRS database " << path << " is truncated.");
+        close(fd);
+        return false;
+    }
+
+    void* map = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED)
+    {
+        NS_LOG_ERROR("Failed to map CNRS database " << path);
+        return false;
+    }
+
+    const CnrsDatabaseFileHeader* header = static_cast<const CnrsDatabaseFileHeader*>(map);
+    // bound the capacity by the file before multiplying, a forged one could wrap
+    uint64_t maxCapacity = (st.st_size - sizeof(CnrsDatabaseFileHeader)) / sizeof(Record);
+    bool valid = std::memcmp(header->magic, CNRS_DB_MAGIC, sizeof(CNRS_DB_MAGIC)) == 0 &&
+                 header->recordSize == sizeof(Record) && header->capacity != 0 &&
+                 header->capacity <= maxCapacity &&
+                 (header->capacity & (header->capacity - 1)) == 0 &&
+                 header->count < header->capacity &&
+                 static_cast<std::size_t>(st.st_size) ==
+                     sizeof(CnrsDatabaseFileHeader) + header->capacity * sizeof(Record);
+    if (!valid)
+    {
+        NS_LOG_ERROR("CNRS database " << path << " is not a valid database.");
+        munmap(map, st.st_size);
+        return false;
+    }
+
+    m_map = map;
+    m_mapSize = st.st_size;
+    m_capacity = header->capacity;
+    m_count = header->count;
+    m_records = reinterpret_cast<const Record*>(static_cast<const char*>(map) +
+                                                sizeof(CnrsDatabaseFileHeader));
+    NS_LOG_DEBUG("Mapped " << m_count << " CNRS records from " << path);
+    return true;
+}
+
+void
+CnrsDatabase::Close()
+{
+    if (m_map)
+    {
+        munmap(m_map, m_mapSize);
+    }
+    m_map = nullptr;
+    m_mapSize = 0;
+    m_records = nullptr;
+    m_capacity = 0;
+    m_count = 0;
+}
+
+bool
+CnrsDatabase::IsOpen() const
+{
+    return m_map != nullptr;
+}
+
+bool
+CnrsDatabase::Find(CYBERTWINID_t id, uint32_t& ip, uint16_t& port) const
+{
+    if (!m_records)
+    {
+        return false;
+    }
+
+    uint64_t mask = m_capacity - 1;
+    uint64_t slot = Hash(id) & mask;
+    // a file with every slot used has no empty slot to stop at
+    for (uint64_t probes = 0; probes < m_capacity; probes++, slot = (slot + 1) & mask)
+    {
+        const Record& record = m_records[slot];
+        if (!record.used)
+        {
+            return false;
+        }
+        if (record.cybertwinID == id)
+        {
+            ip = record.cybertwinAddr;
+            port = record.cybertwinPort;
+            return true;
+        }
+    }
+    return false;
+}
+
+uint64_t
+CnrsDatabase::GetNRecords() const
+{
+    return m_count;
+}
+
+uint64_t
+CnrsDatabase::GetCapacity() const
+{
+    return m_capacity;
+}
+
+const CnrsDatabase::Record*
+CnrsDatabase::GetRecords() const
+{
+    return m_records;
+}
+
+//********************************************************************
+//*                    CNRS Database Writer                          *
+//********************************************************************
+
+CnrsDatabaseWriter::CnrsDatabaseWriter(uint64_t expectedRecords)
+    : m_count(0)
+{
+    // keep the table at most half full
+    uint64_t capacity = 16;
+    while (capacity < 2 * expectedRecords)
+    {
+        capacity <<= 1;
+    }
+    m_records.assign(capacity, CnrsDatabase::Record{0, 0, 0, 0});
+}
+
+void
+CnrsDatabaseWriter::Insert(CYBERTWINID_t id, uint32_t ip, uint16_t port)
+{
+    uint64_t mask = m_records.size() - 1;
+    uint64_t slot = CnrsDatabase::Hash(id) & mask;
+    while (m_records[slot].used && m_records[slot].cybertwinID != id)
+    {
+        slot = (slot + 1) & mask;
+    }
+
+    if (!m_records[slot].used)
+    {
+        NS_ASSERT_MSG(2 * (m_count + 1) <= m_records.size(),
+                      "More CNRS records than the writer was sized for");
+        m_count++;
+    }
+    m_records[slot] = {id, ip, port, 1};
+}
+
+uint64_t
+CnrsDatabaseWriter::GetNRecords() const
+{
+    return m_count;
+}
+
+bool
+CnrsDatabaseWriter::Commit(const std::string& path) const
+{
+    NS_LOG_FUNCTION(this << path);
+    CnrsDatabaseFileHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, CNRS_DB_MAGIC, sizeof(CNRS_DB_MAGIC));
+    header.recordSize = sizeof(CnrsDatabase::Record);
+    header.capacity = m_records.size();
+    header.count = m_count;
+
+    std::string tmpPath = path + ".tmp";
+    std::ofstream out(tmpPath, std::ios::binary | std::ios::trunc);
+    if (!out)
+    {
+        NS_LOG_ERROR("Failed to create CNRS database " << tmpPath);
+        return false;
+    }
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    out.write(reinterpret_cast<const char*>(m_records.data()),
+              m_records.size() * sizeof(CnrsDatabase::Record));
+    out.close();
+    if (!out)
+    {
+        NS_LOG_ERROR("Failed to write CNRS database " << tmpPath);
+        std::remove(tmpPath.c_str());
+        return false;
+    }
+
+    if (std::rename(tmpPath.c_str(), path.c_str()) != 0)
+    {
+        NS_LOG_ERROR("Failed to replace CNRS database " << path);
+        std::remove(tmpPath.c_str());
+        return false;
+    }
+    return true;
+}
+
+} // namespace ns3
@@ -0,0 +1,79 @@
+#ifndef CYBERTWIN_CNRS_DATABASE_H
+#define CYBERTWIN_CNRS_DATABASE_H
+
+#include "cybertwin-common.h"
+
+#include "ns3/simple-ref-count.h"
+
+#include <string>
+#include <vector>
+
+namespace ns3
+{
+
+/**
+ * On-disk CNRS name table.
+ *
+ * The file is a fixed 64-byte header followed by a power-of-two array of
+ * 16-byte records addressed by open addressing with linear probing, kept at
+ * most half full. Opening a file only maps it, so lookups can start right
+ * away no matter how many names it holds; pages are faulted in on demand.
+ * Records are stored in host byte order.
+ */
+class CnrsDatabase : public SimpleRefCount<CnrsDatabase>
+{
+  public:
+    struct Record
+    {
+        CYBERTWINID_t cybertwinID;
+        uint32_t cybertwinAddr;
+        uint16_t cybertwinPort;
+        uint16_t used;
+    };
+
+    CnrsDatabase();
+    ~CnrsDatabase();
+
+    // maps an existing database file, returns false if it is missing or invalid
+    bool Open(const std::string& path);
+    void Close();
+    bool IsOpen() const;
+
+    bool Find(CYBERTWINID_t id, uint32_t& ip, uint16_t& port) const;
+    uint64_t GetNRecords() const;
+    uint64_t GetCapacity() const;
+    const Record* GetRecords() const;
+
+    static uint64_t Hash(CYBERTWINID_t id);
+
+  private:
+    void* m_map;
+    std::size_t m_mapSize;
+    const Record* m_records;
+    uint64_t m_capacity;
+    uint64_t m_count;
+};
+
+/**
+ * Builds a CnrsDatabase file in memory and writes it out atomically, so a
+ * mapped copy of the previous snapshot stays valid while the new one is
+ * written.
+ */
+class CnrsDatabaseWriter
+{
+  public:
+    CnrsDatabaseWriter(uint64_t expectedRecords);
+
+    // adds or replaces the record of a Cybertwin
+    void Insert(CYBERTWINID_t id, uint32_t ip, uint16_t port);
+    uint64_t GetNRecords() const;
+    bool Commit(const std::string& path) const;
+
+  private:
+    std::vector<CnrsDatabase::Record> m_records;
+    uint64_t m_count;
+};
+
+} // namespace ns3
+
+#endif
@@ -6,10 +6,13 @@
 #include "ns3/inet-socket-address.h"
 
 #define TX_MAX_NUM (128)
-#define LOCAL_PORT_COUNTER_START (40000)
-#define GLOBAL_PORT_COUNTER_START (50000)
+// below the ephemeral ports of ns-3 sockets, 49152-65535
+#define LOCAL_PORT_COUNTER_START (30000)
+#define GLOBAL_PORT_COUNTER_START (40000)
+#define GLOBAL_PORT_COUNTER_END (49151)
 
 #define NAME_RESOLUTION_SERVICE_PORT (5353)
+#define EDGE_TRANSPORT_PORT (7443)
 
 
 typedef uint64_t CYBERTWINID_t;
@@ -24,6 +27,9 @@ enum{
     CYBERTWIN_REMOVE,
     CYBERTWIN_CONTROLLER_SUCCESS,
     CYBERTWIN_CONTROLLER_ERROR,
+    CYBERTWIN_CREATE_BATCH,
+    CYBERTWIN_REMOVE_BATCH,
+    CYBERTWIN_BATCH_RESPONSE,
 };
 
 enum CNRS_METHOD
@@ -31,7 +37,8 @@ enum CNRS_METHOD
     CNRS_QUERY,
     CNRS_INSERT,
     CNRS_RESPONSE_OK,
-    CNRS_RESPONSE_FAIL
+    CNRS_RESPONSE_FAIL,
+    CNRS_INSERT_BATCH
 };
 
 #endif
\ No newline at end of file
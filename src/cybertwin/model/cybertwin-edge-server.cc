@@ -1,17 +1,24 @@
 #include "cybertwin-edge-server.h"
 
+#include "ns3/boolean.h"
+#include "ns3/ipv4-end-point.h"
 #include "ns3/log.h"
 #include "ns3/socket.h"
 #include "ns3/tcp-socket-factory.h"
+#include "ns3/tcp-l4-protocol.h"
 #include "ns3/tcp-socket.h"
 #include "ns3/uinteger.h"
 
+#include <algorithm>
+
 namespace ns3
 {
 
 NS_LOG_COMPONENT_DEFINE("CybertwinController");
 NS_OBJECT_ENSURE_REGISTERED(CybertwinController);
 
+std::unordered_map<uint64_t, Address> GuidTable;
+
 TypeId
 CybertwinController::GetTypeId()
 {
@@ -28,15 +35,48 @@ CybertwinController::GetTypeId()
                                           "The port on which the application sends data",
                                           UintegerValue(443),
                                           MakeUintegerAccessor(&CybertwinController::m_localPort),
-                                          MakeUintegerChecker<uint16_t>());
+                                          MakeUintegerChecker<uint16_t>())
+                            .AddAttribute("NameResolutionServer",
+                                          "The address of the CNRS the cybertwins resolve names with",
+                                          AddressValue(),
+                                          MakeAddressAccessor(&CybertwinController::m_cnrsAddr),
+                                          MakeAddressChecker())
+                            .AddAttribute("MultiplexPeers",
+                                          "Carry the traffic of all cybertwins over one connection per remote edge",
+                                          BooleanValue(true),
+                                          MakeBooleanAccessor(&CybertwinController::m_multiplexPeers),
+                                          MakeBooleanChecker())
+                            .AddAttribute("LocalPortMin",
+                                          "First port handed out for cybertwin local interfaces",
+                                          UintegerValue(LOCAL_PORT_COUNTER_START),
+                                          MakeUintegerAccessor(&CybertwinController::m_localPortMin),
+                                          MakeUintegerChecker<uint16_t>(1))
+                            .AddAttribute("LocalPortMax",
+                                          "Last port handed out for cybertwin local interfaces",
+                                          UintegerValue(GLOBAL_PORT_COUNTER_START - 1),
+                                          MakeUintegerAccessor(&CybertwinController::m_localPortMax),
+                                          MakeUintegerChecker<uint16_t>(1))
+                            .AddAttribute("GlobalPortMin",
+                                          "First port handed out for cybertwin global interfaces",
+                                          UintegerValue(GLOBAL_PORT_COUNTER_START),
+                                          MakeUintegerAccessor(&CybertwinController::m_globalPortMin),
+                                          MakeUintegerChecker<uint16_t>(1))
+                            .AddAttribute("GlobalPortMax",
+                                          "Last port handed out for cybertwin global interfaces",
+                                          UintegerValue(GLOBAL_PORT_COUNTER_END),
+                                          MakeUintegerAccessor(&CybertwinController::m_globalPortMax),
+                                          MakeUintegerChecker<uint16_t>(1));
     return tid;
 }
 
 CybertwinController::CybertwinController()
     : m_listenSocket(nullptr),
       m_controlTable(Create<CybertwinControlTable>()),
-      localPortCounter(LOCAL_PORT_COUNTER_START),
-      globalPortCounter(GLOBAL_PORT_COUNTER_START)
+      m_nameResolver(nullptr),
+      m_multiplexPeers(true),
+      m_edgeTransport(nullptr),
+      m_localPorts(nullptr),
+      m_globalPorts(nullptr)
 {
     NS_LOG_FUNCTION(this);
 }
@@ -51,12 +91,25 @@ CybertwinController::DoDispose()
     std::unordered_map<Ptr<Socket>, Ptr<StreamState>>::iterator it;
     for (it = m_streamBuffer.begin(); it != m_streamBuffer.end(); ++it)
     {
-        it->first->Close();
         it->first->SetCloseCallbacks(MakeNullCallback<void, Ptr<Socket>>(),
                                      MakeNullCallback<void, Ptr<Socket>>());
         it->first->SetRecvCallback(MakeNullCallback<void, Ptr<Socket>>());
     }
     m_streamBuffer.clear();
+    m_controlBuffer.clear();
+    m_pendingBatches.clear();
+    m_idleCybertwins.clear();
+
+    if (m_nameResolver)
+    {
+        m_nameResolver->Dispose();
+        m_nameResolver = nullptr;
+    }
+    if (m_edgeTransport)
+    {
+        m_edgeTransport->Dispose();
+        m_edgeTransport = nullptr;
+    }
 
     Application::DoDispose();
 }
@@ -65,6 +118,38 @@ void
 CybertwinController::StartApplication()
 {
     NS_LOG_FUNCTION(this);
+    if (!m_nameResolver && !m_cnrsAddr.IsInvalid())
+    {
+        m_nameResolver = CreateObject<NameResolutionClient>();
+        m_nameResolver->SetAttribute("ServerAddress", AddressValue(m_cnrsAddr));
+        m_nameResolver->SetNode(GetNode());
+    }
+
+    if (!m_localPorts)
+    {
+        NS_ABORT_MSG_IF(m_localPortMin > m_localPortMax || m_globalPortMin > m_globalPortMax,
+                        "Invalid cybertwin port range");
+        NS_ABORT_MSG_IF(m_localPortMin <= m_globalPortMax && m_globalPortMin <= m_localPortMax,
+                        "Cybertwin local and global port ranges overlap");
+        m_localPorts = Create<CybertwinPortAllocator>(m_localPortMin, m_localPortMax);
+        m_globalPorts = Create<CybertwinPortAllocator>(m_globalPortMin, m_globalPortMax);
+        // never hand out the controller's own port
+        m_localPorts->Reserve(m_localPort);
+        m_globalPorts->Reserve(m_localPort);
+    }
+
+    if (m_multiplexPeers && !m_edgeTransport)
+    {
+        m_edgeTransport = CreateObject<CybertwinEdgeTransport>();
+        m_edgeTransport->SetNode(GetNode());
+        m_edgeTransport->Start();
+
+        UintegerValue transportPort;
+        m_edgeTransport->GetAttribute("Port", transportPort);
+        m_localPorts->Reserve(transportPort.Get());
+        m_globalPorts->Reserve(transportPort.Get());
+    }
+
     // Create the socket if not already
     if (!m_listenSocket)
     {
@@ -92,7 +177,6 @@ CybertwinController::StartApplication()
         }
 
         m_listenSocket->Listen();
-        m_listenSocket->ShutdownSend();
     }
 
     m_listenSocket->SetAcceptCallback(
@@ -118,6 +202,14 @@ CybertwinController::StopApplication()
         m_listenSocket->SetRecvCallback(MakeNullCallback<void, Ptr<Socket>>());
         m_listenSocket->SetSendCallback(MakeNullCallback<void, Ptr<Socket>, uint32_t>());
     }
+    for (auto& entry : m_streamBuffer)
+    {
+        entry.first->Close();
+    }
+    if (m_edgeTransport)
+    {
+        m_edgeTransport->Stop();
+    }
 }
 
 bool
@@ -143,44 +235,178 @@ CybertwinController::ReceivedDataCallback2(Ptr<Socket> socket)
     NS_LOG_FUNCTION(this<<socket);
     Ptr<Packet> packet;
     Address from;
-    uint32_t ret = 0;
 
+    CybertwinFrameBuffer& buffer = m_controlBuffer[socket];
     while ((packet = socket->RecvFrom(from)))
     {
         NS_LOG_DEBUG("Recv packet.");
-        CybertwinControllerHeader reqHeader, rspHeader;
-        packet->RemoveHeader(reqHeader);
+        buffer.Append(packet);
+    }
 
-        //TODO: Packet check
-        switch (reqHeader.GetMethod())
+    // messages may be split across or packed into segments
+    while (true)
+    {
+        auto batch = m_pendingBatches.find(socket);
+        if (batch != m_pendingBatches.end())
+        {
+            if (!HandleBatchEntries(socket, batch->second, buffer))
+            {
+                break;
+            }
+            continue;
+        }
+        uint32_t size = GetControlMessageSize(buffer);
+        if (size == 0)
         {
-        case NOTHING:
-            NS_LOG_DEBUG("method nothing.");
-            break;
-        case CYBERTWIN_CREATE:
-            ret = BornCybertwin(reqHeader, rspHeader);
-            NS_LOG_DEBUG("Create Cybertwin.");
-            break;
-        case CYBERTWIN_REMOVE:
-            ret = KillCybertwin(reqHeader, rspHeader);
-            NS_LOG_DEBUG("Remove Cybertwin.");
-            break;
-        default:
-            NS_LOG_DEBUG("Unknown Command.");
             break;
         }
+        HandleControlMessage(socket, buffer.Remove(size));
+    }
+}
+
+uint32_t
+CybertwinController::GetControlMessageSize(const CybertwinFrameBuffer& buffer) const
+{
+    uint8_t prefix[4];
+    uint32_t available = buffer.GetSize();
+    if (available < sizeof(prefix))
+    {
+        return 0;
+    }
+    buffer.CopyData(prefix, sizeof(prefix));
+
+    uint16_t method = (prefix[0] << 8) | prefix[1];
+    uint32_t size;
+    if (method == CYBERTWIN_CREATE_BATCH || method == CYBERTWIN_REMOVE_BATCH)
+    {
+        // the entries follow as they arrive
+        size = CybertwinControllerBatchHeader::GetFixedSize();
+    }else
+    {
+        size = CybertwinControllerHeader().GetSerializedSize();
+    }
+    return available < size ? 0 : size;
+}
+
+void
+CybertwinController::HandleControlMessage(Ptr<Socket> socket, Ptr<Packet> packet)
+{
+    int ret = 0;
+    uint8_t method[2];
+    packet->CopyData(method, sizeof(method));
+    if (((method[0] << 8) | method[1]) == CYBERTWIN_CREATE_BATCH ||
+        ((method[0] << 8) | method[1]) == CYBERTWIN_REMOVE_BATCH)
+    {
+        HandleBatchMessage(socket, packet);
+        return;
+    }
+
+    CybertwinControllerHeader reqHeader, rspHeader;
+    packet->RemoveHeader(reqHeader);
+
+    //TODO: Packet check
+    switch (reqHeader.GetMethod())
+    {
+    case NOTHING:
+        NS_LOG_DEBUG("method nothing.");
+        break;
+    case CYBERTWIN_CREATE:
+        ret = BornCybertwin(reqHeader, rspHeader);
+        NS_LOG_DEBUG("Create Cybertwin.");
+        break;
+    case CYBERTWIN_REMOVE:
+        ret = KillCybertwin(reqHeader, rspHeader);
+        NS_LOG_DEBUG("Remove Cybertwin.");
+        break;
+    default:
+        NS_LOG_DEBUG("Unknown Command.");
+        break;
+    }
+
+    if (ret < 0)
+    {
+        NS_LOG_DEBUG("Failed to execute the command.");
+        rspHeader.SetMethod(CYBERTWIN_CONTROLLER_ERROR);
+    }else{
+        rspHeader.SetMethod(CYBERTWIN_CONTROLLER_SUCCESS);
+    }
+
+    Response2EndHost(socket, rspHeader);
+}
+
+// The entries of a batch are served as their bytes come in, so a large batch
+// is worked on while the rest of it is still on the wire. It is answered once,
+// when its last entry is done.
+void
+CybertwinController::HandleBatchMessage(Ptr<Socket> socket, Ptr<Packet> packet)
+{
+    uint8_t prefix[4];
+    packet->CopyData(prefix, sizeof(prefix));
+    PendingBatch& batch = m_pendingBatches[socket];
+    batch.method = (prefix[0] << 8) | prefix[1];
+    batch.remaining = (prefix[2] << 8) | prefix[3];
+    batch.response = CybertwinControllerBatchHeader();
+    batch.response.SetMethod(CYBERTWIN_BATCH_RESPONSE);
+    NS_LOG_DEBUG("Batch of " << batch.remaining << " requests.");
+
+    if (batch.method == CYBERTWIN_CREATE_BATCH)
+    {
+        // rehash once for the whole batch
+        CybertwinMapTable.reserve(CybertwinMapTable.size() + batch.remaining);
+    }
+}
 
-        if (ret < 0)
+bool
+CybertwinController::HandleBatchEntries(Ptr<Socket> socket,
+                                        PendingBatch& batch,
+                                        CybertwinFrameBuffer& buffer)
+{
+    const uint32_t entrySize = CybertwinControllerBatchHeader::GetEntrySize();
+    uint32_t count = std::min(batch.remaining, buffer.GetSize() / entrySize);
+    if (count)
+    {
+        // all the complete entries at once
+        uint32_t size = count * entrySize;
+        Buffer entries;
+        entries.AddAtStart(size);
+        std::vector<uint8_t> data(size);
+        buffer.CopyData(data.data(), size);
+        buffer.Remove(size);
+        entries.Begin().Write(data.data(), size);
+        CybertwinControllerBatchHeader reqBatch;
+        reqBatch.DeserializeEntries(entries.Begin(), count);
+
+        for (uint32_t i = 0; i < count; i++)
         {
-            NS_LOG_DEBUG("Failed to execute the command.");
-            rspHeader.SetMethod(CYBERTWIN_CONTROLLER_ERROR);
-        }else{
-            rspHeader.SetMethod(CYBERTWIN_CONTROLLER_SUCCESS);
+            CybertwinControllerHeader reqHeader, rspHeader;
+            reqHeader.SetMethod(batch.method == CYBERTWIN_CREATE_BATCH ? CYBERTWIN_CREATE
+                                                                       : CYBERTWIN_REMOVE);
+            reqHeader.SetDeviceName(reqBatch.GetDeviceName(i));
+            reqHeader.SetNetworkType(reqBatch.GetNetworkType(i));
+            reqHeader.SetCybertwinID(reqBatch.GetCybertwinID(i));
+
+            int ret = batch.method == CYBERTWIN_CREATE_BATCH ? BornCybertwin(reqHeader, rspHeader)
+                                                             : KillCybertwin(reqHeader, rspHeader);
+            batch.response.AddEntry(reqBatch.GetDeviceName(i),
+                                    reqBatch.GetNetworkType(i),
+                                    rspHeader.GetCybertwinID(),
+                                    rspHeader.GetCybertwinPort(),
+                                    ret < 0 ? CYBERTWIN_CONTROLLER_ERROR
+                                            : CYBERTWIN_CONTROLLER_SUCCESS);
         }
-
-        Response2EndHost(socket, rspHeader);
+        batch.remaining -= count;
+    }
+    if (batch.remaining)
+    {
+        return false;
     }
 
+    // one answer for the whole batch
+    Ptr<Packet> rspPacket = Create<Packet>(0);
+    rspPacket->AddHeader(batch.response);
+    m_pendingBatches.erase(socket);
+    socket->Send(rspPacket);
+    return true;
 }
 
 void
@@ -202,36 +428,27 @@ CybertwinController::ReceivedDataCallback(Ptr<Socket> socket)
     Ptr<CybertwinItem> cybertwin;
     Address from;
 
-    while ((packet = socket->RecvFrom(from)))
+    if (m_streamBuffer.find(socket) == m_streamBuffer.end())
     {
-        if (packet->GetSize() == 0)
-        {
-            break;
-        }
-
-        //bool firstPacket = false;
-        if (m_streamBuffer.find(socket) == m_streamBuffer.end())
-        {
-            m_streamBuffer.insert(std::make_pair(socket, Create<StreamState>()));
-        }
+        m_streamBuffer.insert(std::make_pair(socket, Create<StreamState>()));
+    }
+    socketStream = m_streamBuffer.find(socket)->second;
 
-        socketStream = m_streamBuffer.find(socket)->second;
-        if (socketStream->bytesToReceive == 0)
-        {
-            // new packet
-            CybertwinPacketHeader header;
-            packet->RemoveHeader(header);
-            socketStream->update(header);
-            //firstPacket = true;
-        }
+    while ((packet = socket->RecvFrom(from)))
+    {
+        socketStream->rxBuffer.Append(packet);
+    }
 
-        uint32_t contentSize = packet->GetSize();
-        if (contentSize > socketStream->bytesToReceive)
-        {
-            NS_LOG_ERROR("The received packet is larger than expected");
-            socketStream->bytesToReceive = 0;
-            continue;
-        }
+    // hand over whole frames only, however the stream was segmented
+    CybertwinPacketHeader header;
+    const uint32_t headerSize = header.GetSerializedSize();
+    while (socketStream->rxBuffer.PeekHeader(header, headerSize) &&
+           socketStream->rxBuffer.GetSize() >= headerSize + header.GetSize())
+    {
+        Ptr<Packet> frame = socketStream->rxBuffer.Remove(headerSize + header.GetSize());
+        frame->RemoveHeader(header);
+        socketStream->update(header);
+        uint32_t contentSize = frame->GetSize();
 
         switch (socketStream->action)
         {
@@ -244,18 +461,16 @@ CybertwinController::ReceivedDataCallback(Ptr<Socket> socket)
             break;
         case 2:
             cybertwin = m_controlTable->Get(socketStream->srcGuid);
-            // cybertwin->SendTo(socketStream->dstGuid, packet->Copy(), firstPacket);
+            // cybertwin->SendTo(socketStream->dstGuid, frame);
             break;
         case 3:
             cybertwin = m_controlTable->Get(socketStream->dstGuid);
-            // cybertwin->RecvFrom(socketStream->srcGuid, packet->Copy(), firstPacket);
+            // cybertwin->RecvFrom(socketStream->srcGuid, frame);
             break;
         default:
             NS_FATAL_ERROR("Failed to receive data: invalid command in packet");
             break;
         }
-
-        socketStream->bytesToReceive -= contentSize;
     }
 }
 
@@ -263,6 +478,8 @@ void
 CybertwinController::NormalCloseCallback(Ptr<Socket> socket)
 {
     NS_LOG_FUNCTION(this << socket);
+    bool controlSocket = m_controlBuffer.erase(socket) > 0;
+    m_pendingBatches.erase(socket);
     if (m_streamBuffer.find(socket) != m_streamBuffer.end())
     {
         Ptr<StreamState> socketStream = m_streamBuffer.find(socket)->second;
@@ -273,7 +490,7 @@ CybertwinController::NormalCloseCallback(Ptr<Socket> socket)
         socket->ShutdownSend();
         m_streamBuffer.erase(socket);
     }
-    else
+    else if (!controlSocket)
     {
         NS_LOG_ERROR("Failed to disconnect: socket not existed");
     }
@@ -289,7 +506,7 @@ CybertwinController::ErrorCloseCallback(Ptr<Socket> socket)
     // TODO: Set a timer and remove cybertwin after timeout
 }
 
-uint32_t
+int
 CybertwinController::BornCybertwin(CybertwinControllerHeader &reqHeader, CybertwinControllerHeader &rspHeader)
 {
     NS_LOG_DEBUG("CybertwinController: Borning a new Cybertwin.");
@@ -310,13 +527,39 @@ CybertwinController::BornCybertwin(CybertwinControllerHeader &reqHeader, Cybertw
         return -1;
     }
 
-    //TODO: check port to prevent port conflict.
-    localPort = ++localPortCounter;
-    globalPort = ++globalPortCounter;
+    localPort = AllocatePort(m_localPorts);
+    globalPort = AllocatePort(m_globalPorts);
+    if (localPort == 0 || globalPort == 0)
+    {
+        NS_LOG_ERROR("No free port left for a new cybertwin.");
+        if (localPort != 0)
+        {
+            m_localPorts->Release(localPort);
+        }
+        if (globalPort != 0)
+        {
+            m_globalPorts->Release(globalPort);
+        }
+        return -1;
+    }
 
-    Ptr<Cybertwin> cybertwin = Create<Cybertwin>();
-    GetNode()->AddApplication(cybertwin);
+    // the node keeps its applications, so closed twins are brought back
+    // instead of adding new ones
+    Ptr<Cybertwin> cybertwin;
+    bool recycled = !m_idleCybertwins.empty();
+    if (recycled)
+    {
+        cybertwin = m_idleCybertwins.back();
+        m_idleCybertwins.pop_back();
+    }
+    else
+    {
+        cybertwin = CreateObject<Cybertwin>();
+        GetNode()->AddApplication(cybertwin);
+    }
     cybertwin->SetCybertwinID(cybertwinID);
+    cybertwin->SetNameResolver(m_nameResolver);
+    cybertwin->SetEdgeTransport(m_edgeTransport);
     if (Ipv4Address::IsMatchingType(m_localAddr))
     {
         NS_LOG_DEBUG("Set Cybertwin Addr: "<<m_localAddr);
@@ -328,9 +571,10 @@ CybertwinController::BornCybertwin(CybertwinControllerHeader &reqHeader, Cybertw
     }
 
     CybertwinMapTable[cybertwinID] = cybertwin;
-
-    //TODO: ensure the cybertwin really start
-    cybertwin->SetStartTime(Simulator::Now());
+    if (recycled)
+    {
+        cybertwin->Restart();
+    }
 
     rspHeader.SetCybertwinID(cybertwinID);
     rspHeader.SetCybertwinPort(localPort);
@@ -338,7 +582,7 @@ CybertwinController::BornCybertwin(CybertwinControllerHeader &reqHeader, Cybertw
     return 0;
 }
 
-uint32_t 
+int
 CybertwinController::KillCybertwin(CybertwinControllerHeader &reqHeader, CybertwinControllerHeader &rspHeader)
 {
     NS_LOG_DEBUG("CybertwinController: Kill cybertwin.");
@@ -348,8 +592,8 @@ CybertwinController::KillCybertwin(CybertwinControllerHeader &reqHeader, Cybertw
     if (CybertwinMapTable.find(cybertwinID) != CybertwinMapTable.end())
     {
         Ptr<Cybertwin> cybertwin = CybertwinMapTable[cybertwinID];
-        //TODO: consider a more reasonable way to stop the cybertwin
-        cybertwin->SetStopTime(Simulator::Now());
+        // the ports go back to the pool once no socket of the twin holds them
+        cybertwin->Stop(MakeCallback(&CybertwinController::CybertwinClosed, this).Bind(cybertwin));
         CybertwinMapTable.erase(cybertwinID);
     }
 
@@ -357,6 +601,54 @@ CybertwinController::KillCybertwin(CybertwinControllerHeader &reqHeader, Cybertw
 }
 
 
+void
+CybertwinController::CybertwinClosed(Ptr<Cybertwin> cybertwin)
+{
+    NS_LOG_FUNCTION(this << cybertwin);
+    m_localPorts->Release(cybertwin->GetLocalInterface().second);
+    m_globalPorts->Release(cybertwin->GetGlobalInterface().second);
+    m_idleCybertwins.push_back(cybertwin);
+}
+
+uint16_t
+CybertwinController::AllocatePort(Ptr<CybertwinPortAllocator> ports)
+{
+    // ports other sockets of the node hold are skipped, and tried again later
+    std::vector<uint16_t> skipped;
+    uint16_t port;
+    while ((port = ports->Allocate()) != 0 && IsPortBound(port))
+    {
+        NS_LOG_DEBUG("Port " << port << " is bound by another socket.");
+        skipped.push_back(port);
+    }
+    for (uint16_t bound : skipped)
+    {
+        ports->Release(bound);
+    }
+    return port;
+}
+
+bool
+CybertwinController::IsPortBound(uint16_t port) const
+{
+    Ptr<TcpL4Protocol> tcp = GetNode()->GetObject<TcpL4Protocol>();
+    if (!tcp || !Ipv4Address::IsMatchingType(m_localAddr))
+    {
+        return false;
+    }
+    // the demux refuses an endpoint that would clash with one it holds,
+    // whether bound to our address or to any
+    for (Ipv4Address address : {Ipv4Address::ConvertFrom(m_localAddr), Ipv4Address::GetAny()})
+    {
+        Ipv4EndPoint* endPoint = tcp->Allocate(nullptr, address, port);
+        if (!endPoint)
+        {
+            return true;
+        }
+        tcp->DeAllocate(endPoint);
+    }
+    return false;
+}
 
 // Cybertwin Control Table
 CybertwinControlTable::CybertwinControlTable()
@@ -1,7 +1,10 @@
 #ifndef CYBERTWIN_EDGE_SERVER_H
 #define CYBERTWIN_EDGE_SERVER_H
 
+#include "cybertwin-edge-transport.h"
+#include "cybertwin-frame-buffer.h"
 #include "cybertwin-packet-header.h"
+#include "cybertwin-port-allocator.h"
 #include "cybertwin.h"
 
 #include "ns3/address.h"
@@ -15,6 +18,7 @@
 
 #include <string>
 #include <unordered_map>
+#include <vector>
 
 namespace ns3
 {
@@ -43,7 +47,7 @@ class AddressHash
 };
 
 // Global GUID Table (temporary)
-std::unordered_map<uint64_t, Address> GuidTable;
+extern std::unordered_map<uint64_t, Address> GuidTable;
 
 class CybertwinItem : public SimpleRefCount<CybertwinItem>
 {
@@ -97,9 +101,26 @@ class CybertwinController : public Application
     void ReceivedDataCallback(Ptr<Socket> socket);
     void ReceivedDataCallback2(Ptr<Socket> socket);
 
-    uint32_t BornCybertwin(CybertwinControllerHeader &reqHeader, CybertwinControllerHeader &rspHeader);
-    uint32_t KillCybertwin(CybertwinControllerHeader &reqHeader, CybertwinControllerHeader &rspHeader);
+    uint32_t GetControlMessageSize(const CybertwinFrameBuffer& buffer) const;
+    void HandleControlMessage(Ptr<Socket> socket, Ptr<Packet> message);
+    void HandleBatchMessage(Ptr<Socket> socket, Ptr<Packet> message);
+
+    // a batch whose entries are still arriving
+    struct PendingBatch
+    {
+        uint16_t method{NOTHING};
+        uint32_t remaining{0}; // entries not received yet
+        CybertwinControllerBatchHeader response;
+    };
+
+    bool HandleBatchEntries(Ptr<Socket> socket, PendingBatch& batch, CybertwinFrameBuffer& buffer);
+
+    int BornCybertwin(CybertwinControllerHeader &reqHeader, CybertwinControllerHeader &rspHeader);
+    int KillCybertwin(CybertwinControllerHeader &reqHeader, CybertwinControllerHeader &rspHeader);
     void Response2EndHost(Ptr<Socket> socket, CybertwinControllerHeader rspHeader);
+    void CybertwinClosed(Ptr<Cybertwin> cybertwin);
+    uint16_t AllocatePort(Ptr<CybertwinPortAllocator> ports);
+    bool IsPortBound(uint16_t port) const;
 
     Ptr<Socket> m_listenSocket;
     Ptr<CybertwinControlTable> m_controlTable;
@@ -111,6 +132,7 @@ class CybertwinController : public Application
         uint64_t dstGuid{0};
         uint16_t action{0};
         bool isClientSocket{false};
+        CybertwinFrameBuffer rxBuffer; // frames not yet complete
 
         void update(CybertwinPacketHeader& header)
         {
@@ -129,11 +151,22 @@ class CybertwinController : public Application
     };
 
     std::unordered_map<Ptr<Socket>, Ptr<StreamState>> m_streamBuffer;
+    std::unordered_map<Ptr<Socket>, CybertwinFrameBuffer> m_controlBuffer; // partial control messages
+    std::unordered_map<Ptr<Socket>, PendingBatch> m_pendingBatches;
     Address m_localAddr;
     uint64_t m_localPort;
-    uint16_t localPortCounter;
-    uint16_t globalPortCounter;
+    Address m_cnrsAddr;
+    Ptr<NameResolutionClient> m_nameResolver; // shared by all cybertwins on this edge
+    bool m_multiplexPeers;
+    Ptr<CybertwinEdgeTransport> m_edgeTransport; // shared by all cybertwins on this edge
+    uint16_t m_localPortMin;
+    uint16_t m_localPortMax;
+    uint16_t m_globalPortMin;
+    uint16_t m_globalPortMax;
+    Ptr<CybertwinPortAllocator> m_localPorts;
+    Ptr<CybertwinPortAllocator> m_globalPorts;
     std::unordered_map<CYBERTWINID_t, Ptr<Cybertwin>> CybertwinMapTable;
+    std::vector<Ptr<Cybertwin>> m_idleCybertwins; // killed and closed, reused by the next births
 };
 
 } // namespace ns3
@@ -0,0 +1,492 @@
+#include "cybertwin-edge-transport.h"
+
+#include "ns3/inet-socket-address.h"
+#include "ns3/log.h"
+#include "ns3/simulator.h"
+#include "ns3/tcp-socket-factory.h"
+#include "ns3/uinteger.h"
+
+#include <algorithm>
+
+namespace ns3
+{
+
+NS_LOG_COMPONENT_DEFINE("CybertwinEdgeTransport");
+NS_OBJECT_ENSURE_REGISTERED(CybertwinEdgeTransport);
+
+TypeId
+CybertwinEdgeTransport::GetTypeId()
+{
+    static TypeId tid =
+        TypeId("ns3::CybertwinEdgeTransport")
+            .SetParent<Object>()
+            .SetGroupName("cybertwin")
+            .AddConstructor<CybertwinEdgeTransport>()
+            .AddAttribute("Port",
+                          "The port every edge listens on for multiplexed connections",
+                          UintegerValue(EDGE_TRANSPORT_PORT),
+                          MakeUintegerAccessor(&CybertwinEdgeTransport::m_port),
+                          MakeUintegerChecker<uint16_t>(1))
+            .AddAttribute("StreamQuantum",
+                          "The credit in bytes granted to each stream per scheduling round",
+                          UintegerValue(16 * 1024),
+                          MakeUintegerAccessor(&CybertwinEdgeTransport::m_streamQuantum),
+                          MakeUintegerChecker<uint32_t>(1))
+            .AddAttribute("StreamQueueLimit",
+                          "The number of bytes a stream may buffer before its sender is held back",
+                          UintegerValue(64 * 1024),
+                          MakeUintegerAccessor(&CybertwinEdgeTransport::m_streamQueueLimit),
+                          MakeUintegerChecker<uint32_t>(1));
+    return tid;
+}
+
+CybertwinEdgeTransport::CybertwinEdgeTransport()
+    : m_node(nullptr),
+      m_listenSocket(nullptr),
+      m_port(EDGE_TRANSPORT_PORT),
+      m_streamQuantum(16 * 1024),
+      m_streamQueueLimit(64 * 1024)
+{
+    NS_LOG_FUNCTION(this);
+}
+
+CybertwinEdgeTransport::~CybertwinEdgeTransport()
+{
+    NS_LOG_FUNCTION(this);
+}
+
+void
+CybertwinEdgeTransport::DoDispose()
+{
+    NS_LOG_FUNCTION(this);
+    // the devices may already be gone: closing here would send a FIN
+    // through them, the connections are closed by Stop
+    if (m_listenSocket)
+    {
+        m_listenSocket->SetAcceptCallback(MakeNullCallback<bool, Ptr<Socket>, const Address&>(),
+                                          MakeNullCallback<void, Ptr<Socket>, const Address&>());
+        m_listenSocket = nullptr;
+    }
+    for (auto& entry : m_sockets)
+    {
+        Simulator::Cancel(entry.second->drainEvent);
+        ClearCallbacks(entry.first);
+        entry.second->socket = nullptr;
+        entry.second->streams.clear();
+        entry.second->activeStreams.clear();
+    }
+    m_connections.clear();
+    m_sockets.clear();
+    m_endpoints.clear();
+    m_node = nullptr;
+    Object::DoDispose();
+}
+
+void
+CybertwinEdgeTransport::SetNode(Ptr<Node> node)
+{
+    m_node = node;
+}
+
+void
+CybertwinEdgeTransport::Start()
+{
+    NS_LOG_FUNCTION(this);
+    if (m_listenSocket)
+    {
+        return;
+    }
+
+    m_listenSocket = Socket::CreateSocket(m_node, TcpSocketFactory::GetTypeId());
+    if (m_listenSocket->Bind(InetSocketAddress(Ipv4Address::GetAny(), m_port)) == -1)
+    {
+        NS_FATAL_ERROR("Failed to bind the edge transport to port " << m_port);
+    }
+    m_listenSocket->SetAcceptCallback(
+        MakeCallback(&CybertwinEdgeTransport::ConnectionRequestCallback, this),
+        MakeCallback(&CybertwinEdgeTransport::NewConnectionCreatedCallback, this));
+    m_listenSocket->Listen();
+}
+
+void
+CybertwinEdgeTransport::Stop()
+{
+    NS_LOG_FUNCTION(this);
+    if (m_listenSocket)
+    {
+        m_listenSocket->SetAcceptCallback(MakeNullCallback<bool, Ptr<Socket>, const Address&>(),
+                                          MakeNullCallback<void, Ptr<Socket>, const Address&>());
+        m_listenSocket->Close();
+        m_listenSocket = nullptr;
+    }
+
+    // copy, closing a connection modifies the maps
+    std::vector<Ptr<Connection>> connections;
+    for (auto& entry : m_sockets)
+    {
+        connections.push_back(entry.second);
+    }
+    for (auto& conn : connections)
+    {
+        CloseConnection(conn);
+    }
+    m_connections.clear();
+    m_sockets.clear();
+}
+
+void
+CybertwinEdgeTransport::Register(CYBERTWINID_t id, ReceiveCallback receive, ResumeCallback resume)
+{
+    NS_LOG_FUNCTION(this << id);
+    m_endpoints[id] = Endpoint{receive, resume};
+}
+
+void
+CybertwinEdgeTransport::Unregister(CYBERTWINID_t id)
+{
+    NS_LOG_FUNCTION(this << id);
+    m_endpoints.erase(id);
+}
+
+uint32_t
+CybertwinEdgeTransport::GetNConnections() const
+{
+    return m_connections.size();
+}
+
+bool
+CybertwinEdgeTransport::Send(CYBERTWINID_t src,
+                             CYBERTWINID_t dst,
+                             Ipv4Address edge,
+                             Ptr<Packet> packet)
+{
+    NS_LOG_FUNCTION(this << src << dst << edge << packet);
+    Ptr<Connection> conn = GetConnection(edge);
+    StreamKey key{src, dst};
+    Stream& stream = conn->streams[key];
+
+    // an empty stream takes any packet, so large packets cannot get stuck
+    uint32_t size = packet->GetSize();
+    if (stream.bytes && stream.bytes + size > m_streamQueueLimit)
+    {
+        return false;
+    }
+
+    // frames never exceed one quantum, they are cut from the packet without copying
+    for (uint32_t offset = 0; offset < size; offset += m_streamQuantum)
+    {
+        uint32_t length = std::min(m_streamQuantum, size - offset);
+        Ptr<Packet> frame =
+            (offset == 0 && length == size) ? packet->Copy() : packet->CreateFragment(offset, length);
+        frame->AddHeader(CybertwinPacketHeader(src, dst, length));
+        stream.frames.push(frame);
+    }
+    stream.bytes += size;
+
+    ActivateStream(conn, key, stream);
+    return true;
+}
+
+//********************************************************************
+//*                        Connections                               *
+//********************************************************************
+
+Ptr<CybertwinEdgeTransport::Connection>
+CybertwinEdgeTransport::GetConnection(Ipv4Address edge)
+{
+    auto it = m_connections.find(edge);
+    if (it != m_connections.end())
+    {
+        return it->second;
+    }
+
+    NS_LOG_DEBUG("Opening edge connection to " << edge << ":" << m_port);
+    Ptr<Connection> conn = Create<Connection>();
+    conn->edge = edge;
+    m_connections[edge] = conn;
+
+    Ptr<Socket> socket = Socket::CreateSocket(m_node, TcpSocketFactory::GetTypeId());
+    socket->SetConnectCallback(MakeCallback(&CybertwinEdgeTransport::ConnectSucceededCallback, this),
+                               MakeCallback(&CybertwinEdgeTransport::ConnectFailedCallback, this));
+    socket->Bind();
+    AttachSocket(conn, socket);
+    socket->Connect(InetSocketAddress(edge, m_port));
+    return conn;
+}
+
+void
+CybertwinEdgeTransport::AttachSocket(Ptr<Connection> conn, Ptr<Socket> socket)
+{
+    conn->socket = socket;
+    m_sockets[socket] = conn;
+    socket->SetRecvCallback(MakeCallback(&CybertwinEdgeTransport::RecvHandler, this));
+    socket->SetSendCallback(MakeCallback(&CybertwinEdgeTransport::SendCallback, this));
+    socket->SetCloseCallbacks(MakeCallback(&CybertwinEdgeTransport::NormalCloseCallback, this),
+                              MakeCallback(&CybertwinEdgeTransport::ErrorCloseCallback, this));
+}
+
+void
+CybertwinEdgeTransport::ClearCallbacks(Ptr<Socket> socket)
+{
+    socket->SetConnectCallback(MakeNullCallback<void, Ptr<Socket>>(),
+                               MakeNullCallback<void, Ptr<Socket>>());
+    socket->SetRecvCallback(MakeNullCallback<void, Ptr<Socket>>());
+    socket->SetSendCallback(MakeNullCallback<void, Ptr<Socket>, uint32_t>());
+    socket->SetCloseCallbacks(MakeNullCallback<void, Ptr<Socket>>(),
+                              MakeNullCallback<void, Ptr<Socket>>());
+}
+
+void
+CybertwinEdgeTransport::CloseConnection(Ptr<Connection> conn)
+{
+    NS_LOG_FUNCTION(this << conn->edge);
+    Simulator::Cancel(conn->drainEvent);
+
+    auto it = m_connections.find(conn->edge);
+    if (it != m_connections.end() && it->second == conn)
+    {
+        m_connections.erase(it);
+    }
+
+    if (conn->socket)
+    {
+        m_sockets.erase(conn->socket);
+        ClearCallbacks(conn->socket);
+        conn->socket->Close();
+        conn->socket = nullptr;
+    }
+    conn->connected = false;
+
+    // the queued frames are lost, let their senders go on
+    std::vector<StreamKey> keys;
+    for (auto& entry : conn->streams)
+    {
+        keys.push_back(entry.first);
+    }
+    conn->streams.clear();
+    conn->activeStreams.clear();
+    for (auto& key : keys)
+    {
+        auto endpoint = m_endpoints.find(key.src);
+        if (endpoint != m_endpoints.end() && !endpoint->second.resume.IsNull())
+        {
+            endpoint->second.resume(key.dst);
+        }
+    }
+}
+
+bool
+CybertwinEdgeTransport::ConnectionRequestCallback(Ptr<Socket> socket, const Address& from)
+{
+    return true;
+}
+
+void
+CybertwinEdgeTransport::NewConnectionCreatedCallback(Ptr<Socket> socket, const Address& from)
+{
+    Ipv4Address edge = InetSocketAddress::ConvertFrom(from).GetIpv4();
+    NS_LOG_DEBUG("Accepted edge connection from " << edge);
+
+    Ptr<Connection> conn = Create<Connection>();
+    conn->edge = edge;
+    conn->connected = true;
+    // send through the accepted connection too, unless we already dialed that edge
+    if (m_connections.find(edge) == m_connections.end())
+    {
+        m_connections[edge] = conn;
+    }
+    AttachSocket(conn, socket);
+}
+
+void
+CybertwinEdgeTransport::ConnectSucceededCallback(Ptr<Socket> socket)
+{
+    auto it = m_sockets.find(socket);
+    if (it == m_sockets.end())
+    {
+        return;
+    }
+    NS_LOG_DEBUG("Edge connection to " << it->second->edge << " established.");
+    it->second->connected = true;
+    ScheduleDrain(it->second);
+}
+
+void
+CybertwinEdgeTransport::ConnectFailedCallback(Ptr<Socket> socket)
+{
+    auto it = m_sockets.find(socket);
+    if (it == m_sockets.end())
+    {
+        return;
+    }
+    // the next packet for this edge dials again
+    NS_LOG_ERROR("Failed to connect to edge " << it->second->edge);
+    CloseConnection(it->second);
+}
+
+void
+CybertwinEdgeTransport::SendCallback(Ptr<Socket> socket, uint32_t txSpace)
+{
+    auto it = m_sockets.find(socket);
+    if (it != m_sockets.end())
+    {
+        ScheduleDrain(it->second);
+    }
+}
+
+void
+CybertwinEdgeTransport::NormalCloseCallback(Ptr<Socket> socket)
+{
+    auto it = m_sockets.find(socket);
+    if (it != m_sockets.end())
+    {
+        CloseConnection(it->second);
+    }
+}
+
+void
+CybertwinEdgeTransport::ErrorCloseCallback(Ptr<Socket> socket)
+{
+    NS_LOG_ERROR("Edge connection error: " << socket->GetErrno());
+    NormalCloseCallback(socket);
+}
+
+//********************************************************************
+//*                        Receive side                              *
+//********************************************************************
+
+void
+CybertwinEdgeTransport::RecvHandler(Ptr<Socket> socket)
+{
+    auto it = m_sockets.find(socket);
+    if (it == m_sockets.end())
+    {
+        return;
+    }
+    Ptr<Connection> conn = it->second;
+
+    Ptr<Packet> packet;
+    while ((packet = socket->Recv()))
+    {
+        conn->rxBuffer.Append(packet);
+    }
+
+    CybertwinPacketHeader header;
+    const uint32_t headerSize = header.GetSerializedSize();
+    while (conn->rxBuffer.PeekHeader(header, headerSize) &&
+           conn->rxBuffer.GetSize() >= headerSize + header.GetSize())
+    {
+        Ptr<Packet> payload = conn->rxBuffer.Remove(headerSize + header.GetSize());
+        payload->RemoveHeader(header);
+
+        auto endpoint = m_endpoints.find(header.GetDst());
+        if (endpoint == m_endpoints.end())
+        {
+            NS_LOG_DEBUG("No cybertwin " << header.GetDst() << " here, drop frame.");
+            continue;
+        }
+        endpoint->second.receive(header.GetSrc(), payload);
+    }
+}
+
+//********************************************************************
+//*                        Send side                                 *
+//********************************************************************
+
+void
+CybertwinEdgeTransport::ActivateStream(Ptr<Connection> conn, const StreamKey& key, Stream& stream)
+{
+    if (stream.active || stream.frames.empty())
+    {
+        return;
+    }
+    stream.active = true;
+    conn->activeStreams.push_back(key);
+    ScheduleDrain(conn);
+}
+
+void
+CybertwinEdgeTransport::ScheduleDrain(Ptr<Connection> conn)
+{
+    if (conn->connected && !conn->activeStreams.empty() && !conn->drainEvent.IsRunning())
+    {
+        conn->drainEvent = Simulator::ScheduleNow(&CybertwinEdgeTransport::Drain, this, conn);
+    }
+}
+
+void
+CybertwinEdgeTransport::Drain(Ptr<Connection> conn)
+{
+    const uint32_t headerSize = CybertwinPacketHeader().GetSerializedSize();
+
+    // one deficit round robin round over the streams of this connection
+    std::size_t rounds = conn->activeStreams.size();
+    for (std::size_t i = 0; i < rounds && conn->socket; i++)
+    {
+        StreamKey key = conn->activeStreams.front();
+        conn->activeStreams.pop_front();
+        Stream& stream = conn->streams[key];
+        stream.active = false;
+        // a stream cut short by a full socket still holds the credit of its
+        // last turn, another quantum would let it hoard them
+        if (stream.deficit < stream.frames.front()->GetSize() - headerSize)
+        {
+            stream.deficit += m_streamQuantum;
+        }
+
+        uint32_t sent = 0;
+        bool blocked = false;
+        while (!stream.frames.empty())
+        {
+            Ptr<Packet> frame = stream.frames.front();
+            uint32_t size = frame->GetSize() - headerSize;
+            if (size > stream.deficit)
+            {
+                break;
+            }
+            if (conn->socket->GetTxAvailable() < frame->GetSize() || conn->socket->Send(frame) < 0)
+            {
+                blocked = true;
+                break;
+            }
+            stream.frames.pop();
+            stream.bytes -= size;
+            stream.deficit -= size;
+            sent += size;
+        }
+
+        if (stream.frames.empty())
+        {
+            // idle streams do not hoard credit
+            conn->streams.erase(key);
+        }
+        else if (blocked)
+        {
+            // it resumes its turn once the socket has room again
+            stream.active = true;
+            conn->activeStreams.push_front(key);
+        }
+        else
+        {
+            stream.active = true;
+            conn->activeStreams.push_back(key);
+        }
+
+        if (sent)
+        {
+            auto endpoint = m_endpoints.find(key.src);
+            if (endpoint != m_endpoints.end() && !endpoint->second.resume.IsNull())
+            {
+                endpoint->second.resume(key.dst);
+            }
+        }
+        if (blocked)
+        {
+            // the socket send callback starts the next round
+            return;
+        }
+    }
+    ScheduleDrain(conn);
+}
+
+} // namespace ns3
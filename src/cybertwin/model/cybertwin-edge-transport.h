@@ -0,0 +1,142 @@
+#ifndef CYBERTWIN_EDGE_TRANSPORT_H
+#define CYBERTWIN_EDGE_TRANSPORT_H
+
+#include "cybertwin-common.h"
+#include "cybertwin-frame-buffer.h"
+#include "cybertwin-packet-header.h"
+
+#include "ns3/event-id.h"
+#include "ns3/ipv4-address.h"
+#include "ns3/node.h"
+#include "ns3/object.h"
+#include "ns3/socket.h"
+
+#include <deque>
+#include <queue>
+#include <unordered_map>
+
+namespace ns3
+{
+
+/**
+ * Multiplexed transport between the cybertwins of two edge servers.
+ *
+ * Instead of one TCP connection per pair of cybertwins, every edge keeps a
+ * single connection to each remote edge it talks to. Packets are framed
+ * with a CybertwinPacketHeader carrying the source and destination
+ * Cybertwin IDs and the payload size, and handed to the destination twin
+ * on the other side.
+ *
+ * Each (src, dst) pair is a stream with its own queue. The streams sharing
+ * a connection are served with deficit round robin, StreamQuantum bytes per
+ * round, so a bulk transfer cannot starve the others. Packets larger than a
+ * quantum are cut into several frames. Every stream buffers at most
+ * StreamQueueLimit bytes; Send refuses packets that do not fit and the
+ * sending twin is called back once its stream made progress.
+ *
+ * All edges are expected to listen on the same Port.
+ */
+class CybertwinEdgeTransport : public Object
+{
+  public:
+    // packet from a remote twin: source Cybertwin ID, payload
+    typedef Callback<void, CYBERTWINID_t, Ptr<Packet>> ReceiveCallback;
+    // the stream towards the given destination has room again
+    typedef Callback<void, CYBERTWINID_t> ResumeCallback;
+
+    CybertwinEdgeTransport();
+    ~CybertwinEdgeTransport() override;
+    static TypeId GetTypeId();
+
+    void SetNode(Ptr<Node> node);
+    void Start();
+    // closes the connections, to be called while the devices still exist
+    void Stop();
+
+    void Register(CYBERTWINID_t id, ReceiveCallback receive, ResumeCallback resume);
+    void Unregister(CYBERTWINID_t id);
+
+    // queues a packet on the stream, returns false if the stream is full
+    bool Send(CYBERTWINID_t src, CYBERTWINID_t dst, Ipv4Address edge, Ptr<Packet> packet);
+
+    uint32_t GetNConnections() const;
+
+  protected:
+    void DoDispose() override;
+
+  private:
+    struct StreamKey
+    {
+        CYBERTWINID_t src;
+        CYBERTWINID_t dst;
+
+        bool operator==(const StreamKey& other) const
+        {
+            return src == other.src && dst == other.dst;
+        }
+    };
+
+    struct StreamKeyHash
+    {
+        std::size_t operator()(const StreamKey& key) const
+        {
+            return std::hash<uint64_t>()(key.src * 0x9E3779B97F4A7C15ULL ^ key.dst);
+        }
+    };
+
+    struct Stream
+    {
+        std::queue<Ptr<Packet>> frames;
+        uint32_t bytes{0};
+        uint32_t deficit{0};
+        bool active{false};
+    };
+
+    struct Connection : public SimpleRefCount<Connection>
+    {
+        Ipv4Address edge;
+        Ptr<Socket> socket{nullptr};
+        bool connected{false};
+        std::unordered_map<StreamKey, Stream, StreamKeyHash> streams;
+        std::deque<StreamKey> activeStreams;
+        EventId drainEvent;
+        CybertwinFrameBuffer rxBuffer;
+    };
+
+    struct Endpoint
+    {
+        ReceiveCallback receive;
+        ResumeCallback resume;
+    };
+
+    Ptr<Connection> GetConnection(Ipv4Address edge);
+    void AttachSocket(Ptr<Connection> conn, Ptr<Socket> socket);
+    void ClearCallbacks(Ptr<Socket> socket);
+    void CloseConnection(Ptr<Connection> conn);
+
+    bool ConnectionRequestCallback(Ptr<Socket> socket, const Address& from);
+    void NewConnectionCreatedCallback(Ptr<Socket> socket, const Address& from);
+    void ConnectSucceededCallback(Ptr<Socket> socket);
+    void ConnectFailedCallback(Ptr<Socket> socket);
+    void SendCallback(Ptr<Socket> socket, uint32_t txSpace);
+    void NormalCloseCallback(Ptr<Socket> socket);
+    void ErrorCloseCallback(Ptr<Socket> socket);
+    void RecvHandler(Ptr<Socket> socket);
+
+    void ActivateStream(Ptr<Connection> conn, const StreamKey& key, Stream& stream);
+    void ScheduleDrain(Ptr<Connection> conn);
+    void Drain(Ptr<Connection> conn);
+
+    Ptr<Node> m_node;
+    Ptr<Socket> m_listenSocket;
+    uint16_t m_port;
+    uint32_t m_streamQuantum;
+    uint32_t m_streamQueueLimit;
+    std::unordered_map<Ipv4Address, Ptr<Connection>, Ipv4AddressHash> m_connections;
+    std::unordered_map<Ptr<Socket>, Ptr<Connection>> m_sockets;
+    std::unordered_map<CYBERTWINID_t, Endpoint> m_endpoints;
+};
+
+} // namespace ns3
+
+#endif
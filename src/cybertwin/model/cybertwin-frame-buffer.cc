@@ -0,0 +1,111 @@
+#include "cybertwin-frame-buffer.h"
+
+#include "ns3/log.h"
+
+#include <vector>
+
+namespace ns3
+{
+NS_LOG_COMPONENT_DEFINE("CybertwinFrameBuffer");
+
+CybertwinFrameBuffer::CybertwinFrameBuffer()
+    : m_size(0)
+{
+}
+
+void
+CybertwinFrameBuffer::Append(Ptr<Packet> chunk)
+{
+    if (chunk->GetSize() == 0)
+    {
+        return;
+    }
+    m_chunks.push_back(chunk);
+    m_size += chunk->GetSize();
+}
+
+void
+CybertwinFrameBuffer::Clear()
+{
+    m_chunks.clear();
+    m_size = 0;
+}
+
+uint32_t
+CybertwinFrameBuffer::GetSize() const
+{
+    return m_size;
+}
+
+uint32_t
+CybertwinFrameBuffer::CopyData(uint8_t* buffer, uint32_t size) const
+{
+    uint32_t copied = 0;
+    for (auto it = m_chunks.begin(); it != m_chunks.end() && copied < size; ++it)
+    {
+        copied += (*it)->CopyData(buffer + copied, size - copied);
+    }
+    return copied;
+}
+
+bool
+CybertwinFrameBuffer::PeekHeader(Header& header, uint32_t headerSize) const
+{
+    if (m_size < headerSize)
+    {
+        return false;
+    }
+    if (m_chunks.front()->GetSize() >= headerSize)
+    {
+        m_chunks.front()->PeekHeader(header);
+        return true;
+    }
+
+    // the header is split across chunks, only its bytes are gathered
+    std::vector<uint8_t> bytes(headerSize);
+    CopyData(bytes.data(), headerSize);
+    Ptr<Packet> joined = Create<Packet>(bytes.data(), headerSize);
+    joined->PeekHeader(header);
+    return true;
+}
+
+Ptr<Packet>
+CybertwinFrameBuffer::Remove(uint32_t size)
+{
+    if (m_size < size)
+    {
+        return nullptr;
+    }
+    m_size -= size;
+
+    Ptr<Packet> frame = nullptr;
+    while (size > 0)
+    {
+        Ptr<Packet> chunk = m_chunks.front();
+        Ptr<Packet> piece;
+        if (chunk->GetSize() <= size)
+        {
+            piece = chunk;
+            m_chunks.pop_front();
+        }
+        else
+        {
+            piece = chunk->CreateFragment(0, size);
+            chunk->RemoveAtStart(size);
+        }
+        size -= piece->GetSize();
+
+        if (!frame)
+        {
+            frame = piece;
+        }
+        else
+        {
+            NS_LOG_LOGIC("Frame spans chunks, joining " << piece->GetSize() << " bytes");
+            frame->AddAtEnd(piece);
+        }
+    }
+    return frame ? frame : Create<Packet>(0);
+}
+
+} // namespace ns3
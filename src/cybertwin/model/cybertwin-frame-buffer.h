@@ -0,0 +1,45 @@
+#ifndef CYBERTWIN_FRAME_BUFFER_H
+#define CYBERTWIN_FRAME_BUFFER_H
+
+#include "ns3/header.h"
+#include "ns3/packet.h"
+#include "ns3/ptr.h"
+
+#include <deque>
+
+namespace ns3
+{
+
+/**
+ * Reassembles length-prefixed frames from a TCP byte stream.
+ *
+ * Received packets are kept as a chain of chunks instead of being merged
+ * into one buffer. A frame that lies within one chunk is cut out with
+ * CreateFragment, which shares the chunk's data; only frames spanning
+ * several chunks are joined with AddAtEnd. Headers split across chunks can
+ * still be peeked.
+ */
+class CybertwinFrameBuffer
+{
+  public:
+    CybertwinFrameBuffer();
+
+    void Append(Ptr<Packet> chunk);
+    void Clear();
+    uint32_t GetSize() const;
+
+    // copies up to size bytes from the front without consuming them
+    uint32_t CopyData(uint8_t* buffer, uint32_t size) const;
+    // deserializes a header of headerSize bytes from the front, false if not enough data
+    bool PeekHeader(Header& header, uint32_t headerSize) const;
+    // removes and returns the first size bytes, nullptr if not enough data
+    Ptr<Packet> Remove(uint32_t size);
+
+  private:
+    std::deque<Ptr<Packet>> m_chunks;
+    uint32_t m_size;
+};
+
+} // namespace ns3
+
+#endif
@@ -1,9 +1,14 @@
 #include "ns3/log.h"
+#include "ns3/simulator.h"
+#include "ns3/string.h"
+#include "ns3/uinteger.h"
 #include "cybertwin-name-resolution-service.h"
 
 namespace ns3
 {
 NS_LOG_COMPONENT_DEFINE("NameResolutionService");
+NS_OBJECT_ENSURE_REGISTERED(NameResolutionService);
+NS_OBJECT_ENSURE_REGISTERED(NameResolutionClient);
 
 TypeId
 NameResolutionService::GetTypeId()
@@ -12,7 +17,51 @@ NameResolutionService::GetTypeId()
         TypeId("ns3::NameResolutionService")
             .SetParent<Application>()
             .SetGroupName("Applications")
-            .AddConstructor<NameResolutionService>();
+            .AddConstructor<NameResolutionService>()
+            .AddAttribute("SuperiorAddress",
+                          "The IPv4 address of the superior CNRS, invalid for the root",
+                          AddressValue(),
+                          MakeAddressAccessor(&NameResolutionService::superior),
+                          MakeAddressChecker())
+            .AddAttribute("DatabaseName",
+                          "The file the name table is persisted to, empty to keep it in memory only",
+                          StringValue(""),
+                          MakeStringAccessor(&NameResolutionService::databaseName),
+                          MakeStringChecker())
+            .AddAttribute("SnapshotInterval",
+                          "The interval between database snapshots, zero to save only on stop",
+                          TimeValue(Seconds(0)),
+                          MakeTimeAccessor(&NameResolutionService::m_snapshotInterval),
+                          MakeTimeChecker())
+            .AddAttribute("Shards",
+                          "The number of shards the name table is split into",
+                          UintegerValue(16),
+                          MakeUintegerAccessor(&NameResolutionService::m_nShards),
+                          MakeUintegerChecker<uint32_t>(1))
+            .AddAttribute("ReportBatchSize",
+                          "The maximum number of records reported to the superior per datagram",
+                          UintegerValue(100),
+                          MakeUintegerAccessor(&NameResolutionService::m_reportBatchSize),
+                          MakeUintegerChecker<uint32_t>(1, 4096))
+            .AddAttribute("ReportInterval",
+                          "The longest time a record waits before it is reported to the superior",
+                          TimeValue(MilliSeconds(100)),
+                          MakeTimeAccessor(&NameResolutionService::m_reportInterval),
+                          MakeTimeChecker())
+            .AddAttribute("UpstreamCacheTtl",
+                          "How long an answer from the superior is cached",
+                          TimeValue(Seconds(60)),
+                          MakeTimeAccessor(&NameResolutionService::m_upstreamCacheTtl),
+                          MakeTimeChecker())
+            .AddAttribute("UpstreamTimeout",
+                          "How long to wait for the superior before failing a forwarded query",
+                          TimeValue(Seconds(1)),
+                          MakeTimeAccessor(&NameResolutionService::m_upstreamTimeout),
+                          MakeTimeChecker())
+            .AddTraceSource("UpstreamTx",
+                            "A datagram has been sent to the superior",
+                            MakeTraceSourceAccessor(&NameResolutionService::m_upstreamTxTrace),
+                            "ns3::Packet::TracedCallback");
     return tid;
 }
 
@@ -20,7 +69,11 @@ NameResolutionService::NameResolutionService():
     serviceSocket(nullptr),
     reportSocket(nullptr),
     m_port(NAME_RESOLUTION_SERVICE_PORT),
-    databaseName("testdb")
+    database(nullptr),
+    databaseDirty(false),
+    m_nShards(16),
+    m_nItems(0),
+    m_reportBatchSize(100)
 {
     NS_LOG_FUNCTION(this);
 }
@@ -30,7 +83,11 @@ NameResolutionService::NameResolutionService(Address super):
     reportSocket(nullptr),
     m_port(NAME_RESOLUTION_SERVICE_PORT),
     superior(super),
-    databaseName("testdb")
+    database(nullptr),
+    databaseDirty(false),
+    m_nShards(16),
+    m_nItems(0),
+    m_reportBatchSize(100)
 {
 }
 
@@ -40,6 +97,25 @@ NameResolutionService::~NameResolutionService()
     serviceSocket = nullptr;
 }
 
+void
+NameResolutionService::DoDispose()
+{
+    NS_LOG_FUNCTION(this);
+    Simulator::Cancel(reportEvent);
+    Simulator::Cancel(snapshotEvent);
+    database = nullptr;
+    for (auto& entry : upstreamQueries)
+    {
+        Simulator::Cancel(entry.second.timeout);
+    }
+    upstreamQueries.clear();
+    upstreamCache.clear();
+    itemCache.clear();
+    serviceSocket = nullptr;
+    reportSocket = nullptr;
+    Application::DoDispose();
+}
+
 void
 NameResolutionService::StartApplication()
 {
@@ -49,8 +125,11 @@ NameResolutionService::StartApplication()
 void
 NameResolutionService::StopApplication()
 {
-    //TODO: rememeber to save database.
     NS_LOG_DEBUG("stop CNRS.");
+    Simulator::Cancel(reportEvent);
+    Simulator::Cancel(snapshotEvent);
+    FlushReports();
+    SaveDatabase();
 }
 
 
@@ -58,10 +137,28 @@ void
 NameResolutionService::InitNameResolutionService()
 {
     NS_LOG_DEBUG("Init name resolution service.");
+    if (itemCache.size() != m_nShards)
+    {
+        itemCache.assign(m_nShards, ItemShard());
+        m_nItems = 0;
+    }
     LoadDatabase();
     InitNameResolutionServer();
 }
 
+uint32_t
+NameResolutionService::GetNItems() const
+{
+    return m_nItems + (database ? database->GetNRecords() : 0);
+}
+
+NameResolutionService::ItemShard &
+NameResolutionService::GetShard(CYBERTWINID_t id)
+{
+    // spread sequential IDs over the shards
+    return itemCache[(id * 0x9E3779B97F4A7C15ULL >> 32) % itemCache.size()];
+}
+
 void 
 NameResolutionService::LoadDatabase()
 {
@@ -69,7 +166,80 @@ NameResolutionService::LoadDatabase()
     if (databaseName.size() != 0)
     {
         NS_LOG_DEBUG("loading database");
+        if (!database)
+        {
+            database = Create<CnrsDatabase>();
+        }
+        if (database->Open(databaseName))
+        {
+            NS_LOG_INFO("CNRS: loaded " << database->GetNRecords() << " items from " << databaseName);
+        }
+        if (m_snapshotInterval.IsStrictlyPositive() && !snapshotEvent.IsRunning())
+        {
+            snapshotEvent = Simulator::Schedule(m_snapshotInterval,
+                                                &NameResolutionService::PeriodicSnapshot,
+                                                this);
+        }
+    }
+}
+
+void
+NameResolutionService::PeriodicSnapshot()
+{
+    SaveDatabase();
+    snapshotEvent = Simulator::Schedule(m_snapshotInterval,
+                                        &NameResolutionService::PeriodicSnapshot,
+                                        this);
+}
+
+void
+NameResolutionService::SaveDatabase()
+{
+    if (databaseName.size() == 0 || !databaseDirty)
+    {
+        return;
+    }
+    NS_LOG_FUNCTION(this);
+
+    // merge the mapped snapshot with the names inserted since
+    uint64_t base = database && database->IsOpen() ? database->GetNRecords() : 0;
+    CnrsDatabaseWriter writer(base + m_nItems);
+    if (base)
+    {
+        const CnrsDatabase::Record* records = database->GetRecords();
+        for (uint64_t i = 0; i < database->GetCapacity(); i++)
+        {
+            if (records[i].used)
+            {
+                writer.Insert(records[i].cybertwinID, records[i].cybertwinAddr, records[i].cybertwinPort);
+            }
+        }
+    }
+    for (const ItemShard &shard : itemCache)
+    {
+        for (const auto &item : shard)
+        {
+            writer.Insert(item.first, item.second.first.Get(), item.second.second);
+        }
+    }
+
+    if (!writer.Commit(databaseName))
+    {
+        return;
+    }
+    NS_LOG_INFO("CNRS: saved " << writer.GetNRecords() << " items to " << databaseName);
+
+    // the new file holds everything, serve it from the mapping again
+    if (!database)
+    {
+        database = Create<CnrsDatabase>();
+    }
+    if (database->Open(databaseName))
+    {
+        itemCache.assign(m_nShards, ItemShard());
+        m_nItems = 0;
     }
+    databaseDirty = false;
 }
 
 void
@@ -110,6 +280,7 @@ NameResolutionService::InitReportUDPSocket()
         reportSocket->Connect(
             InetSocketAddress(Ipv4Address::ConvertFrom(superior), NAME_RESOLUTION_SERVICE_PORT)
         );
+        reportSocket->SetRecvCallback(MakeCallback(&NameResolutionService::UpstreamRecvHandler, this));
     }
 }
 
@@ -119,32 +290,42 @@ NameResolutionService::RecvHandler(Ptr<Socket> socket)
     NS_LOG_FUNCTION(this<<socket);
     Ptr<Packet> packet;
     Address from;
-    Address localAddress;
 
     while ((packet = socket->RecvFrom(from)))
     {
         CybertwinCNRSHeader rcvHeader;
-        packet->RemoveHeader(rcvHeader);
+        packet->PeekHeader(rcvHeader);
         Ptr<Packet> rspPacket = Create<Packet>(0);
+        bool respond = true;
 
         switch(rcvHeader.GetMethod())
         {
             case CNRS_QUERY:
-                QueryRequestHandler(rcvHeader, rspPacket);
+                packet->RemoveHeader(rcvHeader);
+                respond = QueryRequestHandler(rcvHeader, rspPacket, from);
                 break;
             case CNRS_INSERT:
+                packet->RemoveHeader(rcvHeader);
                 InsertRequestHandler(rcvHeader, rspPacket);
                 break;
+            case CNRS_INSERT_BATCH:
+                // reports from subordinates are not acknowledged
+                InsertBatchHandler(packet);
+                respond = false;
+                break;
             default:
                 NS_LOG_DEBUG("CNRS: Unknown request.");
         }
 
-        socket->Send(rspPacket);
+        if (respond)
+        {
+            socket->SendTo(rspPacket, 0, from);
+        }
     }
 }
 
-void
-NameResolutionService::QueryRequestHandler(CybertwinCNRSHeader &rcvHeader, Ptr<Packet> rspPacket)
+bool
+NameResolutionService::QueryRequestHandler(CybertwinCNRSHeader &rcvHeader, Ptr<Packet> rspPacket, const Address &from)
 {
     NS_LOG_DEBUG("CNRS: handle query request.");
     //TODO: packet check
@@ -155,8 +336,14 @@ NameResolutionService::QueryRequestHandler(CybertwinCNRSHeader &rcvHeader, Ptr<P
 
     if (QueryCybertwinItem(id, ip, port) < 0)
     {
+        if (!superior.IsInvalid())
+        {
+            ForwardQuery2Superior(id, from);
+            return false;
+        }
         NS_LOG_DEBUG("CNRS: query cybertwinID doesn't exist.");
         rspHeader.SetMethod(CNRS_RESPONSE_FAIL);
+        rspHeader.SetCybertwinID(id);
     }else
     {
         rspHeader.SetMethod(CNRS_RESPONSE_OK);
@@ -165,6 +352,7 @@ NameResolutionService::QueryRequestHandler(CybertwinCNRSHeader &rcvHeader, Ptr<P
         rspHeader.SetCybertwinPort(port);
     }
     rspPacket->AddHeader(rspHeader);
+    return true;
 }
 
 int
@@ -172,11 +360,28 @@ NameResolutionService::QueryCybertwinItem(CYBERTWINID_t id, uint32_t &ip, uint16
 {
     NS_LOG_DEBUG("Query Cybertwin Item.");
     CYBERTWIN_INTERFACE_t interface;
-    if (itemCache.find(id) == itemCache.end())
+    ItemShard &shard = GetShard(id);
+    auto item = shard.find(id);
+    if (item != shard.end())
+    {
+        interface = item->second;
+    }else if (database && database->Find(id, ip, port))
     {
-        return -1;
+        return 0;
+    }else
+    {
+        auto cached = upstreamCache.find(id);
+        if (cached == upstreamCache.end())
+        {
+            return -1;
+        }
+        if (cached->second.expires <= Simulator::Now())
+        {
+            upstreamCache.erase(cached);
+            return -1;
+        }
+        interface = cached->second.interface;
     }
-    interface = itemCache[id];
     ip = interface.first.Get();
     port = interface.second;
 
@@ -200,36 +405,453 @@ NameResolutionService::InsertRequestHandler(CybertwinCNRSHeader &rcvHeader, Ptr<
     ReportName2Superior(name, ip, port);
 
     rspHeader.SetMethod(CNRS_RESPONSE_OK);
+    rspHeader.SetCybertwinID(name);
+    rspHeader.SetCybertwinAddr(ip);
+    rspHeader.SetCybertwinPort(port);
     rspPacket->AddHeader(rspHeader);
 }
 
+void
+NameResolutionService::InsertBatchHandler(Ptr<Packet> packet)
+{
+    CybertwinCNRSBatchHeader batch;
+    packet->RemoveHeader(batch);
+    NS_LOG_DEBUG("CNRS: handle batch of " << batch.GetNRecords() << " records.");
+
+    for (uint32_t i = 0; i < batch.GetNRecords(); i++)
+    {
+        InsertNewCybertwinItem(batch.GetCybertwinID(i),
+                               batch.GetCybertwinAddr(i),
+                               batch.GetCybertwinPort(i));
+        ReportName2Superior(batch.GetCybertwinID(i),
+                            batch.GetCybertwinAddr(i),
+                            batch.GetCybertwinPort(i));
+    }
+}
+
 void
 NameResolutionService::InsertNewCybertwinItem(CYBERTWINID_t id, uint32_t ip, uint16_t port)
 {
     NS_LOG_DEBUG("Insert New Cybertwin Item.");
     CYBERTWIN_INTERFACE_t interface = std::make_pair(Ipv4Address(ip), port);
-    itemCache[id] = interface;
+    if (itemCache.empty())
+    {
+        itemCache.assign(m_nShards, ItemShard());
+    }
+    auto ret = GetShard(id).insert(std::make_pair(id, interface));
+    uint32_t oldIp;
+    uint16_t oldPort;
+    if (!ret.second)
+    {
+        ret.first->second = interface;
+    }else if (!database || !database->Find(id, oldIp, oldPort))
+    {
+        m_nItems++;
+    }
+    upstreamCache.erase(id);
+    databaseDirty = true;
+}
+
+void
+NameResolutionService::ForwardQuery2Superior(CYBERTWINID_t id, const Address &from)
+{
+    NS_LOG_DEBUG("CNRS: forward query " << id << " to superior.");
+    auto it = upstreamQueries.find(id);
+    if (it != upstreamQueries.end())
+    {
+        // already asked, wait for the same answer
+        it->second.requesters.push_back(from);
+        return;
+    }
+    if (!reportSocket)
+    {
+        InitReportUDPSocket();
+    }
+
+    UpstreamQuery &query = upstreamQueries[id];
+    query.requesters.push_back(from);
+    query.timeout = Simulator::Schedule(m_upstreamTimeout,
+                                        &NameResolutionService::UpstreamQueryTimeout,
+                                        this,
+                                        id);
+
+    Ptr<Packet> pack = Create<Packet>(0);
+    CybertwinCNRSHeader header;
+    header.SetMethod(CNRS_QUERY);
+    header.SetCybertwinID(id);
+    pack->AddHeader(header);
+    m_upstreamTxTrace(pack);
+    reportSocket->Send(pack);
+}
+
+void
+NameResolutionService::UpstreamQueryTimeout(CYBERTWINID_t id)
+{
+    NS_LOG_DEBUG("CNRS: superior did not answer query " << id);
+    AnswerUpstreamQuery(id, false, 0, 0);
+}
+
+void
+NameResolutionService::UpstreamRecvHandler(Ptr<Socket> socket)
+{
+    NS_LOG_FUNCTION(this<<socket);
+    Ptr<Packet> packet;
+    Address from;
+
+    while ((packet = socket->RecvFrom(from)))
+    {
+        CybertwinCNRSHeader rspHeader;
+        packet->RemoveHeader(rspHeader);
+
+        switch(rspHeader.GetMethod())
+        {
+            case CNRS_RESPONSE_OK:
+                AnswerUpstreamQuery(rspHeader.GetCybertwinID(),
+                                    true,
+                                    rspHeader.GetCybertwinAddr(),
+                                    rspHeader.GetCybertwinPort());
+                break;
+            case CNRS_RESPONSE_FAIL:
+                AnswerUpstreamQuery(rspHeader.GetCybertwinID(), false, 0, 0);
+                break;
+            default:
+                NS_LOG_DEBUG("CNRS: Unknown response from superior.");
+        }
+    }
+}
+
+void
+NameResolutionService::AnswerUpstreamQuery(CYBERTWINID_t id, bool found, uint32_t ip, uint16_t port)
+{
+    auto it = upstreamQueries.find(id);
+    if (it == upstreamQueries.end())
+    {
+        return;
+    }
+    std::vector<Address> requesters;
+    requesters.swap(it->second.requesters);
+    Simulator::Cancel(it->second.timeout);
+    upstreamQueries.erase(it);
+
+    CybertwinCNRSHeader rspHeader;
+    rspHeader.SetCybertwinID(id);
+    if (found)
+    {
+        upstreamCache[id] = {std::make_pair(Ipv4Address(ip), port),
+                             Simulator::Now() + m_upstreamCacheTtl};
+        rspHeader.SetMethod(CNRS_RESPONSE_OK);
+        rspHeader.SetCybertwinAddr(ip);
+        rspHeader.SetCybertwinPort(port);
+    }else
+    {
+        rspHeader.SetMethod(CNRS_RESPONSE_FAIL);
+    }
+
+    for (const Address &requester : requesters)
+    {
+        Ptr<Packet> rspPacket = Create<Packet>(0);
+        rspPacket->AddHeader(rspHeader);
+        serviceSocket->SendTo(rspPacket, 0, requester);
+    }
 }
 
 void
 NameResolutionService::ReportName2Superior(CYBERTWINID_t id, uint32_t ip, uint16_t port)
 {
     NS_LOG_DEBUG("Report new item two superior.");
-    if (!superior.IsInvalid()) return;
+    if (superior.IsInvalid()) return;
+
+    pendingReports.AddRecord(id, ip, port);
+    if (pendingReports.GetNRecords() >= m_reportBatchSize)
+    {
+        Simulator::Cancel(reportEvent);
+        FlushReports();
+    }else if (!reportEvent.IsRunning())
+    {
+        reportEvent = Simulator::Schedule(m_reportInterval, &NameResolutionService::FlushReports, this);
+    }
+}
+
+void
+NameResolutionService::FlushReports()
+{
+    if (pendingReports.GetNRecords() == 0) return;
     if (!reportSocket){
         InitReportUDPSocket();
     }
     if (!reportSocket) return ;
 
-    Ptr<Packet> pack = Create<Packet>(128);
+    NS_LOG_DEBUG("Report " << pendingReports.GetNRecords() << " items to superior.");
+    Ptr<Packet> pack = Create<Packet>(0);
+    pack->AddHeader(pendingReports);
+    pendingReports.Clear();
+    m_upstreamTxTrace(pack);
+    reportSocket->Send(pack);
+}
+
+//********************************************************************
+//*                  Name Resolution Client                          *
+//********************************************************************
+
+TypeId
+NameResolutionClient::GetTypeId()
+{
+    static TypeId tid =
+        TypeId("ns3::NameResolutionClient")
+            .SetParent<Object>()
+            .SetGroupName("cybertwin")
+            .AddConstructor<NameResolutionClient>()
+            .AddAttribute("ServerAddress",
+                          "The IPv4 address of the name resolution service",
+                          AddressValue(),
+                          MakeAddressAccessor(&NameResolutionClient::m_serverAddr),
+                          MakeAddressChecker())
+            .AddAttribute("PositiveTtl",
+                          "How long a resolved name stays in the cache",
+                          TimeValue(Seconds(60)),
+                          MakeTimeAccessor(&NameResolutionClient::m_positiveTtl),
+                          MakeTimeChecker())
+            .AddAttribute("NegativeTtl",
+                          "How long an unknown name stays in the cache",
+                          TimeValue(Seconds(5)),
+                          MakeTimeAccessor(&NameResolutionClient::m_negativeTtl),
+                          MakeTimeChecker())
+            .AddAttribute("QueryTimeout",
+                          "How long to wait for an answer before retrying a query",
+                          TimeValue(Seconds(1)),
+                          MakeTimeAccessor(&NameResolutionClient::m_queryTimeout),
+                          MakeTimeChecker())
+            .AddAttribute("MaxRetries",
+                          "The number of times a query is retransmitted before giving up",
+                          UintegerValue(3),
+                          MakeUintegerAccessor(&NameResolutionClient::m_maxRetries),
+                          MakeUintegerChecker<uint32_t>());
+    return tid;
+}
+
+NameResolutionClient::NameResolutionClient():
+    m_node(nullptr),
+    m_socket(nullptr)
+{
+    NS_LOG_FUNCTION(this);
+}
+
+NameResolutionClient::~NameResolutionClient()
+{
+    NS_LOG_FUNCTION(this);
+}
+
+void
+NameResolutionClient::DoDispose()
+{
+    NS_LOG_FUNCTION(this);
+    for (auto& entry : m_pending)
+    {
+        Simulator::Cancel(entry.second.timeout);
+    }
+    m_pending.clear();
+    m_cache.clear();
+    if (m_socket)
+    {
+        m_socket->SetRecvCallback(MakeNullCallback<void, Ptr<Socket>>());
+        m_socket->Close();
+        m_socket = nullptr;
+    }
+    m_node = nullptr;
+    Object::DoDispose();
+}
+
+void
+NameResolutionClient::SetNode(Ptr<Node> node)
+{
+    m_node = node;
+}
+
+bool
+NameResolutionClient::Lookup(CYBERTWINID_t id, CybertwinInterface &interface)
+{
+    auto it = m_cache.find(id);
+    if (it == m_cache.end())
+    {
+        return false;
+    }
+    if (it->second.expires <= Simulator::Now())
+    {
+        m_cache.erase(it);
+        return false;
+    }
+    interface = it->second.interface;
+    return it->second.found;
+}
+
+void
+NameResolutionClient::Resolve(CYBERTWINID_t id, ResolvedCallback callback)
+{
+    NS_LOG_FUNCTION(this << id);
+    auto it = m_cache.find(id);
+    if (it != m_cache.end() && it->second.expires > Simulator::Now())
+    {
+        callback(id, it->second.found, it->second.interface);
+        return;
+    }
+    if (it != m_cache.end())
+    {
+        m_cache.erase(it);
+    }
+
+    // coalesce with a query that is already in flight
+    bool inFlight = m_pending.find(id) != m_pending.end();
+    m_pending[id].waiters.push_back(callback);
+    if (!inFlight)
+    {
+        SendQuery(id);
+    }
+}
+
+void
+NameResolutionClient::Insert(CYBERTWINID_t id, Ipv4Address ip, uint16_t port)
+{
+    NS_LOG_FUNCTION(this << id << ip << port);
+    m_cache[id] = {true, std::make_pair(ip, port), Simulator::Now() + m_positiveTtl};
+
     CybertwinCNRSHeader header;
     header.SetMethod(CNRS_INSERT);
     header.SetCybertwinID(id);
-    header.SetCybertwinAddr(ip);
+    header.SetCybertwinAddr(ip.Get());
     header.SetCybertwinPort(port);
+    SendRequest(header);
+}
 
-    pack->AddHeader(header);
-    reportSocket->Send(pack);
+bool
+NameResolutionClient::InitSocket()
+{
+    if (m_socket)
+    {
+        return true;
+    }
+    if (!m_node || !Ipv4Address::IsMatchingType(m_serverAddr))
+    {
+        NS_LOG_ERROR("CNRS client: no node or server address configured.");
+        return false;
+    }
+
+    TypeId tid = TypeId::LookupByName("ns3::UdpSocketFactory");
+    m_socket = Socket::CreateSocket(m_node, tid);
+    if (m_socket->Bind() < 0)
+    {
+        NS_FATAL_ERROR("Failed to bind socket");
+    }
+    m_socket->Connect(
+        InetSocketAddress(Ipv4Address::ConvertFrom(m_serverAddr), NAME_RESOLUTION_SERVICE_PORT)
+    );
+    m_socket->SetRecvCallback(MakeCallback(&NameResolutionClient::RecvHandler, this));
+    return true;
+}
+
+void
+NameResolutionClient::SendRequest(CybertwinCNRSHeader &header)
+{
+    if (!InitSocket())
+    {
+        return;
+    }
+    Ptr<Packet> packet = Create<Packet>(0);
+    packet->AddHeader(header);
+    m_socket->Send(packet);
+}
+
+void
+NameResolutionClient::SendQuery(CYBERTWINID_t id)
+{
+    NS_LOG_DEBUG("CNRS client: query " << id);
+    if (!InitSocket())
+    {
+        Complete(id, false, CybertwinInterface());
+        return;
+    }
+
+    CybertwinCNRSHeader header;
+    header.SetMethod(CNRS_QUERY);
+    header.SetCybertwinID(id);
+    SendRequest(header);
+
+    PendingQuery& query = m_pending[id];
+    query.timeout = Simulator::Schedule(m_queryTimeout, &NameResolutionClient::QueryTimeout, this, id);
 }
-} // namespace ns3
 
+void
+NameResolutionClient::QueryTimeout(CYBERTWINID_t id)
+{
+    auto it = m_pending.find(id);
+    if (it == m_pending.end())
+    {
+        return;
+    }
+    if (it->second.retries++ < m_maxRetries)
+    {
+        SendQuery(id);
+        return;
+    }
+    NS_LOG_DEBUG("CNRS client: query " << id << " timed out.");
+    Complete(id, false, CybertwinInterface());
+}
+
+void
+NameResolutionClient::RecvHandler(Ptr<Socket> socket)
+{
+    NS_LOG_FUNCTION(this << socket);
+    Ptr<Packet> packet;
+    Address from;
+
+    while ((packet = socket->RecvFrom(from)))
+    {
+        CybertwinCNRSHeader rspHeader;
+        packet->RemoveHeader(rspHeader);
+        CYBERTWINID_t id = rspHeader.GetCybertwinID();
+
+        // insert acknowledgements and late answers have nobody waiting
+        if (m_pending.find(id) == m_pending.end())
+        {
+            continue;
+        }
+
+        switch (rspHeader.GetMethod())
+        {
+            case CNRS_RESPONSE_OK:
+                Complete(id,
+                         true,
+                         std::make_pair(Ipv4Address(rspHeader.GetCybertwinAddr()),
+                                        rspHeader.GetCybertwinPort()));
+                break;
+            case CNRS_RESPONSE_FAIL:
+                Complete(id, false, CybertwinInterface());
+                break;
+            default:
+                NS_LOG_DEBUG("CNRS client: Unknown response.");
+        }
+    }
+}
+
+void
+NameResolutionClient::Complete(CYBERTWINID_t id, bool found, CybertwinInterface interface)
+{
+    m_cache[id] = {found, interface, Simulator::Now() + (found ? m_positiveTtl : m_negativeTtl)};
+
+    auto it = m_pending.find(id);
+    if (it == m_pending.end())
+    {
+        return;
+    }
+    // detach the waiters first, a callback may start a new lookup
+    std::vector<ResolvedCallback> waiters;
+    waiters.swap(it->second.waiters);
+    Simulator::Cancel(it->second.timeout);
+    m_pending.erase(it);
+
+    for (auto& waiter : waiters)
+    {
+        waiter(id, found, interface);
+    }
+}
+
+} // namespace ns3
@@ -1,16 +1,36 @@
 #ifndef CYBERTWIN_NAME_RESOLUTION_SERVICE_H
 #define CYBERTWIN_NAME_RESOLUTION_SERVICE_H
 #include "ns3/application.h"
+#include "ns3/event-id.h"
+#include "ns3/node.h"
+#include "ns3/nstime.h"
 #include "ns3/socket.h"
+#include "ns3/traced-callback.h"
+#include "cybertwin-cnrs-database.h"
 #include "cybertwin-common.h"
 #include "cybertwin-packet-header.h"
 
 #include <string>
 #include <unordered_map>
+#include <vector>
 
 namespace ns3
 {
 
+/**
+ * Cybertwin name resolution service (CNRS).
+ *
+ * Names registered here are kept in a table split into shards and reported
+ * to the superior CNRS, if any, in batches of up to ReportBatchSize records
+ * per datagram. Queries for unknown names are forwarded to the superior and
+ * the answers cached for UpstreamCacheTtl, so a tree of services resolves
+ * every name any of its leaves knows about.
+ *
+ * When DatabaseName is set, the table is persisted as a CnrsDatabase file.
+ * The file is mapped when the service starts and new names are kept in the
+ * shards on top of it until the next snapshot merges both into a new file,
+ * either every SnapshotInterval or when the service stops.
+ */
 class NameResolutionService: public Application
 {
     public:
@@ -21,29 +41,140 @@ class NameResolutionService: public Application
 
         void InitNameResolutionService();
 
+        // number of names registered with this service, not counting cached answers
+        uint32_t GetNItems() const;
+
+    protected:
+        void DoDispose() override;
+
     private:
+        // answer learned from the superior
+        struct UpstreamItem
+        {
+            CYBERTWIN_INTERFACE_t interface;
+            Time expires;
+        };
+
+        // query forwarded to the superior, and who is waiting for it
+        struct UpstreamQuery
+        {
+            std::vector<Address> requesters;
+            EventId timeout;
+        };
+
+        typedef std::unordered_map<CYBERTWINID_t, CYBERTWIN_INTERFACE_t> ItemShard;
+
         void StartApplication() override;
         void StopApplication() override;
 
         void LoadDatabase();
+        void SaveDatabase();
+        void PeriodicSnapshot();
         void InitNameResolutionServer();
         void InitReportUDPSocket();
 
         void RecvHandler(Ptr<Socket> socket);
+        void UpstreamRecvHandler(Ptr<Socket> socket);
 
-        void QueryRequestHandler(CybertwinCNRSHeader &rcvHeader, Ptr<Packet> rspPacket);
+        bool QueryRequestHandler(CybertwinCNRSHeader &rcvHeader, Ptr<Packet> rspPacket, const Address &from);
         int QueryCybertwinItem(CYBERTWINID_t id, uint32_t &ip, uint16_t &port);
         void InsertRequestHandler(CybertwinCNRSHeader &rcvHeader, Ptr<Packet> rspPacket);
+        void InsertBatchHandler(Ptr<Packet> packet);
         void InsertNewCybertwinItem(CYBERTWINID_t id, uint32_t ip, uint16_t port);
+        ItemShard &GetShard(CYBERTWINID_t id);
+
+        void ForwardQuery2Superior(CYBERTWINID_t id, const Address &from);
+        void UpstreamQueryTimeout(CYBERTWINID_t id);
+        void AnswerUpstreamQuery(CYBERTWINID_t id, bool found, uint32_t ip, uint16_t port);
 
         void ReportName2Superior(CYBERTWINID_t id, uint32_t ip, uint16_t port);
+        void FlushReports();
 
         Ptr<Socket> serviceSocket;
         Ptr<Socket> reportSocket;
         uint16_t m_port;
         Address superior;
         std::string databaseName;
-        std::unordered_map<CYBERTWINID_t, CYBERTWIN_INTERFACE_t> itemCache;
+        Ptr<CnrsDatabase> database;
+        Time m_snapshotInterval;
+        EventId snapshotEvent;
+        bool databaseDirty;
+        uint32_t m_nShards;
+        std::vector<ItemShard> itemCache;
+        uint32_t m_nItems;
+
+        Time m_upstreamCacheTtl;
+        Time m_upstreamTimeout;
+        std::unordered_map<CYBERTWINID_t, UpstreamItem> upstreamCache;
+        std::unordered_map<CYBERTWINID_t, UpstreamQuery> upstreamQueries;
+
+        uint32_t m_reportBatchSize;
+        Time m_reportInterval;
+        CybertwinCNRSBatchHeader pendingReports;
+        EventId reportEvent;
+
+        TracedCallback<Ptr<const Packet>> m_upstreamTxTrace;
+};
+
+/**
+ * Non-blocking client of the NameResolutionService.
+ *
+ * Lookups that miss the local cache send a single CNRS_QUERY per Cybertwin
+ * ID; later lookups for the same ID wait on that query instead of issuing
+ * their own. Positive and negative answers are cached with separate TTLs.
+ */
+class NameResolutionClient: public Object
+{
+    public:
+        typedef Callback<void, CYBERTWINID_t, bool, CybertwinInterface> ResolvedCallback;
+
+        NameResolutionClient();
+        ~NameResolutionClient();
+        static TypeId GetTypeId();
+
+        void SetNode(Ptr<Node> node);
+
+        // returns true and fills interface if the cache holds a live positive answer
+        bool Lookup(CYBERTWINID_t id, CybertwinInterface &interface);
+        // answers from the cache when possible, otherwise calls back once the server replied
+        void Resolve(CYBERTWINID_t id, ResolvedCallback callback);
+        // registers a name with the server and caches it locally
+        void Insert(CYBERTWINID_t id, Ipv4Address ip, uint16_t port);
+
+    protected:
+        void DoDispose() override;
+
+    private:
+        struct CacheEntry
+        {
+            bool found;
+            CybertwinInterface interface;
+            Time expires;
+        };
+
+        struct PendingQuery
+        {
+            std::vector<ResolvedCallback> waiters;
+            EventId timeout;
+            uint32_t retries{0};
+        };
+
+        bool InitSocket();
+        void SendRequest(CybertwinCNRSHeader &header);
+        void SendQuery(CYBERTWINID_t id);
+        void QueryTimeout(CYBERTWINID_t id);
+        void RecvHandler(Ptr<Socket> socket);
+        void Complete(CYBERTWINID_t id, bool found, CybertwinInterface interface);
+
+        Ptr<Node> m_node;
+        Ptr<Socket> m_socket;
+        Address m_serverAddr;
+        Time m_positiveTtl;
+        Time m_negativeTtl;
+        Time m_queryTimeout;
+        uint32_t m_maxRetries;
+        std::unordered_map<CYBERTWINID_t, CacheEntry> m_cache;
+        std::unordered_map<CYBERTWINID_t, PendingQuery> m_pending;
 };
 }//ns3
 
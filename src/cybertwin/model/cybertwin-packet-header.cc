@@ -6,6 +6,8 @@ namespace ns3
 {
 NS_LOG_COMPONENT_DEFINE("CybertwinPacketHeader");
 NS_OBJECT_ENSURE_REGISTERED(CybertwinPacketHeader);
+NS_OBJECT_ENSURE_REGISTERED(CybertwinCNRSBatchHeader);
+NS_OBJECT_ENSURE_REGISTERED(CybertwinControllerBatchHeader);
 
 
 //********************************************************************
@@ -136,7 +138,8 @@ CybertwinControllerHeader::CybertwinControllerHeader():
     method(NOTHING),
     devName(0),
     netType(0),
-    cybertwinID(0)
+    cybertwinID(0),
+    cybertwinPort(0)
 {
 }
 
@@ -253,6 +256,170 @@ CYBERTWINID_t CybertwinControllerHeader::GetCybertwinID() const
     return cybertwinID;
 }
 
+//********************************************************************
+//*           Cybertwin Controller Batch Header                      *
+//********************************************************************
+
+CybertwinControllerBatchHeader::CybertwinControllerBatchHeader():
+    method(NOTHING)
+{
+}
+
+TypeId
+CybertwinControllerBatchHeader::GetTypeId()
+{
+    static TypeId tid = TypeId("ns3::CybertwinControllerBatchHeader")
+                            .SetParent<Header>()
+                            .SetGroupName("cybertwin")
+                            .AddConstructor<CybertwinControllerBatchHeader>();
+    return tid;
+}
+
+TypeId
+CybertwinControllerBatchHeader::GetInstanceTypeId() const
+{
+    return GetTypeId();
+}
+
+void
+CybertwinControllerBatchHeader::Print(std::ostream& os) const
+{
+    os << "(method=" << method << " entries=" << entries.size() << ")";
+}
+
+uint32_t
+CybertwinControllerBatchHeader::GetFixedSize()
+{
+    return sizeof(uint16_t) + sizeof(uint16_t);
+}
+
+uint32_t
+CybertwinControllerBatchHeader::GetEntrySize()
+{
+    return sizeof(DEVNAME_t)
+            + sizeof(NETTYPE_t)
+            + sizeof(CYBERTWINID_t)
+            + sizeof(uint16_t)
+            + sizeof(uint16_t);
+}
+
+uint32_t
+CybertwinControllerBatchHeader::GetSerializedSize() const
+{
+    return GetFixedSize() + entries.size() * GetEntrySize();
+}
+
+void
+CybertwinControllerBatchHeader::Serialize(Buffer::Iterator start) const
+{
+    Buffer::Iterator i = start;
+    i.WriteHtonU16(method);
+    i.WriteHtonU16(entries.size());
+    for (const Entry& entry : entries)
+    {
+        i.WriteHtonU64(entry.devName);
+        i.WriteHtonU16(entry.netType);
+        i.WriteHtonU64(entry.cybertwinID);
+        i.WriteHtonU16(entry.cybertwinPort);
+        i.WriteHtonU16(entry.status);
+    }
+}
+
+uint32_t
+CybertwinControllerBatchHeader::Deserialize(Buffer::Iterator start)
+{
+    Buffer::Iterator i = start;
+    method = i.ReadNtohU16();
+    uint16_t count = i.ReadNtohU16();
+    entries.clear();
+    DeserializeEntries(i, count);
+    return GetSerializedSize();
+}
+
+void
+CybertwinControllerBatchHeader::DeserializeEntries(Buffer::Iterator start, uint32_t count)
+{
+    Buffer::Iterator i = start;
+    entries.reserve(entries.size() + count);
+    for (uint32_t n = 0; n < count; n++)
+    {
+        Entry entry;
+        entry.devName = i.ReadNtohU64();
+        entry.netType = i.ReadNtohU16();
+        entry.cybertwinID = i.ReadNtohU64();
+        entry.cybertwinPort = i.ReadNtohU16();
+        entry.status = i.ReadNtohU16();
+        entries.push_back(entry);
+    }
+}
+
+std::string
+CybertwinControllerBatchHeader::ToString() const
+{
+    std::ostringstream oss;
+    Print(oss);
+    return oss.str();
+}
+
+void
+CybertwinControllerBatchHeader::SetMethod(uint16_t method)
+{
+    this->method = method;
+}
+
+uint16_t
+CybertwinControllerBatchHeader::GetMethod() const
+{
+    return method;
+}
+
+void
+CybertwinControllerBatchHeader::AddEntry(DEVNAME_t devName,
+                                         NETTYPE_t netType,
+                                         CYBERTWINID_t cybertwinID,
+                                         uint16_t cybertwinPort,
+                                         uint16_t status)
+{
+    NS_ASSERT_MSG(entries.size() < UINT16_MAX, "Too many entries in one controller batch");
+    entries.push_back({devName, netType, cybertwinID, cybertwinPort, status});
+}
+
+uint32_t
+CybertwinControllerBatchHeader::GetNEntries() const
+{
+    return entries.size();
+}
+
+DEVNAME_t
+CybertwinControllerBatchHeader::GetDeviceName(uint32_t i) const
+{
+    return entries[i].devName;
+}
+
+NETTYPE_t
+CybertwinControllerBatchHeader::GetNetworkType(uint32_t i) const
+{
+    return entries[i].netType;
+}
+
+CYBERTWINID_t
+CybertwinControllerBatchHeader::GetCybertwinID(uint32_t i) const
+{
+    return entries[i].cybertwinID;
+}
+
+uint16_t
+CybertwinControllerBatchHeader::GetCybertwinPort(uint32_t i) const
+{
+    return entries[i].cybertwinPort;
+}
+
+uint16_t
+CybertwinControllerBatchHeader::GetStatus(uint32_t i) const
+{
+    return entries[i].status;
+}
+
 //********************************************************************
 //*                    Cybertwin CNRS Header                         *
 //********************************************************************
@@ -272,7 +439,11 @@ CybertwinCNRSHeader::GetInstanceTypeId() const
     return GetTypeId();
 }
 
-CybertwinCNRSHeader::CybertwinCNRSHeader()
+CybertwinCNRSHeader::CybertwinCNRSHeader():
+    method(0),
+    cybertwinID(0),
+    cybertwinAddr(0),
+    cybertwinPort(0)
 {
 }
 
@@ -370,4 +541,138 @@ CybertwinCNRSHeader::GetCybertwinPort() const
     return cybertwinPort;
 }
 
-} // namespace ns3
\ No newline at end of file
+//********************************************************************
+//*                 Cybertwin CNRS Batch Header                      *
+//********************************************************************
+TypeId
+CybertwinCNRSBatchHeader::GetTypeId()
+{
+    static TypeId tid = TypeId("ns3::CybertwinCNRSBatchHeader")
+                            .SetParent<Header>()
+                            .SetGroupName("cybertwin")
+                            .AddConstructor<CybertwinCNRSBatchHeader>();
+    return tid;
+}
+
+TypeId
+CybertwinCNRSBatchHeader::GetInstanceTypeId() const
+{
+    return GetTypeId();
+}
+
+CybertwinCNRSBatchHeader::CybertwinCNRSBatchHeader():
+    method(CNRS_INSERT_BATCH)
+{
+}
+
+void
+CybertwinCNRSBatchHeader::Print(std::ostream& os) const
+{
+    os << "(method=" << method << " records=" << records.size() << ")";
+}
+
+uint32_t
+CybertwinCNRSBatchHeader::GetRecordSize()
+{
+    return sizeof(CYBERTWINID_t) + sizeof(uint32_t) + sizeof(uint16_t);
+}
+
+uint32_t
+CybertwinCNRSBatchHeader::GetSerializedSize() const
+{
+    return sizeof(method)
+            + sizeof(uint16_t)
+            + records.size() * GetRecordSize();
+}
+
+void
+CybertwinCNRSBatchHeader::Serialize(Buffer::Iterator start) const
+{
+    Buffer::Iterator i = start;
+    i.WriteHtonU16(method);
+    i.WriteHtonU16(records.size());
+    for (const Record& record : records)
+    {
+        i.WriteHtonU64(record.cybertwinID);
+        i.WriteHtonU32(record.cybertwinAddr);
+        i.WriteHtonU16(record.cybertwinPort);
+    }
+}
+
+uint32_t
+CybertwinCNRSBatchHeader::Deserialize(Buffer::Iterator start)
+{
+    Buffer::Iterator i = start;
+    method = i.ReadNtohU16();
+    uint16_t count = i.ReadNtohU16();
+    records.clear();
+    records.reserve(count);
+    for (uint16_t n = 0; n < count; n++)
+    {
+        Record record;
+        record.cybertwinID = i.ReadNtohU64();
+        record.cybertwinAddr = i.ReadNtohU32();
+        record.cybertwinPort = i.ReadNtohU16();
+        records.push_back(record);
+    }
+    return GetSerializedSize();
+}
+
+std::string
+CybertwinCNRSBatchHeader::ToString() const
+{
+    std::ostringstream oss;
+    Print(oss);
+    return oss.str();
+}
+
+void
+CybertwinCNRSBatchHeader::SetMethod(uint16_t method)
+{
+    this->method = method;
+}
+
+uint16_t
+CybertwinCNRSBatchHeader::GetMethod() const
+{
+    return method;
+}
+
+void
+CybertwinCNRSBatchHeader::AddRecord(CYBERTWINID_t id, uint32_t addr, uint16_t port)
+{
+    NS_ASSERT_MSG(records.size() < UINT16_MAX, "Too many records in one CNRS batch");
+    records.push_back({id, addr, port});
+}
+
+uint32_t
+CybertwinCNRSBatchHeader::GetNRecords() const
+{
+    return records.size();
+}
+
+void
+CybertwinCNRSBatchHeader::Clear()
+{
+    records.clear();
+}
+
+CYBERTWINID_t
+CybertwinCNRSBatchHeader::GetCybertwinID(uint32_t i) const
+{
+    return records[i].cybertwinID;
+}
+
+uint32_t
+CybertwinCNRSBatchHeader::GetCybertwinAddr(uint32_t i) const
+{
+    return records[i].cybertwinAddr;
+}
+
+uint16_t
+CybertwinCNRSBatchHeader::GetCybertwinPort(uint32_t i) const
+{
+    return records[i].cybertwinPort;
+}
+
+} // namespace ns3
@@ -4,6 +4,8 @@
 #include "ns3/header.h"
 #include "cybertwin-common.h"
 
+#include <vector>
+
 namespace ns3
 {
 
@@ -82,6 +84,59 @@ class CybertwinControllerHeader: public Header
     uint16_t cybertwinPort;
 };
 
+// Many create or remove requests in one message, and their answers in the
+// response. Each entry carries the same fields as a CybertwinControllerHeader
+// plus the per-entry result.
+class CybertwinControllerBatchHeader: public Header
+{
+  public:
+    CybertwinControllerBatchHeader();
+
+    static TypeId GetTypeId();
+    TypeId GetInstanceTypeId() const override;
+
+    void Print(std::ostream& os) const override;
+    uint32_t GetSerializedSize() const override;
+    void Serialize(Buffer::Iterator start) const override;
+    uint32_t Deserialize(Buffer::Iterator start) override;
+    std::string ToString() const;
+
+    void SetMethod(uint16_t method);
+    uint16_t GetMethod() const;
+
+    void AddEntry(DEVNAME_t devName,
+                  NETTYPE_t netType,
+                  CYBERTWINID_t cybertwinID,
+                  uint16_t cybertwinPort = 0,
+                  uint16_t status = NOTHING);
+    uint32_t GetNEntries() const;
+
+    DEVNAME_t GetDeviceName(uint32_t i) const;
+    NETTYPE_t GetNetworkType(uint32_t i) const;
+    CYBERTWINID_t GetCybertwinID(uint32_t i) const;
+    uint16_t GetCybertwinPort(uint32_t i) const;
+    uint16_t GetStatus(uint32_t i) const;
+
+    // size of the method and count fields that precede the entries
+    static uint32_t GetFixedSize();
+    static uint32_t GetEntrySize();
+    // appends count entries serialized as in a batch, without the fixed fields
+    void DeserializeEntries(Buffer::Iterator start, uint32_t count);
+
+  private:
+    struct Entry
+    {
+        DEVNAME_t devName;
+        NETTYPE_t netType;
+        CYBERTWINID_t cybertwinID;
+        uint16_t cybertwinPort;
+        uint16_t status;
+    };
+
+    uint16_t method;
+    std::vector<Entry> entries;
+};
+
 class CybertwinCNRSHeader: public Header
 {
   public:
@@ -115,6 +170,47 @@ class CybertwinCNRSHeader: public Header
     uint16_t cybertwinPort;
 };
 
+// Carries many CNRS records in one datagram. The method field comes first so
+// the receiver can peek a CybertwinCNRSHeader to tell the two apart.
+class CybertwinCNRSBatchHeader: public Header
+{
+  public:
+    CybertwinCNRSBatchHeader();
+
+    static TypeId GetTypeId();
+    TypeId GetInstanceTypeId() const override;
+
+    void Print(std::ostream& os) const override;
+    uint32_t GetSerializedSize() const override;
+    void Serialize(Buffer::Iterator start) const override;
+    uint32_t Deserialize(Buffer::Iterator start) override;
+    std::string ToString() const;
+
+    void SetMethod(uint16_t method);
+    uint16_t GetMethod() const;
+
+    void AddRecord(CYBERTWINID_t id, uint32_t addr, uint16_t port);
+    uint32_t GetNRecords() const;
+    void Clear();
+
+    CYBERTWINID_t GetCybertwinID(uint32_t i) const;
+    uint32_t GetCybertwinAddr(uint32_t i) const;
+    uint16_t GetCybertwinPort(uint32_t i) const;
+
+    static uint32_t GetRecordSize();
+
+  private:
+    struct Record
+    {
+        CYBERTWINID_t cybertwinID;
+        uint32_t cybertwinAddr;
+        uint16_t cybertwinPort;
+    };
+
+    uint16_t method;
+    std::vector<Record> records;
+};
+
 } // namespace ns3
 
 #endif
\ No newline at end of file
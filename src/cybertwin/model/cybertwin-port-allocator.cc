@@ -0,0 +1,134 @@
+#include "cybertwin-port-allocator.h"
+
+#include "ns3/assert.h"
+#include "ns3/log.h"
+
+namespace ns3
+{
+NS_LOG_COMPONENT_DEFINE("CybertwinPortAllocator");
+
+CybertwinPortAllocator::CybertwinPortAllocator(uint16_t first, uint16_t last)
+    : m_first(first),
+      m_last(last),
+      m_next(first),
+      m_nAllocated(0)
+{
+    NS_ASSERT_MSG(first != 0 && first <= last, "Invalid port range " << first << "-" << last);
+    m_bitmap.assign((last - first + 1 + 63) / 64, 0);
+}
+
+uint16_t
+CybertwinPortAllocator::Allocate()
+{
+    // untouched ports first, skipping the ones reserved meanwhile
+    while (m_next <= m_last)
+    {
+        uint16_t port = m_next++;
+        if (!IsAllocated(port))
+        {
+            Set(port);
+            return port;
+        }
+    }
+
+    while (!m_free.empty())
+    {
+        uint16_t port = m_free.front();
+        m_free.pop_front();
+        if (!IsAllocated(port))
+        {
+            Set(port);
+            return port;
+        }
+    }
+
+    NS_LOG_WARN("Port range " << m_first << "-" << m_last << " exhausted.");
+    return 0;
+}
+
+bool
+CybertwinPortAllocator::Reserve(uint16_t port)
+{
+    if (!IsInRange(port) || IsAllocated(port))
+    {
+        return false;
+    }
+    Set(port);
+    return true;
+}
+
+bool
+CybertwinPortAllocator::Release(uint16_t port)
+{
+    if (!IsInRange(port) || !IsAllocated(port))
+    {
+        NS_LOG_WARN("Releasing port " << port << " which is not allocated.");
+        return false;
+    }
+    Clear(port);
+    // ports above m_next are picked up by the cursor again
+    if (port < m_next)
+    {
+        m_free.push_back(port);
+    }
+    return true;
+}
+
+bool
+CybertwinPortAllocator::IsInRange(uint16_t port) const
+{
+    return port >= m_first && port <= m_last;
+}
+
+bool
+CybertwinPortAllocator::IsAllocated(uint16_t port) const
+{
+    if (!IsInRange(port))
+    {
+        return false;
+    }
+    uint32_t bit = port - m_first;
+    return (m_bitmap[bit / 64] >> (bit % 64)) & 1;
+}
+
+uint32_t
+CybertwinPortAllocator::GetNAllocated() const
+{
+    return m_nAllocated;
+}
+
+uint32_t
+CybertwinPortAllocator::GetNAvailable() const
+{
+    return m_last - m_first + 1 - m_nAllocated;
+}
+
+uint16_t
+CybertwinPortAllocator::GetFirst() const
+{
+    return m_first;
+}
+
+uint16_t
+CybertwinPortAllocator::GetLast() const
+{
+    return m_last;
+}
+
+void
+CybertwinPortAllocator::Set(uint16_t port)
+{
+    uint32_t bit = port - m_first;
+    m_bitmap[bit / 64] |= uint64_t(1) << (bit % 64);
+    m_nAllocated++;
+}
+
+void
+CybertwinPortAllocator::Clear(uint16_t port)
+{
+    uint32_t bit = port - m_first;
+    m_bitmap[bit / 64] &= ~(uint64_t(1) << (bit % 64));
+    m_nAllocated--;
+}
+
+} // namespace ns3
@@ -0,0 +1,55 @@
+#ifndef CYBERTWIN_PORT_ALLOCATOR_H
+#define CYBERTWIN_PORT_ALLOCATOR_H
+
+#include "ns3/simple-ref-count.h"
+
+#include <cstdint>
+#include <deque>
+#include <vector>
+
+namespace ns3
+{
+
+/**
+ * Hands out ports from a fixed range [first, last].
+ *
+ * A bitmap records which ports are in use, so conflicts are detected in
+ * O(1). Ports that were never used are handed out in order; released ports
+ * go to the back of a FIFO free list and are only reused once the rest of
+ * the range has been consumed, which gives connections of the previous
+ * owner (e.g. in TIME_WAIT) as much time as possible to go away.
+ */
+class CybertwinPortAllocator : public SimpleRefCount<CybertwinPortAllocator>
+{
+  public:
+    CybertwinPortAllocator(uint16_t first, uint16_t last);
+
+    // returns 0 if the range is exhausted
+    uint16_t Allocate();
+    // marks a port used by someone else so it is never handed out
+    bool Reserve(uint16_t port);
+    // returns false if the port is out of range or not allocated
+    bool Release(uint16_t port);
+
+    bool IsInRange(uint16_t port) const;
+    bool IsAllocated(uint16_t port) const;
+    uint32_t GetNAllocated() const;
+    uint32_t GetNAvailable() const;
+    uint16_t GetFirst() const;
+    uint16_t GetLast() const;
+
+  private:
+    void Set(uint16_t port);
+    void Clear(uint16_t port);
+
+    uint16_t m_first;
+    uint16_t m_last;
+    uint32_t m_next;                // first port that was never handed out
+    uint32_t m_nAllocated;
+    std::vector<uint64_t> m_bitmap; // one bit per port in the range
+    std::deque<uint16_t> m_free;    // released ports, oldest first
+};
+
+} // namespace ns3
+
+#endif
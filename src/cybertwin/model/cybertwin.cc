@@ -2,34 +2,194 @@
 
 #include "ns3/applications-module.h"
 #include "ns3/packet.h"
+#include "ns3/boolean.h"
+#include "ns3/data-rate.h"
 #include "ns3/simulator.h"
+#include "ns3/uinteger.h"
 #include "cybertwin-packet-header.h"
 
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
 namespace ns3
 {
 
 NS_LOG_COMPONENT_DEFINE("Cybertwin");
+NS_OBJECT_ENSURE_REGISTERED(Cybertwin);
 
 TypeId
 Cybertwin::GetTypeId()
 {
     static TypeId tid =
-        TypeId("Cybertwin").SetParent<Application>().SetGroupName("cybertwin");
+        TypeId("ns3::Cybertwin")
+            .SetParent<Application>()
+            .SetGroupName("cybertwin")
+            .AddConstructor<Cybertwin>()
+            .AddAttribute("PeerQuantum",
+                          "The credit in bytes granted to each peer queue per forwarding round",
+                          UintegerValue(TX_MAX_NUM * 1024),
+                          MakeUintegerAccessor(&Cybertwin::m_peerQuantum),
+                          MakeUintegerChecker<uint32_t>(1))
+            .AddAttribute("DrainRateInterval",
+                          "The interval over which the per-peer drain rate is measured",
+                          TimeValue(MilliSeconds(100)),
+                          MakeTimeAccessor(&Cybertwin::m_drainRateInterval),
+                          MakeTimeChecker())
+            .AddAttribute("PeerConnectRetries",
+                          "The number of times a failed connection to a peer is retried before "
+                          "the packets waiting for it are dropped",
+                          UintegerValue(5),
+                          MakeUintegerAccessor(&Cybertwin::m_peerConnectRetries),
+                          MakeUintegerChecker<uint32_t>())
+            .AddAttribute("PeerRetryInterval",
+                          "The delay before the first retry, doubled after each failure",
+                          TimeValue(Seconds(1)),
+                          MakeTimeAccessor(&Cybertwin::m_peerRetryInterval),
+                          MakeTimeChecker())
+            .AddAttribute("LazyGlobalSocket",
+                          "Open the global listener, and register with the CNRS, only when the "
+                          "end host first connects. Until then the twin cannot be resolved.",
+                          BooleanValue(false),
+                          MakeBooleanAccessor(&Cybertwin::m_lazyGlobalSocket),
+                          MakeBooleanChecker())
+            .AddAttribute("NameResolutionServer",
+                          "The address of the CNRS used when no resolver is shared with the twin",
+                          AddressValue(),
+                          MakeAddressAccessor(&Cybertwin::m_cnrsAddr),
+                          MakeAddressChecker())
+            .AddAttribute("TxQueueLimit",
+                          "The most traffic from the end host queued for all peers together",
+                          QueueSizeValue(QueueSize("1MB")),
+                          MakeQueueSizeAccessor(&Cybertwin::m_txQueueLimit),
+                          MakeQueueSizeChecker())
+            .AddAttribute("RxQueueLimit",
+                          "The most traffic from peers queued for the end host",
+                          QueueSizeValue(QueueSize("1MB")),
+                          MakeQueueSizeAccessor(&Cybertwin::m_rxQueueLimit),
+                          MakeQueueSizeChecker())
+            .AddAttribute("TxRate",
+                          "The rate the end host's traffic is forwarded at, zero for no limit",
+                          DataRateValue(DataRate(0)),
+                          MakeDataRateAccessor(&Cybertwin::m_txRate),
+                          MakeDataRateChecker())
+            .AddAttribute("TxBurst",
+                          "The size in bytes of the token bucket shaping forwarded traffic",
+                          UintegerValue(64 * 1024),
+                          MakeUintegerAccessor(&Cybertwin::m_txBurst),
+                          MakeUintegerChecker<uint32_t>(1))
+            .AddAttribute("RxRate",
+                          "The rate traffic is delivered to the end host at, zero for no limit",
+                          DataRateValue(DataRate(0)),
+                          MakeDataRateAccessor(&Cybertwin::m_rxRate),
+                          MakeDataRateChecker())
+            .AddAttribute("RxBurst",
+                          "The size in bytes of the token bucket shaping delivered traffic",
+                          UintegerValue(64 * 1024),
+                          MakeUintegerAccessor(&Cybertwin::m_rxBurst),
+                          MakeUintegerChecker<uint32_t>(1))
+            .AddAttribute("TxPackets",
+                          "The number of packets forwarded to peers",
+                          TypeId::ATTR_GET,
+                          UintegerValue(0),
+                          MakeUintegerAccessor(&Cybertwin::m_txPackets),
+                          MakeUintegerChecker<uint64_t>())
+            .AddAttribute("TxBytes",
+                          "The number of bytes forwarded to peers",
+                          TypeId::ATTR_GET,
+                          UintegerValue(0),
+                          MakeUintegerAccessor(&Cybertwin::m_txBytes),
+                          MakeUintegerChecker<uint64_t>())
+            .AddAttribute("TxDrops",
+                          "The number of packets from the end host dropped",
+                          TypeId::ATTR_GET,
+                          UintegerValue(0),
+                          MakeUintegerAccessor(&Cybertwin::m_txDrops),
+                          MakeUintegerChecker<uint64_t>())
+            .AddAttribute("RxPackets",
+                          "The number of packets delivered to the end host",
+                          TypeId::ATTR_GET,
+                          UintegerValue(0),
+                          MakeUintegerAccessor(&Cybertwin::m_rxPackets),
+                          MakeUintegerChecker<uint64_t>())
+            .AddAttribute("RxBytes",
+                          "The number of bytes delivered to the end host",
+                          TypeId::ATTR_GET,
+                          UintegerValue(0),
+                          MakeUintegerAccessor(&Cybertwin::m_rxBytes),
+                          MakeUintegerChecker<uint64_t>())
+            .AddAttribute("RxDrops",
+                          "The number of packets from peers dropped",
+                          TypeId::ATTR_GET,
+                          UintegerValue(0),
+                          MakeUintegerAccessor(&Cybertwin::m_rxDrops),
+                          MakeUintegerChecker<uint64_t>())
+            .AddTraceSource("Tx",
+                            "A packet from the end host has been forwarded to a peer",
+                            MakeTraceSourceAccessor(&Cybertwin::m_txTrace),
+                            "ns3::Packet::TracedCallback")
+            .AddTraceSource("TxDrop",
+                            "A packet from the end host has been dropped",
+                            MakeTraceSourceAccessor(&Cybertwin::m_txDropTrace),
+                            "ns3::Packet::TracedCallback")
+            .AddTraceSource("Rx",
+                            "A packet from a peer has been delivered to the end host",
+                            MakeTraceSourceAccessor(&Cybertwin::m_rxTrace),
+                            "ns3::Packet::TracedCallback")
+            .AddTraceSource("RxDrop",
+                            "A packet from a peer has been dropped",
+                            MakeTraceSourceAccessor(&Cybertwin::m_rxDropTrace),
+                            "ns3::Packet::TracedCallback")
+            .AddTraceSource("PeerQueueDepth",
+                            "The number of packets queued for a peer has changed",
+                            MakeTraceSourceAccessor(&Cybertwin::m_peerQueueDepthTrace),
+                            "ns3::Cybertwin::PeerQueueDepthCallback")
+            .AddTraceSource("PeerDrainRate",
+                            "The measured drain rate of a peer queue",
+                            MakeTraceSourceAccessor(&Cybertwin::m_peerDrainRateTrace),
+                            "ns3::Cybertwin::PeerDrainRateCallback");
 
     return tid;
 }
 
 Cybertwin::Cybertwin():
+    cybertwinID(0),
     localSocket(nullptr),
-    globalSocket(nullptr)
+    globalSocket(nullptr),
+    localConnSocket(nullptr),
+    m_stopped(false),
+    m_txQueueLimit("1MB"),
+    m_rxQueueLimit("1MB"),
+    m_txQueuePackets(0),
+    m_txQueueBytes(0),
+    m_rxQueueBytes(0),
+    m_txRate(0),
+    m_txBurst(64 * 1024),
+    m_rxRate(0),
+    m_rxBurst(64 * 1024),
+    m_txWaitSize(0),
+    m_txPackets(0),
+    m_txBytes(0),
+    m_txDrops(0),
+    m_rxPackets(0),
+    m_rxBytes(0),
+    m_rxDrops(0),
+    m_peerQuantum(TX_MAX_NUM * 1024),
+    m_drainRateInterval(MilliSeconds(100)),
+    m_peerConnectRetries(5),
+    m_peerRetryInterval(Seconds(1)),
+    m_lazyGlobalSocket(false),
+    nameResolver(nullptr),
+    edgeTransport(nullptr)
 {
 }
 
 Cybertwin::Cybertwin(CYBERTWINID_t id, CybertwinInterface local, CybertwinInterface global):
-cybertwinID(id), 
-localInterface(local),
-globalInterface(global)
+    Cybertwin()
 {
+    cybertwinID = id;
+    localInterface = local;
+    globalInterface = global;
     NS_LOG_INFO("Create new Cybertwin ["<<cybertwinID<<"]");
 }
 
@@ -38,11 +198,30 @@ Cybertwin::~Cybertwin()
     NS_LOG_INFO("Delete Cybertwin ["<<cybertwinID<<"]");
 }
 
+void
+Cybertwin::DoDispose()
+{
+    m_closedCallback = MakeNullCallback<void>();
+    m_connSockets.clear();
+    globalRxBuffers.clear();
+    localConnSocket = nullptr;
+    localSocket = nullptr;
+    globalSocket = nullptr;
+    Application::DoDispose();
+}
+
 void
 Cybertwin::StartApplication()
 {
     NS_LOG_INFO("Cybertwin "<<cybertwinID<<" born.");
+    if (m_stopped)
+    {
+        // stopped before the start event ran, the ports may be reused already
+        return;
+    }
     int ret = -1;
+    m_txBucket.Reset(m_txRate, m_txBurst);
+    m_rxBucket.Reset(m_rxRate, m_rxBurst);
     Address addr;
     uint16_t port;
 
@@ -83,10 +262,30 @@ Cybertwin::StartApplication()
     localSocket->SetCloseCallbacks(MakeCallback(&Cybertwin::localNormalCloseCallback, this),
                                     MakeCallback(&Cybertwin::localErrorCloseCallback, this));
     localSocket->Listen();
-    localSocket->ShutdownSend();
     NS_LOG_DEBUG("Cybertwin is locally listening.");
 
-    // init global socket
+    if (edgeTransport)
+    {
+        edgeTransport->Register(cybertwinID,
+                                MakeCallback(&Cybertwin::PeerReceiveCallback, this),
+                                MakeCallback(&Cybertwin::PeerResumeCallback, this));
+    }
+
+    if (!m_lazyGlobalSocket)
+    {
+        InitGlobalSocket();
+    }
+}
+
+// The global side is only needed once the end host is attached, so with
+// LazyGlobalSocket the listener and the CNRS registration wait until then.
+void
+Cybertwin::InitGlobalSocket()
+{
+    int ret = -1;
+    Address addr;
+    uint16_t port;
+
     addr = globalInterface.first;
     port = globalInterface.second;
     if (!globalSocket)
@@ -121,13 +320,171 @@ Cybertwin::StartApplication()
     globalSocket->ShutdownSend();
     NS_LOG_DEBUG("Cybertwin is globally listening.");
 
-    Simulator::Schedule(Seconds(0.), &Cybertwin::ouputPackets, this);
+    // register the global interface so that other cybertwins can find us
+    if (!nameResolver && !m_cnrsAddr.IsInvalid())
+    {
+        nameResolver = CreateObject<NameResolutionClient>();
+        nameResolver->SetAttribute("ServerAddress", AddressValue(m_cnrsAddr));
+        nameResolver->SetNode(GetNode());
+    }
+    if (nameResolver && Ipv4Address::IsMatchingType(globalInterface.first))
+    {
+        nameResolver->Insert(cybertwinID,
+                             Ipv4Address::ConvertFrom(globalInterface.first),
+                             globalInterface.second);
+    }
 }
 
 void
 Cybertwin::StopApplication()
 {
     NS_LOG_INFO("Cybertwin "<<cybertwinID<<" stop.");
+    Simulator::Cancel(m_restartEvent);
+    Simulator::Cancel(drainEvent);
+    Simulator::Cancel(deliverEvent);
+    Simulator::Cancel(m_resumeRecvEvent);
+    m_stalledSockets.clear();
+    if (edgeTransport)
+    {
+        edgeTransport->Unregister(cybertwinID);
+    }
+
+    for (auto& entry : txPacketBuffer)
+    {
+        Simulator::Cancel(entry.second.retryEvent);
+        Ptr<Socket> socket = entry.second.socket;
+        if (socket)
+        {
+            socket->SetConnectCallback(MakeNullCallback<void, Ptr<Socket>>(),
+                                       MakeNullCallback<void, Ptr<Socket>>());
+            socket->SetSendCallback(MakeNullCallback<void, Ptr<Socket>, uint32_t>());
+            socket->SetCloseCallbacks(MakeNullCallback<void, Ptr<Socket>>(),
+                                      MakeNullCallback<void, Ptr<Socket>>());
+            socket->Close();
+        }
+    }
+    txPacketBuffer.clear();
+    activePeers.clear();
+    globalTxSocket.clear();
+    m_txQueuePackets = 0;
+    m_txQueueBytes = 0;
+    m_txWaitSize = 0;
+
+    // connections from the end host and from peers
+    std::vector<Ptr<Socket>> connSockets(m_connSockets.begin(), m_connSockets.end());
+    for (auto& socket : connSockets)
+    {
+        socket->SetRecvCallback(MakeNullCallback<void, Ptr<Socket>>());
+        socket->SetSendCallback(MakeNullCallback<void, Ptr<Socket>, uint32_t>());
+        socket->Close();
+    }
+    localConnSocket = nullptr;
+    localRxBuffer.Clear();
+    globalRxBuffers.clear();
+
+    // release the listening ports so the controller can hand them out again
+    if (localSocket)
+    {
+        localSocket->SetAcceptCallback(MakeNullCallback<bool, Ptr<Socket>, const Address&>(),
+                                       MakeNullCallback<void, Ptr<Socket>, const Address&>());
+        localSocket->Close();
+        localSocket = nullptr;
+    }
+    if (globalSocket)
+    {
+        globalSocket->SetAcceptCallback(MakeNullCallback<bool, Ptr<Socket>, const Address&>(),
+                                        MakeNullCallback<void, Ptr<Socket>, const Address&>());
+        globalSocket->Close();
+        globalSocket = nullptr;
+    }
+    m_stopped = true;
+    CheckClosed();
+}
+
+void
+Cybertwin::Stop(Callback<void> closed)
+{
+    m_closedCallback = closed;
+    StopApplication();
+}
+
+void
+Cybertwin::Restart()
+{
+    NS_ASSERT_MSG(m_stopped && m_connSockets.empty() && m_closedCallback.IsNull(),
+                  "Cybertwin " << cybertwinID << " restarted before it closed");
+    NS_LOG_INFO("Cybertwin " << cybertwinID << " restart.");
+    m_stopped = false;
+    while (!rxPacketBuffer.empty())
+    {
+        rxPacketBuffer.pop();
+    }
+    m_rxQueueBytes = 0;
+    m_txPackets = 0;
+    m_txBytes = 0;
+    m_txDrops = 0;
+    m_rxPackets = 0;
+    m_rxBytes = 0;
+    m_rxDrops = 0;
+
+    // a twin stopped before it started still has its first start coming
+    if (IsInitialized() && !m_startEvent.IsRunning())
+    {
+        m_restartEvent = Simulator::ScheduleNow(&Cybertwin::StartApplication, this);
+    }
+}
+
+void
+Cybertwin::TrackConnSocket(Ptr<Socket> socket)
+{
+    // the socket's endpoint keeps our port bound until it is CLOSED
+    m_connSockets.insert(socket);
+    socket->TraceConnectWithoutContext(
+        "State",
+        MakeCallback(&Cybertwin::ConnStateChanged, this).Bind(PeekPointer(socket)));
+}
+
+void
+Cybertwin::ConnStateChanged(Socket* socket,
+                            TcpSocket::TcpStates_t oldState,
+                            TcpSocket::TcpStates_t newState)
+{
+    if (newState == TcpSocket::CLOSED)
+    {
+        ConnSocketClosed(socket);
+    }
+}
+
+void
+Cybertwin::ConnSocketClosed(Ptr<Socket> socket)
+{
+    globalRxBuffers.erase(socket);
+    if (m_connSockets.erase(socket))
+    {
+        CheckClosed();
+    }
+}
+
+void
+Cybertwin::CheckClosed()
+{
+    if (m_stopped && m_connSockets.empty() && !m_closedCallback.IsNull())
+    {
+        // the endpoint is released right after the socket reported it
+        Simulator::ScheduleNow(&Cybertwin::NotifyClosed, this);
+    }
+}
+
+void
+Cybertwin::NotifyClosed()
+{
+    if (m_closedCallback.IsNull())
+    {
+        return;
+    }
+    Callback<void> closed = m_closedCallback;
+    m_closedCallback = MakeNullCallback<void>();
+    closed();
 }
 
 CYBERTWINID_t
@@ -154,6 +511,30 @@ Cybertwin::SetGlobalInterface(Address addr, uint16_t port)
     globalInterface = std::make_pair(addr, port);
 }
 
+CybertwinInterface
+Cybertwin::GetLocalInterface() const
+{
+    return localInterface;
+}
+
+CybertwinInterface
+Cybertwin::GetGlobalInterface() const
+{
+    return globalInterface;
+}
+
+void
+Cybertwin::SetNameResolver(Ptr<NameResolutionClient> resolver)
+{
+    nameResolver = resolver;
+}
+
+void
+Cybertwin::SetEdgeTransport(Ptr<CybertwinEdgeTransport> transport)
+{
+    edgeTransport = transport;
+}
+
 //********************************************************************************
 //*                        Define local function                                 *
 //********************************************************************************
@@ -169,7 +550,22 @@ void
 Cybertwin::localNewConnCreatedCallback(Ptr<Socket> socket, const Address& addr)
 {
     NS_LOG_DEBUG("* Cybertwin * : TCP connection with endhost established.");
+    TrackConnSocket(socket);
+    if (m_stopped)
+    {
+        // completed its handshake after the twin stopped
+        socket->Close();
+        return;
+    }
     socket->SetRecvCallback(MakeCallback(&Cybertwin::localRecvHandler, this));
+    socket->SetSendCallback(MakeCallback(&Cybertwin::localSendCallback, this));
+    localConnSocket = socket;
+    localRxBuffer.Clear();
+    if (!globalSocket)
+    {
+        InitGlobalSocket();
+    }
+    DeliverToEndHost();
 }
 
 void
@@ -177,28 +573,232 @@ Cybertwin::localRecvHandler(Ptr<Socket> socket)
 {
     NS_LOG_DEBUG("* Cybertwin * : Cybertwin received local packet.");
 
-    Ptr<Packet> packet;
     Address from;
-    Address localAddress;
+    CybertwinPacketHeader header;
+    const uint32_t headerSize = header.GetSerializedSize();
 
-    while ((packet = socket->RecvFrom(from)))
+    while (true)
     {
-        CYBERTWINID_t id;
-        CybertwinPacketHeader header;
-        std::queue<Ptr<Packet>> packetQueue;
+        // segments do not follow the end host's frames, only forward whole ones
+        while (localRxBuffer.PeekHeader(header, headerSize) &&
+               localRxBuffer.GetSize() >= headerSize + header.GetSize())
+        {
+            if (!TxQueueFits(headerSize + header.GetSize()))
+            {
+                StallRecv(socket);
+                return;
+            }
+            // the header stays on the packet so the peer knows where it came from
+            Ptr<Packet> frame = localRxBuffer.Remove(headerSize + header.GetSize());
+            EnqueueForPeer(static_cast<CYBERTWINID_t>(header.GetDst()), frame);
+        }
+
+        // leave the rest in the socket, TCP flow control holds the end host back
+        uint32_t room = GetLocalRecvRoom();
+        if (room == 0)
+        {
+            StallRecv(socket);
+            return;
+        }
+        Ptr<Packet> packet = socket->RecvFrom(room, 0, from);
+        if (!packet)
+        {
+            return;
+        }
+        localRxBuffer.Append(packet);
+    }
+}
+
+void
+Cybertwin::localSendCallback(Ptr<Socket> socket, uint32_t txSpace)
+{
+    DeliverToEndHost();
+}
 
-        socket->GetSockName(localAddress);
-        packet->RemoveHeader(header);
-        id = static_cast<CYBERTWINID_t>(header.GetSrc());
+void
+Cybertwin::DeliverToEndHost()
+{
+    if (!localConnSocket)
+    {
+        return;
+    }
 
-        // TODO: it must lock the queue before push data to it.
-        if (txPacketBuffer.find(id) == txPacketBuffer.end())
+    while (!rxPacketBuffer.empty())
+    {
+        Ptr<Packet> packet = rxPacketBuffer.front();
+        uint32_t size = packet->GetSize();
+        if (!m_rxBucket.Conform(size))
         {
-            txPacketBuffer[id] = std::queue<Ptr<Packet>>();
+            if (!deliverEvent.IsRunning())
+            {
+                deliverEvent = Simulator::Schedule(m_rxBucket.GetDelay(size),
+                                                   &Cybertwin::DeliverToEndHost,
+                                                   this);
+            }
+            break;
+        }
+        if (localConnSocket->GetTxAvailable() < size || localConnSocket->Send(packet) < 0)
+        {
+            // wait for the send callback to report free buffer space
+            break;
         }
+        rxPacketBuffer.pop();
+        m_rxQueueBytes -= size;
+        m_rxBucket.Consume(size);
+        m_rxPackets++;
+        m_rxBytes += size;
+        m_rxTrace(packet);
+        ScheduleResumeRecv();
+    }
+}
+
+void
+Cybertwin::EnqueueForEndHost(Ptr<Packet> packet)
+{
+    uint32_t size = packet->GetSize();
+    if (size > GetRxQueueRoom())
+    {
+        NS_LOG_DEBUG("Cybertwin " << cybertwinID << ": rx queue full, drop " << size << " bytes.");
+        m_rxDrops++;
+        m_rxDropTrace(packet);
+        return;
+    }
+    rxPacketBuffer.push(packet);
+    m_rxQueueBytes += size;
+    DeliverToEndHost();
+}
+
+bool
+Cybertwin::TxQueueFits(uint32_t size) const
+{
+    if (m_txQueueLimit.GetUnit() == QueueSizeUnit::PACKETS)
+    {
+        return m_txQueuePackets < m_txQueueLimit.GetValue();
+    }
+    // a frame larger than the whole limit is taken while the queue is empty
+    return m_txQueueBytes + size <= m_txQueueLimit.GetValue() || m_txQueuePackets == 0;
+}
+
+uint32_t
+Cybertwin::GetLocalRecvRoom() const
+{
+    CybertwinPacketHeader header;
+    const uint32_t headerSize = header.GetSerializedSize();
+    uint32_t buffered = localRxBuffer.GetSize();
+
+    // what the next frame still misses, the header first
+    uint32_t missing = headerSize > buffered ? headerSize - buffered : 0;
+    if (!missing && localRxBuffer.PeekHeader(header, headerSize))
+    {
+        uint32_t frameSize = headerSize + header.GetSize();
+        missing = frameSize > buffered ? frameSize - buffered : 0;
+    }
 
-        // push packet to queue
-        txPacketBuffer[id].push(packet);
+    if (m_txQueueLimit.GetUnit() == QueueSizeUnit::PACKETS)
+    {
+        // one frame is reassembled at a time
+        return m_txQueuePackets < m_txQueueLimit.GetValue() ? missing : 0;
+    }
+    // the reassembly buffer counts against the limit too
+    uint64_t held = m_txQueueBytes + buffered;
+    uint32_t room = held < m_txQueueLimit.GetValue() ? m_txQueueLimit.GetValue() - held : 0;
+    if (m_txQueuePackets == 0)
+    {
+        // so that a frame larger than the limit can still be completed
+        room = std::max(room, missing);
+    }
+    return room;
+}
+
+bool
+Cybertwin::RxQueueFits(uint32_t size) const
+{
+    if (m_rxQueueLimit.GetUnit() == QueueSizeUnit::PACKETS)
+    {
+        return rxPacketBuffer.size() < m_rxQueueLimit.GetValue();
+    }
+    // a frame larger than the whole limit is taken while the queue is empty
+    return m_rxQueueBytes + size <= m_rxQueueLimit.GetValue() || rxPacketBuffer.empty();
+}
+
+uint32_t
+Cybertwin::GetGlobalRecvRoom(const CybertwinFrameBuffer& rxBuffer) const
+{
+    CybertwinPacketHeader header;
+    const uint32_t headerSize = header.GetSerializedSize();
+    uint32_t buffered = rxBuffer.GetSize();
+
+    // what the next frame still misses, the header first
+    uint32_t missing = headerSize > buffered ? headerSize - buffered : 0;
+    if (!missing && rxBuffer.PeekHeader(header, headerSize))
+    {
+        uint32_t frameSize = headerSize + header.GetSize();
+        missing = frameSize > buffered ? frameSize - buffered : 0;
+    }
+
+    if (m_rxQueueLimit.GetUnit() == QueueSizeUnit::PACKETS)
+    {
+        return rxPacketBuffer.size() < m_rxQueueLimit.GetValue() ? missing : 0;
+    }
+    // the frame being reassembled counts against the limit too
+    uint64_t held = m_rxQueueBytes + buffered;
+    uint32_t room = held < m_rxQueueLimit.GetValue() ? m_rxQueueLimit.GetValue() - held : 0;
+    if (rxPacketBuffer.empty())
+    {
+        // so that a frame larger than the limit can still be completed
+        room = std::max(room, missing);
+    }
+    return room;
+}
+
+uint32_t
+Cybertwin::GetRxQueueRoom() const
+{
+    if (m_rxQueueLimit.GetUnit() == QueueSizeUnit::PACKETS)
+    {
+        return rxPacketBuffer.size() < m_rxQueueLimit.GetValue()
+                   ? std::numeric_limits<uint32_t>::max()
+                   : 0;
+    }
+    return m_rxQueueBytes < m_rxQueueLimit.GetValue() ? m_rxQueueLimit.GetValue() - m_rxQueueBytes
+                                                      : 0;
+}
+
+void
+Cybertwin::StallRecv(Ptr<Socket> socket)
+{
+    if (std::find(m_stalledSockets.begin(), m_stalledSockets.end(), socket) ==
+        m_stalledSockets.end())
+    {
+        m_stalledSockets.push_back(socket);
+    }
+}
+
+void
+Cybertwin::ScheduleResumeRecv()
+{
+    if (!m_stalledSockets.empty() && !m_resumeRecvEvent.IsRunning())
+    {
+        m_resumeRecvEvent = Simulator::ScheduleNow(&Cybertwin::ResumeRecv, this);
+    }
+}
+
+void
+Cybertwin::ResumeRecv()
+{
+    // sockets whose queue is still full stall again
+    std::vector<Ptr<Socket>> stalled;
+    stalled.swap(m_stalledSockets);
+    for (auto& socket : stalled)
+    {
+        if (socket == localConnSocket)
+        {
+            localRecvHandler(socket);
+        }
+        else
+        {
+            globalRecvHandler(socket);
+        }
     }
 }
 
@@ -213,6 +813,8 @@ void
 Cybertwin::localErrorCloseCallback(Ptr<Socket> socket)
 {
     NS_LOG_ERROR("A socket error occurs:" << socket->GetErrno());
+    // an aborted connection releases its endpoint without going through CLOSED
+    ConnSocketClosed(socket);
 }
 
 //********************************************************************************
@@ -229,7 +831,13 @@ void
 Cybertwin::globalNewConnCreatedCallback(Ptr<Socket> socket, const Address& addr)
 {
     NS_LOG_INFO("TCP connection established.");
-    socket->SetRecvCallback(MakeCallback(&Cybertwin::localRecvHandler, this));
+    TrackConnSocket(socket);
+    if (m_stopped)
+    {
+        socket->Close();
+        return;
+    }
+    socket->SetRecvCallback(MakeCallback(&Cybertwin::globalRecvHandler, this));
 }
 
 void
@@ -237,29 +845,43 @@ Cybertwin::globalRecvHandler(Ptr<Socket> socket)
 {
     NS_LOG_INFO("Cybertwin received global packet.");
 
-    Ptr<Packet> packet;
     Address from;
-    Address localAddress;
+    CybertwinPacketHeader header;
+    const uint32_t headerSize = header.GetSerializedSize();
+    CybertwinFrameBuffer& rxBuffer = globalRxBuffers[socket];
 
-    while ((packet = socket->RecvFrom(from)))
+    while (true)
     {
-        CYBERTWINID_t id;
-        CybertwinPacketHeader header;
-        std::queue<Ptr<Packet>> packetQueue;
-
-        socket->GetSockName(localAddress);
-        packet->RemoveHeader(header);
-        id = static_cast<CYBERTWINID_t>(header.GetSrc());
-        
-        // TODO: it must lock the queue before push data to it.
-        if (rxPacketBuffer.find(id) == rxPacketBuffer.end())
+        // queue and count whole frames, like those from the end host
+        while (rxBuffer.PeekHeader(header, headerSize) &&
+               rxBuffer.GetSize() >= headerSize + header.GetSize())
         {
-            rxPacketBuffer[id] = std::queue<Ptr<Packet>>();
+            if (!RxQueueFits(headerSize + header.GetSize()))
+            {
+                StallRecv(socket);
+                DeliverToEndHost();
+                return;
+            }
+            Ptr<Packet> frame = rxBuffer.Remove(headerSize + header.GetSize());
+            rxPacketBuffer.push(frame);
+            m_rxQueueBytes += frame->GetSize();
         }
 
-        // push packet to rxqueue
-        rxPacketBuffer[id].push(packet);
+        uint32_t room = GetGlobalRecvRoom(rxBuffer);
+        if (room == 0)
+        {
+            StallRecv(socket);
+            break;
+        }
+        Ptr<Packet> packet = socket->RecvFrom(room, 0, from);
+        if (!packet)
+        {
+            break;
+        }
+        rxBuffer.Append(packet);
     }
+
+    DeliverToEndHost();
 }
 
 void 
@@ -273,64 +895,446 @@ void
 Cybertwin::globalErrorCloseCallback(Ptr<Socket> socket)
 {
     NS_LOG_ERROR("A socket error occurs:" << socket->GetErrno());
+    ConnSocketClosed(socket);
+}
+
+//********************************************************************************
+//*                        Define forwarding engine                              *
+//********************************************************************************
+
+void
+Cybertwin::EnqueueForPeer(CYBERTWINID_t dst, Ptr<Packet> packet)
+{
+    PeerQueue& peer = txPacketBuffer[dst];
+    peer.packets.push(packet);
+    peer.bytes += packet->GetSize();
+    m_txQueuePackets++;
+    m_txQueueBytes += packet->GetSize();
+    m_peerQueueDepthTrace(dst, peer.packets.size());
+
+    // a connection that failed is retried by its own timer
+    if (!peer.socket && !peer.multiplexed && !peer.retryEvent.IsRunning())
+    {
+        ResolvePeer(dst, peer);
+    }
+    ActivatePeer(dst, peer);
+}
+
+void
+Cybertwin::ActivatePeer(CYBERTWINID_t dst, PeerQueue& peer)
+{
+    if (peer.active || !peer.connected || peer.blocked || peer.packets.empty())
+    {
+        return;
+    }
+    peer.active = true;
+    activePeers.push_back(dst);
+    ScheduleDrain();
+}
+
+void
+Cybertwin::ScheduleDrain()
+{
+    // coalesce everything that becomes ready at the same instant into one round,
+    // a pending round waiting for tx tokens already covers it
+    if (!drainEvent.IsRunning())
+    {
+        drainEvent = Simulator::ScheduleNow(&Cybertwin::ouputPackets, this);
+    }
+}
+
+void
+Cybertwin::ResolvePeer(CYBERTWINID_t dst, PeerQueue& peer)
+{
+    CybertwinInterface dstInterface;
+
+    if (!nameResolver)
+    {
+        NS_LOG_ERROR("Cybertwin " << cybertwinID << ": no name resolver to find " << dst);
+        DropPeerPackets(dst, peer);
+        return;
+    }
+    if (nameResolver->Lookup(dst, dstInterface))
+    {
+        ConnectPeer(dst, peer, dstInterface);
+        return;
+    }
+
+    // packets stay parked in the peer queue until the answer comes back
+    if (!peer.resolving)
+    {
+        peer.resolving = true;
+        nameResolver->Resolve(dst, MakeCallback(&Cybertwin::NameResolvedCallback, this));
+    }
+}
+
+void
+Cybertwin::NameResolvedCallback(CYBERTWINID_t id, bool found, CybertwinInterface interface)
+{
+    auto it = txPacketBuffer.find(id);
+    if (it == txPacketBuffer.end())
+    {
+        return;
+    }
+    PeerQueue& peer = it->second;
+    peer.resolving = false;
+
+    if (!found)
+    {
+        NS_LOG_DEBUG("Cybertwin " << cybertwinID << ": " << id << " is unknown.");
+        DropPeerPackets(id, peer);
+        return;
+    }
+    if (!peer.socket && !peer.multiplexed)
+    {
+        ConnectPeer(id, peer, interface);
+    }
+}
+
+void
+Cybertwin::ConnectPeer(CYBERTWINID_t dst, PeerQueue& peer, CybertwinInterface dstInterface)
+{
+    // the edge keeps the connection, the peer is ready right away
+    if (edgeTransport && Ipv4Address::IsMatchingType(dstInterface.first))
+    {
+        peer.multiplexed = true;
+        peer.edge = Ipv4Address::ConvertFrom(dstInterface.first);
+        peer.connected = true;
+        peer.rateWindowStart = Simulator::Now();
+        ActivatePeer(dst, peer);
+        return;
+    }
+
+    Ptr<Socket> dstSock = Socket::CreateSocket(GetNode(), TcpSocketFactory::GetTypeId());
+    dstSock->SetConnectCallback(MakeCallback(&Cybertwin::PeerConnectSucceededCallback, this),
+                                MakeCallback(&Cybertwin::PeerConnectFailedCallback, this));
+    dstSock->SetSendCallback(MakeCallback(&Cybertwin::PeerSendCallback, this));
+    // a refused connection is reported as a close
+    dstSock->SetCloseCallbacks(MakeCallback(&Cybertwin::PeerCloseCallback, this),
+                               MakeCallback(&Cybertwin::PeerCloseCallback, this));
+
+    if (Ipv4Address::IsMatchingType(dstInterface.first))
+    {
+        Ipv4Address ipv4 = Ipv4Address::ConvertFrom(dstInterface.first);
+        InetSocketAddress inetAddress = InetSocketAddress(ipv4, dstInterface.second);
+        dstSock->Bind();
+        dstSock->Connect(inetAddress);
+    }else if (Ipv6Address::IsMatchingType(dstInterface.first))
+    {
+        Ipv6Address ipv6 = Ipv6Address::ConvertFrom(dstInterface.first);
+        Inet6SocketAddress inet6Address = Inet6SocketAddress(ipv6, dstInterface.second);
+        dstSock->Bind6();
+        dstSock->Connect(inet6Address);
+    }
+
+    peer.socket = dstSock;
+    globalTxSocket[dstSock] = dst;
+}
+
+void
+Cybertwin::PeerConnectSucceededCallback(Ptr<Socket> socket)
+{
+    auto it = globalTxSocket.find(socket);
+    if (it == globalTxSocket.end())
+    {
+        return;
+    }
+    NS_LOG_DEBUG("Cybertwin " << cybertwinID << ": connected to " << it->second);
+
+    PeerQueue& peer = txPacketBuffer[it->second];
+    peer.connected = true;
+    peer.retries = 0;
+    peer.rateWindowStart = Simulator::Now();
+    ActivatePeer(it->second, peer);
+}
+
+void
+Cybertwin::PeerConnectFailedCallback(Ptr<Socket> socket)
+{
+    NS_LOG_ERROR("Cybertwin " << cybertwinID << ": failed to connect to a peer.");
+    PeerSocketClosed(socket);
+}
+
+void
+Cybertwin::PeerCloseCallback(Ptr<Socket> socket)
+{
+    PeerSocketClosed(socket);
+}
+
+void
+Cybertwin::PeerSocketClosed(Ptr<Socket> socket)
+{
+    auto it = globalTxSocket.find(socket);
+    if (it == globalTxSocket.end())
+    {
+        return;
+    }
+    CYBERTWINID_t dst = it->second;
+    globalTxSocket.erase(it);
+
+    socket->SetConnectCallback(MakeNullCallback<void, Ptr<Socket>>(),
+                               MakeNullCallback<void, Ptr<Socket>>());
+    socket->SetSendCallback(MakeNullCallback<void, Ptr<Socket>, uint32_t>());
+    socket->SetCloseCallbacks(MakeNullCallback<void, Ptr<Socket>>(),
+                              MakeNullCallback<void, Ptr<Socket>>());
+    // not from within the socket's own callback
+    Simulator::ScheduleNow([socket]() { socket->Close(); });
+
+    PeerQueue& peer = txPacketBuffer[dst];
+    peer.socket = nullptr;
+    peer.connected = false;
+    peer.blocked = false;
+    if (peer.packets.empty())
+    {
+        // the next packet for this peer connects again
+        return;
+    }
+    if (peer.retries >= m_peerConnectRetries)
+    {
+        NS_LOG_DEBUG("Cybertwin " << cybertwinID << ": giving up on " << dst << ".");
+        peer.retries = 0;
+        DropPeerPackets(dst, peer);
+        return;
+    }
+    Time delay = m_peerRetryInterval * static_cast<int64_t>(1 << std::min(peer.retries, 16U));
+    peer.retries++;
+    peer.retryEvent = Simulator::Schedule(delay, &Cybertwin::RetryPeer, this, dst);
+}
+
+void
+Cybertwin::RetryPeer(CYBERTWINID_t dst)
+{
+    auto it = txPacketBuffer.find(dst);
+    if (it == txPacketBuffer.end())
+    {
+        return;
+    }
+    PeerQueue& peer = it->second;
+    if (!peer.socket && !peer.multiplexed && !peer.packets.empty())
+    {
+        // resolve again, the peer may have moved
+        ResolvePeer(dst, peer);
+    }
+}
+
+void
+Cybertwin::DropPeerPackets(CYBERTWINID_t dst, PeerQueue& peer)
+{
+    NS_LOG_DEBUG("Cybertwin " << cybertwinID << ": drop " << peer.packets.size()
+                              << " packets for " << dst << ".");
+    while (!peer.packets.empty())
+    {
+        m_txDrops++;
+        m_txDropTrace(peer.packets.front());
+        DequeueForPeer(peer);
+    }
+    peer.deficit = 0;
+    m_peerQueueDepthTrace(dst, 0);
+    ScheduleResumeRecv();
+}
+
+void
+Cybertwin::PeerSendCallback(Ptr<Socket> socket, uint32_t txSpace)
+{
+    auto it = globalTxSocket.find(socket);
+    if (it == globalTxSocket.end())
+    {
+        return;
+    }
+
+    PeerQueue& peer = txPacketBuffer[it->second];
+    peer.blocked = false;
+    ActivatePeer(it->second, peer);
+}
+
+void
+Cybertwin::PeerResumeCallback(CYBERTWINID_t dst)
+{
+    auto it = txPacketBuffer.find(dst);
+    if (it == txPacketBuffer.end() || !it->second.blocked)
+    {
+        return;
+    }
+    it->second.blocked = false;
+    ActivatePeer(dst, it->second);
+}
+
+void
+Cybertwin::PeerReceiveCallback(CYBERTWINID_t src, Ptr<Packet> packet)
+{
+    NS_LOG_INFO("Cybertwin " << cybertwinID << " received " << packet->GetSize()
+                             << " bytes from " << src);
+    EnqueueForEndHost(packet);
 }
 
 void
 Cybertwin::ouputPackets()
 {
-    //NS_LOG_DEBUG("Cybertwin outputPakcets proces.");
-    //naive output method
-    for (auto rxBuffer:rxPacketBuffer)
+    // one deficit round robin round over the peers that can send right now
+    m_txWaitSize = 0;
+    std::size_t rounds = activePeers.size();
+    for (std::size_t i = 0; i < rounds && !m_txWaitSize; i++)
     {
-        CYBERTWINID_t dstGuid = rxBuffer.first;
-        std::queue<Ptr<Packet>> packetQueue = rxBuffer.second;
-        uint32_t size = packetQueue.size();
-        Ptr<Socket> txSocket;
-        Ptr<Packet> packet;
+        CYBERTWINID_t dst = activePeers.front();
+        activePeers.pop_front();
 
-        // check if the connection have been established.
-        if (globalTxSocket.find(dstGuid) == globalTxSocket.end())
+        PeerQueue& peer = txPacketBuffer[dst];
+        peer.active = false;
+        if (!peer.connected)
         {
-            // establish connection
-            if (nameResolutionCache.find(dstGuid) == nameResolutionCache.end())
-            {
-                //TODO: global name resolution service.
-                //nameResolutionCache[dstGuid] = guidResolution(dstGuid);
-            }
-            CybertwinInterface dstInterface = nameResolutionCache[dstGuid];
-            
-            Ptr<Socket> dstSock = Socket::CreateSocket(GetNode(), TcpSocketFactory::GetTypeId());
-            
-            if (Ipv4Address::IsMatchingType(dstInterface.first))
-            {
-                Ipv4Address ipv4 = Ipv4Address::ConvertFrom(dstInterface.first);
-                InetSocketAddress inetAddress = InetSocketAddress(ipv4, dstInterface.second);
-                dstSock->Bind();
-                dstSock->Connect(inetAddress);
-            }else if (Ipv6Address::IsMatchingType(dstInterface.first))
-            {
-                Ipv6Address ipv6 = Ipv6Address::ConvertFrom(dstInterface.first);
-                Inet6SocketAddress inet6Address = Inet6SocketAddress(ipv6, dstInterface.second);
-                dstSock->Bind();
-                dstSock->Connect(inet6Address);
-            }
+            // lost its connection since it was activated
+            continue;
+        }
+        // a peer cut short by the socket or the token bucket still holds the
+        // credit of its last turn, another quantum would let it hoard them
+        if (peer.deficit < peer.packets.front()->GetSize())
+        {
+            peer.deficit += m_peerQuantum;
+        }
+        DrainPeer(dst, peer);
 
-            globalTxSocket[dstGuid] = dstSock;
+        if (m_txWaitSize)
+        {
+            // out of tokens in the middle of its turn, it resumes the next round
+            peer.active = true;
+            activePeers.push_front(dst);
+            break;
         }
+        // peers that ran out of credit take another turn in the next round
+        ActivatePeer(dst, peer);
+    }
+
+    // out of tokens, the next round starts once the waiting packet conforms
+    if (m_txWaitSize)
+    {
+        Simulator::Cancel(drainEvent);
+        drainEvent = Simulator::Schedule(m_txBucket.GetDelay(m_txWaitSize),
+                                         &Cybertwin::ouputPackets,
+                                         this);
+    }
+}
+
+void
+Cybertwin::DrainPeer(CYBERTWINID_t dst, PeerQueue& peer)
+{
+    uint32_t sent = 0;
 
-        txSocket = globalTxSocket[dstGuid];
+    while (!peer.packets.empty())
+    {
+        Ptr<Packet> packet = peer.packets.front();
+        uint32_t size = packet->GetSize();
 
-        for (uint32_t i=0; i<size && i<TX_MAX_NUM; i++)
+        if (size > peer.deficit)
+        {
+            break;
+        }
+        if (!m_txBucket.Conform(size))
+        {
+            m_txWaitSize = size;
+            break;
+        }
+        bool accepted;
+        if (peer.multiplexed)
         {
-            packet = packetQueue.front();
-            //TODO : add header
-            //CybertwinGlobalHeader header();
-            //packet->AddHeader(header);
-            txSocket->Send(packet);
+            accepted = edgeTransport->Send(cybertwinID, dst, peer.edge, packet);
         }
+        else
+        {
+            accepted = peer.socket->GetTxAvailable() >= size && peer.socket->Send(packet) >= 0;
+        }
+        if (!accepted)
+        {
+            peer.blocked = true;
+            break;
+        }
+
+        DequeueForPeer(peer);
+        peer.deficit -= size;
+        sent += size;
+        m_txBucket.Consume(size);
+        m_txPackets++;
+        m_txBytes += size;
+        m_txTrace(packet);
+    }
+
+    if (peer.packets.empty())
+    {
+        peer.deficit = 0;
+    }
+    if (sent)
+    {
+        m_peerQueueDepthTrace(dst, peer.packets.size());
+        UpdateDrainRate(dst, peer, sent);
+        ScheduleResumeRecv();
     }
+}
+
+void
+Cybertwin::DequeueForPeer(PeerQueue& peer)
+{
+    uint32_t size = peer.packets.front()->GetSize();
+    peer.packets.pop();
+    peer.bytes -= size;
+    m_txQueuePackets--;
+    m_txQueueBytes -= size;
+}
+
+void
+Cybertwin::UpdateDrainRate(CYBERTWINID_t dst, PeerQueue& peer, uint32_t bytes)
+{
+    peer.drainedBytes += bytes;
 
-    Simulator::Schedule(Seconds(2.), &Cybertwin::ouputPackets, this);
+    Time elapsed = Simulator::Now() - peer.rateWindowStart;
+    if (elapsed >= m_drainRateInterval)
+    {
+        m_peerDrainRateTrace(dst, DataRate(static_cast<uint64_t>(peer.drainedBytes * 8 / elapsed.GetSeconds())));
+        peer.drainedBytes = 0;
+        peer.rateWindowStart = Simulator::Now();
+    }
+}
+
+void
+Cybertwin::TokenBucket::Reset(DataRate rate, uint32_t burst)
+{
+    this->rate = rate;
+    this->burst = burst;
+    tokens = burst;
+    lastUpdate = Simulator::Now();
+}
+
+bool
+Cybertwin::TokenBucket::Conform(uint32_t size)
+{
+    if (rate.GetBitRate() == 0)
+    {
+        return true;
+    }
+    Time now = Simulator::Now();
+    tokens = std::min<double>(burst,
+                              tokens + rate.GetBitRate() / 8.0 * (now - lastUpdate).GetSeconds());
+    lastUpdate = now;
+    return tokens >= std::min(size, burst);
+}
+
+void
+Cybertwin::TokenBucket::Consume(uint32_t size)
+{
+    // may go negative for packets larger than the burst, the debt is paid off first
+    if (rate.GetBitRate() != 0)
+    {
+        tokens -= size;
+    }
+}
+
+Time
+Cybertwin::TokenBucket::GetDelay(uint32_t size) const
+{
+    double missing = std::min(size, burst) - tokens;
+    if (rate.GetBitRate() == 0 || missing <= 0)
+    {
+        return Time(0);
+    }
+    return rate.CalculateBytesTxTime(static_cast<uint32_t>(std::ceil(missing)));
 }
 
 void
@@ -7,10 +7,20 @@
 #include "ns3/ipv4-address.h"
 #include "ns3/internet-module.h"
 #include "ns3/network-module.h"
+#include "ns3/data-rate.h"
+#include "ns3/event-id.h"
+#include "ns3/queue-size.h"
+#include "ns3/traced-callback.h"
 #include "cybertwin-common.h"
+#include "cybertwin-edge-transport.h"
+#include "cybertwin-frame-buffer.h"
+#include "cybertwin-name-resolution-service.h"
 #include <string>
 #include <unordered_map>
+#include <deque>
 #include <queue>
+#include <set>
+#include <vector>
 
 namespace ns3
 {
@@ -42,16 +52,123 @@ public:
 
     void ouputPackets();
 
+    // forwarding engine
+    void PeerConnectSucceededCallback(Ptr<Socket> socket);
+    void PeerConnectFailedCallback(Ptr<Socket> socket);
+    void PeerCloseCallback(Ptr<Socket> socket);
+    void PeerSendCallback(Ptr<Socket> socket, uint32_t txSpace);
+    void localSendCallback(Ptr<Socket> socket, uint32_t txSpace);
+
+    /**
+     * TracedCallback signature for per-peer queue depth changes.
+     *
+     * \param [in] peer The destination Cybertwin ID.
+     * \param [in] packets The number of packets queued for the peer.
+     */
+    typedef void (*PeerQueueDepthCallback)(CYBERTWINID_t peer, uint32_t packets);
+
+    /**
+     * TracedCallback signature for per-peer drain rate samples.
+     *
+     * \param [in] peer The destination Cybertwin ID.
+     * \param [in] rate The rate at which the peer queue was drained.
+     */
+    typedef void (*PeerDrainRateCallback)(CYBERTWINID_t peer, DataRate rate);
+
     CYBERTWINID_t GetCybertwinID() const;
     void SetCybertwinID(CYBERTWINID_t cybertwinID);
 
     void SetLocalInterface(Address address, uint16_t port);
     void SetGlobalInterface(Address address, uint16_t port);
+    CybertwinInterface GetLocalInterface() const;
+    CybertwinInterface GetGlobalInterface() const;
+
+    void SetNameResolver(Ptr<NameResolutionClient> resolver);
+    void SetEdgeTransport(Ptr<CybertwinEdgeTransport> transport);
+    void NameResolvedCallback(CYBERTWINID_t id, bool found, CybertwinInterface interface);
 
     void start();
+
+    // Stops the twin now. Its connections keep its local and global ports
+    // bound until TCP released them (TIME_WAIT), closed is called then.
+    void Stop(Callback<void> closed);
+    // Starts a twin again once Stop reported it closed, with the identity and
+    // interfaces set since. Its counters start over.
+    void Restart();
+
+protected:
+    void DoDispose() override;
+
 private:
     void StartApplication() override;
     void StopApplication() override;
+    void InitGlobalSocket();
+    void TrackConnSocket(Ptr<Socket> socket);
+    void ConnStateChanged(Socket* socket, TcpSocket::TcpStates_t oldState, TcpSocket::TcpStates_t newState);
+    void ConnSocketClosed(Ptr<Socket> socket);
+    void CheckClosed();
+    void NotifyClosed();
+
+    // Token bucket shaping one direction of the twin's traffic. A packet
+    // passes once the bucket holds its size in bytes, or the whole burst for
+    // packets larger than that. A zero rate disables shaping.
+    struct TokenBucket
+    {
+        DataRate rate;
+        uint32_t burst{0};
+        double tokens{0};
+        Time lastUpdate{0};
+
+        void Reset(DataRate rate, uint32_t burst);
+        bool Conform(uint32_t size);
+        void Consume(uint32_t size);
+        Time GetDelay(uint32_t size) const; // until Conform(size) holds
+    };
+
+    // Per-destination forwarding state. Packets wait here until the
+    // connection to the peer can take them and the peer has enough credit
+    // left in the current round (deficit round robin).
+    struct PeerQueue
+    {
+        std::queue<Ptr<Packet>> packets;
+        uint32_t bytes{0};
+        uint32_t deficit{0};
+        Ptr<Socket> socket{nullptr};
+        bool multiplexed{false}; // sent through the edge transport instead of socket
+        Ipv4Address edge;
+        bool resolving{false};
+        bool connected{false};
+        bool blocked{false};
+        bool active{false};
+        uint32_t retries{0}; // failed connection attempts in a row
+        EventId retryEvent;
+        uint64_t drainedBytes{0};
+        Time rateWindowStart{0};
+    };
+
+    void EnqueueForPeer(CYBERTWINID_t dst, Ptr<Packet> packet);
+    void ScheduleDrain();
+    void ActivatePeer(CYBERTWINID_t dst, PeerQueue& peer);
+    void ResolvePeer(CYBERTWINID_t dst, PeerQueue& peer);
+    void ConnectPeer(CYBERTWINID_t dst, PeerQueue& peer, CybertwinInterface dstInterface);
+    void DrainPeer(CYBERTWINID_t dst, PeerQueue& peer);
+    void PeerSocketClosed(Ptr<Socket> socket);
+    void RetryPeer(CYBERTWINID_t dst);
+    void DropPeerPackets(CYBERTWINID_t dst, PeerQueue& peer);
+    void UpdateDrainRate(CYBERTWINID_t dst, PeerQueue& peer, uint32_t bytes);
+    void DeliverToEndHost();
+    bool TxQueueFits(uint32_t size) const;
+    uint32_t GetLocalRecvRoom() const;
+    bool RxQueueFits(uint32_t size) const;
+    uint32_t GetGlobalRecvRoom(const CybertwinFrameBuffer& rxBuffer) const;
+    uint32_t GetRxQueueRoom() const;
+    void EnqueueForEndHost(Ptr<Packet> packet);
+    void DequeueForPeer(PeerQueue& peer);
+    void StallRecv(Ptr<Socket> socket);
+    void ScheduleResumeRecv();
+    void ResumeRecv();
+    void PeerReceiveCallback(CYBERTWINID_t src, Ptr<Packet> packet);
+    void PeerResumeCallback(CYBERTWINID_t dst);
 
     CYBERTWINID_t cybertwinID;
 
@@ -61,13 +178,67 @@ private:
     Ptr<Socket> globalSocket; // network socket
     CybertwinInterface globalInterface;
 
-    std::unordered_map<CYBERTWINID_t, std::queue<Ptr<Packet>>> txPacketBuffer;
-    std::unordered_map<CYBERTWINID_t, std::queue<Ptr<Packet>>> rxPacketBuffer;
+    Ptr<Socket> localConnSocket; // connection accepted from the end host
+    std::set<Ptr<Socket>> m_connSockets; // accepted connections still holding our ports
+    bool m_stopped;
+    EventId m_restartEvent;
+    Callback<void> m_closedCallback;
+    CybertwinFrameBuffer localRxBuffer; // partial frames from the end host
+
+    // outbound: packets from the end host, keyed by destination
+    std::unordered_map<CYBERTWINID_t, PeerQueue> txPacketBuffer;
+    std::deque<CYBERTWINID_t> activePeers;
+    std::unordered_map<Ptr<Socket>, CYBERTWINID_t> globalTxSocket;
+    EventId drainEvent;
+
+    // inbound: frames from other cybertwins, waiting for the end host
+    std::queue<Ptr<Packet>> rxPacketBuffer;
+    std::unordered_map<Ptr<Socket>, CybertwinFrameBuffer> globalRxBuffers; // partial frames from peers
+    EventId deliverEvent;
+
+    // queue limits: sockets are not read while full, frames from the edge
+    // transport are dropped. The frames being reassembled from the end host
+    // count against the tx limit.
+    QueueSize m_txQueueLimit;
+    QueueSize m_rxQueueLimit;
+    uint32_t m_txQueuePackets;
+    uint64_t m_txQueueBytes;
+    uint64_t m_rxQueueBytes;
+    std::vector<Ptr<Socket>> m_stalledSockets;
+    EventId m_resumeRecvEvent;
+
+    DataRate m_txRate;
+    uint32_t m_txBurst;
+    DataRate m_rxRate;
+    uint32_t m_rxBurst;
+    TokenBucket m_txBucket;
+    TokenBucket m_rxBucket;
+    uint32_t m_txWaitSize; // size of the packet waiting for tx tokens
+
+    // traffic counters, forwarded to peers (tx) and delivered to the end host (rx)
+    uint64_t m_txPackets;
+    uint64_t m_txBytes;
+    uint64_t m_txDrops;
+    uint64_t m_rxPackets;
+    uint64_t m_rxBytes;
+    uint64_t m_rxDrops;
+    TracedCallback<Ptr<const Packet>> m_txTrace;
+    TracedCallback<Ptr<const Packet>> m_txDropTrace;
+    TracedCallback<Ptr<const Packet>> m_rxTrace;
+    TracedCallback<Ptr<const Packet>> m_rxDropTrace;
+
+    uint32_t m_peerQuantum;
+    Time m_drainRateInterval;
+    uint32_t m_peerConnectRetries;
+    Time m_peerRetryInterval;
+    bool m_lazyGlobalSocket;
+    TracedCallback<CYBERTWINID_t, uint32_t> m_peerQueueDepthTrace;
+    TracedCallback<CYBERTWINID_t, DataRate> m_peerDrainRateTrace;
 
-    std::unordered_map<CYBERTWINID_t, Ptr<Socket> > globalTxSocket;
-    // TODO: Add traffic logger
     // TODO: Add other functionality
-    std::unordered_map<CYBERTWINID_t, CybertwinInterface> nameResolutionCache;
+    Ptr<NameResolutionClient> nameResolver;
+    Address m_cnrsAddr;
+    Ptr<CybertwinEdgeTransport> edgeTransport; // shared by all cybertwins on this edge
 };
 }
 
@@ -1,10 +1,28 @@
 
 // Include a header file from your module to test.
 #include "ns3/cybertwin.h"
+#include "ns3/cybertwin-cnrs-database.h"
+#include "ns3/cybertwin-edge-server.h"
+#include "ns3/cybertwin-edge-transport.h"
+#include "ns3/cybertwin-frame-buffer.h"
+#include "ns3/cybertwin-name-resolution-service.h"
+#include "ns3/cybertwin-packet-header.h"
+#include "ns3/cybertwin-port-allocator.h"
+#include "ns3/internet-stack-helper.h"
+#include "ns3/ipv4-address-helper.h"
+#include "ns3/simple-net-device-helper.h"
+#include "ns3/simulator.h"
 
 // An essential include is test.h
 #include "ns3/test.h"
 
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <set>
+#include <vector>
+
 // Do not put your test classes in namespace ns3.  You may find it useful
 // to use the using directive to access the ns3 namespace directly
 using namespace ns3;
@@ -45,6 +63,1691 @@ CybertwinTestCase1::DoRun()
     NS_TEST_ASSERT_MSG_EQ_TOL(0.01, 0.01, 0.001, "Numbers are not equal within tolerance");
 }
 
+// Resolve names against a CNRS running on the same node over the loopback.
+class CybertwinNameResolutionTestCase : public TestCase
+{
+  public:
+    CybertwinNameResolutionTestCase();
+
+  private:
+    void DoRun() override;
+    void Resolved(CYBERTWINID_t id, bool found, CybertwinInterface interface);
+
+    uint32_t m_found;
+    uint32_t m_notFound;
+};
+
+CybertwinNameResolutionTestCase::CybertwinNameResolutionTestCase()
+    : TestCase("Cybertwin name resolution client caches and coalesces lookups"),
+      m_found(0),
+      m_notFound(0)
+{
+}
+
+void
+CybertwinNameResolutionTestCase::Resolved(CYBERTWINID_t id, bool found, CybertwinInterface interface)
+{
+    if (!found)
+    {
+        m_notFound++;
+        return;
+    }
+    m_found++;
+    NS_TEST_EXPECT_MSG_EQ(id, 42, "Answer for the wrong Cybertwin");
+    NS_TEST_EXPECT_MSG_EQ(Ipv4Address::ConvertFrom(interface.first),
+                          Ipv4Address("10.0.0.1"),
+                          "Wrong address resolved");
+    NS_TEST_EXPECT_MSG_EQ(interface.second, 50001, "Wrong port resolved");
+}
+
+void
+CybertwinNameResolutionTestCase::DoRun()
+{
+    Ptr<Node> node = CreateObject<Node>();
+    InternetStackHelper stack;
+    stack.Install(node);
+
+    Ptr<NameResolutionService> cnrs = CreateObject<NameResolutionService>();
+    node->AddApplication(cnrs);
+
+    Ptr<NameResolutionClient> writer = CreateObject<NameResolutionClient>();
+    writer->SetAttribute("ServerAddress", AddressValue(Ipv4Address::GetLoopback()));
+    writer->SetNode(node);
+
+    Ptr<NameResolutionClient> reader = CreateObject<NameResolutionClient>();
+    reader->SetAttribute("ServerAddress", AddressValue(Ipv4Address::GetLoopback()));
+    reader->SetNode(node);
+
+    NameResolutionClient::ResolvedCallback cb =
+        MakeCallback(&CybertwinNameResolutionTestCase::Resolved, this);
+    Simulator::Schedule(Seconds(1),
+                        &NameResolutionClient::Insert,
+                        writer,
+                        42,
+                        Ipv4Address("10.0.0.1"),
+                        50001);
+    // both lookups ride on the same query
+    Simulator::Schedule(Seconds(2), &NameResolutionClient::Resolve, reader, 42, cb);
+    Simulator::Schedule(Seconds(2), &NameResolutionClient::Resolve, reader, 42, cb);
+    Simulator::Schedule(Seconds(2), &NameResolutionClient::Resolve, reader, 7, cb);
+    // answered from the negative cache without waiting
+    Simulator::Schedule(Seconds(3), &NameResolutionClient::Resolve, reader, 7, cb);
+
+    Simulator::Stop(Seconds(4));
+    Simulator::Run();
+
+    NS_TEST_EXPECT_MSG_EQ(m_found, 2, "Positive answers were not delivered to every waiter");
+    NS_TEST_EXPECT_MSG_EQ(m_notFound, 2, "Negative answer was not delivered or cached");
+
+    CybertwinInterface interface;
+    NS_TEST_EXPECT_MSG_EQ(reader->Lookup(42, interface), true, "Answer was not cached");
+
+    Simulator::Destroy();
+}
+
+// Three services on a line, leaf -> middle -> root: a name known only to the
+// root is resolved through the leaf, and the answer is cached on the way down.
+class CybertwinCnrsHierarchyTestCase : public TestCase
+{
+  public:
+    CybertwinCnrsHierarchyTestCase();
+
+  private:
+    void DoRun() override;
+    void Resolved(CYBERTWINID_t id, bool found, CybertwinInterface interface);
+    void UpstreamTx(std::string level, Ptr<const Packet> packet);
+
+    std::map<CYBERTWINID_t, uint32_t> m_found;
+    std::map<CYBERTWINID_t, uint32_t> m_notFound;
+    std::map<std::string, uint32_t> m_upstreamQueries;
+};
+
+CybertwinCnrsHierarchyTestCase::CybertwinCnrsHierarchyTestCase()
+    : TestCase("Cybertwin CNRS forwards misses up the hierarchy and caches answers")
+{
+}
+
+void
+CybertwinCnrsHierarchyTestCase::Resolved(CYBERTWINID_t id, bool found, CybertwinInterface interface)
+{
+    if (!found)
+    {
+        m_notFound[id]++;
+        return;
+    }
+    m_found[id]++;
+    NS_TEST_EXPECT_MSG_EQ(Ipv4Address::ConvertFrom(interface.first),
+                          Ipv4Address("10.0.0.1"),
+                          "Wrong address resolved");
+    NS_TEST_EXPECT_MSG_EQ(interface.second, 50001, "Wrong port resolved");
+}
+
+void
+CybertwinCnrsHierarchyTestCase::UpstreamTx(std::string level, Ptr<const Packet> packet)
+{
+    CybertwinCNRSHeader header;
+    packet->PeekHeader(header);
+    if (header.GetMethod() == CNRS_QUERY)
+    {
+        m_upstreamQueries[level]++;
+    }
+}
+
+void
+CybertwinCnrsHierarchyTestCase::DoRun()
+{
+    NodeContainer nodes;
+    nodes.Create(3);
+    InternetStackHelper stack;
+    stack.Install(nodes);
+    SimpleNetDeviceHelper link;
+    link.SetChannelAttribute("Delay", TimeValue(MilliSeconds(1)));
+    Ipv4AddressHelper address("10.1.1.0", "255.255.255.0");
+    Ipv4InterfaceContainer interfaces = address.Assign(link.Install(nodes));
+
+    // node 0 is the root, node 1 the middle and node 2 the leaf
+    std::vector<Ptr<NameResolutionService>> services;
+    for (uint32_t i = 0; i < nodes.GetN(); i++)
+    {
+        Ptr<NameResolutionService> cnrs = CreateObject<NameResolutionService>();
+        if (i > 0)
+        {
+            cnrs->SetAttribute("SuperiorAddress", AddressValue(interfaces.GetAddress(i - 1)));
+        }
+        nodes.Get(i)->AddApplication(cnrs);
+        services.push_back(cnrs);
+    }
+    services[1]->TraceConnect("UpstreamTx",
+                              "middle",
+                              MakeCallback(&CybertwinCnrsHierarchyTestCase::UpstreamTx, this));
+    services[2]->TraceConnect("UpstreamTx",
+                              "leaf",
+                              MakeCallback(&CybertwinCnrsHierarchyTestCase::UpstreamTx, this));
+
+    Ptr<NameResolutionClient> writer = CreateObject<NameResolutionClient>();
+    writer->SetAttribute("ServerAddress", AddressValue(Ipv4Address::GetLoopback()));
+    writer->SetNode(nodes.Get(0));
+
+    std::vector<Ptr<NameResolutionClient>> readers;
+    for (uint32_t i = 0; i < 3; i++)
+    {
+        Ptr<NameResolutionClient> reader = CreateObject<NameResolutionClient>();
+        reader->SetAttribute("ServerAddress", AddressValue(Ipv4Address::GetLoopback()));
+        reader->SetNode(nodes.Get(2));
+        readers.push_back(reader);
+    }
+
+    NameResolutionClient::ResolvedCallback cb =
+        MakeCallback(&CybertwinCnrsHierarchyTestCase::Resolved, this);
+    Simulator::Schedule(Seconds(1),
+                        &NameResolutionClient::Insert,
+                        writer,
+                        42,
+                        Ipv4Address("10.0.0.1"),
+                        50001);
+    // two readers miss at once, the leaf asks the middle only once
+    Simulator::Schedule(Seconds(2), &NameResolutionClient::Resolve, readers[0], 42, cb);
+    Simulator::Schedule(Seconds(2), &NameResolutionClient::Resolve, readers[1], 42, cb);
+    Simulator::Schedule(Seconds(2), &NameResolutionClient::Resolve, readers[0], 7, cb);
+    // a fresh reader is answered from the leaf's cache
+    Simulator::Schedule(Seconds(3), &NameResolutionClient::Resolve, readers[2], 42, cb);
+
+    Simulator::Stop(Seconds(4));
+    Simulator::Run();
+
+    NS_TEST_EXPECT_MSG_EQ(m_found[42], 3, "Name known to the root not resolved at the leaf");
+    NS_TEST_EXPECT_MSG_EQ(m_notFound[7], 1, "Unknown name not failed through the hierarchy");
+    NS_TEST_EXPECT_MSG_EQ(m_found.count(7), 0, "Unknown name resolved");
+    // one query for 42 and one for 7 at each level
+    NS_TEST_EXPECT_MSG_EQ(m_upstreamQueries["leaf"], 2, "Leaf did not coalesce or cache queries");
+    NS_TEST_EXPECT_MSG_EQ(m_upstreamQueries["middle"], 2, "Middle did not forward to the root");
+    // cached answers are not registered names
+    NS_TEST_EXPECT_MSG_EQ(services[2]->GetNItems(), 0, "Cached answer counted as registered");
+    NS_TEST_EXPECT_MSG_EQ(services[0]->GetNItems(), 1, "Root lost the registered name");
+
+    Simulator::Destroy();
+}
+
+// Names registered with a leaf are reported to its superior in batches of
+// ReportBatchSize, the remainder after ReportInterval.
+class CybertwinCnrsReportTestCase : public TestCase
+{
+  public:
+    CybertwinCnrsReportTestCase();
+
+  private:
+    void DoRun() override;
+    void UpstreamTx(Ptr<const Packet> packet);
+    void Resolved(CYBERTWINID_t id, bool found, CybertwinInterface interface);
+
+    std::vector<std::pair<Time, std::vector<CYBERTWINID_t>>> m_reports;
+    std::set<CYBERTWINID_t> m_resolved;
+};
+
+CybertwinCnrsReportTestCase::CybertwinCnrsReportTestCase()
+    : TestCase("Cybertwin CNRS reports names to its superior in timed batches")
+{
+}
+
+void
+CybertwinCnrsReportTestCase::UpstreamTx(Ptr<const Packet> packet)
+{
+    CybertwinCNRSBatchHeader batch;
+    packet->PeekHeader(batch);
+    NS_TEST_EXPECT_MSG_EQ(batch.GetMethod(), CNRS_INSERT_BATCH, "Report is not a batch");
+
+    std::vector<CYBERTWINID_t> ids;
+    for (uint32_t i = 0; i < batch.GetNRecords(); i++)
+    {
+        ids.push_back(batch.GetCybertwinID(i));
+        NS_TEST_EXPECT_MSG_EQ(Ipv4Address(batch.GetCybertwinAddr(i)),
+                              Ipv4Address("10.0.0.1"),
+                              "Wrong address reported");
+        NS_TEST_EXPECT_MSG_EQ(batch.GetCybertwinPort(i),
+                              50000 + batch.GetCybertwinID(i),
+                              "Wrong port reported");
+    }
+    m_reports.emplace_back(Simulator::Now(), ids);
+}
+
+void
+CybertwinCnrsReportTestCase::Resolved(CYBERTWINID_t id, bool found, CybertwinInterface interface)
+{
+    if (found)
+    {
+        m_resolved.insert(id);
+    }
+}
+
+void
+CybertwinCnrsReportTestCase::DoRun()
+{
+    NodeContainer nodes;
+    nodes.Create(2);
+    InternetStackHelper stack;
+    stack.Install(nodes);
+    SimpleNetDeviceHelper link;
+    Ipv4AddressHelper address("10.1.1.0", "255.255.255.0");
+    Ipv4InterfaceContainer interfaces = address.Assign(link.Install(nodes));
+
+    Ptr<NameResolutionService> root = CreateObject<NameResolutionService>();
+    nodes.Get(0)->AddApplication(root);
+    Ptr<NameResolutionService> leaf = CreateObject<NameResolutionService>();
+    leaf->SetAttribute("SuperiorAddress", AddressValue(interfaces.GetAddress(0)));
+    leaf->SetAttribute("ReportBatchSize", UintegerValue(3));
+    leaf->SetAttribute("ReportInterval", TimeValue(MilliSeconds(100)));
+    leaf->TraceConnectWithoutContext("UpstreamTx",
+                                     MakeCallback(&CybertwinCnrsReportTestCase::UpstreamTx, this));
+    nodes.Get(1)->AddApplication(leaf);
+
+    Ptr<NameResolutionClient> writer = CreateObject<NameResolutionClient>();
+    writer->SetAttribute("ServerAddress", AddressValue(Ipv4Address::GetLoopback()));
+    writer->SetNode(nodes.Get(1));
+    Ptr<NameResolutionClient> reader = CreateObject<NameResolutionClient>();
+    reader->SetAttribute("ServerAddress", AddressValue(Ipv4Address::GetLoopback()));
+    reader->SetNode(nodes.Get(0));
+
+    // five names at once fill one batch and leave two waiting for the timer
+    for (CYBERTWINID_t id = 1; id <= 5; id++)
+    {
+        Simulator::Schedule(Seconds(1),
+                            &NameResolutionClient::Insert,
+                            writer,
+                            id,
+                            Ipv4Address("10.0.0.1"),
+                            50000 + id);
+    }
+    // a lone name waits for the timer too
+    Simulator::Schedule(Seconds(2),
+                        &NameResolutionClient::Insert,
+                        writer,
+                        6,
+                        Ipv4Address("10.0.0.1"),
+                        50006);
+
+    NameResolutionClient::ResolvedCallback cb =
+        MakeCallback(&CybertwinCnrsReportTestCase::Resolved, this);
+    for (CYBERTWINID_t id = 1; id <= 6; id++)
+    {
+        Simulator::Schedule(Seconds(3), &NameResolutionClient::Resolve, reader, id, cb);
+    }
+
+    Simulator::Stop(Seconds(4));
+    Simulator::Run();
+
+    NS_TEST_ASSERT_MSG_EQ(m_reports.size(), 3, "Wrong number of reports");
+    NS_TEST_EXPECT_MSG_EQ(m_reports[0].second.size(), 3, "Full batch not sent at once");
+    NS_TEST_EXPECT_MSG_EQ(m_reports[1].second.size(), 2, "Remainder not reported");
+    NS_TEST_EXPECT_MSG_EQ(m_reports[2].second.size(), 1, "Lone name not reported");
+    NS_TEST_EXPECT_MSG_EQ((m_reports[0].second == std::vector<CYBERTWINID_t>{1, 2, 3}),
+                          true,
+                          "Full batch holds the wrong names");
+    NS_TEST_EXPECT_MSG_EQ((m_reports[1].second == std::vector<CYBERTWINID_t>{4, 5}),
+                          true,
+                          "Remainder holds the wrong names");
+    NS_TEST_EXPECT_MSG_EQ(m_reports[2].second.front(), 6, "Lone report holds the wrong name");
+
+    // the full batch leaves with the third insert, the others after the interval
+    NS_TEST_EXPECT_MSG_LT(m_reports[0].first, Seconds(1) + MilliSeconds(1), "Full batch delayed");
+    NS_TEST_EXPECT_MSG_GT_OR_EQ(m_reports[1].first,
+                                Seconds(1) + MilliSeconds(100),
+                                "Remainder reported before the interval");
+    NS_TEST_EXPECT_MSG_LT(m_reports[1].first,
+                          Seconds(1) + MilliSeconds(101),
+                          "Remainder held past the interval");
+    NS_TEST_EXPECT_MSG_GT_OR_EQ(m_reports[2].first,
+                                Seconds(2) + MilliSeconds(100),
+                                "Lone name reported before the interval");
+    NS_TEST_EXPECT_MSG_LT(m_reports[2].first,
+                          Seconds(2) + MilliSeconds(101),
+                          "Lone name held past the interval");
+
+    NS_TEST_EXPECT_MSG_EQ(root->GetNItems(), 6, "Superior did not register the reports");
+    NS_TEST_EXPECT_MSG_EQ(m_resolved.size(), 6, "Reported names not resolvable at the superior");
+
+    Simulator::Destroy();
+}
+
+// Write a CNRS database file and look the names up through the mapping.
+class CybertwinCnrsDatabaseTestCase : public TestCase
+{
+  public:
+    CybertwinCnrsDatabaseTestCase();
+
+  private:
+    void DoRun() override;
+};
+
+CybertwinCnrsDatabaseTestCase::CybertwinCnrsDatabaseTestCase()
+    : TestCase("Cybertwin CNRS database survives a save and reload")
+{
+}
+
+void
+CybertwinCnrsDatabaseTestCase::DoRun()
+{
+    std::string path = CreateTempDirFilename("cnrs.db");
+    const uint32_t nRecords = 1000;
+
+    CnrsDatabaseWriter writer(nRecords);
+    for (uint32_t i = 0; i < nRecords; i++)
+    {
+        writer.Insert(i, 0x0a000000 + i, 40000 + i);
+    }
+    // replacing a record must not add a new one
+    writer.Insert(7, 0x0b000007, 7);
+    NS_TEST_ASSERT_MSG_EQ(writer.GetNRecords(), nRecords, "Replaced record counted twice");
+    NS_TEST_ASSERT_MSG_EQ(writer.Commit(path), true, "Failed to write the database");
+
+    CnrsDatabase database;
+    NS_TEST_ASSERT_MSG_EQ(database.Open(path), true, "Failed to map the database");
+    NS_TEST_EXPECT_MSG_EQ(database.GetNRecords(), nRecords, "Wrong number of records loaded");
+
+    uint32_t ip = 0;
+    uint16_t port = 0;
+    NS_TEST_EXPECT_MSG_EQ(database.Find(999, ip, port), true, "Stored name not found");
+    NS_TEST_EXPECT_MSG_EQ(ip, 0x0a000000 + 999, "Wrong address loaded");
+    NS_TEST_EXPECT_MSG_EQ(port, 40999, "Wrong port loaded");
+    NS_TEST_EXPECT_MSG_EQ(database.Find(7, ip, port), true, "Replaced name not found");
+    NS_TEST_EXPECT_MSG_EQ(port, 7, "Replaced record not updated");
+    NS_TEST_EXPECT_MSG_EQ(database.Find(nRecords, ip, port), false, "Unknown name found");
+
+    database.Close();
+    std::remove(path.c_str());
+
+    // a header claiming more records than the file holds must not be mapped
+    const uint64_t nSlots = 16;
+    uint8_t header[64] = {'C', 'N', 'R', 'S', 'D', 'B', '0', '1'};
+    uint32_t recordSize = sizeof(CnrsDatabase::Record);
+    uint64_t capacity = uint64_t(1) << 60;
+    uint64_t count = 0;
+    std::memcpy(header + 8, &recordSize, sizeof(recordSize));
+    std::memcpy(header + 16, &capacity, sizeof(capacity));
+    std::memcpy(header + 24, &count, sizeof(count));
+    std::vector<CnrsDatabase::Record> records(nSlots);
+    for (uint64_t i = 0; i < nSlots; i++)
+    {
+        records[i] = CnrsDatabase::Record{nRecords + 1 + i, 0, 0, 1};
+    }
+    std::ofstream forged(path, std::ios::binary);
+    forged.write(reinterpret_cast<const char*>(header), sizeof(header));
+    forged.write(reinterpret_cast<const char*>(records.data()),
+                 nSlots * sizeof(CnrsDatabase::Record));
+    forged.close();
+    NS_TEST_EXPECT_MSG_EQ(database.Open(path), false, "Mapped a forged capacity");
+
+    // a table without a free slot must still end the probe sequence
+    capacity = nSlots;
+    std::memcpy(header + 16, &capacity, sizeof(capacity));
+    forged.open(path, std::ios::binary);
+    forged.write(reinterpret_cast<const char*>(header), sizeof(header));
+    forged.write(reinterpret_cast<const char*>(records.data()),
+                 nSlots * sizeof(CnrsDatabase::Record));
+    forged.close();
+    NS_TEST_ASSERT_MSG_EQ(database.Open(path), true, "Failed to map a full table");
+    NS_TEST_EXPECT_MSG_EQ(database.Find(0, ip, port), false, "Unknown name found in a full table");
+    NS_TEST_EXPECT_MSG_EQ(database.Find(nRecords + 1, ip, port), true, "Stored name not found");
+
+    database.Close();
+    std::remove(path.c_str());
+}
+
+// Allocate, exhaust and recycle a small port range.
+class CybertwinPortAllocatorTestCase : public TestCase
+{
+  public:
+    CybertwinPortAllocatorTestCase();
+
+  private:
+    void DoRun() override;
+};
+
+CybertwinPortAllocatorTestCase::CybertwinPortAllocatorTestCase()
+    : TestCase("Cybertwin port allocator reuses released ports without conflicts")
+{
+}
+
+void
+CybertwinPortAllocatorTestCase::DoRun()
+{
+    CybertwinPortAllocator ports(100, 199);
+    NS_TEST_ASSERT_MSG_EQ(ports.Reserve(150), true, "Failed to reserve a free port");
+    NS_TEST_ASSERT_MSG_EQ(ports.Reserve(150), false, "Reserved a port twice");
+    NS_TEST_ASSERT_MSG_EQ(ports.Reserve(200), false, "Reserved a port out of range");
+
+    std::set<uint16_t> seen;
+    for (uint32_t i = 0; i < 99; i++)
+    {
+        uint16_t port = ports.Allocate();
+        NS_TEST_ASSERT_MSG_EQ(ports.IsInRange(port), true, "Port out of range");
+        NS_TEST_ASSERT_MSG_NE(port, 150, "Reserved port handed out");
+        NS_TEST_ASSERT_MSG_EQ(seen.insert(port).second, true, "Port handed out twice");
+    }
+    NS_TEST_ASSERT_MSG_EQ(ports.GetNAvailable(), 0, "Range should be exhausted");
+    NS_TEST_ASSERT_MSG_EQ(ports.Allocate(), 0, "Allocated from an exhausted range");
+
+    // released ports come back oldest first
+    NS_TEST_ASSERT_MSG_EQ(ports.Release(120), true, "Failed to release");
+    NS_TEST_ASSERT_MSG_EQ(ports.Release(110), true, "Failed to release");
+    NS_TEST_ASSERT_MSG_EQ(ports.Release(110), false, "Released a port twice");
+    NS_TEST_ASSERT_MSG_EQ(ports.Allocate(), 120, "Released ports not reused in order");
+    NS_TEST_ASSERT_MSG_EQ(ports.Allocate(), 110, "Released ports not reused in order");
+
+    // a long churn keeps the footprint constant
+    for (uint32_t i = 0; i < 100000; i++)
+    {
+        uint16_t port = 100 + i % 100;
+        if (port == 150)
+        {
+            continue;
+        }
+        NS_TEST_ASSERT_MSG_EQ(ports.Release(port), true, "Failed to release during churn");
+        NS_TEST_ASSERT_MSG_EQ(ports.Allocate(), port, "Churn handed out an unexpected port");
+    }
+    NS_TEST_ASSERT_MSG_EQ(ports.GetNAllocated(), 100, "Allocation count drifted");
+}
+
+// Create, kill and re-create cybertwins through the controller, with a
+// single port of each kind so the second twin reuses the first one's.
+class CybertwinControllerChurnTestCase : public TestCase
+{
+  public:
+    CybertwinControllerChurnTestCase();
+
+  private:
+    void DoRun() override;
+    void SendRequest(uint16_t method, DEVNAME_t devName, CYBERTWINID_t id);
+    void ControllerResponse(Ptr<Socket> socket);
+    void EndHostConnected(Ptr<Socket> socket);
+    void EndHostClosed(Ptr<Socket> socket);
+
+    Ptr<Node> m_node;
+    Ptr<Socket> m_controlSocket;
+    Ptr<Packet> m_rxBuffer;
+    std::vector<CybertwinControllerHeader> m_responses;
+    uint32_t m_connected;
+    uint32_t m_closed;
+};
+
+CybertwinControllerChurnTestCase::CybertwinControllerChurnTestCase()
+    : TestCase("Cybertwin controller stops killed cybertwins before reusing their ports"),
+      m_connected(0),
+      m_closed(0)
+{
+}
+
+void
+CybertwinControllerChurnTestCase::SendRequest(uint16_t method, DEVNAME_t devName, CYBERTWINID_t id)
+{
+    CybertwinControllerHeader header;
+    header.SetMethod(method);
+    header.SetDeviceName(devName);
+    header.SetNetworkType(0);
+    header.SetCybertwinID(id);
+    Ptr<Packet> packet = Create<Packet>(0);
+    packet->AddHeader(header);
+    m_controlSocket->Send(packet);
+}
+
+void
+CybertwinControllerChurnTestCase::ControllerResponse(Ptr<Socket> socket)
+{
+    Ptr<Packet> packet;
+    while ((packet = socket->Recv()))
+    {
+        m_rxBuffer->AddAtEnd(packet);
+    }
+
+    CybertwinControllerHeader header;
+    while (m_rxBuffer->GetSize() >= header.GetSerializedSize())
+    {
+        m_rxBuffer->RemoveHeader(header);
+        m_responses.push_back(header);
+        if (header.GetMethod() == CYBERTWIN_CONTROLLER_SUCCESS && header.GetCybertwinPort())
+        {
+            // the end host attaches to its new twin
+            Ptr<Socket> endHost = Socket::CreateSocket(m_node, TcpSocketFactory::GetTypeId());
+            endHost->Bind();
+            endHost->SetConnectCallback(
+                MakeCallback(&CybertwinControllerChurnTestCase::EndHostConnected, this),
+                MakeNullCallback<void, Ptr<Socket>>());
+            endHost->SetCloseCallbacks(
+                MakeCallback(&CybertwinControllerChurnTestCase::EndHostClosed, this),
+                MakeCallback(&CybertwinControllerChurnTestCase::EndHostClosed, this));
+            endHost->Connect(InetSocketAddress(Ipv4Address::GetLoopback(), header.GetCybertwinPort()));
+        }
+    }
+}
+
+void
+CybertwinControllerChurnTestCase::EndHostConnected(Ptr<Socket> socket)
+{
+    m_connected++;
+}
+
+void
+CybertwinControllerChurnTestCase::EndHostClosed(Ptr<Socket> socket)
+{
+    m_closed++;
+    socket->Close();
+}
+
+void
+CybertwinControllerChurnTestCase::DoRun()
+{
+    m_node = CreateObject<Node>();
+    InternetStackHelper stack;
+    stack.Install(m_node);
+
+    Ptr<CybertwinController> controller = CreateObject<CybertwinController>();
+    controller->SetAttribute("LocalAddress", AddressValue(Ipv4Address::GetLoopback()));
+    controller->SetAttribute("MultiplexPeers", BooleanValue(false));
+    controller->SetAttribute("LocalPortMin", UintegerValue(6000));
+    controller->SetAttribute("LocalPortMax", UintegerValue(6000));
+    controller->SetAttribute("GlobalPortMin", UintegerValue(7000));
+    controller->SetAttribute("GlobalPortMax", UintegerValue(7000));
+    m_node->AddApplication(controller);
+
+    m_rxBuffer = Create<Packet>();
+    m_controlSocket = Socket::CreateSocket(m_node, TcpSocketFactory::GetTypeId());
+    m_controlSocket->Bind();
+    m_controlSocket->SetRecvCallback(
+        MakeCallback(&CybertwinControllerChurnTestCase::ControllerResponse, this));
+    Simulator::Schedule(Seconds(0.5), [this]() {
+        m_controlSocket->Connect(InetSocketAddress(Ipv4Address::GetLoopback(), 443));
+    });
+
+    Simulator::Schedule(Seconds(1),
+                        &CybertwinControllerChurnTestCase::SendRequest,
+                        this,
+                        CYBERTWIN_CREATE,
+                        1,
+                        0);
+    // the killed twin's connection to its end host still holds port 6000
+    Simulator::Schedule(Seconds(3),
+                        &CybertwinControllerChurnTestCase::SendRequest,
+                        this,
+                        CYBERTWIN_REMOVE,
+                        0,
+                        1);
+    Simulator::Schedule(Seconds(3),
+                        &CybertwinControllerChurnTestCase::SendRequest,
+                        this,
+                        CYBERTWIN_CREATE,
+                        2,
+                        0);
+    // past TIME_WAIT (2 MSL) the port is free again
+    Simulator::Schedule(Seconds(300),
+                        &CybertwinControllerChurnTestCase::SendRequest,
+                        this,
+                        CYBERTWIN_CREATE,
+                        2,
+                        0);
+
+    Simulator::Stop(Seconds(310));
+    Simulator::Run();
+
+    NS_TEST_ASSERT_MSG_EQ(m_responses.size(), 4, "Missing controller responses");
+    NS_TEST_EXPECT_MSG_EQ(m_responses[0].GetMethod(), CYBERTWIN_CONTROLLER_SUCCESS, "First twin not created");
+    NS_TEST_EXPECT_MSG_EQ(m_responses[0].GetCybertwinPort(), 6000, "First twin on an unexpected port");
+    NS_TEST_EXPECT_MSG_EQ(m_responses[1].GetMethod(), CYBERTWIN_CONTROLLER_SUCCESS, "Twin not killed");
+    NS_TEST_EXPECT_MSG_EQ(m_responses[2].GetMethod(),
+                          CYBERTWIN_CONTROLLER_ERROR,
+                          "Port handed out while a socket still held it");
+    NS_TEST_EXPECT_MSG_EQ(m_responses[3].GetMethod(), CYBERTWIN_CONTROLLER_SUCCESS, "Second twin not created");
+    NS_TEST_EXPECT_MSG_EQ(m_responses[3].GetCybertwinPort(), 6000, "Released port not reused");
+    NS_TEST_EXPECT_MSG_EQ(m_closed, 1, "Killed twin did not close its end host connection");
+    NS_TEST_EXPECT_MSG_EQ(m_connected, 2, "End host could not attach to the re-created twin");
+    NS_TEST_EXPECT_MSG_EQ(m_node->GetNApplications(), 2, "Killed twin not reused");
+
+    m_controlSocket = nullptr;
+    m_node = nullptr;
+    Simulator::Destroy();
+}
+
+// Batched creation and removal through the controller, with room for three
+// twins: every entry gets its own status, the ports of removed twins are
+// handed out again, and a batch is served while it is still arriving.
+class CybertwinControllerBatchTestCase : public TestCase
+{
+  public:
+    CybertwinControllerBatchTestCase();
+
+  private:
+    void DoRun() override;
+    void SendBatch(uint16_t method, std::vector<uint64_t> ids, Time split);
+    void ControllerResponse(Ptr<Socket> socket);
+
+    Ptr<Socket> m_controlSocket;
+    Ptr<Packet> m_rxBuffer;
+};
+
+CybertwinControllerBatchTestCase::CybertwinControllerBatchTestCase()
+    : TestCase("Cybertwin controller answers create and remove batches per entry")
+{
+}
+
+void
+CybertwinControllerBatchTestCase::SendBatch(uint16_t method, std::vector<uint64_t> ids, Time split)
+{
+    CybertwinControllerBatchHeader header;
+    header.SetMethod(method);
+    for (uint64_t id : ids)
+    {
+        // device names for creation, Cybertwin IDs for removal
+        header.AddEntry(id, 0, id);
+    }
+    Ptr<Packet> packet = Create<Packet>(0);
+    packet->AddHeader(header);
+    if (split.IsZero())
+    {
+        m_controlSocket->Send(packet);
+        return;
+    }
+    // the fixed fields and the first entry now, the rest later
+    uint32_t first = CybertwinControllerBatchHeader::GetFixedSize() +
+                     CybertwinControllerBatchHeader::GetEntrySize();
+    m_controlSocket->Send(packet->CreateFragment(0, first));
+    Ptr<Packet> rest = packet->CreateFragment(first, packet->GetSize() - first);
+    Simulator::Schedule(split, [this, rest]() { m_controlSocket->Send(rest); });
+}
+
+void
+CybertwinControllerBatchTestCase::ControllerResponse(Ptr<Socket> socket)
+{
+    Ptr<Packet> packet;
+    while ((packet = socket->Recv()))
+    {
+        m_rxBuffer->AddAtEnd(packet);
+    }
+}
+
+void
+CybertwinControllerBatchTestCase::DoRun()
+{
+    Ptr<Node> node = CreateObject<Node>();
+    InternetStackHelper stack;
+    stack.Install(node);
+
+    Ptr<CybertwinController> controller = CreateObject<CybertwinController>();
+    controller->SetAttribute("LocalAddress", AddressValue(Ipv4Address::GetLoopback()));
+    controller->SetAttribute("MultiplexPeers", BooleanValue(false));
+    controller->SetAttribute("LocalPortMin", UintegerValue(6000));
+    controller->SetAttribute("LocalPortMax", UintegerValue(6002));
+    controller->SetAttribute("GlobalPortMin", UintegerValue(7000));
+    controller->SetAttribute("GlobalPortMax", UintegerValue(7002));
+    node->AddApplication(controller);
+
+    m_rxBuffer = Create<Packet>();
+    m_controlSocket = Socket::CreateSocket(node, TcpSocketFactory::GetTypeId());
+    m_controlSocket->Bind();
+    m_controlSocket->SetRecvCallback(
+        MakeCallback(&CybertwinControllerBatchTestCase::ControllerResponse, this));
+    Simulator::Schedule(Seconds(0.5), [this]() {
+        m_controlSocket->Connect(InetSocketAddress(Ipv4Address::GetLoopback(), 443));
+    });
+
+    // a duplicate, and one twin more than there are ports for
+    Simulator::Schedule(Seconds(1),
+                        &CybertwinControllerBatchTestCase::SendBatch,
+                        this,
+                        CYBERTWIN_CREATE_BATCH,
+                        std::vector<uint64_t>{1, 2, 2, 3, 4},
+                        Time(0));
+    Simulator::Schedule(Seconds(2),
+                        &CybertwinControllerBatchTestCase::SendBatch,
+                        this,
+                        CYBERTWIN_REMOVE_BATCH,
+                        std::vector<uint64_t>{1, 2},
+                        Time(0));
+    // the first entry is served before the rest of the batch is sent
+    Simulator::Schedule(Seconds(3),
+                        &CybertwinControllerBatchTestCase::SendBatch,
+                        this,
+                        CYBERTWIN_CREATE_BATCH,
+                        std::vector<uint64_t>{5, 6},
+                        Seconds(1));
+    bool servedBeforeRest = false;
+    Simulator::Schedule(Seconds(3.5), [node, &servedBeforeRest]() {
+        for (uint32_t i = 0; i < node->GetNApplications(); i++)
+        {
+            Ptr<Cybertwin> twin = DynamicCast<Cybertwin>(node->GetApplication(i));
+            servedBeforeRest |= twin && twin->GetCybertwinID() == 5;
+        }
+    });
+    uint32_t responsesBeforeRest = 0;
+    Simulator::Schedule(Seconds(3.5), [this, &responsesBeforeRest]() {
+        responsesBeforeRest = m_rxBuffer->GetSize();
+    });
+
+    Simulator::Stop(Seconds(10));
+    Simulator::Run();
+
+    std::vector<CybertwinControllerBatchHeader> responses;
+    while (m_rxBuffer->GetSize() >= CybertwinControllerBatchHeader::GetFixedSize())
+    {
+        CybertwinControllerBatchHeader header;
+        m_rxBuffer->RemoveHeader(header);
+        responses.push_back(header);
+    }
+    NS_TEST_ASSERT_MSG_EQ(responses.size(), 3, "Not one response per batch");
+
+    const CybertwinControllerBatchHeader& created = responses[0];
+    NS_TEST_EXPECT_MSG_EQ(created.GetMethod(), CYBERTWIN_BATCH_RESPONSE, "Wrong response method");
+    NS_TEST_ASSERT_MSG_EQ(created.GetNEntries(), 5, "Not one status per entry");
+    std::vector<uint16_t> statuses{CYBERTWIN_CONTROLLER_SUCCESS,
+                                   CYBERTWIN_CONTROLLER_SUCCESS,
+                                   CYBERTWIN_CONTROLLER_ERROR,
+                                   CYBERTWIN_CONTROLLER_SUCCESS,
+                                   CYBERTWIN_CONTROLLER_ERROR};
+    std::vector<uint16_t> ports{6000, 6001, 0, 6002, 0};
+    std::vector<uint64_t> devices{1, 2, 2, 3, 4};
+    for (uint32_t i = 0; i < 5; i++)
+    {
+        NS_TEST_EXPECT_MSG_EQ(created.GetDeviceName(i), devices[i], "Entries out of order");
+        NS_TEST_EXPECT_MSG_EQ(created.GetStatus(i), statuses[i], "Wrong status of entry " << i);
+        if (statuses[i] == CYBERTWIN_CONTROLLER_SUCCESS)
+        {
+            NS_TEST_EXPECT_MSG_EQ(created.GetCybertwinPort(i), ports[i], "Wrong port of entry " << i);
+            NS_TEST_EXPECT_MSG_EQ(created.GetCybertwinID(i), created.GetDeviceName(i), "Wrong ID of entry " << i);
+        }
+    }
+
+    const CybertwinControllerBatchHeader& removed = responses[1];
+    NS_TEST_ASSERT_MSG_EQ(removed.GetNEntries(), 2, "Not one status per removal");
+    for (uint32_t i = 0; i < 2; i++)
+    {
+        NS_TEST_EXPECT_MSG_EQ(removed.GetStatus(i), CYBERTWIN_CONTROLLER_SUCCESS, "Twin not removed");
+    }
+
+    // the removed twins' ports, and their applications, are reused
+    const CybertwinControllerBatchHeader& recreated = responses[2];
+    NS_TEST_ASSERT_MSG_EQ(recreated.GetNEntries(), 2, "Not one status per entry");
+    std::set<uint16_t> reused;
+    for (uint32_t i = 0; i < 2; i++)
+    {
+        NS_TEST_EXPECT_MSG_EQ(recreated.GetStatus(i), CYBERTWIN_CONTROLLER_SUCCESS, "Twin not re-created");
+        reused.insert(recreated.GetCybertwinPort(i));
+    }
+    NS_TEST_EXPECT_MSG_EQ((reused == std::set<uint16_t>{6000, 6001}), true, "Released ports not reused");
+    NS_TEST_EXPECT_MSG_EQ(node->GetNApplications(), 4, "Removed twins not reused");
+
+    // at 3.5 s the first entry of the last batch had been served, not answered
+    NS_TEST_EXPECT_MSG_EQ(responsesBeforeRest,
+                          created.GetSerializedSize() + removed.GetSerializedSize(),
+                          "Batch answered before it was complete");
+    NS_TEST_EXPECT_MSG_EQ(servedBeforeRest, true, "Batch entries wait for the whole batch");
+
+    m_controlSocket = nullptr;
+    Simulator::Destroy();
+}
+
+// A port some other socket of the node holds is never handed to a twin,
+// and the default ranges stay clear of the ephemeral ports.
+class CybertwinControllerBoundPortTestCase : public TestCase
+{
+  public:
+    CybertwinControllerBoundPortTestCase();
+
+  private:
+    void DoRun() override;
+    void ControllerResponse(Ptr<Socket> socket);
+
+    std::vector<CybertwinControllerHeader> m_responses;
+};
+
+CybertwinControllerBoundPortTestCase::CybertwinControllerBoundPortTestCase()
+    : TestCase("Cybertwin controller skips ports bound by other sockets")
+{
+}
+
+void
+CybertwinControllerBoundPortTestCase::ControllerResponse(Ptr<Socket> socket)
+{
+    Ptr<Packet> packet;
+    while ((packet = socket->Recv()))
+    {
+        CybertwinControllerHeader header;
+        packet->RemoveHeader(header);
+        m_responses.push_back(header);
+    }
+}
+
+void
+CybertwinControllerBoundPortTestCase::DoRun()
+{
+    Ptr<Node> node = CreateObject<Node>();
+    InternetStackHelper stack;
+    stack.Install(node);
+
+    Ptr<CybertwinController> controller = CreateObject<CybertwinController>();
+    UintegerValue globalPortMax;
+    controller->GetAttribute("GlobalPortMax", globalPortMax);
+    NS_TEST_EXPECT_MSG_LT(globalPortMax.Get(), 49152, "Default ports overlap the ephemeral ones");
+
+    controller->SetAttribute("LocalAddress", AddressValue(Ipv4Address::GetLoopback()));
+    controller->SetAttribute("MultiplexPeers", BooleanValue(false));
+    controller->SetAttribute("LocalPortMin", UintegerValue(6000));
+    controller->SetAttribute("LocalPortMax", UintegerValue(6001));
+    controller->SetAttribute("GlobalPortMin", UintegerValue(7000));
+    controller->SetAttribute("GlobalPortMax", UintegerValue(7001));
+    node->AddApplication(controller);
+
+    // one on our address, one on any
+    Ptr<Socket> localHolder = Socket::CreateSocket(node, TcpSocketFactory::GetTypeId());
+    localHolder->Bind(InetSocketAddress(Ipv4Address::GetLoopback(), 6000));
+    Ptr<Socket> globalHolder = Socket::CreateSocket(node, TcpSocketFactory::GetTypeId());
+    globalHolder->Bind(InetSocketAddress(Ipv4Address::GetAny(), 7000));
+
+    Ptr<Socket> controlSocket = Socket::CreateSocket(node, TcpSocketFactory::GetTypeId());
+    controlSocket->Bind();
+    controlSocket->SetRecvCallback(
+        MakeCallback(&CybertwinControllerBoundPortTestCase::ControllerResponse, this));
+    Simulator::Schedule(Seconds(0.5), [controlSocket]() {
+        controlSocket->Connect(InetSocketAddress(Ipv4Address::GetLoopback(), 443));
+    });
+    Simulator::Schedule(Seconds(1), [controlSocket]() {
+        CybertwinControllerHeader header;
+        header.SetMethod(CYBERTWIN_CREATE);
+        header.SetDeviceName(1);
+        header.SetNetworkType(0);
+        Ptr<Packet> packet = Create<Packet>(0);
+        packet->AddHeader(header);
+        controlSocket->Send(packet);
+    });
+
+    Simulator::Stop(Seconds(5));
+    Simulator::Run();
+
+    NS_TEST_ASSERT_MSG_EQ(m_responses.size(), 1, "Missing controller response");
+    NS_TEST_EXPECT_MSG_EQ(m_responses[0].GetMethod(), CYBERTWIN_CONTROLLER_SUCCESS, "Twin not created");
+    NS_TEST_EXPECT_MSG_EQ(m_responses[0].GetCybertwinPort(), 6001, "Twin got a bound local port");
+    Ptr<Cybertwin> twin = DynamicCast<Cybertwin>(node->GetApplication(1));
+    NS_TEST_ASSERT_MSG_NE(twin, nullptr, "Twin not added to the node");
+    NS_TEST_EXPECT_MSG_EQ(twin->GetGlobalInterface().second, 7001, "Twin got a bound global port");
+
+    Simulator::Destroy();
+}
+
+// Several streams share one loopback edge connection.
+class CybertwinEdgeTransportTestCase : public TestCase
+{
+  public:
+    CybertwinEdgeTransportTestCase();
+
+  private:
+    void DoRun() override;
+    void Received(CYBERTWINID_t dst, CYBERTWINID_t src, Ptr<Packet> packet);
+    void Send(Ptr<CybertwinEdgeTransport> transport, CYBERTWINID_t src, CYBERTWINID_t dst, uint32_t size);
+
+    std::map<CYBERTWINID_t, uint32_t> m_received;
+    uint32_t m_refused;
+};
+
+CybertwinEdgeTransportTestCase::CybertwinEdgeTransportTestCase()
+    : TestCase("Cybertwin edge transport multiplexes streams over one connection"),
+      m_refused(0)
+{
+}
+
+void
+CybertwinEdgeTransportTestCase::Received(CYBERTWINID_t dst, CYBERTWINID_t src, Ptr<Packet> packet)
+{
+    NS_TEST_EXPECT_MSG_EQ(src + 1, dst, "Frame delivered to the wrong cybertwin");
+    m_received[dst] += packet->GetSize();
+}
+
+void
+CybertwinEdgeTransportTestCase::Send(Ptr<CybertwinEdgeTransport> transport,
+                                     CYBERTWINID_t src,
+                                     CYBERTWINID_t dst,
+                                     uint32_t size)
+{
+    if (!transport->Send(src, dst, Ipv4Address::GetLoopback(), Create<Packet>(size)))
+    {
+        m_refused++;
+    }
+}
+
+void
+CybertwinEdgeTransportTestCase::DoRun()
+{
+    Ptr<Node> node = CreateObject<Node>();
+    InternetStackHelper stack;
+    stack.Install(node);
+
+    Ptr<CybertwinEdgeTransport> transport = CreateObject<CybertwinEdgeTransport>();
+    transport->SetAttribute("StreamQueueLimit", UintegerValue(64 * 1024));
+    transport->SetNode(node);
+    transport->Start();
+    for (CYBERTWINID_t dst : {2, 4, 6})
+    {
+        transport->Register(dst,
+                            MakeCallback(&CybertwinEdgeTransportTestCase::Received, this).Bind(dst),
+                            MakeNullCallback<void, CYBERTWINID_t>());
+    }
+
+    // a packet larger than the stream limit is taken while the stream is empty
+    Simulator::Schedule(Seconds(1), &CybertwinEdgeTransportTestCase::Send, this, transport, 1, 2, 100000);
+    Simulator::Schedule(Seconds(1), &CybertwinEdgeTransportTestCase::Send, this, transport, 1, 2, 1000);
+    for (uint32_t i = 0; i < 50; i++)
+    {
+        Simulator::Schedule(Seconds(1), &CybertwinEdgeTransportTestCase::Send, this, transport, 3, 4, 1000);
+    }
+    // no twin 8 on this edge, the frame is dropped
+    Simulator::Schedule(Seconds(1), &CybertwinEdgeTransportTestCase::Send, this, transport, 5, 8, 500);
+    Simulator::Schedule(Seconds(2), &CybertwinEdgeTransportTestCase::Send, this, transport, 5, 6, 3000);
+
+    Simulator::Stop(Seconds(5));
+    Simulator::Run();
+
+    NS_TEST_EXPECT_MSG_EQ(m_refused, 1, "A full stream accepted more data");
+    NS_TEST_EXPECT_MSG_EQ(m_received[2], 100000, "Large packet not reassembled");
+    NS_TEST_EXPECT_MSG_EQ(m_received[4], 50000, "Small packets lost");
+    NS_TEST_EXPECT_MSG_EQ(m_received[6], 3000, "Frames after a dropped one lost");
+    NS_TEST_EXPECT_MSG_EQ(transport->GetNConnections(), 1, "Streams did not share the connection");
+
+    transport->Dispose();
+    Simulator::Destroy();
+}
+
+// Feed frames through the buffer cut at awkward places.
+class CybertwinFrameBufferTestCase : public TestCase
+{
+  public:
+    CybertwinFrameBufferTestCase();
+
+  private:
+    void DoRun() override;
+};
+
+CybertwinFrameBufferTestCase::CybertwinFrameBufferTestCase()
+    : TestCase("Cybertwin frame buffer reassembles frames split across segments")
+{
+}
+
+void
+CybertwinFrameBufferTestCase::DoRun()
+{
+    // three frames with payloads of 10, 3000 and 0 bytes
+    const uint32_t payloads[] = {10, 3000, 0};
+    Ptr<Packet> stream = Create<Packet>(0);
+    for (uint32_t i = 0; i < 3; i++)
+    {
+        std::vector<uint8_t> data(payloads[i], static_cast<uint8_t>(i + 1));
+        Ptr<Packet> frame = Create<Packet>(data.data(), data.size());
+        frame->AddHeader(CybertwinPacketHeader(i, i + 100, payloads[i]));
+        stream->AddAtEnd(frame);
+    }
+
+    // segments that split the first header and straddle frame boundaries
+    CybertwinFrameBuffer buffer;
+    const uint32_t cuts[] = {5, 40, 1500, 1000};
+    uint32_t offset = 0;
+    for (uint32_t cut : cuts)
+    {
+        buffer.Append(stream->CreateFragment(offset, cut));
+        offset += cut;
+    }
+    buffer.Append(stream->CreateFragment(offset, stream->GetSize() - offset));
+    NS_TEST_ASSERT_MSG_EQ(buffer.GetSize(), stream->GetSize(), "Bytes lost while appending");
+
+    CybertwinPacketHeader header;
+    const uint32_t headerSize = header.GetSerializedSize();
+    for (uint32_t i = 0; i < 3; i++)
+    {
+        NS_TEST_ASSERT_MSG_EQ(buffer.PeekHeader(header, headerSize), true, "Header not found");
+        NS_TEST_ASSERT_MSG_EQ(header.GetSrc(), i, "Wrong header peeked");
+        NS_TEST_ASSERT_MSG_EQ(header.GetSize(), payloads[i], "Wrong frame size");
+
+        Ptr<Packet> frame = buffer.Remove(headerSize + header.GetSize());
+        frame->RemoveHeader(header);
+        NS_TEST_ASSERT_MSG_EQ(frame->GetSize(), payloads[i], "Wrong payload size");
+        std::vector<uint8_t> data(payloads[i]);
+        frame->CopyData(data.data(), data.size());
+        for (uint8_t byte : data)
+        {
+            NS_TEST_ASSERT_MSG_EQ(uint32_t(byte), i + 1, "Payload corrupted");
+        }
+    }
+    NS_TEST_ASSERT_MSG_EQ(buffer.GetSize(), 0, "Bytes left over");
+    NS_TEST_ASSERT_MSG_EQ(buffer.PeekHeader(header, headerSize), false, "Peeked an empty buffer");
+    NS_TEST_ASSERT_MSG_EQ(buffer.Remove(1), nullptr, "Removed from an empty buffer");
+}
+
+// Three twins on one edge: twin 1 forwards shaped traffic to twin 2, twin 3
+// gets more than its rx queue holds from a remote twin.
+class CybertwinShapingTestCase : public TestCase
+{
+  public:
+    CybertwinShapingTestCase();
+
+  private:
+    void DoRun() override;
+    void Transmitted(Ptr<const Packet> packet);
+    void Delivered(Ptr<const Packet> packet);
+    void QueueDepth(CYBERTWINID_t peer, uint32_t packets);
+    void EndHostReceived(Ptr<Socket> socket);
+    void EndHostSend(Ptr<Socket> socket, uint32_t frames);
+    Ptr<Socket> ConnectEndHost(Ptr<Node> node, uint16_t port);
+
+    std::vector<std::pair<Time, uint32_t>> m_transmitted;
+    std::vector<std::pair<Time, uint32_t>> m_delivered;
+    std::map<Ptr<Socket>, uint32_t> m_endHostBytes;
+    uint32_t m_maxQueueDepth;
+};
+
+CybertwinShapingTestCase::CybertwinShapingTestCase()
+    : TestCase("Cybertwin shapes, counts and bounds per-twin traffic"),
+      m_maxQueueDepth(0)
+{
+}
+
+void
+CybertwinShapingTestCase::Transmitted(Ptr<const Packet> packet)
+{
+    m_transmitted.emplace_back(Simulator::Now(), packet->GetSize());
+}
+
+void
+CybertwinShapingTestCase::Delivered(Ptr<const Packet> packet)
+{
+    m_delivered.emplace_back(Simulator::Now(), packet->GetSize());
+}
+
+void
+CybertwinShapingTestCase::QueueDepth(CYBERTWINID_t peer, uint32_t packets)
+{
+    m_maxQueueDepth = std::max(m_maxQueueDepth, packets);
+}
+
+void
+CybertwinShapingTestCase::EndHostReceived(Ptr<Socket> socket)
+{
+    Ptr<Packet> packet;
+    while ((packet = socket->Recv()))
+    {
+        m_endHostBytes[socket] += packet->GetSize();
+    }
+}
+
+void
+CybertwinShapingTestCase::EndHostSend(Ptr<Socket> socket, uint32_t frames)
+{
+    for (uint32_t i = 0; i < frames; i++)
+    {
+        Ptr<Packet> frame = Create<Packet>(1000);
+        frame->AddHeader(CybertwinPacketHeader(1, 2, 1000));
+        socket->Send(frame);
+    }
+}
+
+Ptr<Socket>
+CybertwinShapingTestCase::ConnectEndHost(Ptr<Node> node, uint16_t port)
+{
+    Ptr<Socket> socket = Socket::CreateSocket(node, TcpSocketFactory::GetTypeId());
+    socket->Bind();
+    socket->Connect(InetSocketAddress(Ipv4Address::GetLoopback(), port));
+    socket->SetRecvCallback(MakeCallback(&CybertwinShapingTestCase::EndHostReceived, this));
+    m_endHostBytes[socket] = 0;
+    return socket;
+}
+
+// cumulative bytes never run ahead of the bucket, one packet of slack
+static bool
+Conforms(const std::vector<std::pair<Time, uint32_t>>& samples, double rate, double burst)
+{
+    uint64_t total = 0;
+    for (auto& sample : samples)
+    {
+        total += sample.second;
+        double allowed = burst + rate * (sample.first - samples.front().first).GetSeconds();
+        if (total > allowed + sample.second)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+void
+CybertwinShapingTestCase::DoRun()
+{
+    Ptr<Node> node = CreateObject<Node>();
+    InternetStackHelper stack;
+    stack.Install(node);
+
+    Ptr<CybertwinEdgeTransport> transport = CreateObject<CybertwinEdgeTransport>();
+    transport->SetNode(node);
+    transport->Start();
+    Ptr<NameResolutionClient> resolver = CreateObject<NameResolutionClient>();
+    resolver->SetAttribute("ServerAddress", AddressValue(Ipv4Address::GetLoopback()));
+    resolver->SetNode(node);
+
+    std::vector<Ptr<Cybertwin>> twins;
+    for (CYBERTWINID_t id : {1, 2, 3})
+    {
+        Ptr<Cybertwin> twin = CreateObject<Cybertwin>();
+        twin->SetAttribute("LazyGlobalSocket", BooleanValue(false));
+        twin->SetCybertwinID(id);
+        twin->SetLocalInterface(Ipv4Address::GetLoopback(), 5000 + 2 * id);
+        twin->SetGlobalInterface(Ipv4Address::GetLoopback(), 5001 + 2 * id);
+        twin->SetNameResolver(resolver);
+        twin->SetEdgeTransport(transport);
+        node->AddApplication(twin);
+        twins.push_back(twin);
+    }
+    // 100 kB/s out of twin 1, at most 10 frames waiting
+    twins[0]->SetAttribute("TxRate", DataRateValue(DataRate("800kbps")));
+    twins[0]->SetAttribute("TxBurst", UintegerValue(4000));
+    twins[0]->SetAttribute("TxQueueLimit", QueueSizeValue(QueueSize("10p")));
+    twins[0]->TraceConnectWithoutContext("Tx", MakeCallback(&CybertwinShapingTestCase::Transmitted, this));
+    twins[0]->TraceConnectWithoutContext("PeerQueueDepth", MakeCallback(&CybertwinShapingTestCase::QueueDepth, this));
+    // 10 kB/s into twin 3, at most 5000 bytes waiting
+    twins[2]->SetAttribute("RxRate", DataRateValue(DataRate("80kbps")));
+    twins[2]->SetAttribute("RxBurst", UintegerValue(2000));
+    twins[2]->SetAttribute("RxQueueLimit", QueueSizeValue(QueueSize("5000B")));
+    twins[2]->TraceConnectWithoutContext("Rx", MakeCallback(&CybertwinShapingTestCase::Delivered, this));
+
+    Ptr<Socket> sender = ConnectEndHost(node, 5002);
+    Ptr<Socket> receiver = ConnectEndHost(node, 5004);
+    Ptr<Socket> slowReceiver = ConnectEndHost(node, 5006);
+
+    Simulator::Schedule(Seconds(1), &CybertwinShapingTestCase::EndHostSend, this, sender, 40);
+    for (uint32_t i = 0; i < 50; i++)
+    {
+        Simulator::Schedule(Seconds(1), [transport]() {
+            transport->Send(100, 3, Ipv4Address::GetLoopback(), Create<Packet>(1000));
+        });
+    }
+
+    Simulator::Stop(Seconds(10));
+    Simulator::Run();
+
+    const uint32_t frameSize = 1000 + CybertwinPacketHeader().GetSerializedSize();
+    UintegerValue txPackets;
+    UintegerValue txBytes;
+    UintegerValue txDrops;
+    twins[0]->GetAttribute("TxPackets", txPackets);
+    twins[0]->GetAttribute("TxBytes", txBytes);
+    twins[0]->GetAttribute("TxDrops", txDrops);
+    NS_TEST_EXPECT_MSG_EQ(txPackets.Get(), 40, "Frames from the end host lost");
+    NS_TEST_EXPECT_MSG_EQ(txBytes.Get(), 40 * frameSize, "Forwarded bytes miscounted");
+    NS_TEST_EXPECT_MSG_EQ(txDrops.Get(), 0, "Back pressure should not drop");
+    NS_TEST_EXPECT_MSG_EQ(m_endHostBytes[receiver], 40 * frameSize, "Peer end host missed frames");
+    NS_TEST_EXPECT_MSG_LT_OR_EQ(m_maxQueueDepth, 10, "Tx queue limit exceeded");
+    NS_TEST_EXPECT_MSG_EQ(Conforms(m_transmitted, 100000, 4000), true, "Tx not shaped");
+    NS_TEST_EXPECT_MSG_GT(m_transmitted.back().first - m_transmitted.front().first,
+                          Seconds(0.3),
+                          "Tx finished faster than the rate allows");
+
+    UintegerValue rxPackets;
+    UintegerValue rxBytes;
+    UintegerValue rxDrops;
+    twins[2]->GetAttribute("RxPackets", rxPackets);
+    twins[2]->GetAttribute("RxBytes", rxBytes);
+    twins[2]->GetAttribute("RxDrops", rxDrops);
+    NS_TEST_EXPECT_MSG_GT(rxDrops.Get(), 0, "Rx queue limit not enforced");
+    NS_TEST_EXPECT_MSG_EQ(rxPackets.Get() + rxDrops.Get(), 50, "Frames unaccounted for");
+    NS_TEST_EXPECT_MSG_EQ(rxBytes.Get(), m_endHostBytes[slowReceiver], "Delivered bytes miscounted");
+    NS_TEST_EXPECT_MSG_EQ(Conforms(m_delivered, 10000, 2000), true, "Rx not shaped");
+
+    transport->Dispose();
+    Simulator::Destroy();
+}
+
+// Twin 1 forwards a burst to twin 2 followed by one to twin 3, shaped to
+// one frame at a time: with a quantum of one frame the peers take turns
+// instead of the first one draining its whole backlog.
+class CybertwinPeerFairnessTestCase : public TestCase
+{
+  public:
+    CybertwinPeerFairnessTestCase();
+
+  private:
+    void DoRun() override;
+    void Transmitted(Ptr<const Packet> packet);
+    void QueueDepth(CYBERTWINID_t peer, uint32_t packets);
+    void DrainRate(CYBERTWINID_t peer, DataRate rate);
+    void EndHostSend(Ptr<Socket> socket);
+
+    std::vector<uint64_t> m_transmitted;
+    std::map<CYBERTWINID_t, uint32_t> m_queueDepth;
+    std::map<CYBERTWINID_t, std::vector<DataRate>> m_drainRates;
+};
+
+CybertwinPeerFairnessTestCase::CybertwinPeerFairnessTestCase()
+    : TestCase("Cybertwin shares its tx rate fairly between backlogged peers")
+{
+}
+
+void
+CybertwinPeerFairnessTestCase::Transmitted(Ptr<const Packet> packet)
+{
+    CybertwinPacketHeader header;
+    packet->PeekHeader(header);
+    m_transmitted.push_back(header.GetDst());
+}
+
+void
+CybertwinPeerFairnessTestCase::QueueDepth(CYBERTWINID_t peer, uint32_t packets)
+{
+    m_queueDepth[peer] = packets;
+}
+
+void
+CybertwinPeerFairnessTestCase::DrainRate(CYBERTWINID_t peer, DataRate rate)
+{
+    // only while both peers are backlogged
+    if (m_queueDepth[2] > 0 && m_queueDepth[3] > 0)
+    {
+        m_drainRates[peer].push_back(rate);
+    }
+}
+
+void
+CybertwinPeerFairnessTestCase::EndHostSend(Ptr<Socket> socket)
+{
+    for (CYBERTWINID_t dst : {2, 3})
+    {
+        for (uint32_t i = 0; i < 30; i++)
+        {
+            Ptr<Packet> frame = Create<Packet>(1000);
+            frame->AddHeader(CybertwinPacketHeader(1, dst, 1000));
+            socket->Send(frame);
+        }
+    }
+}
+
+void
+CybertwinPeerFairnessTestCase::DoRun()
+{
+    Ptr<Node> node = CreateObject<Node>();
+    InternetStackHelper stack;
+    stack.Install(node);
+
+    Ptr<CybertwinEdgeTransport> transport = CreateObject<CybertwinEdgeTransport>();
+    transport->SetNode(node);
+    transport->Start();
+    Ptr<NameResolutionClient> resolver = CreateObject<NameResolutionClient>();
+    resolver->SetAttribute("ServerAddress", AddressValue(Ipv4Address::GetLoopback()));
+    resolver->SetNode(node);
+
+    std::vector<Ptr<Cybertwin>> twins;
+    for (CYBERTWINID_t id : {1, 2, 3})
+    {
+        Ptr<Cybertwin> twin = CreateObject<Cybertwin>();
+        twin->SetAttribute("LazyGlobalSocket", BooleanValue(false));
+        twin->SetCybertwinID(id);
+        twin->SetLocalInterface(Ipv4Address::GetLoopback(), 5000 + 2 * id);
+        twin->SetGlobalInterface(Ipv4Address::GetLoopback(), 5001 + 2 * id);
+        twin->SetNameResolver(resolver);
+        twin->SetEdgeTransport(transport);
+        node->AddApplication(twin);
+        twins.push_back(twin);
+    }
+    const uint32_t frameSize = 1000 + CybertwinPacketHeader().GetSerializedSize();
+    // 100 kB/s with room for a single frame, so every round ends on the bucket
+    twins[0]->SetAttribute("TxRate", DataRateValue(DataRate("800kbps")));
+    twins[0]->SetAttribute("TxBurst", UintegerValue(frameSize));
+    twins[0]->SetAttribute("PeerQuantum", UintegerValue(frameSize));
+    twins[0]->TraceConnectWithoutContext("Tx", MakeCallback(&CybertwinPeerFairnessTestCase::Transmitted, this));
+    twins[0]->TraceConnectWithoutContext("PeerQueueDepth", MakeCallback(&CybertwinPeerFairnessTestCase::QueueDepth, this));
+    twins[0]->TraceConnectWithoutContext("PeerDrainRate", MakeCallback(&CybertwinPeerFairnessTestCase::DrainRate, this));
+
+    Ptr<Socket> sender = Socket::CreateSocket(node, TcpSocketFactory::GetTypeId());
+    sender->Bind();
+    sender->Connect(InetSocketAddress(Ipv4Address::GetLoopback(), 5002));
+    std::vector<Ptr<Socket>> receivers;
+    for (uint16_t port : {5004, 5006})
+    {
+        Ptr<Socket> receiver = Socket::CreateSocket(node, TcpSocketFactory::GetTypeId());
+        receiver->Bind();
+        receiver->Connect(InetSocketAddress(Ipv4Address::GetLoopback(), port));
+        receivers.push_back(receiver);
+    }
+
+    Simulator::Schedule(Seconds(1), &CybertwinPeerFairnessTestCase::EndHostSend, this, sender);
+    Simulator::Stop(Seconds(10));
+    Simulator::Run();
+
+    NS_TEST_ASSERT_MSG_EQ(m_transmitted.size(), 60, "Frames from the end host lost");
+    // once twin 3 has frames waiting, no peer sends twice in a row while
+    // the other one is still backlogged
+    auto first = std::find(m_transmitted.begin(), m_transmitted.end(), 3);
+    NS_TEST_ASSERT_MSG_EQ((first != m_transmitted.end()), true, "Twin 3 never served");
+    uint32_t left = std::count(first, m_transmitted.end(), 2);
+    for (auto it = first + 1; it != m_transmitted.end() && left > 0; it++)
+    {
+        NS_TEST_EXPECT_MSG_NE(*it, *(it - 1), "Peer " << *it << " served twice in a row");
+        left -= *it == 2;
+    }
+
+    NS_TEST_EXPECT_MSG_EQ(m_queueDepth[2], 0, "Twin 2 backlog not drained");
+    NS_TEST_EXPECT_MSG_EQ(m_queueDepth[3], 0, "Twin 3 backlog not drained");
+    NS_TEST_ASSERT_MSG_EQ(m_drainRates[2].empty(), false, "No drain rate for twin 2");
+    NS_TEST_ASSERT_MSG_EQ(m_drainRates[3].empty(), false, "No drain rate for twin 3");
+    // each gets about half of the 800 kbps, the first window of a peer
+    // starts before its backlog does
+    for (CYBERTWINID_t peer : {2, 3})
+    {
+        for (std::size_t i = 1; i < m_drainRates[peer].size(); i++)
+        {
+            NS_TEST_EXPECT_MSG_EQ_TOL(m_drainRates[peer][i].GetBitRate(),
+                                      400000,
+                                      100000,
+                                      "Twin " << peer << " got an unfair share");
+        }
+    }
+
+    transport->Dispose();
+    Simulator::Destroy();
+}
+
+// An end host sending faster than its twin forwards, against a tx limit in
+// bytes: the frames queued and the one being reassembled stay within it.
+class CybertwinTxQueueLimitTestCase : public TestCase
+{
+  public:
+    CybertwinTxQueueLimitTestCase();
+
+  private:
+    void DoRun() override;
+    void QueueDepth(CYBERTWINID_t peer, uint32_t packets);
+    void Delivered(Ptr<const Packet> packet);
+    void EndHostSend(Ptr<Socket> socket);
+
+    uint32_t m_maxQueueDepth;
+    uint32_t m_delivered;
+};
+
+CybertwinTxQueueLimitTestCase::CybertwinTxQueueLimitTestCase()
+    : TestCase("Cybertwin counts partial end host frames against its tx queue limit"),
+      m_maxQueueDepth(0),
+      m_delivered(0)
+{
+}
+
+void
+CybertwinTxQueueLimitTestCase::QueueDepth(CYBERTWINID_t peer, uint32_t packets)
+{
+    m_maxQueueDepth = std::max(m_maxQueueDepth, packets);
+}
+
+void
+CybertwinTxQueueLimitTestCase::Delivered(Ptr<const Packet> packet)
+{
+    m_delivered += packet->GetSize();
+}
+
+void
+CybertwinTxQueueLimitTestCase::EndHostSend(Ptr<Socket> socket)
+{
+    for (uint32_t i = 0; i < 20; i++)
+    {
+        Ptr<Packet> frame = Create<Packet>(1000);
+        frame->AddHeader(CybertwinPacketHeader(1, 2, 1000));
+        socket->Send(frame);
+    }
+    // larger than the whole limit
+    Ptr<Packet> frame = Create<Packet>(10000);
+    frame->AddHeader(CybertwinPacketHeader(1, 2, 10000));
+    socket->Send(frame);
+}
+
+void
+CybertwinTxQueueLimitTestCase::DoRun()
+{
+    Ptr<Node> node = CreateObject<Node>();
+    InternetStackHelper stack;
+    stack.Install(node);
+
+    Ptr<CybertwinEdgeTransport> transport = CreateObject<CybertwinEdgeTransport>();
+    transport->SetNode(node);
+    transport->Start();
+    Ptr<NameResolutionClient> resolver = CreateObject<NameResolutionClient>();
+    resolver->SetAttribute("ServerAddress", AddressValue(Ipv4Address::GetLoopback()));
+    resolver->SetNode(node);
+
+    std::vector<Ptr<Cybertwin>> twins;
+    for (CYBERTWINID_t id : {1, 2})
+    {
+        Ptr<Cybertwin> twin = CreateObject<Cybertwin>();
+        twin->SetAttribute("LazyGlobalSocket", BooleanValue(false));
+        twin->SetCybertwinID(id);
+        twin->SetLocalInterface(Ipv4Address::GetLoopback(), 5000 + 2 * id);
+        twin->SetGlobalInterface(Ipv4Address::GetLoopback(), 5001 + 2 * id);
+        twin->SetNameResolver(resolver);
+        twin->SetEdgeTransport(transport);
+        node->AddApplication(twin);
+        twins.push_back(twin);
+    }
+    // three 1016-byte frames fit, a fourth only partly
+    twins[0]->SetAttribute("TxQueueLimit", QueueSizeValue(QueueSize("4000B")));
+    twins[0]->SetAttribute("TxRate", DataRateValue(DataRate("400kbps")));
+    twins[0]->SetAttribute("TxBurst", UintegerValue(1100));
+    twins[0]->TraceConnectWithoutContext("PeerQueueDepth",
+                                         MakeCallback(&CybertwinTxQueueLimitTestCase::QueueDepth, this));
+    twins[0]->TraceConnectWithoutContext("Tx", MakeCallback(&CybertwinTxQueueLimitTestCase::Delivered, this));
+
+    Ptr<Socket> sender = Socket::CreateSocket(node, TcpSocketFactory::GetTypeId());
+    sender->Bind();
+    sender->Connect(InetSocketAddress(Ipv4Address::GetLoopback(), 5002));
+    Ptr<Socket> receiver = Socket::CreateSocket(node, TcpSocketFactory::GetTypeId());
+    receiver->Bind();
+    receiver->Connect(InetSocketAddress(Ipv4Address::GetLoopback(), 5004));
+
+    Simulator::Schedule(Seconds(1), &CybertwinTxQueueLimitTestCase::EndHostSend, this, sender);
+    Simulator::Stop(Seconds(10));
+    Simulator::Run();
+
+    const uint32_t headerSize = CybertwinPacketHeader().GetSerializedSize();
+    UintegerValue txDrops;
+    twins[0]->GetAttribute("TxDrops", txDrops);
+    NS_TEST_EXPECT_MSG_LT_OR_EQ(m_maxQueueDepth, 3, "Tx queue limit in bytes exceeded");
+    NS_TEST_EXPECT_MSG_EQ(m_delivered,
+                          20 * (1000 + headerSize) + 10000 + headerSize,
+                          "Frames from the end host lost");
+    NS_TEST_EXPECT_MSG_EQ(txDrops.Get(), 0, "Back pressure should not drop");
+
+    transport->Dispose();
+    Simulator::Destroy();
+}
+
+// A peer nobody listens for never answers the handshake: the twin retries a
+// few times, then drops what waited for it and connects again for later frames.
+class CybertwinPeerRetryTestCase : public TestCase
+{
+  public:
+    CybertwinPeerRetryTestCase();
+
+  private:
+    void DoRun() override;
+    void EndHostSend(Ptr<Socket> socket, uint32_t frames);
+    void PeerAccept(Ptr<Socket> socket, const Address& from);
+    void PeerReceived(Ptr<Socket> socket);
+
+    uint32_t m_peerBytes;
+};
+
+CybertwinPeerRetryTestCase::CybertwinPeerRetryTestCase()
+    : TestCase("Cybertwin retries failed peer connections, then drops"),
+      m_peerBytes(0)
+{
+}
+
+void
+CybertwinPeerRetryTestCase::EndHostSend(Ptr<Socket> socket, uint32_t frames)
+{
+    for (uint32_t i = 0; i < frames; i++)
+    {
+        Ptr<Packet> frame = Create<Packet>(1000);
+        frame->AddHeader(CybertwinPacketHeader(1, 2, 1000));
+        socket->Send(frame);
+    }
+}
+
+void
+CybertwinPeerRetryTestCase::PeerAccept(Ptr<Socket> socket, const Address& from)
+{
+    socket->SetRecvCallback(MakeCallback(&CybertwinPeerRetryTestCase::PeerReceived, this));
+}
+
+void
+CybertwinPeerRetryTestCase::PeerReceived(Ptr<Socket> socket)
+{
+    Ptr<Packet> packet;
+    while ((packet = socket->Recv()))
+    {
+        m_peerBytes += packet->GetSize();
+    }
+}
+
+void
+CybertwinPeerRetryTestCase::DoRun()
+{
+    Ptr<Node> node = CreateObject<Node>();
+    InternetStackHelper stack;
+    stack.Install(node);
+
+    Ptr<NameResolutionClient> resolver = CreateObject<NameResolutionClient>();
+    resolver->SetAttribute("ServerAddress", AddressValue(Ipv4Address::GetLoopback()));
+    resolver->SetAttribute("PositiveTtl", TimeValue(Seconds(1000)));
+    resolver->SetNode(node);
+    resolver->Insert(2, Ipv4Address::GetLoopback(), 5999);
+
+    Ptr<Cybertwin> twin = CreateObject<Cybertwin>();
+    twin->SetAttribute("PeerConnectRetries", UintegerValue(2));
+    twin->SetAttribute("PeerRetryInterval", TimeValue(MilliSeconds(100)));
+    twin->SetCybertwinID(1);
+    twin->SetLocalInterface(Ipv4Address::GetLoopback(), 5002);
+    twin->SetGlobalInterface(Ipv4Address::GetLoopback(), 5003);
+    twin->SetNameResolver(resolver);
+    node->AddApplication(twin);
+
+    Ptr<Socket> sender = Socket::CreateSocket(node, TcpSocketFactory::GetTypeId());
+    sender->Bind();
+    sender->Connect(InetSocketAddress(Ipv4Address::GetLoopback(), 5002));
+    Simulator::Schedule(Seconds(1), &CybertwinPeerRetryTestCase::EndHostSend, this, sender, 5);
+
+    // each attempt gives up after its SYN retries, about three minutes, the
+    // peer shows up after the twin gave up on it three times
+    Ptr<Socket> peer = Socket::CreateSocket(node, TcpSocketFactory::GetTypeId());
+    Simulator::Schedule(Seconds(700), [this, peer]() {
+        peer->Bind(InetSocketAddress(Ipv4Address::GetAny(), 5999));
+        peer->Listen();
+        peer->SetAcceptCallback(MakeNullCallback<bool, Ptr<Socket>, const Address&>(),
+                                MakeCallback(&CybertwinPeerRetryTestCase::PeerAccept, this));
+    });
+    Simulator::Schedule(Seconds(701), &CybertwinPeerRetryTestCase::EndHostSend, this, sender, 3);
+    Simulator::Stop(Seconds(710));
+    Simulator::Run();
+
+    const uint32_t frameSize = 1000 + CybertwinPacketHeader().GetSerializedSize();
+    UintegerValue txPackets;
+    UintegerValue txDrops;
+    twin->GetAttribute("TxPackets", txPackets);
+    twin->GetAttribute("TxDrops", txDrops);
+    NS_TEST_EXPECT_MSG_EQ(txDrops.Get(), 5, "Frames for an unreachable peer not dropped");
+    NS_TEST_EXPECT_MSG_EQ(txPackets.Get(), 3, "Frames after the peer came up lost");
+    NS_TEST_EXPECT_MSG_EQ(m_peerBytes, 3 * frameSize, "Peer missed frames");
+
+    Simulator::Destroy();
+}
+
+// Twins connected by a TCP socket each, without an edge transport: the
+// receiving twin queues and counts whole frames, not TCP segments.
+class CybertwinGlobalFramesTestCase : public TestCase
+{
+  public:
+    CybertwinGlobalFramesTestCase();
+
+  private:
+    void DoRun() override;
+    void Delivered(Ptr<const Packet> packet);
+    void EndHostSend(Ptr<Socket> socket);
+
+    std::vector<uint32_t> m_delivered;
+};
+
+CybertwinGlobalFramesTestCase::CybertwinGlobalFramesTestCase()
+    : TestCase("Cybertwin reassembles frames from peer connections")
+{
+}
+
+void
+CybertwinGlobalFramesTestCase::Delivered(Ptr<const Packet> packet)
+{
+    m_delivered.push_back(packet->GetSize());
+}
+
+void
+CybertwinGlobalFramesTestCase::EndHostSend(Ptr<Socket> socket)
+{
+    // sizes that do not line up with the segments
+    for (uint32_t i = 0; i < 20; i++)
+    {
+        Ptr<Packet> frame = Create<Packet>(700 + 100 * i);
+        frame->AddHeader(CybertwinPacketHeader(1, 2, 700 + 100 * i));
+        socket->Send(frame);
+    }
+}
+
+void
+CybertwinGlobalFramesTestCase::DoRun()
+{
+    Ptr<Node> node = CreateObject<Node>();
+    InternetStackHelper stack;
+    stack.Install(node);
+
+    Ptr<NameResolutionClient> resolver = CreateObject<NameResolutionClient>();
+    resolver->SetAttribute("ServerAddress", AddressValue(Ipv4Address::GetLoopback()));
+    resolver->SetAttribute("PositiveTtl", TimeValue(Seconds(1000)));
+    resolver->SetNode(node);
+    resolver->Insert(2, Ipv4Address::GetLoopback(), 5005);
+
+    std::vector<Ptr<Cybertwin>> twins;
+    for (CYBERTWINID_t id : {1, 2})
+    {
+        Ptr<Cybertwin> twin = CreateObject<Cybertwin>();
+        twin->SetCybertwinID(id);
+        twin->SetLocalInterface(Ipv4Address::GetLoopback(), 5000 + 2 * id);
+        twin->SetGlobalInterface(Ipv4Address::GetLoopback(), 5001 + 2 * id);
+        twin->SetNameResolver(resolver);
+        node->AddApplication(twin);
+        twins.push_back(twin);
+    }
+    twins[1]->TraceConnectWithoutContext("Rx", MakeCallback(&CybertwinGlobalFramesTestCase::Delivered, this));
+
+    Ptr<Socket> sender = Socket::CreateSocket(node, TcpSocketFactory::GetTypeId());
+    sender->Bind();
+    sender->Connect(InetSocketAddress(Ipv4Address::GetLoopback(), 5002));
+    Ptr<Socket> receiver = Socket::CreateSocket(node, TcpSocketFactory::GetTypeId());
+    receiver->Bind();
+    receiver->Connect(InetSocketAddress(Ipv4Address::GetLoopback(), 5004));
+
+    Simulator::Schedule(Seconds(1), &CybertwinGlobalFramesTestCase::EndHostSend, this, sender);
+    Simulator::Stop(Seconds(10));
+    Simulator::Run();
+
+    const uint32_t headerSize = CybertwinPacketHeader().GetSerializedSize();
+    UintegerValue rxPackets;
+    UintegerValue rxBytes;
+    twins[1]->GetAttribute("RxPackets", rxPackets);
+    twins[1]->GetAttribute("RxBytes", rxBytes);
+    NS_TEST_ASSERT_MSG_EQ(m_delivered.size(), 20, "Rx traced segments instead of frames");
+    NS_TEST_EXPECT_MSG_EQ(rxPackets.Get(), 20, "RxPackets counted segments instead of frames");
+    uint64_t bytes = 0;
+    for (uint32_t i = 0; i < 20; i++)
+    {
+        NS_TEST_EXPECT_MSG_EQ(m_delivered[i], headerSize + 700 + 100 * i, "Frame " << i << " cut");
+        bytes += m_delivered[i];
+    }
+    NS_TEST_EXPECT_MSG_EQ(rxBytes.Get(), bytes, "Delivered bytes miscounted");
+
+    Simulator::Destroy();
+}
+
 // The TestSuite class names the TestSuite, identifies what type of TestSuite,
 // and enables the TestCases to be run.  Typically, only the constructor for
 // this class must be defined
@@ -60,6 +1763,21 @@ CybertwinTestSuite::CybertwinTestSuite()
 {
     // TestDuration for TestCase can be QUICK, EXTENSIVE or TAKES_FOREVER
     AddTestCase(new CybertwinTestCase1, TestCase::QUICK);
+    AddTestCase(new CybertwinNameResolutionTestCase, TestCase::QUICK);
+    AddTestCase(new CybertwinCnrsHierarchyTestCase, TestCase::QUICK);
+    AddTestCase(new CybertwinCnrsReportTestCase, TestCase::QUICK);
+    AddTestCase(new CybertwinCnrsDatabaseTestCase, TestCase::QUICK);
+    AddTestCase(new CybertwinPortAllocatorTestCase, TestCase::QUICK);
+    AddTestCase(new CybertwinControllerChurnTestCase, TestCase::QUICK);
+    AddTestCase(new CybertwinControllerBoundPortTestCase, TestCase::QUICK);
+    AddTestCase(new CybertwinControllerBatchTestCase, TestCase::QUICK);
+    AddTestCase(new CybertwinEdgeTransportTestCase, TestCase::QUICK);
+    AddTestCase(new CybertwinFrameBufferTestCase, TestCase::QUICK);
+    AddTestCase(new CybertwinShapingTestCase, TestCase::QUICK);
+    AddTestCase(new CybertwinPeerFairnessTestCase, TestCase::QUICK);
+    AddTestCase(new CybertwinTxQueueLimitTestCase, TestCase::QUICK);
+    AddTestCase(new CybertwinPeerRetryTestCase, TestCase::QUICK);
+    AddTestCase(new CybertwinGlobalFramesTestCase, TestCase::QUICK);
 }
 
 // Do not forget to allocate an instance of this TestSuite
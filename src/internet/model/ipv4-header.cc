@@ -19,10 +19,15 @@
 
 #include "ipv4-header.h"
 
+#include "icmpv4.h"
+#include "tcp-header.h"
+#include "udp-header.h"
+
 #include "ns3/abort.h"
 #include "ns3/assert.h"
 #include "ns3/header.h"
 #include "ns3/log.h"
+#include "ns3/packet.h"
 
 namespace ns3
 {
@@ -483,4 +488,48 @@ Ipv4Header::Deserialize(Buffer::Iterator start)
     return GetSerializedSize();
 }
 
+namespace
+{
+
+/**
+ * \ingroup ipv4
+ * Parser of the Ipv4Header, for lazy printing (see Packet::EnableLazyPrinting)
+ */
+class Ipv4HeaderParser
+{
+  public:
+    Ipv4HeaderParser()
+    {
+        Packet::RegisterHeaderParser(Ipv4Header::GetTypeId(),
+                                     MakeCallback(&Ipv4HeaderParser::GetNextHeader));
+    }
+
+    /**
+     * \param [in] header An Ipv4Header.
+     * \returns The type of the header following it.
+     */
+    static TypeId GetNextHeader(const Header& header)
+    {
+        const auto& ipv4 = static_cast<const Ipv4Header&>(header);
+        if (ipv4.GetFragmentOffset() != 0)
+        {
+            // not the first fragment: no transport header
+            return TypeId();
+        }
+        switch (ipv4.GetProtocol())
+        {
+        case 1:
+            return Icmpv4Header::GetTypeId();
+        case 6:
+            return TcpHeader::GetTypeId();
+        case 17:
+            return UdpHeader::GetTypeId();
+        default:
+            return TypeId();
+        }
+    }
+} g_ipv4HeaderParser; ///< the parser of Ipv4Header
+
+} // namespace
+
 } // namespace ns3
@@ -19,10 +19,15 @@
 
 #include "ipv6-header.h"
 
+#include "icmpv6-header.h"
+#include "tcp-header.h"
+#include "udp-header.h"
+
 #include "ns3/address-utils.h"
 #include "ns3/assert.h"
 #include "ns3/header.h"
 #include "ns3/log.h"
+#include "ns3/packet.h"
 
 namespace ns3
 {
@@ -331,4 +336,42 @@ Ipv6Header::EcnTypeToString(EcnType ecn) const
     };
 }
 
+namespace
+{
+
+/**
+ * \ingroup ipv6
+ * Parser of the Ipv6Header, for lazy printing (see Packet::EnableLazyPrinting)
+ */
+class Ipv6HeaderParser
+{
+  public:
+    Ipv6HeaderParser()
+    {
+        Packet::RegisterHeaderParser(Ipv6Header::GetTypeId(),
+                                     MakeCallback(&Ipv6HeaderParser::GetNextHeader));
+    }
+
+    /**
+     * \param [in] header An Ipv6Header.
+     * \returns The type of the header following it, extension headers excepted.
+     */
+    static TypeId GetNextHeader(const Header& header)
+    {
+        switch (static_cast<const Ipv6Header&>(header).GetNextHeader())
+        {
+        case 6:
+            return TcpHeader::GetTypeId();
+        case 17:
+            return UdpHeader::GetTypeId();
+        case 58:
+            return Icmpv6Header::GetTypeId();
+        default:
+            return TypeId();
+        }
+    }
+} g_ipv6HeaderParser; ///< the parser of Ipv6Header
+
+} // namespace
+
 } /* namespace ns3 */
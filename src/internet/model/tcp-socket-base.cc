@@ -1310,6 +1310,11 @@ TcpSocketBase::IsValidTcpSegment(const SequenceNumber32 seq,
 void
 TcpSocketBase::DoForwardUp(Ptr<Packet> packet, const Address& fromAddress, const Address& toAddress)
 {
+    // The application may close the socket from its receive callback, which
+    // deallocates the end point and releases the socket: keep it alive until
+    // the segment is processed (see bug 2211)
+    Ptr<TcpSocketBase> self = this;
+
     // in case the packet still has a priority tag attached, remove it
     SocketPriorityTag priorityTag;
     packet->RemovePacketTag(priorityTag);
@@ -18,7 +18,10 @@
  */
 #include "buffer.h"
 
+#include "packet-allocator.h"
+
 #include "ns3/assert.h"
+#include "ns3/ip-checksum.h"
 #include "ns3/log.h"
 
 #define LOG_INTERNAL_STATE(y)                                                                      \
@@ -54,138 +57,39 @@ namespace ns3
 
 NS_LOG_COMPONENT_DEFINE("Buffer");
 
+#ifdef NS3_MTP
+thread_local uint32_t Buffer::g_recommendedStart = 0;
+thread_local uint32_t Buffer::g_maxSize = 0;
+#else
 uint32_t Buffer::g_recommendedStart = 0;
-#ifdef BUFFER_FREE_LIST
-/* The following macros are pretty evil but they are needed to allow us to
- * keep track of 3 possible states for the g_freeList variable:
- *  - uninitialized means that no one has created a buffer yet
- *    so no one has created the associated free list (it is created
- *    on-demand when the first buffer is created)
- *  - initialized means that the free list exists and is valid
- *  - destroyed means that the static destructors of this compilation unit
- *    have run so, the free list has been cleared from its content
- * The key is that in destroyed state, we are careful not re-create it
- * which is a typical weakness of lazy evaluation schemes which use
- * '0' as a special value to indicate both un-initialized and destroyed.
- * Note that it is important to use '0' as the marker for un-initialized state
- * because the variable holding this state information is initialized to zero
- * which the compiler assigns to zero-memory which is initialized to _zero_
- * before the constructors run so this ensures perfect handling of crazy
- * constructor orderings.
- */
-#define MAGIC_DESTROYED (~(long)0)
-#define IS_UNINITIALIZED(x) (x == (Buffer::FreeList*)0)
-#define IS_DESTROYED(x) (x == (Buffer::FreeList*)MAGIC_DESTROYED)
-#define IS_INITIALIZED(x) (!IS_UNINITIALIZED(x) && !IS_DESTROYED(x))
-#define DESTROYED ((Buffer::FreeList*)MAGIC_DESTROYED)
-#define UNINITIALIZED ((Buffer::FreeList*)0)
 uint32_t Buffer::g_maxSize = 0;
-Buffer::FreeList* Buffer::g_freeList = nullptr;
-struct Buffer::LocalStaticDestructor Buffer::g_localStaticDestructor;
-
-Buffer::LocalStaticDestructor::~LocalStaticDestructor()
-{
-    NS_LOG_FUNCTION(this);
-    if (IS_INITIALIZED(g_freeList))
-    {
-        for (Buffer::FreeList::iterator i = g_freeList->begin(); i != g_freeList->end(); i++)
-        {
-            Buffer::Deallocate(*i);
-        }
-        delete g_freeList;
-        g_freeList = DESTROYED;
-    }
-}
-
+#endif
 void
 Buffer::Recycle(struct Buffer::Data* data)
 {
     NS_LOG_FUNCTION(data);
     NS_ASSERT(data->m_count == 0);
-    NS_ASSERT(!IS_UNINITIALIZED(g_freeList));
-    g_maxSize = std::max(g_maxSize, data->m_size);
-    /* feed into free list */
-    if (data->m_size < g_maxSize || IS_DESTROYED(g_freeList) || g_freeList->size() > 1000)
-    {
-        Buffer::Deallocate(data);
-    }
-    else
+    if (data->m_size <= PacketAllocator::MAX_SIZE / 2)
     {
-        NS_ASSERT(IS_INITIALIZED(g_freeList));
-        g_freeList->push_back(data);
+        g_maxSize = std::max(g_maxSize, data->m_size);
     }
+    PacketAllocator::Deallocate(data, data->m_size - 1 + sizeof(struct Buffer::Data));
 }
 
 Buffer::Data*
-Buffer::Create(uint32_t dataSize)
-{
-    NS_LOG_FUNCTION(dataSize);
-    /* try to find a buffer correctly sized. */
-    if (IS_UNINITIALIZED(g_freeList))
-    {
-        g_freeList = new Buffer::FreeList();
-    }
-    else if (IS_INITIALIZED(g_freeList))
-    {
-        while (!g_freeList->empty())
-        {
-            struct Buffer::Data* data = g_freeList->back();
-            g_freeList->pop_back();
-            if (data->m_size >= dataSize)
-            {
-                data->m_count = 1;
-                return data;
-            }
-            Buffer::Deallocate(data);
-        }
-    }
-    struct Buffer::Data* data = Buffer::Allocate(dataSize);
-    NS_ASSERT(data->m_count == 1);
-    return data;
-}
-#else  /* BUFFER_FREE_LIST */
-void
-Buffer::Recycle(struct Buffer::Data* data)
-{
-    NS_LOG_FUNCTION(data);
-    NS_ASSERT(data->m_count == 0);
-    Deallocate(data);
-}
-
-Buffer::Data*
-Buffer::Create(uint32_t size)
-{
-    NS_LOG_FUNCTION(size);
-    return Allocate(size);
-}
-#endif /* BUFFER_FREE_LIST */
-
-struct Buffer::Data*
-Buffer::Allocate(uint32_t reqSize)
+Buffer::Create(uint32_t reqSize)
 {
     NS_LOG_FUNCTION(reqSize);
-    if (reqSize == 0)
-    {
-        reqSize = 1;
-    }
-    NS_ASSERT(reqSize >= 1);
+    reqSize = std::max(std::max(reqSize, g_maxSize), 1U);
     uint32_t size = reqSize - 1 + sizeof(struct Buffer::Data);
-    uint8_t* b = new uint8_t[size];
-    struct Buffer::Data* data = reinterpret_cast<struct Buffer::Data*>(b);
-    data->m_size = reqSize;
+    void* b = PacketAllocator::Allocate(size);
+    struct Buffer::Data* data = static_cast<struct Buffer::Data*>(b);
+    // the whole block is usable
+    data->m_size = PacketAllocator::GetCapacity(size) + 1 - sizeof(struct Buffer::Data);
     data->m_count = 1;
     return data;
 }
 
-void
-Buffer::Deallocate(struct Buffer::Data* data)
-{
-    NS_LOG_FUNCTION(data);
-    NS_ASSERT(data->m_count == 0);
-    uint8_t* buf = reinterpret_cast<uint8_t*>(data);
-    delete[] buf;
-}
-
 Buffer::Buffer()
 {
     NS_LOG_FUNCTION(this);
@@ -263,8 +167,7 @@ Buffer::operator=(const Buffer& o)
     if (m_data != o.m_data)
     {
         // not assignment to self.
-        m_data->m_count--;
-        if (m_data->m_count == 0)
+        if (--m_data->m_count == 0)
         {
             Recycle(m_data);
         }
@@ -286,8 +189,7 @@ Buffer::~Buffer()
     NS_LOG_FUNCTION(this);
     NS_ASSERT(CheckInternalState());
     g_recommendedStart = std::max(g_recommendedStart, m_maxZeroAreaStart);
-    m_data->m_count--;
-    if (m_data->m_count == 0)
+    if (--m_data->m_count == 0)
     {
         Recycle(m_data);
     }
@@ -312,7 +214,12 @@ Buffer::AddAtStart(uint32_t start)
 {
     NS_LOG_FUNCTION(this << start);
     NS_ASSERT(CheckInternalState());
+#ifdef NS3_MTP
+    // the dirty area of shared data may be extended by another thread
+    bool isDirty = m_data->m_count > 1;
+#else
     bool isDirty = m_data->m_count > 1 && m_start > m_data->m_dirtyStart;
+#endif
     if (m_start >= start && !isDirty)
     {
         /* enough space in the buffer and not dirty.
@@ -330,8 +237,7 @@ Buffer::AddAtStart(uint32_t start)
         uint32_t newSize = GetInternalSize() + start;
         struct Buffer::Data* newData = Buffer::Create(newSize);
         memcpy(newData->m_data + start, m_data->m_data + m_start, GetInternalSize());
-        m_data->m_count--;
-        if (m_data->m_count == 0)
+        if (--m_data->m_count == 0)
         {
             Buffer::Recycle(m_data);
         }
@@ -358,7 +264,11 @@ Buffer::AddAtEnd(uint32_t end)
 {
     NS_LOG_FUNCTION(this << end);
     NS_ASSERT(CheckInternalState());
+#ifdef NS3_MTP
+    bool isDirty = m_data->m_count > 1;
+#else
     bool isDirty = m_data->m_count > 1 && m_end < m_data->m_dirtyEnd;
+#endif
     if (GetInternalEnd() + end <= m_data->m_size && !isDirty)
     {
         /* enough space in buffer and not dirty
@@ -376,8 +286,7 @@ Buffer::AddAtEnd(uint32_t end)
         uint32_t newSize = GetInternalSize() + end;
         struct Buffer::Data* newData = Buffer::Create(newSize);
         memcpy(newData->m_data, m_data->m_data + m_start, GetInternalSize());
-        m_data->m_count--;
-        if (m_data->m_count == 0)
+        if (--m_data->m_count == 0)
         {
             Buffer::Recycle(m_data);
         }
@@ -1145,18 +1054,44 @@ uint16_t
 Buffer::Iterator::CalculateIpChecksum(uint16_t size, uint32_t initialChecksum)
 {
     NS_LOG_FUNCTION(this << size << initialChecksum);
+    NS_ASSERT_MSG(m_current >= m_dataStart && m_current + size <= m_dataEnd,
+                  GetReadErrorMessage());
     /* see RFC 1071 to understand this code. */
-    uint32_t sum = initialChecksum;
-
-    for (int j = 0; j < size / 2; j++)
-    {
-        sum += ReadU16();
-    }
-
-    if (size & 1)
+    uint64_t sum = initialChecksum;
+
+    // Sum the contiguous spans of bytes on either side of the zero area,
+    // which adds nothing.  A range without the zero area is a single span.
+    // A span starting at an odd offset has its words made of the other
+    // bytes, so its sum is byte-swapped (RFC 1071, section 2.B).
+    uint32_t offset = 0;
+    while (offset < size)
     {
-        sum += ReadU8();
+        uint32_t current = m_current + offset;
+        uint32_t length = size - offset;
+        const uint8_t* data;
+        if (current < m_zeroStart)
+        {
+            length = std::min(length, m_zeroStart - current);
+            data = &m_data[current];
+        }
+        else if (current < m_zeroEnd)
+        {
+            offset += std::min(length, m_zeroEnd - current);
+            continue;
+        }
+        else
+        {
+            data = &m_data[current - (m_zeroEnd - m_zeroStart)];
+        }
+        uint16_t partial = OnesComplementSum(data, length);
+        if (offset & 1)
+        {
+            partial = (partial << 8) | (partial >> 8);
+        }
+        sum += partial;
+        offset += length;
     }
+    m_current += size;
 
     while (sum >> 16)
     {
@@ -25,7 +25,9 @@
 #include <stdint.h>
 #include <vector>
 
-#define BUFFER_FREE_LIST 1
+#ifdef NS3_MTP
+#include <atomic>
+#endif
 
 namespace ns3
 {
@@ -369,6 +371,10 @@ class Buffer
          * \param size size of the buffer.
          * \param initialChecksum initial value
          * \return checksum
+         *
+         * The bytes on either side of the zero area are summed a span at a
+         * time with OnesComplementSum, and the zero area is skipped.  The
+         * iterator is advanced by \p size bytes.
          */
         uint16_t CalculateIpChecksum(uint16_t size, uint32_t initialChecksum);
 
@@ -665,7 +671,11 @@ class Buffer
          * The reference count of an instance of this data structure.
          * Each buffer which references an instance holds a count.
          */
+#ifdef NS3_MTP
+        std::atomic<uint32_t> m_count;
+#else
         uint32_t m_count;
+#endif
         /**
          * the size of the m_data field below.
          */
@@ -729,27 +739,16 @@ class Buffer
     uint32_t GetInternalEnd() const;
 
     /**
-     * \brief Recycle the buffer memory
+     * \brief Recycle the buffer memory into the PacketAllocator
      * \param data the buffer data storage
      */
     static void Recycle(struct Buffer::Data* data);
     /**
-     * \brief Create a buffer data storage
-     * \param size the storage size to create
+     * \brief Create a buffer data storage from the PacketAllocator
+     * \param size the storage size to create; the storage can be larger
      * \returns a pointer to the created buffer storage
      */
     static struct Buffer::Data* Create(uint32_t size);
-    /**
-     * \brief Allocate a buffer data storage
-     * \param reqSize the storage size to create
-     * \returns a pointer to the allocated buffer storage
-     */
-    static struct Buffer::Data* Allocate(uint32_t reqSize);
-    /**
-     * \brief Deallocate the buffer memory
-     * \param data the buffer data storage
-     */
-    static void Deallocate(struct Buffer::Data* data);
 
     struct Data* m_data; //!< the buffer data storage
 
@@ -769,7 +768,21 @@ class Buffer
      * writing data. i.e., m_start should be initialized to this
      * value.
      */
+#ifdef NS3_MTP
+    static thread_local uint32_t g_recommendedStart;
+#else
     static uint32_t g_recommendedStart;
+#endif
+    /**
+     * maximum size of the buffer data storages recycled so far: new
+     * storages are at least this large, so that they usually have room
+     * for the headers and trailers added later.
+     */
+#ifdef NS3_MTP
+    static thread_local uint32_t g_maxSize;
+#else
+    static uint32_t g_maxSize;
+#endif
 
     /**
      * offset to the start of the virtual zero area from the start
@@ -791,21 +804,6 @@ class Buffer
      * instance from the start of m_data->m_data
      */
     uint32_t m_end;
-
-#ifdef BUFFER_FREE_LIST
-    /// Container for buffer data
-    typedef std::vector<struct Buffer::Data*> FreeList;
-
-    /// Local static destructor structure
-    struct LocalStaticDestructor
-    {
-        ~LocalStaticDestructor();
-    };
-
-    static uint32_t g_maxSize;                                   //!< Max observed data size
-    static FreeList* g_freeList;                                 //!< Buffer data container
-    static struct LocalStaticDestructor g_localStaticDestructor; //!< Local static destructor
-#endif
 };
 
 } // namespace ns3
@@ -18,14 +18,17 @@
  */
 #include "byte-tag-list.h"
 
+#include "packet-allocator.h"
+
 #include "ns3/log.h"
 
 #include <cstring>
 #include <limits>
 #include <vector>
 
-#define USE_FREE_LIST 1
-#define FREE_LIST_SIZE 1000
+#ifdef NS3_MTP
+#include <atomic>
+#endif
 #define OFFSET_MAX (std::numeric_limits<int32_t>::max())
 
 namespace ns3
@@ -43,38 +46,15 @@ NS_LOG_COMPONENT_DEFINE("ByteTagList");
 struct ByteTagListData
 {
     uint32_t size;   //!< size of the data
+#ifdef NS3_MTP
+    std::atomic<uint32_t> count; //!< use counter (for smart deallocation)
+#else
     uint32_t count;  //!< use counter (for smart deallocation)
+#endif
     uint32_t dirty;  //!< number of bytes actually in use
     uint8_t data[4]; //!< data
 };
 
-#ifdef USE_FREE_LIST
-/**
- * \ingroup packet
- *
- * \brief Container class for struct ByteTagListData
- *
- * Internal use only.
- */
-static class ByteTagListDataFreeList : public std::vector<struct ByteTagListData*>
-{
-  public:
-    ~ByteTagListDataFreeList();
-} g_freeList; //!< Container for struct ByteTagListData
-
-static uint32_t g_maxSize = 0; //!< maximum data size (used for allocation)
-
-ByteTagListDataFreeList::~ByteTagListDataFreeList()
-{
-    NS_LOG_FUNCTION(this);
-    for (ByteTagListDataFreeList::iterator i = begin(); i != end(); i++)
-    {
-        uint8_t* buffer = (uint8_t*)(*i);
-        delete[] buffer;
-    }
-}
-#endif /* USE_FREE_LIST */
-
 ByteTagList::Iterator::Item::Item(TagBuffer buf_)
     : buf(buf_)
 {
@@ -211,7 +191,12 @@ ByteTagList::Add(TypeId tid, uint32_t bufferSize, int32_t start, int32_t end)
         m_data = Allocate(spaceNeeded);
         m_used = 0;
     }
+#ifdef NS3_MTP
+    // the dirty end of shared data may be moved by another thread
+    else if (m_data->size < spaceNeeded || m_data->count != 1)
+#else
     else if (m_data->size < spaceNeeded || (m_data->count != 1 && m_data->dirty != m_used))
+#endif
     {
         struct ByteTagListData* newData = Allocate(spaceNeeded);
         std::memcpy(&newData->data, &m_data->data, m_used);
@@ -349,30 +334,16 @@ ByteTagList::AddAtStart(int32_t prependOffset)
     *this = list;
 }
 
-#ifdef USE_FREE_LIST
-
 struct ByteTagListData*
 ByteTagList::Allocate(uint32_t size)
 {
     NS_LOG_FUNCTION(this << size);
-    while (!g_freeList.empty())
-    {
-        struct ByteTagListData* data = g_freeList.back();
-        g_freeList.pop_back();
-        NS_ASSERT(data != nullptr);
-        if (data->size >= size)
-        {
-            data->count = 1;
-            data->dirty = 0;
-            return data;
-        }
-        uint8_t* buffer = (uint8_t*)data;
-        delete[] buffer;
-    }
-    uint8_t* buffer = new uint8_t[std::max(size, g_maxSize) + sizeof(struct ByteTagListData) - 4];
-    struct ByteTagListData* data = (struct ByteTagListData*)buffer;
+    std::size_t bytes = size + sizeof(struct ByteTagListData) - 4;
+    struct ByteTagListData* data =
+        static_cast<struct ByteTagListData*>(PacketAllocator::Allocate(bytes));
     data->count = 1;
-    data->size = size;
+    // the whole block is usable
+    data->size = PacketAllocator::GetCapacity(bytes) - sizeof(struct ByteTagListData) + 4;
     data->dirty = 0;
     return data;
 }
@@ -385,54 +356,12 @@ ByteTagList::Deallocate(struct ByteTagListData* data)
     {
         return;
     }
-    g_maxSize = std::max(g_maxSize, data->size);
-    data->count--;
-    if (data->count == 0)
+    if (--data->count == 0)
     {
-        if (g_freeList.size() > FREE_LIST_SIZE || data->size < g_maxSize)
-        {
-            uint8_t* buffer = (uint8_t*)data;
-            delete[] buffer;
-        }
-        else
-        {
-            g_freeList.push_back(data);
-        }
+        PacketAllocator::Deallocate(data, data->size + sizeof(struct ByteTagListData) - 4);
     }
 }
 
-#else /* USE_FREE_LIST */
-
-struct ByteTagListData*
-ByteTagList::Allocate(uint32_t size)
-{
-    NS_LOG_FUNCTION(this << size);
-    uint8_t* buffer = new uint8_t[size + sizeof(struct ByteTagListData) - 4];
-    struct ByteTagListData* data = (struct ByteTagListData*)buffer;
-    data->count = 1;
-    data->size = size;
-    data->dirty = 0;
-    return data;
-}
-
-void
-ByteTagList::Deallocate(struct ByteTagListData* data)
-{
-    NS_LOG_FUNCTION(this << data);
-    if (data == 0)
-    {
-        return;
-    }
-    data->count--;
-    if (data->count == 0)
-    {
-        uint8_t* buffer = (uint8_t*)data;
-        delete[] buffer;
-    }
-}
-
-#endif /* USE_FREE_LIST */
-
 uint32_t
 ByteTagList::GetSerializedSize() const
 {
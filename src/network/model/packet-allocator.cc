@@ -0,0 +1,395 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "packet-allocator.h"
+
+#include "ns3/assert.h"
+#include "ns3/log.h"
+
+#include <algorithm>
+#include <atomic>
+#include <list>
+#include <mutex>
+#include <new>
+#include <vector>
+
+/**
+ * \file
+ * \ingroup packet
+ * ns3::PacketAllocator implementation.
+ */
+
+namespace ns3
+{
+
+NS_LOG_COMPONENT_DEFINE("PacketAllocator");
+
+namespace
+{
+
+/** A free block, linked to the next one. */
+struct FreeBlock
+{
+    FreeBlock* next; //!< The next free block.
+};
+
+/** The free blocks of a size class in a thread cache. */
+struct ThreadClass
+{
+    FreeBlock* head;                        //!< The first free block.
+    uint32_t count;                         //!< The number of free blocks.
+    std::atomic<uint64_t> allocations;      //!< Blocks allocated by the thread.
+    std::atomic<uint64_t> deallocations;    //!< Blocks deallocated by the thread.
+};
+
+/** The cache of free blocks of a thread. */
+struct ThreadCache
+{
+    ThreadClass classes[PacketAllocator::N_CLASSES]; //!< The size classes.
+    bool registered; //!< Whether the depot knows the cache.
+    bool exited;     //!< Whether the thread exit flushed the cache.
+};
+
+/**
+ * The cache of the calling thread.
+ *
+ * Trivially constructible and destructible, so that it needs no guard,
+ * and stays usable by the destructors run after the thread exit flushed it.
+ */
+thread_local ThreadCache g_cache;
+
+/** A list of free blocks of one size class. */
+struct Chain
+{
+    FreeBlock* head; //!< The first block.
+    uint32_t count;  //!< The number of blocks.
+};
+
+/** The free blocks and statistics shared by the threads. */
+struct Depot
+{
+    std::mutex mutex;                                          //!< Protects the depot.
+    std::vector<Chain> chains[PacketAllocator::N_CLASSES];     //!< The free blocks.
+    std::vector<void*> slabs;                                  //!< All the slabs.
+    PacketAllocator::Stats stats[PacketAllocator::N_CLASSES];  //!< Slabs, and counts of the
+                                                               //!< exited threads.
+    std::list<ThreadCache*> caches;                            //!< Caches of running threads.
+    std::atomic<uint64_t> largeAllocations{0};                 //!< Large allocations.
+};
+
+/**
+ * \returns The depot, never destroyed since packets are released by
+ * static destructors.
+ */
+Depot&
+GetDepot()
+{
+    static Depot* depot = new Depot();
+    return *depot;
+}
+
+/**
+ * \param [in] sizeClass A size class index.
+ * \returns The size of the blocks of the class: 32, then 1.5 * 2^k and 2^(k + 1).
+ */
+constexpr std::size_t
+ClassSize(std::size_t sizeClass)
+{
+    return sizeClass == 0        ? 32
+           : sizeClass % 2 == 1 ? std::size_t(3) << ((sizeClass - 1) / 2 + 4)
+                                : std::size_t(1) << ((sizeClass - 1) / 2 + 6);
+}
+
+/** The sizes and batches of the size classes. */
+struct ClassTable
+{
+    std::size_t sizes[PacketAllocator::N_CLASSES]; //!< The sizes of the blocks.
+    /** The number of blocks moved at once between a thread cache and the depot. */
+    uint32_t batches[PacketAllocator::N_CLASSES];
+};
+
+/** \returns The sizes and batches of the size classes. */
+constexpr ClassTable
+MakeClassTable()
+{
+    ClassTable table{};
+    for (std::size_t c = 0; c < PacketAllocator::N_CLASSES; c++)
+    {
+        table.sizes[c] = ClassSize(c);
+        std::size_t batch = 32768 / table.sizes[c];
+        table.batches[c] = static_cast<uint32_t>(batch < 4 ? 4 : batch > 64 ? 64 : batch);
+    }
+    return table;
+}
+
+/** The sizes and batches of the size classes. */
+constexpr ClassTable g_classes = MakeClassTable();
+
+static_assert(ClassSize(PacketAllocator::N_CLASSES - 1) == PacketAllocator::MAX_SIZE,
+              "The largest size class must be MAX_SIZE");
+
+/**
+ * Increment a counter only written by the calling thread.
+ * \param [in,out] counter The counter.
+ */
+inline void
+Bump(std::atomic<uint64_t>& counter)
+{
+    counter.store(counter.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+}
+
+/** Give the blocks of the thread cache back to the depot when the thread exits. */
+struct CacheOwner
+{
+    ~CacheOwner()
+    {
+        Depot& depot = GetDepot();
+        std::lock_guard<std::mutex> lock(depot.mutex);
+        for (std::size_t c = 0; c < PacketAllocator::N_CLASSES; c++)
+        {
+            ThreadClass& tc = g_cache.classes[c];
+            if (tc.count > 0)
+            {
+                depot.chains[c].push_back({tc.head, tc.count});
+                tc.head = nullptr;
+                tc.count = 0;
+            }
+            depot.stats[c].allocations += tc.allocations.load(std::memory_order_relaxed);
+            depot.stats[c].deallocations += tc.deallocations.load(std::memory_order_relaxed);
+            tc.allocations.store(0, std::memory_order_relaxed);
+            tc.deallocations.store(0, std::memory_order_relaxed);
+        }
+        depot.caches.remove(&g_cache);
+        g_cache.registered = false;
+        g_cache.exited = true;
+    }
+};
+
+/**
+ * Make the depot know the cache of the calling thread, on its first
+ * exchange with the depot.
+ * \param [in] depot The depot, locked.
+ */
+void
+Register(Depot& depot)
+{
+    if (g_cache.registered || g_cache.exited)
+    {
+        return;
+    }
+    static thread_local CacheOwner owner;
+    (void)owner;
+    depot.caches.push_back(&g_cache);
+    g_cache.registered = true;
+}
+
+} // unnamed namespace
+
+std::size_t
+PacketAllocator::GetSizeClass(std::size_t size)
+{
+    if (size <= 32)
+    {
+        return 0;
+    }
+    // with 2^b <= size - 1 < 2^(b + 1), the classes 1.5 * 2^b and 2^(b + 1)
+    uint64_t n = size - 1;
+#if defined(__GNUC__)
+    std::size_t b = 63 - __builtin_clzll(n);
+#else
+    std::size_t b = 0;
+    while ((n >> (b + 1)) != 0)
+    {
+        b++;
+    }
+#endif
+    return 2 * (b - 5) + (n < (uint64_t(3) << (b - 1)) ? 1 : 2);
+}
+
+std::size_t
+PacketAllocator::GetClassSize(std::size_t sizeClass)
+{
+    return g_classes.sizes[sizeClass];
+}
+
+std::size_t
+PacketAllocator::GetCapacity(std::size_t size)
+{
+    if (size > MAX_SIZE)
+    {
+        return size;
+    }
+    return GetClassSize(GetSizeClass(size));
+}
+
+void*
+PacketAllocator::Allocate(std::size_t size)
+{
+    if (size > MAX_SIZE)
+    {
+        GetDepot().largeAllocations.fetch_add(1, std::memory_order_relaxed);
+        return ::operator new(size);
+    }
+    std::size_t c = GetSizeClass(size);
+    ThreadClass& tc = g_cache.classes[c];
+    Bump(tc.allocations);
+    FreeBlock* block = tc.head;
+    if (block == nullptr)
+    {
+        return Refill(c);
+    }
+    tc.head = block->next;
+    tc.count--;
+    return block;
+}
+
+void
+PacketAllocator::Deallocate(void* p, std::size_t size)
+{
+    if (size > MAX_SIZE)
+    {
+        ::operator delete(p);
+        return;
+    }
+    std::size_t c = GetSizeClass(size);
+    ThreadClass& tc = g_cache.classes[c];
+    Bump(tc.deallocations);
+    FreeBlock* block = static_cast<FreeBlock*>(p);
+    block->next = tc.head;
+    tc.head = block;
+    if (++tc.count > 2 * g_classes.batches[c])
+    {
+        Spill(c);
+    }
+}
+
+void*
+PacketAllocator::Refill(std::size_t sizeClass)
+{
+    ThreadClass& tc = g_cache.classes[sizeClass];
+    NS_ASSERT(tc.count == 0);
+    Depot& depot = GetDepot();
+    std::lock_guard<std::mutex> lock(depot.mutex);
+    Register(depot);
+    std::vector<Chain>& chains = depot.chains[sizeClass];
+    if (chains.empty())
+    {
+        // carve a new slab into chains of a batch
+        std::size_t size = g_classes.sizes[sizeClass];
+        uint32_t batch = g_classes.batches[sizeClass];
+        std::size_t n = std::max<std::size_t>(65536 / size, batch);
+        uint8_t* slab = static_cast<uint8_t*>(::operator new(n * size));
+        NS_LOG_LOGIC("new slab of " << n << " blocks of " << size << " bytes");
+        depot.slabs.push_back(slab);
+        depot.stats[sizeClass].slabs++;
+        depot.stats[sizeClass].slabBytes += n * size;
+        for (std::size_t i = 0; i < n; i += batch)
+        {
+            std::size_t end = std::min<std::size_t>(i + batch, n);
+            for (std::size_t j = i; j < end; j++)
+            {
+                reinterpret_cast<FreeBlock*>(slab + j * size)->next =
+                    j + 1 < end ? reinterpret_cast<FreeBlock*>(slab + (j + 1) * size) : nullptr;
+            }
+            chains.push_back({reinterpret_cast<FreeBlock*>(slab + i * size),
+                              static_cast<uint32_t>(end - i)});
+        }
+    }
+    Chain chain = chains.back();
+    chains.pop_back();
+    tc.head = chain.head->next;
+    tc.count = chain.count - 1;
+    return chain.head;
+}
+
+void
+PacketAllocator::Spill(std::size_t sizeClass)
+{
+    ThreadClass& tc = g_cache.classes[sizeClass];
+    uint32_t batch = g_classes.batches[sizeClass];
+    FreeBlock* head = tc.head;
+    FreeBlock* last = head;
+    for (uint32_t i = 1; i < batch; i++)
+    {
+        last = last->next;
+    }
+    tc.head = last->next;
+    tc.count -= batch;
+    last->next = nullptr;
+    Depot& depot = GetDepot();
+    std::lock_guard<std::mutex> lock(depot.mutex);
+    Register(depot);
+    depot.chains[sizeClass].push_back({head, batch});
+}
+
+PacketAllocator::Stats
+PacketAllocator::GetStats(std::size_t sizeClass)
+{
+    NS_ASSERT(sizeClass < N_CLASSES);
+    Depot& depot = GetDepot();
+    std::lock_guard<std::mutex> lock(depot.mutex);
+    Stats stats = depot.stats[sizeClass];
+    for (ThreadCache* cache : depot.caches)
+    {
+        const ThreadClass& tc = cache->classes[sizeClass];
+        stats.allocations += tc.allocations.load(std::memory_order_relaxed);
+        stats.deallocations += tc.deallocations.load(std::memory_order_relaxed);
+    }
+    if (!g_cache.registered)
+    {
+        // the calling thread did not exchange blocks with the depot yet
+        const ThreadClass& tc = g_cache.classes[sizeClass];
+        stats.allocations += tc.allocations.load(std::memory_order_relaxed);
+        stats.deallocations += tc.deallocations.load(std::memory_order_relaxed);
+    }
+    stats.largeAllocations = 0;
+    return stats;
+}
+
+PacketAllocator::Stats
+PacketAllocator::GetStats()
+{
+    Stats total = {0, 0, 0, 0, 0};
+    for (std::size_t c = 0; c < N_CLASSES; c++)
+    {
+        Stats stats = GetStats(c);
+        total.allocations += stats.allocations;
+        total.deallocations += stats.deallocations;
+        total.slabs += stats.slabs;
+        total.slabBytes += stats.slabBytes;
+    }
+    total.largeAllocations = GetDepot().largeAllocations.load(std::memory_order_relaxed);
+    return total;
+}
+
+void
+PacketAllocator::PrintStats(std::ostream& os)
+{
+    os << "size allocations deallocations slabs slabBytes" << std::endl;
+    for (std::size_t c = 0; c < N_CLASSES; c++)
+    {
+        Stats stats = GetStats(c);
+        if (stats.allocations == 0 && stats.slabs == 0)
+        {
+            continue;
+        }
+        os << GetClassSize(c) << " " << stats.allocations << " " << stats.deallocations << " "
+           << stats.slabs << " " << stats.slabBytes << std::endl;
+    }
+    os << "large allocations " << GetDepot().largeAllocations.load(std::memory_order_relaxed)
+       << std::endl;
+}
+
+} // namespace ns3
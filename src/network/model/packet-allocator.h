@@ -0,0 +1,131 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef PACKET_ALLOCATOR_H
+#define PACKET_ALLOCATOR_H
+
+#include <cstddef>
+#include <ostream>
+#include <stdint.h>
+
+/**
+ * \file
+ * \ingroup packet
+ * ns3::PacketAllocator declaration.
+ */
+
+namespace ns3
+{
+
+/**
+ * \ingroup packet
+ *
+ * \brief Memory of the packets and of their buffers, metadata and tags.
+ *
+ * The blocks are sorted into size classes, two per power of two from
+ * 32 bytes to 64 KiB. Each thread keeps a cache of free blocks per size
+ * class, exchanged with a global depot in batches, and the depot carves
+ * new blocks from slabs taken from the system. The slabs are never given
+ * back: in steady state, creating, copying and destroying packets does
+ * not call the system allocator. Larger blocks come from the system.
+ *
+ * A block can be deallocated by any thread.
+ */
+class PacketAllocator
+{
+  public:
+    /** Allocation statistics. */
+    struct Stats
+    {
+        uint64_t allocations;      //!< Number of blocks allocated.
+        uint64_t deallocations;    //!< Number of blocks deallocated.
+        uint64_t slabs;            //!< Number of slabs taken from the system.
+        uint64_t slabBytes;        //!< Size of the slabs, in bytes.
+        uint64_t largeAllocations; //!< Number of blocks larger than the size classes.
+    };
+
+    /** Number of size classes. */
+    static constexpr std::size_t N_CLASSES = 23;
+    /** Size of the largest size class, in bytes. */
+    static constexpr std::size_t MAX_SIZE = 65536;
+
+    /**
+     * Allocate a block.
+     * \param [in] size The size of the block, in bytes.
+     * \returns The block, of GetCapacity() bytes.
+     */
+    static void* Allocate(std::size_t size);
+
+    /**
+     * Deallocate a block.
+     * \param [in] p The block.
+     * \param [in] size The size given to Allocate(), or the capacity of the block.
+     */
+    static void Deallocate(void* p, std::size_t size);
+
+    /**
+     * \param [in] size The size of a block.
+     * \returns The number of bytes of the block allocated for \p size,
+     * which can all be used.
+     */
+    static std::size_t GetCapacity(std::size_t size);
+
+    /**
+     * \returns The statistics of all the threads, since the start of the program.
+     */
+    static Stats GetStats();
+
+    /**
+     * \param [in] sizeClass The size class index, less than N_CLASSES.
+     * \returns The statistics of the size class, without large allocations.
+     */
+    static Stats GetStats(std::size_t sizeClass);
+
+    /**
+     * Print the statistics of the size classes used so far.
+     * \param [in] os The output stream.
+     */
+    static void PrintStats(std::ostream& os);
+
+  private:
+    /**
+     * \param [in] size The size of a block, at most MAX_SIZE.
+     * \returns The index of its size class.
+     */
+    static std::size_t GetSizeClass(std::size_t size);
+
+    /**
+     * \param [in] sizeClass A size class index.
+     * \returns The size of the blocks of the class.
+     */
+    static std::size_t GetClassSize(std::size_t sizeClass);
+
+    /**
+     * Refill an empty thread cache.
+     * \param [in] sizeClass The size class.
+     * \returns A block.
+     */
+    static void* Refill(std::size_t sizeClass);
+
+    /**
+     * Give half of a full thread cache back to the depot.
+     * \param [in] sizeClass The size class.
+     */
+    static void Spill(std::size_t sizeClass);
+};
+
+} // namespace ns3
+
+#endif /* PACKET_ALLOCATOR_H */
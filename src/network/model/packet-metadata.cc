@@ -20,12 +20,14 @@
 
 #include "buffer.h"
 #include "header.h"
+#include "packet-allocator.h"
 #include "trailer.h"
 
 #include "ns3/assert.h"
 #include "ns3/fatal-error.h"
 #include "ns3/log.h"
 
+#include <algorithm>
 #include <list>
 #include <utility>
 
@@ -37,19 +39,13 @@ NS_LOG_COMPONENT_DEFINE("PacketMetadata");
 bool PacketMetadata::m_enable = false;
 bool PacketMetadata::m_enableChecking = false;
 bool PacketMetadata::m_metadataSkipped = false;
+#ifdef NS3_MTP
+thread_local uint32_t PacketMetadata::m_maxSize = 0;
+std::atomic<uint16_t> PacketMetadata::m_chunkUid = 0;
+#else
 uint32_t PacketMetadata::m_maxSize = 0;
 uint16_t PacketMetadata::m_chunkUid = 0;
-PacketMetadata::DataFreeList PacketMetadata::m_freeList;
-
-PacketMetadata::DataFreeList::~DataFreeList()
-{
-    NS_LOG_FUNCTION(this);
-    for (iterator i = begin(); i != end(); i++)
-    {
-        PacketMetadata::Deallocate(*i);
-    }
-    PacketMetadata::m_enable = false;
-}
+#endif
 
 void
 PacketMetadata::Enable()
@@ -80,8 +76,7 @@ PacketMetadata::ReserveCopy(uint32_t size)
     struct PacketMetadata::Data* newData = PacketMetadata::Create(m_used + size);
     memcpy(newData->m_data, m_data->m_data, m_used);
     newData->m_dirtyEnd = m_used;
-    m_data->m_count--;
-    if (m_data->m_count == 0)
+    if (--m_data->m_count == 0)
     {
         PacketMetadata::Recycle(m_data);
     }
@@ -104,8 +99,13 @@ PacketMetadata::Reserve(uint32_t size)
 {
     NS_LOG_FUNCTION(this << size);
     NS_ASSERT(m_data != nullptr);
+#ifdef NS3_MTP
+    // the dirty end of shared data may be moved by another thread
+    if (m_data->m_size >= m_used + size && (m_head == 0xffff || m_data->m_count == 1))
+#else
     if (m_data->m_size >= m_used + size &&
         (m_head == 0xffff || m_data->m_count == 1 || m_data->m_dirtyEnd == m_used))
+#endif
     {
         /* enough room, not dirty. */
     }
@@ -384,8 +384,12 @@ PacketMetadata::AddSmall(const struct PacketMetadata::SmallItem* item)
     uint32_t typeUidSize = GetUleb128Size(item->typeUid);
     uint32_t sizeSize = GetUleb128Size(item->size);
     uint32_t n = 2 + 2 + typeUidSize + sizeSize + 2;
+#ifdef NS3_MTP
+    if (m_used + n > m_data->m_size || (m_head != 0xffff && m_data->m_count != 1))
+#else
     if (m_used + n > m_data->m_size ||
         (m_head != 0xffff && m_data->m_count != 1 && m_used != m_data->m_dirtyEnd))
+#endif
     {
         ReserveCopy(n);
     }
@@ -421,8 +425,12 @@ PacketMetadata::AddBig(uint32_t next,
     uint32_t fragEndSize = GetUleb128Size(extraItem->fragmentEnd);
     uint32_t n = 2 + 2 + typeUidSize + sizeSize + 2 + fragStartSize + fragEndSize + 4;
 
+#ifdef NS3_MTP
+    if (m_used + n > m_data->m_size || (m_head != 0xffff && m_data->m_count != 1))
+#else
     if (m_used + n > m_data->m_size ||
         (m_head != 0xffff && m_data->m_count != 1 && m_used != m_data->m_dirtyEnd))
+#endif
     {
         ReserveCopy(n);
     }
@@ -572,68 +580,27 @@ PacketMetadata::Create(uint32_t size)
     {
         m_maxSize = size;
     }
-    while (!m_freeList.empty())
-    {
-        struct PacketMetadata::Data* data = m_freeList.back();
-        m_freeList.pop_back();
-        if (data->m_size >= size)
-        {
-            NS_LOG_LOGIC("create found size=" << data->m_size);
-            data->m_count = 1;
-            return data;
-        }
-        NS_LOG_LOGIC("create dealloc size=" << data->m_size);
-        PacketMetadata::Deallocate(data);
-    }
-    NS_LOG_LOGIC("create alloc size=" << m_maxSize);
-    return PacketMetadata::Allocate(m_maxSize);
-}
-
-void
-PacketMetadata::Recycle(struct PacketMetadata::Data* data)
-{
-    NS_LOG_FUNCTION(data);
-    if (!m_enable)
-    {
-        PacketMetadata::Deallocate(data);
-        return;
-    }
-    NS_LOG_LOGIC("recycle size=" << data->m_size << ", list=" << m_freeList.size());
-    NS_ASSERT(data->m_count == 0);
-    if (m_freeList.size() > 1000 || data->m_size < m_maxSize)
-    {
-        PacketMetadata::Deallocate(data);
-    }
-    else
-    {
-        m_freeList.push_back(data);
-    }
-}
-
-struct PacketMetadata::Data*
-PacketMetadata::Allocate(uint32_t n)
-{
-    NS_LOG_FUNCTION(n);
-    uint32_t size = sizeof(struct Data);
-    if (n <= PACKET_METADATA_DATA_M_DATA_SIZE)
-    {
-        n = PACKET_METADATA_DATA_M_DATA_SIZE;
-    }
-    size += n - PACKET_METADATA_DATA_M_DATA_SIZE;
-    uint8_t* buf = new uint8_t[size];
-    struct PacketMetadata::Data* data = (struct PacketMetadata::Data*)buf;
-    data->m_size = n;
+    // the largest size seen so far, so that the storage can grow in place
+    uint32_t n = std::max<uint32_t>(m_maxSize, PACKET_METADATA_DATA_M_DATA_SIZE);
+    uint32_t bytes = sizeof(struct Data) + n - PACKET_METADATA_DATA_M_DATA_SIZE;
+    struct PacketMetadata::Data* data =
+        static_cast<struct PacketMetadata::Data*>(PacketAllocator::Allocate(bytes));
+    // the whole block is usable
+    data->m_size = PacketAllocator::GetCapacity(bytes) - sizeof(struct Data) +
+                   PACKET_METADATA_DATA_M_DATA_SIZE;
     data->m_count = 1;
     data->m_dirtyEnd = 0;
     return data;
 }
 
 void
-PacketMetadata::Deallocate(struct PacketMetadata::Data* data)
+PacketMetadata::Recycle(struct PacketMetadata::Data* data)
 {
     NS_LOG_FUNCTION(data);
-    uint8_t* buf = (uint8_t*)data;
-    delete[] buf;
+    NS_ASSERT(data->m_count == 0);
+    PacketAllocator::Deallocate(data,
+                                sizeof(struct Data) + data->m_size -
+                                    PACKET_METADATA_DATA_M_DATA_SIZE);
 }
 
 PacketMetadata
@@ -671,8 +638,7 @@ PacketMetadata::DoAddHeader(uint32_t uid, uint32_t size)
     item.prev = 0xffff;
     item.typeUid = uid;
     item.size = size;
-    item.chunkUid = m_chunkUid;
-    m_chunkUid++;
+    item.chunkUid = m_chunkUid++;
     uint16_t written = AddSmall(&item);
     UpdateHead(written);
 }
@@ -739,8 +705,7 @@ PacketMetadata::AddTrailer(const Trailer& trailer, uint32_t size)
     item.prev = m_tail;
     item.typeUid = uid;
     item.size = size;
-    item.chunkUid = m_chunkUid;
-    m_chunkUid++;
+    item.chunkUid = m_chunkUid++;
     uint16_t written = AddSmall(&item);
     UpdateTail(written);
     NS_ASSERT(IsStateOk());
@@ -29,6 +29,10 @@
 #include <stdint.h>
 #include <vector>
 
+#ifdef NS3_MTP
+#include <atomic>
+#endif
+
 namespace ns3
 {
 
@@ -421,7 +425,11 @@ class PacketMetadata
     struct Data
     {
         /** number of references to this struct Data instance. */
+#ifdef NS3_MTP
+        std::atomic<uint32_t> m_count;
+#else
         uint32_t m_count;
+#endif
         /** size (in bytes) of m_data buffer below */
         uint16_t m_size;
         /** max of the m_used field over all objects which reference this struct Data instance */
@@ -504,16 +512,6 @@ class PacketMetadata
         uint64_t packetUid;
     };
 
-    /**
-     * \brief Class to hold all the metadata
-     */
-    class DataFreeList : public std::vector<struct Data*>
-    {
-      public:
-        ~DataFreeList();
-    };
-
-    friend DataFreeList::~DataFreeList();
     /// Friend class
     friend class ItemIterator;
 
@@ -648,29 +646,17 @@ class PacketMetadata
     bool IsSharedPointerOk(uint16_t pointer) const;
 
     /**
-     * \brief Recycle the buffer memory
+     * \brief Recycle the buffer memory into the PacketAllocator
      * \param data the buffer data storage
      */
     static void Recycle(struct PacketMetadata::Data* data);
     /**
-     * \brief Create a buffer data storage
-     * \param size the storage size to create
+     * \brief Create a buffer data storage from the PacketAllocator
+     * \param size the storage size to create; the storage can be larger
      * \returns a pointer to the created buffer storage
      */
     static struct PacketMetadata::Data* Create(uint32_t size);
-    /**
-     * \brief Allocate a buffer data storage
-     * \param n the storage size to create
-     * \returns a pointer to the allocated buffer storage
-     */
-    static struct PacketMetadata::Data* Allocate(uint32_t n);
-    /**
-     * \brief Deallocate the buffer memory
-     * \param data the buffer data storage
-     */
-    static void Deallocate(struct PacketMetadata::Data* data);
 
-    static DataFreeList m_freeList; //!< the metadata data storage
     static bool m_enable;           //!< Enable the packet metadata
     static bool m_enableChecking;   //!< Enable the packet metadata checking
 
@@ -681,8 +667,13 @@ class PacketMetadata
      */
     static bool m_metadataSkipped;
 
+#ifdef NS3_MTP
+    static thread_local uint32_t m_maxSize; //!< maximum metadata size
+    static std::atomic<uint16_t> m_chunkUid; //!< Chunk Uid
+#else
     static uint32_t m_maxSize;  //!< maximum metadata size
     static uint16_t m_chunkUid; //!< Chunk Uid
+#endif
 
     struct Data* m_data; //!< Metadata storage
     /*
@@ -734,8 +725,7 @@ PacketMetadata::operator=(const PacketMetadata& o)
     {
         // not self assignment
         NS_ASSERT(m_data != nullptr);
-        m_data->m_count--;
-        if (m_data->m_count == 0)
+        if (--m_data->m_count == 0)
         {
             PacketMetadata::Recycle(m_data);
         }
@@ -753,8 +743,7 @@ PacketMetadata::operator=(const PacketMetadata& o)
 PacketMetadata::~PacketMetadata()
 {
     NS_ASSERT(m_data != nullptr);
-    m_data->m_count--;
-    if (m_data->m_count == 0)
+    if (--m_data->m_count == 0)
     {
         PacketMetadata::Recycle(m_data);
     }
@@ -19,7 +19,7 @@
 
 /**
 \file   packet-tag-list.cc
-\brief  Implements a linked list of Packet tags, including copy-on-write semantics.
+\brief  Implements a flat list of Packet tags, including copy-on-write semantics.
 */
 
 #include "packet-tag-list.h"
@@ -30,6 +30,7 @@
 #include "ns3/fatal-error.h"
 #include "ns3/log.h"
 
+#include <algorithm>
 #include <cstring>
 
 namespace ns3
@@ -37,269 +38,227 @@ namespace ns3
 
 NS_LOG_COMPONENT_DEFINE("PacketTagList");
 
-PacketTagList::TagData*
-PacketTagList::CreateTagData(size_t dataSize)
+/**
+ * \ingroup packet
+ * \param [in] capacity The number of slots.
+ * \returns The size of a TagArray.
+ */
+static std::size_t
+GetTagArraySize(uint32_t capacity)
 {
-    NS_ASSERT_MSG(dataSize < std::numeric_limits<decltype(TagData::size)>::max(),
-                  "Requested TagData size " << dataSize << " exceeds maximum "
-                                            << std::numeric_limits<decltype(TagData::size)>::max());
-
-    void* p = std::malloc(sizeof(TagData) + dataSize - 1);
-    // The matching frees are in RemoveAll and RemoveWriter
-
-    TagData* tag = new (p) TagData;
-    tag->size = dataSize;
-    return tag;
+    return sizeof(PacketTagList::TagArray) + (capacity - 1) * sizeof(PacketTagList::TagData);
 }
 
-bool
-PacketTagList::COWTraverse(Tag& tag, PacketTagList::COWWriter Writer)
+uint32_t
+PacketTagList::GetMaskBit(TypeId tid)
 {
-    TypeId tid = tag.GetInstanceTypeId();
-    NS_LOG_FUNCTION(this << tid);
-    NS_LOG_INFO("looking for " << tid);
+    return uint32_t(1) << (tid.GetUid() & 31);
+}
 
-    // trivial case when list is empty
-    if (m_next == nullptr)
+PacketTagList::TagData*
+PacketTagList::Find(TypeId tid) const
+{
+    if ((m_tidMask & GetMaskBit(tid)) == 0)
     {
-        return false;
+        return nullptr;
     }
-
-    bool found = false;
-
-    struct TagData** prevNext = &m_next; // previous node's next pointer
-    struct TagData* cur = m_next;        // cursor to current node
-    struct TagData* it = nullptr;        // utility
-
-    // Search from the head of the list until we find tid or a merge
-    while (cur != nullptr)
+    TagData* begin = const_cast<TagData*>(Begin());
+    TagData* end = begin + m_size;
+    for (TagData* cur = begin; cur != end; cur++)
     {
-        if (cur->count > 1)
-        {
-            // found merge
-            NS_LOG_INFO("found initial merge before tid");
-            break;
-        }
-        else if (cur->tid == tid)
-        {
-            NS_LOG_INFO("found tid before initial merge, calling writer");
-            found = (this->*Writer)(tag, true, cur, prevNext);
-            break;
-        }
-        else
+        if (cur->tid == tid)
         {
-            // no merge or tid found yet, move on
-            prevNext = &cur->next;
-            cur = cur->next;
+            return cur;
         }
-    } // while !found && !cow
+    }
+    return nullptr;
+}
 
-    // did we find it or run out of tags?
-    if (cur == nullptr || found)
+PacketTagList::TagData*
+PacketTagList::MakeWritable(uint32_t capacity)
+{
+    if (m_array == nullptr && capacity <= INLINE_SLOTS)
     {
-        NS_LOG_INFO("returning after header with found: " << found);
-        return found;
+        return m_tags;
+    }
+    if (m_array != nullptr && m_array->count == 1 && capacity <= m_array->capacity)
+    {
+        return m_array->tags;
     }
 
-    // From here on out, we have to copy the list
-    // until we find tid, then link past it
-
-    // Before we do all that work, let's make sure tid really exists
-    for (it = cur; it != nullptr; it = it->next)
+    NS_LOG_FUNCTION(this << capacity);
+    // copy the slots: grow, or unshare the array
+    uint32_t newCapacity = std::max(capacity, 2 * INLINE_SLOTS);
+    if (m_array != nullptr)
+    {
+        newCapacity = std::max(newCapacity, m_array->capacity);
+        if (capacity > m_array->capacity)
+        {
+            newCapacity = std::max(newCapacity, 2 * m_array->capacity);
+        }
+    }
+    void* p = PacketAllocator::Allocate(GetTagArraySize(newCapacity));
+    auto array = new (p) TagArray;
+    array->count = 1;
+    array->capacity = newCapacity;
+    TagData* from = m_array != nullptr ? m_array->tags : m_tags;
+    bool shared = m_array != nullptr && m_array->count > 1;
+    for (uint32_t i = 0; i < m_size; i++)
     {
-        if (it->tid == tid)
+        array->tags[i] = from[i];
+        if (shared)
         {
-            break;
+            Retain(array->tags[i]);
         }
     }
-    if (it == nullptr)
+    if (shared)
     {
-        // got to end of list without finding tid
-        NS_LOG_INFO("tid not found after first merge");
-        return found;
+        m_array->count--;
     }
-
-    // At this point cur is a merge, but untested for tid
-    NS_ASSERT(cur != nullptr);
-    NS_ASSERT(cur->count > 1);
-
-    /*
-       Walk the remainder of the list, copying, until we find tid
-       As we put a copy of the cur node onto our list,
-       we move the merge point down the list.
-
-       Starting position                  End position
-         T1 is a merge                     T1.count decremented
-                                           T2 is a merge
-                                           T1' is a copy of T1
-
-            other                             other
-                 \                                 \
-        Prev  ->  T1  ->  T2  -> ...                T1  ->  T2  -> ...
-             /   /                                         /|
-        pNext cur                         Prev  ->  T1' --/ |
-                                                       /    |
-                                                  pNext   cur
-
-       When we reach tid, we link past it, decrement count, and we're done.
-    */
-
-    // Should normally check for null cur pointer,
-    // but since we know tid exists, we'll skip this test
-    while (/* cur && */ cur->tid != tid)
+    else if (m_array != nullptr)
     {
-        NS_ASSERT(cur != nullptr);
-        NS_ASSERT(cur->count > 1);
-        cur->count--; // unmerge cur
-        struct TagData* copy = CreateTagData(cur->size);
-        copy->tid = cur->tid;
-        copy->count = 1;
-        copy->size = cur->size;
-        memcpy(copy->data, cur->data, copy->size);
-        copy->next = cur->next; // merge into tail
-        copy->next->count++;    // mark new merge
-        *prevNext = copy;       // point prior list at copy
-        prevNext = &copy->next; // advance
-        cur = copy->next;
+        // the slots moved: free the old array only
+        std::size_t size = GetTagArraySize(m_array->capacity);
+        m_array->~TagArray();
+        PacketAllocator::Deallocate(m_array, size);
     }
-    // Sanity check:
-    NS_ASSERT(cur != nullptr);  // cur should be non-zero
-    NS_ASSERT(cur->tid == tid); // cur->tid should be tid
-    NS_ASSERT(cur->count > 1);  // cur should be a merge
-
-    // link around tid, removing it from our list
-    found = (this->*Writer)(tag, false, cur, prevNext);
-    return found;
+    m_array = array;
+    return m_array->tags;
 }
 
-bool
-PacketTagList::Remove(Tag& tag)
+void
+PacketTagList::AllocateLarge(TagData& slot)
 {
-    return COWTraverse(tag, &PacketTagList::RemoveWriter);
+    NS_ASSERT(slot.size > INLINE_SIZE);
+    void* p = PacketAllocator::Allocate(sizeof(LargeTagData) + slot.size - 1);
+    // The matching FreeLarge is in Release
+    slot.large = new (p) LargeTagData;
+    slot.large->count = 1;
 }
 
-// COWWriter implementing Remove
-bool
-PacketTagList::RemoveWriter(Tag& tag,
-                            bool preMerge,
-                            struct PacketTagList::TagData* cur,
-                            struct PacketTagList::TagData** prevNext)
+void
+PacketTagList::FreeLarge(LargeTagData* large, uint32_t size)
 {
-    NS_LOG_FUNCTION_NOARGS();
-
-    // found tid
-    bool found = true;
-    tag.Deserialize(TagBuffer(cur->data, cur->data + cur->size));
-    *prevNext = cur->next; // link around cur
+    large->~LargeTagData();
+    PacketAllocator::Deallocate(large, sizeof(LargeTagData) + size - 1);
+}
 
-    if (preMerge)
+void
+PacketTagList::WriteSlot(TagData& slot, const Tag& tag)
+{
+    slot.tid = tag.GetInstanceTypeId();
+    slot.size = tag.GetSerializedSize();
+    uint8_t* data = slot.data;
+    if (slot.size > INLINE_SIZE)
     {
-        // found tid before first merge, so delete cur
-        cur->~TagData();
-        std::free(cur);
+        AllocateLarge(slot);
+        data = slot.large->data;
     }
-    else
+    tag.Serialize(TagBuffer(data, data + slot.size));
+}
+
+void
+PacketTagList::ReleaseArray()
+{
+    if (--m_array->count == 0)
     {
-        // cur is always a merge at this point
-        // unmerge cur, since we linked around it already
-        cur->count--;
-        if (cur->next != nullptr)
+        for (uint32_t i = 0; i < m_size; i++)
         {
-            // there's a next, so make it a merge
-            cur->next->count++;
+            Release(m_array->tags[i]);
         }
+        std::size_t size = GetTagArraySize(m_array->capacity);
+        m_array->~TagArray();
+        PacketAllocator::Deallocate(m_array, size);
     }
-    return found;
+    m_array = nullptr;
 }
 
-bool
-PacketTagList::Replace(Tag& tag)
+void
+PacketTagList::Add(const Tag& tag) const
 {
-    bool found = COWTraverse(tag, &PacketTagList::ReplaceWriter);
-    if (!found)
-    {
-        Add(tag);
-    }
-    return found;
+    NS_LOG_FUNCTION(this << tag.GetInstanceTypeId());
+    // ensure this id was not yet added
+    NS_ASSERT_MSG(Find(tag.GetInstanceTypeId()) == nullptr,
+                  "Error: cannot add the same kind of tag twice.");
+
+    auto self = const_cast<PacketTagList*>(this);
+    TagData* tags = self->MakeWritable(m_size + 1);
+    WriteSlot(tags[m_size], tag);
+    self->m_tidMask |= GetMaskBit(tags[m_size].tid);
+    self->m_size++;
 }
 
-// COWWriter implementing Replace
 bool
-PacketTagList::ReplaceWriter(Tag& tag,
-                             bool preMerge,
-                             struct PacketTagList::TagData* cur,
-                             struct PacketTagList::TagData** prevNext)
+PacketTagList::Remove(Tag& tag)
 {
-    NS_LOG_FUNCTION_NOARGS();
-
-    // found tid
-    bool found = true;
-    if (preMerge)
+    TypeId tid = tag.GetInstanceTypeId();
+    NS_LOG_FUNCTION(this << tid);
+    TagData* cur = Find(tid);
+    if (cur == nullptr)
     {
-        // found tid before first merge, so just rewrite
-        tag.Serialize(TagBuffer(cur->data, cur->data + cur->size));
+        return false;
     }
-    else
+    uint8_t* data = const_cast<uint8_t*>(cur->GetData());
+    tag.Deserialize(TagBuffer(data, data + cur->size));
+
+    uint32_t index = cur - Begin();
+    TagData* tags = MakeWritable(m_size);
+    Release(tags[index]);
+    m_size--;
+    m_tidMask = 0;
+    for (uint32_t i = 0; i < m_size; i++)
     {
-        // cur is always a merge at this point
-        // need to copy, replace, and link past cur
-        cur->count--; // unmerge cur
-        struct TagData* copy = CreateTagData(tag.GetSerializedSize());
-        copy->tid = tag.GetInstanceTypeId();
-        copy->count = 1;
-        tag.Serialize(TagBuffer(copy->data, copy->data + copy->size));
-        copy->next = cur->next; // merge into tail
-        if (copy->next != nullptr)
+        if (i >= index)
         {
-            copy->next->count++; // mark new merge
+            tags[i] = tags[i + 1];
         }
-        *prevNext = copy; // point prior list at copy
+        m_tidMask |= GetMaskBit(tags[i].tid);
     }
-    return found;
+    return true;
 }
 
-void
-PacketTagList::Add(const Tag& tag) const
+bool
+PacketTagList::Replace(Tag& tag)
 {
-    NS_LOG_FUNCTION(this << tag.GetInstanceTypeId());
-    // ensure this id was not yet added
-    for (struct TagData* cur = m_next; cur != nullptr; cur = cur->next)
+    TypeId tid = tag.GetInstanceTypeId();
+    NS_LOG_FUNCTION(this << tid);
+    TagData* cur = Find(tid);
+    if (cur == nullptr)
     {
-        NS_ASSERT_MSG(cur->tid != tag.GetInstanceTypeId(),
-                      "Error: cannot add the same kind of tag twice.");
+        Add(tag);
+        return false;
+    }
+
+    uint32_t index = cur - Begin();
+    TagData& slot = MakeWritable(m_size)[index];
+    uint32_t size = tag.GetSerializedSize();
+    if (size > INLINE_SIZE && slot.size == size && slot.large->count == 1)
+    {
+        // not shared, so just rewrite
+        tag.Serialize(TagBuffer(slot.large->data, slot.large->data + size));
+    }
+    else
+    {
+        Release(slot);
+        WriteSlot(slot, tag);
     }
-    struct TagData* head = CreateTagData(tag.GetSerializedSize());
-    head->count = 1;
-    head->next = nullptr;
-    head->tid = tag.GetInstanceTypeId();
-    head->next = m_next;
-    tag.Serialize(TagBuffer(head->data, head->data + head->size));
-
-    const_cast<PacketTagList*>(this)->m_next = head;
+    return true;
 }
 
 bool
 PacketTagList::Peek(Tag& tag) const
 {
     NS_LOG_FUNCTION(this << tag.GetInstanceTypeId());
-    TypeId tid = tag.GetInstanceTypeId();
-    for (struct TagData* cur = m_next; cur != nullptr; cur = cur->next)
+    const TagData* cur = Find(tag.GetInstanceTypeId());
+    if (cur == nullptr)
     {
-        if (cur->tid == tid)
-        {
-            /* found tag */
-            tag.Deserialize(TagBuffer(cur->data, cur->data + cur->size));
-            return true;
-        }
+        /* no tag found */
+        return false;
     }
-    /* no tag found */
-    return false;
-}
-
-const struct PacketTagList::TagData*
-PacketTagList::Head() const
-{
-    return m_next;
+    /* found tag */
+    uint8_t* data = const_cast<uint8_t*>(cur->GetData());
+    tag.Deserialize(TagBuffer(data, data + cur->size));
+    return true;
 }
 
 uint32_t
@@ -311,7 +270,7 @@ PacketTagList::GetSerializedSize() const
 
     size = 4; // numberOfTags
 
-    for (struct TagData* cur = m_next; cur != nullptr; cur = cur->next)
+    for (const TagData* cur = Begin(); cur != End(); cur++)
     {
         size += 4; // TagData -> size
 
@@ -348,8 +307,10 @@ PacketTagList::Serialize(uint32_t* buffer, uint32_t maxSize) const
         return 0;
     }
 
-    for (struct TagData* cur = m_next; cur != nullptr; cur = cur->next)
+    // most recent tag first
+    for (const TagData* cur = End(); cur != Begin();)
     {
+        cur--;
         if (size + 4 <= maxSize)
         {
             *p++ = cur->size;
@@ -380,7 +341,7 @@ PacketTagList::Serialize(uint32_t* buffer, uint32_t maxSize) const
         uint32_t tagWordSize = (cur->size + 3) & (~3);
         if (size + tagWordSize <= maxSize)
         {
-            memcpy(p, cur->data, cur->size);
+            memcpy(p, cur->GetData(), cur->size);
             size += tagWordSize;
             p += tagWordSize / 4;
         }
@@ -409,7 +370,8 @@ PacketTagList::Deserialize(const uint32_t* buffer, uint32_t size)
 
     NS_LOG_INFO("Deserializing number of tags " << numberOfTags);
 
-    struct TagData* prevTag = nullptr;
+    RemoveAll();
+    TagData* tags = MakeWritable(numberOfTags);
     for (uint32_t i = 0; i < numberOfTags; ++i)
     {
         NS_ASSERT(sizeCheck >= 4);
@@ -427,31 +389,27 @@ PacketTagList::Deserialize(const uint32_t* buffer, uint32_t size)
 
         NS_LOG_INFO("Deserializing tag of type " << tid);
 
-        struct TagData* newTag = CreateTagData(tagSize);
-        newTag->count = 1;
-        newTag->next = nullptr;
-        newTag->tid = tid;
+        // most recent tag first
+        TagData& slot = tags[numberOfTags - 1 - i];
+        slot.tid = tid;
+        slot.size = tagSize;
+        uint8_t* data = slot.data;
+        if (tagSize > INLINE_SIZE)
+        {
+            AllocateLarge(slot);
+            data = slot.large->data;
+        }
 
         NS_ASSERT(sizeCheck >= tagSize);
-        memcpy(newTag->data, p, tagSize);
+        memcpy(data, p, tagSize);
+        m_tidMask |= GetMaskBit(tid);
 
         // ensure 4 byte boundary
         uint32_t tagWordSize = (tagSize + 3) & (~3);
         p += tagWordSize / 4;
         sizeCheck -= tagWordSize;
-
-        // Set link list pointers.
-        if (i == 0)
-        {
-            m_next = newTag;
-        }
-        else
-        {
-            prevTag->next = newTag;
-        }
-
-        prevTag = newTag;
     }
+    m_size = numberOfTags;
 
     NS_ASSERT(sizeCheck == 0);
 
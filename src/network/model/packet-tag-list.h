@@ -21,14 +21,20 @@
 
 /**
 \file   packet-tag-list.h
-\brief  Defines a linked list of Packet tags, including copy-on-write semantics.
+\brief  Defines a flat list of Packet tags, including copy-on-write semantics.
 */
 
+#include "packet-allocator.h"
+
 #include "ns3/type-id.h"
 
 #include <ostream>
 #include <stdint.h>
 
+#ifdef NS3_MTP
+#include <atomic>
+#endif
+
 namespace ns3
 {
 
@@ -44,88 +50,64 @@ class Tag;
  *
  * \internal
  *
- * The implementation of this class is a bit tricky.  Refer to this
- * diagram in the discussion that follows.
- *
- * \dot
- *    digraph {
- *        rankdir = "LR";
- *        clusterrank = local;
- *        node [ shape = record, fontname="FreeSans", fontsize="10" ];
- *        oth  [ label="<l> Other branch | <n> next | <c> ..." ];
- *        PTL1 [ label="<l> PacketTagList A | <n> m_next" , shape=Mrecord];
- *        PTL2 [ label="<l> PacketTagList B | <n> m_next" , shape=Mrecord];
- *        oth:n  -> T7:l ;
- *        PTL2:n -> T6:l ;
- *        PTL1:n -> T5:l ;
- *        T1   [ label="<l> T1  | <n> next | <c> count = 1" ];
- *        T2   [ label="<l> T2  | <n> next | <c> count = 1" ];
- *        T3   [ label="<l> T3  | <n> next | <c> count = 2" ];
- *        T4   [ label="<l> T4  | <n> next | <c> count = 1" ];
- *        T5   [ label="<l> T5  | <n> next | <c> count = 2" ];
- *        T6   [ label="<l> T6  | <n> next | <c> count = 1" ];
- *        T7   [ label="<l> T7  | <n> next | <c> count = 1" ];
- *        NULL [ label="0", shape = ellipse ];
- *        subgraph cluster_list {
- *          penwidth = 0;
- *          T6:n -> T5:l ;
- *          T5:n -> T4:l ;
- *          T4:n -> T3:l ;
- *          T7:n -> T3:l ;
- *          T3:n -> T2:l ;
- *          T2:n -> T1:l ;
- *          T1:n -> NULL ;
- *        };
- *      }
- * \enddot
- *
- *   - Tags are stored in serialized form in a tree of TagData
- *     structures. (<tt>T1-T7</tt> in the diagram)
+ * The tags are stored in serialized form in an array of TagData slots,
+ * in the order they were added:
  *
- *   - Each TagData points (\c next pointers in the diagram)
- *     toward the root of the tree, which is a null pointer.
+ *   - Up to \c INLINE_SLOTS tags are stored in the PacketTagList itself,
+ *     so tagging a packet with a few tags does not allocate memory.
+ *     Copying the list copies these slots.
  *
- *   - \c count is the number of incoming pointers to this
- *     TagData.  Branch points, where branches merge or join, have
- *     <tt>count \> 1</tt> (\c T3, \c T5); successive links along
- *     a branch have <tt>count = 1</tt> (\c T1, \c T2, \c T4, \c T6, \c T7).
+ *   - Once a list holds more tags, they move to a TagArray on the heap,
+ *     which is shared by the copies of the list.  \c count is the number
+ *     of lists sharing it.
  *
- *   - Each PacketTagList points to a specific TagData,
- *     which is the most recent Tag added to the packet. (<tt>T5-T7</tt>)
+ *   - A tag of up to \c INLINE_SIZE bytes is serialized in its slot.  A
+ *     larger tag is serialized in a LargeTagData on the heap, which is
+ *     shared by the copies of its slot.  \c count is the number of slots
+ *     sharing it.
  *
- *   - Conceptually, therefore, each Packet has a PacketTagList which
- *     points to a singly-linked list of TagData.
+ *   - The lookup compares the TypeId of each slot, after checking a
+ *     32 bit mask of the TypeId uids in the list, so looking for a tag
+ *     which is not in the list usually takes no comparison at all.
  *
  * \par <b> Copy-on-write </b> is implemented as follows:
  *
- *   - #Add prepends the new tag to the list (growing that branch of the tree,
- *     as \c T6). This is a constant time operation, and does not affect
- *     any other #PacketTagList's, hence this is a \c const function.
- *
  *   - Copy constructor (PacketTagList(const PacketTagList & o))
  *     and assignment (#operator=(const PacketTagList & o))
- *     simply join the tree at the same place as the original
- *     PacketTagList \c o, incrementing the \c count.
- *     For assignment, the old branch is deleted, up to
- *     the first branch point, which has its \c count decremented.
- *     (PacketTagList \c B started as a copy of PacketTagList \c A,
- *     before \c T6 was added to \c B).
+ *     copy the inline slots, or share the TagArray of \c o,
+ *     incrementing its \c count.  Large tags are shared likewise.
  *
- *   - #Remove and #Replace are a little tricky, depending on where the
- *     target tag is found relative to the first branch point:
- *     - \e Target before <em> the first branch point: </em> \n
- *       The target is just dealt with in place (linked around and deleted,
- *       in the case of #Remove; rewritten in the case of #Replace).
- *     - \e Target at or after <em> the first branch point: </em> \n
- *       The portion of the list between the first branch and the target is
- *       shared. This portion is copied before the #Remove or #Replace is
- *       performed.
+ *   - #Add, #Remove and #Replace first copy a shared TagArray, so
+ *     they do not affect any other #PacketTagList.  #Add is a \c const
+ *     function.  #Replace rewrites a large tag in place only when its
+ *     slot does not share it.
  */
 class PacketTagList
 {
   public:
+    /** Size of the tags serialized in their slot, in bytes. */
+    static constexpr uint32_t INLINE_SIZE = 16;
+    /** Number of slots stored in the PacketTagList itself. */
+    static constexpr uint32_t INLINE_SLOTS = 4;
+
     /**
-     * Tree node for sharing serialized tags.
+     * Serialization buffer of a tag larger than \c INLINE_SIZE.
+     *
+     * We allocate enough room for the Tag type which will be serialized
+     * into data.  See Object::Aggregates for a similar construction.
+     */
+    struct LargeTagData
+    {
+#ifdef NS3_MTP
+        std::atomic<uint32_t> count; //!< Number of slots sharing this buffer
+#else
+        uint32_t count;  //!< Number of slots sharing this buffer
+#endif
+        uint8_t data[1]; //!< Serialization buffer
+    };
+
+    /**
+     * Slot holding one serialized tag.
      *
      * See PacketTagList for a discussion of the data structure.
      *
@@ -134,18 +116,36 @@ class PacketTagList
      * PacketTagIterator::Item::GetTag() needs the data and size values.
      * The Item nested class can't be forward declared, so friending isn't
      * possible.
-     *
-     * We use placement new so we can allocate enough room for the Tag
-     * type which will be serialized into data.  See Object::Aggregates
-     * for a similar construction.
      */
     struct TagData
     {
-        struct TagData* next; //!< Pointer to next in list
-        uint32_t count;       //!< Number of incoming links
-        TypeId tid;           //!< Type of the tag serialized into #data
-        uint32_t size;        //!< Size of the \c data buffer
-        uint8_t data[1];      //!< Serialization buffer
+        TypeId tid;    //!< Type of the tag serialized into the slot
+        uint32_t size; //!< Size of the serialized tag
+
+        union {
+            uint8_t data[INLINE_SIZE]; //!< Serialization buffer of a small tag
+            LargeTagData* large;       //!< Serialization buffer of a large tag
+        };
+
+        /** \returns The serialized tag. */
+        const uint8_t* GetData() const
+        {
+            return size <= INLINE_SIZE ? data : large->data;
+        }
+    };
+
+    /**
+     * Shared array of slots, once a list holds more than \c INLINE_SLOTS tags.
+     */
+    struct TagArray
+    {
+#ifdef NS3_MTP
+        std::atomic<uint32_t> count; //!< Number of lists sharing this array
+#else
+        uint32_t count;    //!< Number of lists sharing this array
+#endif
+        uint32_t capacity; //!< Number of slots
+        TagData tags[1];   //!< The slots
     };
 
     /**
@@ -157,8 +157,8 @@ class PacketTagList
      *
      * \param [in] o The PacketTagList to copy.
      *
-     * This makes a light-weight copy by #RemoveAll, then
-     * pointing to the same \ref TagData as \pname{o}.
+     * This copies the inline slots of \pname{o},
+     * or points to the same \ref TagArray.
      */
     inline PacketTagList(const PacketTagList& o);
     /**
@@ -167,19 +167,19 @@ class PacketTagList
      * \param [in] o The PacketTagList to copy.
      * \returns the copied object
      *
-     * This makes a light-weight copy by #RemoveAll, then
-     * pointing to the same \ref TagData as \pname{o}.
+     * This makes a light-weight copy by #RemoveAll, then copying
+     * the inline slots of \pname{o}, or pointing to the same \ref TagArray.
      */
     inline PacketTagList& operator=(const PacketTagList& o);
     /**
      * Destructor
      *
-     * #RemoveAll's the tags up to the first merge.
+     * #RemoveAll's the tags.
      */
     inline ~PacketTagList();
 
     /**
-     * Add a tag to the head of this branch.
+     * Add a tag at the end of the list.
      *
      * \param [in] tag The tag to add
      */
@@ -211,13 +211,17 @@ class PacketTagList
      */
     bool Peek(Tag& tag) const;
     /**
-     * Remove all tags from this list (up to the first merge).
+     * Remove all tags from this list.
      */
     inline void RemoveAll();
     /**
-     * \returns pointer to head of tag list
+     * \returns pointer to the first slot, holding the oldest tag
      */
-    const struct PacketTagList::TagData* Head() const;
+    inline const struct PacketTagList::TagData* Begin() const;
+    /**
+     * \returns pointer past the last slot, which holds the most recent tag
+     */
+    inline const struct PacketTagList::TagData* End() const;
     /**
      * Returns number of bytes required for packet serialization.
      *
@@ -245,66 +249,65 @@ class PacketTagList
 
   private:
     /**
-     * Allocate and construct a TagData struct, sizing the data area
-     * large enough to serialize dataSize bytes from a Tag.
+     * \returns The mask bit of a TypeId.
+     * \param [in] tid The TypeId.
+     */
+    static uint32_t GetMaskBit(TypeId tid);
+    /**
+     * Find a tag.
      *
-     * \param [in] dataSize The serialized size of the Tag.
-     * \returns The newly constructed TagData object.
+     * \param [in] tid The type of the tag.
+     * \returns The slot of the tag, or \c nullptr if it is not in the list.
      */
-    static TagData* CreateTagData(size_t dataSize);
-
+    TagData* Find(TypeId tid) const;
     /**
-     * Typedef of method function pointer for copy-on-write operations
+     * Make sure the slots are not shared with another list.
      *
-     * \param [in] tag The tag type to operate on.
-     * \param [in] preMerge True if \pname{tag} was found before the first merge,
-     *             false otherwise.
-     * \param [in] cur Pointer to the tag.
-     * \param [in] prevNext Pointer to the struct TagData.next pointer
-     *          pointing to \pname{cur}.
-     * \returns True if operation successful, false otherwise
+     * \param [in] capacity The number of slots needed.
+     * \returns The first slot.
      */
-    typedef bool (PacketTagList::*COWWriter)(Tag& tag,
-                                             bool preMerge,
-                                             struct TagData* cur,
-                                             struct TagData** prevNext);
+    TagData* MakeWritable(uint32_t capacity);
     /**
-     * Traverse the list implementing copy-on-write, using \pname{Writer}.
+     * Serialize a tag into a slot, allocating a LargeTagData if needed.
      *
-     * \param [in] tag The tag type to operate on.
-     * \param [in] Writer The copy-on-write function to use.
-     * \returns True if \pname{tag} found, false otherwise.
+     * \param [out] slot The slot.
+     * \param [in] tag The tag.
      */
-    bool COWTraverse(Tag& tag, PacketTagList::COWWriter Writer);
+    static void WriteSlot(TagData& slot, const Tag& tag);
     /**
-     * Copy-on-write implementing Remove.
+     * Allocate a LargeTagData for a slot.
      *
-     * \param [in] tag The target tag type to remove.
-     * \param [in] preMerge True if \pname{tag} was found before the first merge,
-     *             false otherwise.
-     * \param [in] cur Pointer to the tag.
-     * \param [in] prevNext Pointer to the struct TagData.next pointer
-     *          pointing to \pname{cur}.
-     * \returns True, since tag will definitely be removed.
+     * \param [in,out] slot The slot, with its size set.
      */
-    bool RemoveWriter(Tag& tag, bool preMerge, struct TagData* cur, struct TagData** prevNext);
+    static void AllocateLarge(TagData& slot);
     /**
-     * Copy-on-write implementing Replace
+     * Take a reference to the LargeTagData of a slot, if any.
      *
-     * \param [in] tag The target tag type to replace
-     * \param [in] preMerge True if \pname{tag} was found before the first merge,
-     *          false otherwise.
-     * \param [in] cur Pointer to the tag
-     * \param [in] prevNext Pointer to the struct TagData.next pointer
-     *          pointing to \pname{cur}.
-     * \returns True, since tag value will definitely be replaced.
+     * \param [in] slot The slot.
      */
-    bool ReplaceWriter(Tag& tag, bool preMerge, struct TagData* cur, struct TagData** prevNext);
-
+    static inline void Retain(const TagData& slot);
+    /**
+     * Drop the reference to the LargeTagData of a slot, if any.
+     *
+     * \param [in] slot The slot.
+     */
+    static inline void Release(const TagData& slot);
+    /**
+     * Destroy a LargeTagData no longer shared.
+     *
+     * \param [in] large The LargeTagData.
+     * \param [in] size The size of the tag.
+     */
+    static void FreeLarge(LargeTagData* large, uint32_t size);
     /**
-     * Pointer to first \ref TagData on the list
+     * Drop the reference to the TagArray.
      */
-    struct TagData* m_next;
+    void ReleaseArray();
+
+    TagArray* m_array;            //!< The shared slots, once the list outgrew the inline ones
+    uint32_t m_size;              //!< Number of tags
+    uint32_t m_tidMask;           //!< Mask of the TypeId uids of the tags
+    TagData m_tags[INLINE_SLOTS]; //!< Inline slots
 };
 
 } // namespace ns3
@@ -317,16 +320,26 @@ namespace ns3
 {
 
 PacketTagList::PacketTagList()
-    : m_next()
+    : m_array(nullptr),
+      m_size(0),
+      m_tidMask(0)
 {
 }
 
 PacketTagList::PacketTagList(const PacketTagList& o)
-    : m_next(o.m_next)
+    : m_array(o.m_array),
+      m_size(o.m_size),
+      m_tidMask(o.m_tidMask)
 {
-    if (m_next != nullptr)
+    if (m_array != nullptr)
+    {
+        m_array->count++;
+        return;
+    }
+    for (uint32_t i = 0; i < m_size; i++)
     {
-        m_next->count++;
+        m_tags[i] = o.m_tags[i];
+        Retain(m_tags[i]);
     }
 }
 
@@ -334,15 +347,23 @@ PacketTagList&
 PacketTagList::operator=(const PacketTagList& o)
 {
     // self assignment
-    if (m_next == o.m_next)
+    if (this == &o)
     {
         return *this;
     }
     RemoveAll();
-    m_next = o.m_next;
-    if (m_next != nullptr)
+    m_array = o.m_array;
+    m_size = o.m_size;
+    m_tidMask = o.m_tidMask;
+    if (m_array != nullptr)
     {
-        m_next->count++;
+        m_array->count++;
+        return *this;
+    }
+    for (uint32_t i = 0; i < m_size; i++)
+    {
+        m_tags[i] = o.m_tags[i];
+        Retain(m_tags[i]);
     }
     return *this;
 }
@@ -355,27 +376,49 @@ PacketTagList::~PacketTagList()
 void
 PacketTagList::RemoveAll()
 {
-    struct TagData* prev = nullptr;
-    for (struct TagData* cur = m_next; cur != nullptr; cur = cur->next)
+    if (m_array != nullptr)
     {
-        cur->count--;
-        if (cur->count > 0)
-        {
-            break;
-        }
-        if (prev != nullptr)
+        ReleaseArray();
+    }
+    else
+    {
+        for (uint32_t i = 0; i < m_size; i++)
         {
-            prev->~TagData();
-            std::free(prev);
+            Release(m_tags[i]);
         }
-        prev = cur;
     }
-    if (prev != nullptr)
+    m_size = 0;
+    m_tidMask = 0;
+}
+
+const PacketTagList::TagData*
+PacketTagList::Begin() const
+{
+    return m_array != nullptr ? m_array->tags : m_tags;
+}
+
+const PacketTagList::TagData*
+PacketTagList::End() const
+{
+    return Begin() + m_size;
+}
+
+void
+PacketTagList::Retain(const TagData& slot)
+{
+    if (slot.size > INLINE_SIZE)
+    {
+        slot.large->count++;
+    }
+}
+
+void
+PacketTagList::Release(const TagData& slot)
+{
+    if (slot.size > INLINE_SIZE && --slot.large->count == 0)
     {
-        prev->~TagData();
-        std::free(prev);
+        FreeLarge(slot.large, slot.size);
     }
-    m_next = nullptr;
 }
 
 } // namespace ns3
@@ -24,13 +24,49 @@
 
 #include <cstdarg>
 #include <string>
+#include <unordered_map>
 
 namespace ns3
 {
 
 NS_LOG_COMPONENT_DEFINE("Packet");
 
+#ifdef NS3_MTP
+std::atomic<uint32_t> Packet::m_globalUid = 0;
+thread_local uint64_t* Packet::m_uidCounter = nullptr;
+#else
 uint32_t Packet::m_globalUid = 0;
+#endif
+bool Packet::m_lazyPrinting = false;
+
+/**
+ * \ingroup packet
+ * \returns The header parsers registered for lazy printing, by TypeId uid.
+ */
+static std::unordered_map<uint16_t, Packet::HeaderParser>&
+GetHeaderParsers()
+{
+    static std::unordered_map<uint16_t, Packet::HeaderParser> parsers;
+    return parsers;
+}
+
+/**
+ * \ingroup packet
+ * \param [in] header A header removed from a packet.
+ * \returns The type of the header following \pname{header}, according to
+ *          its parser, or TypeId() if it has no parser.
+ */
+static TypeId
+GetNextHeader(const Header& header)
+{
+    const auto& parsers = GetHeaderParsers();
+    auto it = parsers.find(header.GetInstanceTypeId().GetUid());
+    if (it == parsers.end())
+    {
+        return TypeId();
+    }
+    return it->second(header);
+}
 
 TypeId
 ByteTagIterator::Item::GetTypeId() const
@@ -89,24 +125,26 @@ ByteTagIterator::ByteTagIterator(ByteTagList::Iterator i)
 {
 }
 
-PacketTagIterator::PacketTagIterator(const struct PacketTagList::TagData* head)
-    : m_current(head)
+PacketTagIterator::PacketTagIterator(const struct PacketTagList::TagData* begin,
+                                     const struct PacketTagList::TagData* end)
+    : m_begin(begin),
+      m_current(end)
 {
 }
 
 bool
 PacketTagIterator::HasNext() const
 {
-    return m_current != nullptr;
+    return m_current != m_begin;
 }
 
 PacketTagIterator::Item
 PacketTagIterator::Next()
 {
     NS_ASSERT(HasNext());
-    const struct PacketTagList::TagData* prev = m_current;
-    m_current = m_current->next;
-    return PacketTagIterator::Item(prev);
+    // most recent tag first
+    m_current--;
+    return PacketTagIterator::Item(m_current);
 }
 
 PacketTagIterator::Item::Item(const struct PacketTagList::TagData* data)
@@ -124,7 +162,8 @@ void
 PacketTagIterator::Item::GetTag(Tag& tag) const
 {
     NS_ASSERT(tag.GetInstanceTypeId() == m_data->tid);
-    tag.Deserialize(TagBuffer((uint8_t*)m_data->data, (uint8_t*)m_data->data + m_data->size));
+    auto data = const_cast<uint8_t*>(m_data->GetData());
+    tag.Deserialize(TagBuffer(data, data + m_data->size));
 }
 
 Ptr<Packet>
@@ -140,23 +179,17 @@ Packet::Packet()
     : m_buffer(),
       m_byteTagList(),
       m_packetTagList(),
-      /* The upper 32 bits of the packet id in
-       * metadata is for the system id. For non-
-       * distributed simulations, this is simply
-       * zero.  The lower 32 bits are for the
-       * global UID
-       */
-      m_metadata(static_cast<uint64_t>(Simulator::GetSystemId()) << 32 | m_globalUid, 0),
+      m_metadata(AllocateUid(), 0),
       m_nixVector(nullptr)
 {
-    m_globalUid++;
 }
 
 Packet::Packet(const Packet& o)
     : m_buffer(o.m_buffer),
       m_byteTagList(o.m_byteTagList),
       m_packetTagList(o.m_packetTagList),
-      m_metadata(o.m_metadata)
+      m_metadata(o.m_metadata),
+      m_firstHeader(o.m_firstHeader)
 {
     o.m_nixVector ? m_nixVector = o.m_nixVector->Copy() : m_nixVector = nullptr;
 }
@@ -172,6 +205,7 @@ Packet::operator=(const Packet& o)
     m_byteTagList = o.m_byteTagList;
     m_packetTagList = o.m_packetTagList;
     m_metadata = o.m_metadata;
+    m_firstHeader = o.m_firstHeader;
     o.m_nixVector ? m_nixVector = o.m_nixVector->Copy() : m_nixVector = nullptr;
     return *this;
 }
@@ -180,16 +214,9 @@ Packet::Packet(uint32_t size)
     : m_buffer(size),
       m_byteTagList(),
       m_packetTagList(),
-      /* The upper 32 bits of the packet id in
-       * metadata is for the system id. For non-
-       * distributed simulations, this is simply
-       * zero.  The lower 32 bits are for the
-       * global UID
-       */
-      m_metadata(static_cast<uint64_t>(Simulator::GetSystemId()) << 32 | m_globalUid, size),
+      m_metadata(AllocateUid(), size),
       m_nixVector(nullptr)
 {
-    m_globalUid++;
 }
 
 Packet::Packet(const uint8_t* buffer, uint32_t size, bool magic)
@@ -207,16 +234,9 @@ Packet::Packet(const uint8_t* buffer, uint32_t size)
     : m_buffer(),
       m_byteTagList(),
       m_packetTagList(),
-      /* The upper 32 bits of the packet id in
-       * metadata is for the system id. For non-
-       * distributed simulations, this is simply
-       * zero.  The lower 32 bits are for the
-       * global UID
-       */
-      m_metadata(static_cast<uint64_t>(Simulator::GetSystemId()) << 32 | m_globalUid, size),
+      m_metadata(AllocateUid(), size),
       m_nixVector(nullptr)
 {
-    m_globalUid++;
     m_buffer.AddAtStart(size);
     Buffer::Iterator i = m_buffer.Begin();
     i.Write(buffer, size);
@@ -249,6 +269,10 @@ Packet::CreateFragment(uint32_t start, uint32_t length) const
     Ptr<Packet> ret =
         Ptr<Packet>(new Packet(buffer, byteTagList, m_packetTagList, metadata), false);
     ret->SetNixVector(GetNixVector());
+    if (start == 0)
+    {
+        ret->m_firstHeader = m_firstHeader;
+    }
     return ret;
 }
 
@@ -274,6 +298,10 @@ Packet::AddHeader(const Header& header)
     m_byteTagList.AddAtStart(size);
     header.Serialize(m_buffer.Begin());
     m_metadata.AddHeader(header, size);
+    if (m_lazyPrinting)
+    {
+        m_firstHeader = header.GetInstanceTypeId();
+    }
 }
 
 uint32_t
@@ -287,6 +315,10 @@ Packet::RemoveHeader(Header& header, uint32_t size)
     m_buffer.RemoveAtStart(deserialized);
     m_byteTagList.Adjust(-deserialized);
     m_metadata.RemoveHeader(header, deserialized);
+    if (m_lazyPrinting)
+    {
+        m_firstHeader = GetNextHeader(header);
+    }
     return deserialized;
 }
 
@@ -298,6 +330,10 @@ Packet::RemoveHeader(Header& header)
     m_buffer.RemoveAtStart(deserialized);
     m_byteTagList.Adjust(-deserialized);
     m_metadata.RemoveHeader(header, deserialized);
+    if (m_lazyPrinting)
+    {
+        m_firstHeader = GetNextHeader(header);
+    }
     return deserialized;
 }
 
@@ -354,6 +390,10 @@ void
 Packet::AddAtEnd(Ptr<const Packet> packet)
 {
     NS_LOG_FUNCTION(this << packet << packet->GetSize());
+    if (GetSize() == 0)
+    {
+        m_firstHeader = packet->m_firstHeader;
+    }
     m_byteTagList.AddAtEnd(GetSize());
     ByteTagList copy = packet->m_byteTagList;
     copy.AddAtStart(0);
@@ -387,6 +427,10 @@ Packet::RemoveAtStart(uint32_t size)
     m_buffer.RemoveAtStart(size);
     m_byteTagList.Adjust(-size);
     m_metadata.RemoveAtStart(size);
+    if (size > 0)
+    {
+        m_firstHeader = TypeId();
+    }
 }
 
 void
@@ -455,6 +499,11 @@ Packet::ToString() const
 void
 Packet::Print(std::ostream& os) const
 {
+    if (m_lazyPrinting)
+    {
+        PrintLazy(os);
+        return;
+    }
     PacketMetadata::ItemIterator i = m_metadata.BeginItem(m_buffer);
     while (i.HasNext())
     {
@@ -586,6 +635,54 @@ Packet::Print(std::ostream& os) const
 #endif
 }
 
+void
+Packet::PrintLazy(std::ostream& os) const
+{
+    // Pad a copy of the buffer, so that parsing a truncated header
+    // does not read past its end
+    static const uint32_t PADDING = 64;
+    Buffer buffer = m_buffer;
+    buffer.AddAtEnd(PADDING);
+
+    Buffer::Iterator current = buffer.Begin();
+    uint32_t left = GetSize();
+    TypeId tid = m_firstHeader;
+    while (tid != TypeId() && left > 0)
+    {
+        NS_ASSERT(tid.HasConstructor());
+        Callback<ObjectBase*> constructor = tid.GetConstructor();
+        NS_ASSERT(!constructor.IsNull());
+        auto header = dynamic_cast<Header*>(constructor());
+        NS_ASSERT(header != nullptr);
+        uint32_t size = header->Deserialize(current);
+        if (size > left)
+        {
+            // truncated: print it as payload
+            delete header;
+            break;
+        }
+        if (left < GetSize())
+        {
+            os << " ";
+        }
+        os << tid.GetName() << " (";
+        header->Print(os);
+        os << ")";
+        current.Next(size);
+        left -= size;
+        tid = GetNextHeader(*header);
+        delete header;
+    }
+    if (left > 0)
+    {
+        if (left < GetSize())
+        {
+            os << " ";
+        }
+        os << "Payload (size=" << left << ")";
+    }
+}
+
 PacketMetadata::ItemIterator
 Packet::BeginItem() const
 {
@@ -596,6 +693,10 @@ void
 Packet::EnablePrinting()
 {
     NS_LOG_FUNCTION_NOARGS();
+    if (m_lazyPrinting)
+    {
+        return;
+    }
     PacketMetadata::Enable();
 }
 
@@ -603,9 +704,57 @@ void
 Packet::EnableChecking()
 {
     NS_LOG_FUNCTION_NOARGS();
+    // the checks need the metadata, Print() keeps parsing the buffer
     PacketMetadata::EnableChecking();
 }
 
+void
+Packet::EnableLazyPrinting()
+{
+    NS_LOG_FUNCTION_NOARGS();
+    m_lazyPrinting = true;
+}
+
+void
+Packet::DisableLazyPrinting()
+{
+    NS_LOG_FUNCTION_NOARGS();
+    m_lazyPrinting = false;
+}
+
+void
+Packet::RegisterHeaderParser(TypeId tid, HeaderParser parser)
+{
+    NS_LOG_FUNCTION(tid);
+    GetHeaderParsers()[tid.GetUid()] = parser;
+}
+
+#ifdef NS3_MTP
+void
+Packet::SetUidCounter(uint64_t* counter)
+{
+    m_uidCounter = counter;
+}
+#endif
+
+uint64_t
+Packet::AllocateUid()
+{
+#ifdef NS3_MTP
+    if (m_uidCounter)
+    {
+        return (*m_uidCounter)++;
+    }
+#endif
+    /* The upper 32 bits of the packet id in
+     * metadata is for the system id. For non-
+     * distributed simulations, this is simply
+     * zero.  The lower 32 bits are for the
+     * global UID
+     */
+    return static_cast<uint64_t>(Simulator::GetSystemId()) << 32 | m_globalUid++;
+}
+
 uint32_t
 Packet::GetSerializedSize() const
 {
@@ -1038,7 +1187,7 @@ Packet::PrintPacketTags(std::ostream& os) const
 PacketTagIterator
 Packet::GetPacketTagIterator() const
 {
-    return PacketTagIterator(m_packetTagList.Head());
+    return PacketTagIterator(m_packetTagList.Begin(), m_packetTagList.End());
 }
 
 std::ostream&
@@ -23,6 +23,7 @@
 #include "byte-tag-list.h"
 #include "header.h"
 #include "nix-vector.h"
+#include "packet-allocator.h"
 #include "packet-metadata.h"
 #include "packet-tag-list.h"
 #include "tag.h"
@@ -36,6 +37,10 @@
 
 #include <stdint.h>
 
+#ifdef NS3_MTP
+#include <atomic>
+#endif
+
 namespace ns3
 {
 
@@ -181,11 +186,14 @@ class PacketTagIterator
     friend class Packet;
     /**
      * Constructor
-     * \param head head of the items
+     * \param begin first of the items, the oldest tag
+     * \param end past the last of the items, the most recent tag
      */
-    PacketTagIterator(const struct PacketTagList::TagData* head);
+    PacketTagIterator(const struct PacketTagList::TagData* begin,
+                      const struct PacketTagList::TagData* end);
+    const struct PacketTagList::TagData* m_begin; //!< first of the items
     const struct PacketTagList::TagData*
-        m_current; //!< actual position over the set of tags in a packet
+        m_current; //!< past the actual position over the set of tags in a packet
 };
 
 /**
@@ -208,7 +216,11 @@ class PacketTagIterator
  * output from Packet::Print. If you wish to only enable
  * checking of metadata, and do not need any printing capability, you can
  * call Packet::EnableChecking: its runtime cost is lower than
- * Packet::EnablePrinting.
+ * Packet::EnablePrinting.  Packet::EnableLazyPrinting keeps the metadata
+ * disabled, and lets Packet::Print parse the byte buffer instead, with
+ * the parsers registered by the protocols (see
+ * Packet::RegisterHeaderParser): this costs nothing for the packets
+ * which are never printed.
  *
  * - The set of tags contain simulation-specific information which cannot
  * be stored in the packet byte buffer because the protocol headers or trailers
@@ -256,6 +268,24 @@ class Packet : public SimpleRefCount<Packet>
      * \return the copied object
      */
     Packet& operator=(const Packet& o);
+    /**
+     * \brief Allocate the memory of a packet from the PacketAllocator
+     * \param size the size of the packet object
+     * \returns the memory of the packet
+     */
+    static void* operator new(std::size_t size)
+    {
+        return PacketAllocator::Allocate(size);
+    }
+    /**
+     * \brief Give the memory of a packet back to the PacketAllocator
+     * \param p the memory of the packet
+     * \param size the size of the packet object
+     */
+    static void operator delete(void* p, std::size_t size)
+    {
+        PacketAllocator::Deallocate(p, size);
+    }
     /**
      * \brief Create a packet with a zero-filled payload.
      *
@@ -490,7 +520,8 @@ class Packet : public SimpleRefCount<Packet>
      * Iterate over the headers and trailers present in this packet,
      * from the first header to the last trailer and invoke, for
      * each of them, the user-provided method Header::DoPrint or
-     * Trailer::DoPrint methods.
+     * Trailer::DoPrint methods.  With lazy printing, the headers are
+     * found by parsing the byte buffer, see EnableLazyPrinting.
      */
     void Print(std::ostream& os) const;
 
@@ -498,6 +529,7 @@ class Packet : public SimpleRefCount<Packet>
      * \brief Return a string representation of the packet
      *
      * An empty string is returned if you haven't called EnablePrinting ()
+     * or EnableLazyPrinting ()
      *
      * \return String representation
      */
@@ -536,8 +568,76 @@ class Packet : public SimpleRefCount<Packet>
      * when you remove a header from a packet, this same header
      * was actually present at the front of the packet. These
      * errors will be detected and will abort the program.
+     *
+     * With lazy printing, the checks keep the metadata but Print still
+     * parses the byte buffer.
      */
     static void EnableChecking();
+    /**
+     * \brief Print packets without keeping their metadata.
+     *
+     * Once called, EnablePrinting does not enable the metadata anymore,
+     * so the packets do not pay for them.  Instead, each packet only
+     * records the type of its first header, and Packet::Print parses
+     * the byte buffer from there, asking the parser registered for
+     * each header type (see RegisterHeaderParser) which header follows
+     * it.  The bytes after the last header found are printed as payload.
+     *
+     * Lazy printing takes precedence over the metadata: Print parses
+     * the byte buffer even if EnablePrinting or EnableChecking was called
+     * first, and the packets keep paying for their metadata then.  This
+     * must be called during the simulation setup, before any packet is
+     * created, as the packets created before print as payload only.
+     * Trailers and fragments are not identified: they are part of the
+     * payload.
+     */
+    static void EnableLazyPrinting();
+    /**
+     * \brief Stop printing packets without metadata.
+     *
+     * The packets created afterwards do not record their first header
+     * anymore, Print uses the metadata again, and EnablePrinting enables
+     * it again.  This is mostly useful to tests.
+     */
+    static void DisableLazyPrinting();
+
+    /**
+     * Parser of a header, for lazy printing.
+     *
+     * \param [in] header The header, of the type the parser is registered
+     *             for, deserialized from the packet.
+     * \returns The type of the header following \pname{header} in the
+     *          packet, or TypeId() if none is known.
+     */
+    typedef Callback<TypeId, const Header&> HeaderParser;
+
+    /**
+     * \brief Register the parser of a header type, for lazy printing.
+     *
+     * The protocols register their parsers during the static
+     * initialization, typically in the file defining the header.
+     *
+     * \param [in] tid The type of the header.
+     * \param [in] parser The parser.
+     *
+     * \sa EnableLazyPrinting
+     */
+    static void RegisterHeaderParser(TypeId tid, HeaderParser parser);
+
+#ifdef NS3_MTP
+    /**
+     * \brief Give the packets created by the calling thread their own uids.
+     *
+     * MultithreadedSimulatorImpl hands every partition its own counter, so
+     * that the uids do not depend on how the threads interleave. The
+     * counter holds the whole uid: its upper 32 bits, the system id for
+     * the global counter, tell the partitions apart.
+     *
+     * \param [in] counter The next uid, incremented for every new packet,
+     *             or null to use the global counter again.
+     */
+    static void SetUidCounter(uint64_t* counter);
+#endif
 
     /**
      * \brief Returns number of bytes required for packet
@@ -781,6 +881,11 @@ class Packet : public SimpleRefCount<Packet>
            const PacketTagList& packetTagList,
            const PacketMetadata& metadata);
 
+    /**
+     * \returns The uid of a new packet.
+     */
+    static uint64_t AllocateUid();
+
     /**
      * \brief Deserializes a packet.
      * \param [in] buffer the input buffer.
@@ -789,6 +894,12 @@ class Packet : public SimpleRefCount<Packet>
      */
     uint32_t Deserialize(const uint8_t* buffer, uint32_t size);
 
+    /**
+     * \brief Print the packet contents by parsing the byte buffer.
+     * \param [in] os output stream in which the data should be printed.
+     */
+    void PrintLazy(std::ostream& os) const;
+
     Buffer m_buffer;               //!< the packet buffer (it's actual contents)
     ByteTagList m_byteTagList;     //!< the ByteTag list
     PacketTagList m_packetTagList; //!< the packet's Tag list
@@ -796,8 +907,15 @@ class Packet : public SimpleRefCount<Packet>
 
     /* Please see comments above about nix-vector */
     mutable Ptr<NixVector> m_nixVector; //!< the packet's Nix vector
+    TypeId m_firstHeader;               //!< Type of the first header, for lazy printing
 
+#ifdef NS3_MTP
+    static std::atomic<uint32_t> m_globalUid; //!< Global counter of packets Uid
+    static thread_local uint64_t* m_uidCounter; //!< Counter of the calling thread, if any
+#else
     static uint32_t m_globalUid; //!< Global counter of packets Uid
+#endif
+    static bool m_lazyPrinting; //!< Whether packets are printed without metadata
 };
 
 /**
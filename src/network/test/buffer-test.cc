@@ -19,9 +19,12 @@
 
 #include "ns3/buffer.h"
 #include "ns3/double.h"
+#include "ns3/ip-checksum.h"
 #include "ns3/random-variable-stream.h"
 #include "ns3/test.h"
 
+#include <vector>
+
 using namespace ns3;
 
 /**
@@ -396,6 +399,136 @@ BufferTest::DoRun()
     NS_TEST_ASSERT_MSG_EQ(val1, val2, "Bad ReadNtohU16()");
 }
 
+/**
+ * \ingroup network-test
+ * \ingroup tests
+ *
+ * Buffer::Iterator::CalculateIpChecksum unit tests.
+ */
+class BufferChecksumTest : public TestCase
+{
+  private:
+    /**
+     * Calculates the checksum one word at a time, as a reference.
+     * \param i The iterator at the start of the bytes to checksum
+     * \param size The number of bytes
+     * \param initialChecksum The initial value
+     * \returns the checksum
+     */
+    static uint16_t ReferenceChecksum(Buffer::Iterator i, uint32_t size, uint32_t initialChecksum);
+
+  public:
+    void DoRun() override;
+    BufferChecksumTest();
+};
+
+BufferChecksumTest::BufferChecksumTest()
+    : TestCase("Buffer checksum")
+{
+}
+
+uint16_t
+BufferChecksumTest::ReferenceChecksum(Buffer::Iterator i, uint32_t size, uint32_t initialChecksum)
+{
+    uint64_t sum = initialChecksum;
+    for (uint32_t j = 0; j < size / 2; j++)
+    {
+        sum += i.ReadU16();
+    }
+    if (size & 1)
+    {
+        sum += i.ReadU8();
+    }
+    while (sum >> 16)
+    {
+        sum = (sum & 0xffff) + (sum >> 16);
+    }
+    return ~sum;
+}
+
+void
+BufferChecksumTest::DoRun()
+{
+    Ptr<UniformRandomVariable> rng = CreateObject<UniformRandomVariable>();
+
+    // The vectorized sum matches the scalar one, whatever the alignment and
+    // the length of the bytes.
+    std::vector<uint8_t> bytes(70000);
+    for (uint8_t& byte : bytes)
+    {
+        byte = rng->GetInteger(0, 255);
+    }
+    for (uint32_t offset = 0; offset < 32; offset++)
+    {
+        for (uint32_t length = 0; length < 300; length++)
+        {
+            NS_TEST_ASSERT_MSG_EQ(OnesComplementSum(&bytes[offset], length),
+                                  OnesComplementSumScalar(&bytes[offset], length),
+                                  "Bad sum of " << length << " bytes at offset " << offset);
+        }
+        for (uint32_t length : {1500, 9000, 65535})
+        {
+            NS_TEST_ASSERT_MSG_EQ(OnesComplementSum(&bytes[offset], length),
+                                  OnesComplementSumScalar(&bytes[offset], length),
+                                  "Bad sum of " << length << " bytes at offset " << offset);
+        }
+    }
+    std::vector<uint8_t> ones(70000, 0xff);
+    NS_TEST_ASSERT_MSG_EQ(OnesComplementSum(ones.data(), ones.size()),
+                          0xffff,
+                          "Bad sum of all ones");
+    uint8_t words[] = {0x01, 0x02, 0x03};
+    NS_TEST_ASSERT_MSG_EQ(OnesComplementSum(words, 3), 0x0204, "Bad byte order");
+
+    // The checksum of buffers made of written bytes on both sides of a zero
+    // area, over ranges starting on either side of it, at odd and even
+    // offsets.
+    for (uint32_t start : {0, 1, 2, 3, 20, 41})
+    {
+        for (uint32_t zero : {0, 1, 6, 7, 1460})
+        {
+            for (uint32_t end : {0, 1, 4, 5})
+            {
+                Buffer buffer(zero);
+                buffer.AddAtStart(start);
+                Buffer::Iterator i = buffer.Begin();
+                for (uint32_t j = 0; j < start; j++)
+                {
+                    i.WriteU8(rng->GetInteger(0, 255));
+                }
+                buffer.AddAtEnd(end);
+                i = buffer.End();
+                i.Prev(end);
+                for (uint32_t j = 0; j < end; j++)
+                {
+                    i.WriteU8(rng->GetInteger(0, 255));
+                }
+
+                uint32_t size = buffer.GetSize();
+                for (uint32_t skip = 0; skip < std::min<uint32_t>(size, 5); skip++)
+                {
+                    for (uint32_t length : {size - skip, (size - skip) / 2})
+                    {
+                        uint32_t initial = rng->GetInteger(0, 0xffff);
+                        i = buffer.Begin();
+                        i.Next(skip);
+                        uint16_t expected = ReferenceChecksum(i, length, initial);
+                        uint16_t checksum = i.CalculateIpChecksum(length, initial);
+                        NS_TEST_ASSERT_MSG_EQ(checksum,
+                                              expected,
+                                              "Bad checksum of " << length << " bytes at " << skip
+                                                                 << " in " << start << "+" << zero
+                                                                 << "+" << end << " bytes");
+                        NS_TEST_ASSERT_MSG_EQ(i.GetRemainingSize(),
+                                              size - skip - length,
+                                              "Iterator not advanced by the checksum");
+                    }
+                }
+            }
+        }
+    }
+}
+
 /**
  * \ingroup network-test
  * \ingroup tests
@@ -412,6 +545,7 @@ BufferTestSuite::BufferTestSuite()
     : TestSuite("buffer", UNIT)
 {
     AddTestCase(new BufferTest, TestCase::QUICK);
+    AddTestCase(new BufferChecksumTest, TestCase::QUICK);
 }
 
 static BufferTestSuite g_bufferTestSuite; //!< Static variable for test initialization
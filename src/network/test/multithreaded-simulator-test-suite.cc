@@ -0,0 +1,245 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/config.h"
+#include "ns3/global-value.h"
+#include "ns3/multithreaded-simulator-impl.h"
+#include "ns3/node-container.h"
+#include "ns3/packet.h"
+#include "ns3/simple-channel.h"
+#include "ns3/simple-net-device-helper.h"
+#include "ns3/simulator.h"
+#include "ns3/string.h"
+#include "ns3/test.h"
+#include "ns3/uinteger.h"
+
+#include <vector>
+
+using namespace ns3;
+
+/**
+ * \ingroup network-test
+ * \ingroup tests
+ *
+ * \brief MultithreadedSimulatorImpl runs a forwarding chain like the default simulator.
+ *
+ * Nodes 0 to 3 are chained by two-device SimpleChannels; nodes 3, 4 and 5
+ * share a three-device SimpleChannel, which must keep them in one
+ * partition. Node 0 sends a burst of packets that every node forwards to
+ * the next one as a new packet. The receive times of every node must match
+ * those of a DefaultSimulatorImpl run, and the packet uids must be the same
+ * in two runs with the same MaxThreads. Without NS3_MTP, the nodes must
+ * stay in one partition whatever MaxThreads is.
+ */
+class MultithreadedSimulatorTestCase : public TestCase
+{
+  public:
+    /**
+     * Constructor.
+     * \param [in] maxThreads The MaxThreads attribute of the runs.
+     */
+    MultithreadedSimulatorTestCase(uint32_t maxThreads);
+
+  private:
+    void DoRun() override;
+
+    /**
+     * Build the topology and run it.
+     * \param [in] impl The simulator implementation type.
+     * \return The receive times of each node.
+     */
+    std::vector<std::vector<Time>> RunScenario(std::string impl);
+    /**
+     * Record a packet and forward it to the next node.
+     * \param [in] device The receiving device.
+     * \param [in] packet The packet.
+     * \param [in] protocol The protocol number.
+     * \param [in] from The sender address.
+     * \return Always true.
+     */
+    bool Receive(Ptr<NetDevice> device,
+                 Ptr<const Packet> packet,
+                 uint16_t protocol,
+                 const Address& from);
+    /**
+     * Send a packet from the first node.
+     * \param [in] size The packet size.
+     */
+    void Send(uint32_t size);
+
+    uint32_t m_maxThreads;                     //!< MaxThreads of the runs.
+    std::vector<std::vector<Time>> m_rx;       //!< Receive times, per node.
+    std::vector<std::vector<uint64_t>> m_uids; //!< Received packet uids, per node.
+    std::vector<Ptr<NetDevice>> m_out;         //!< Device towards the next node, per node.
+    std::vector<Address> m_next;               //!< Address of the next node, per node.
+    uint32_t m_nPartitions;                    //!< Partitions found by the last run.
+    Time m_lookahead;                          //!< Lookahead found by the last run.
+};
+
+MultithreadedSimulatorTestCase::MultithreadedSimulatorTestCase(uint32_t maxThreads)
+    : TestCase("MultithreadedSimulatorImpl with MaxThreads " + std::to_string(maxThreads) +
+               " matches the default simulator"),
+      m_maxThreads(maxThreads),
+      m_nPartitions(0)
+{
+}
+
+bool
+MultithreadedSimulatorTestCase::Receive(Ptr<NetDevice> device,
+                                        Ptr<const Packet> packet,
+                                        uint16_t protocol,
+                                        const Address& from)
+{
+    uint32_t node = device->GetNode()->GetId();
+    m_rx[node].push_back(Simulator::Now());
+    m_uids[node].push_back(packet->GetUid());
+    if (m_out[node])
+    {
+        // a new packet, so that every partition hands out uids
+        m_out[node]->Send(Create<Packet>(packet->GetSize()), m_next[node], protocol);
+    }
+    return true;
+}
+
+void
+MultithreadedSimulatorTestCase::Send(uint32_t size)
+{
+    m_out[0]->Send(Create<Packet>(size), m_next[0], 0x800);
+}
+
+std::vector<std::vector<Time>>
+MultithreadedSimulatorTestCase::RunScenario(std::string impl)
+{
+    GlobalValue::Bind("SimulatorImplementationType", StringValue(impl));
+
+    const uint32_t nNodes = 6;
+    NodeContainer nodes;
+    nodes.Create(nNodes);
+    m_rx.assign(nNodes, {});
+    m_uids.assign(nNodes, {});
+    m_out.assign(nNodes, nullptr);
+    m_next.assign(nNodes, Address());
+
+    SimpleNetDeviceHelper helper;
+    helper.SetDeviceAttribute("DataRate", StringValue("8Mbps"));
+    std::vector<Ptr<NetDevice>> in(nNodes);
+    for (uint32_t i = 0; i < 3; i++)
+    {
+        helper.SetChannelAttribute("Delay", StringValue(std::to_string(i + 1) + "ms"));
+        NetDeviceContainer devices = helper.Install(NodeContainer(nodes.Get(i), nodes.Get(i + 1)));
+        m_out[i] = devices.Get(0);
+        m_next[i] = devices.Get(1)->GetAddress();
+        in[i + 1] = devices.Get(1);
+    }
+    helper.SetChannelAttribute("Delay", StringValue("500us"));
+    NetDeviceContainer shared =
+        helper.Install(NodeContainer(nodes.Get(3), nodes.Get(4), nodes.Get(5)));
+    for (uint32_t i = 3; i < nNodes; i++)
+    {
+        if (i > 3)
+        {
+            in[i] = shared.Get(i - 3);
+        }
+        if (i + 1 < nNodes)
+        {
+            m_out[i] = shared.Get(i - 3);
+            m_next[i] = shared.Get(i - 2)->GetAddress();
+        }
+    }
+    for (uint32_t i = 1; i < nNodes; i++)
+    {
+        in[i]->SetReceiveCallback(MakeCallback(&MultithreadedSimulatorTestCase::Receive, this));
+    }
+
+    for (uint32_t k = 0; k < 20; k++)
+    {
+        Simulator::ScheduleWithContext(0,
+                                       MilliSeconds(100) + MicroSeconds(300) * k,
+                                       &MultithreadedSimulatorTestCase::Send,
+                                       this,
+                                       500 + 10 * k);
+    }
+    Simulator::Stop(Seconds(1));
+    Simulator::Run();
+
+    Ptr<MultithreadedSimulatorImpl> mt =
+        DynamicCast<MultithreadedSimulatorImpl>(Simulator::GetImplementation());
+    m_nPartitions = mt ? mt->GetNPartitions() : 0;
+    m_lookahead = mt ? mt->GetLookahead() : Time();
+    Simulator::Destroy();
+    return m_rx;
+}
+
+void
+MultithreadedSimulatorTestCase::DoRun()
+{
+    std::vector<std::vector<Time>> expected = RunScenario("ns3::DefaultSimulatorImpl");
+    NS_TEST_ASSERT_MSG_EQ(expected[5].size(), 20, "Every packet should reach the last node");
+
+    Config::SetDefault("ns3::MultithreadedSimulatorImpl::MaxThreads", UintegerValue(m_maxThreads));
+    RunScenario("ns3::MultithreadedSimulatorImpl");
+    std::vector<std::vector<uint64_t>> uids = m_uids;
+    std::vector<std::vector<Time>> actual = RunScenario("ns3::MultithreadedSimulatorImpl");
+    Config::SetDefault("ns3::MultithreadedSimulatorImpl::MaxThreads", UintegerValue(1));
+    GlobalValue::Bind("SimulatorImplementationType", StringValue("ns3::DefaultSimulatorImpl"));
+
+#ifdef NS3_MTP
+    bool split = m_maxThreads > 1;
+#else
+    bool split = false;
+#endif
+    if (!split)
+    {
+        NS_TEST_EXPECT_MSG_EQ(m_nPartitions, 1, "Unexpected number of partitions");
+        NS_TEST_EXPECT_MSG_EQ(m_lookahead, Time::Max(), "Unexpected lookahead");
+    }
+    else
+    {
+        // nodes 3, 4 and 5 share a medium and must not be split
+        NS_TEST_EXPECT_MSG_EQ(m_nPartitions, 4, "Unexpected number of partitions");
+        NS_TEST_EXPECT_MSG_EQ(m_lookahead, MilliSeconds(1), "Unexpected lookahead");
+        // a single partition uses the global uid counter, which runs on
+        // across runs, several number their packets from the same start
+        NS_TEST_EXPECT_MSG_EQ((uids == m_uids), true, "Packet uids differ between runs");
+    }
+    for (uint32_t i = 0; i < expected.size(); i++)
+    {
+        NS_TEST_ASSERT_MSG_EQ(actual[i].size(), expected[i].size(), "Packets lost at node " << i);
+        for (uint32_t j = 0; j < expected[i].size(); j++)
+        {
+            NS_TEST_EXPECT_MSG_EQ(actual[i][j], expected[i][j], "Node " << i << " packet " << j);
+        }
+    }
+}
+
+/**
+ * \ingroup network-test
+ * \ingroup tests
+ *
+ * \brief MultithreadedSimulatorImpl TestSuite
+ */
+class MultithreadedSimulatorTestSuite : public TestSuite
+{
+  public:
+    MultithreadedSimulatorTestSuite()
+        : TestSuite("multithreaded-simulator", UNIT)
+    {
+        AddTestCase(new MultithreadedSimulatorTestCase(1), TestCase::QUICK);
+        AddTestCase(new MultithreadedSimulatorTestCase(8), TestCase::QUICK);
+    }
+};
+
+static MultithreadedSimulatorTestSuite
+    g_multithreadedSimulatorTestSuite; //!< Static variable for test initialization
@@ -0,0 +1,243 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ns3/packet-allocator.h"
+#include "ns3/packet.h"
+#include "ns3/tag.h"
+#include "ns3/test.h"
+
+#include <cstring>
+#include <thread>
+#include <vector>
+
+using namespace ns3;
+
+/**
+ * \ingroup network-test
+ * \ingroup tests
+ *
+ * Check the size classes and the blocks of the PacketAllocator.
+ */
+class PacketAllocatorBlocksTest : public TestCase
+{
+  public:
+    PacketAllocatorBlocksTest();
+
+  private:
+    void DoRun() override;
+};
+
+PacketAllocatorBlocksTest::PacketAllocatorBlocksTest()
+    : TestCase("Check the blocks of the PacketAllocator")
+{
+}
+
+void
+PacketAllocatorBlocksTest::DoRun()
+{
+    for (std::size_t size = 1; size < 2 * PacketAllocator::MAX_SIZE; size += 1 + size / 16)
+    {
+        std::size_t capacity = PacketAllocator::GetCapacity(size);
+        NS_TEST_ASSERT_MSG_GT_OR_EQ(capacity, size, "Block too small");
+        NS_TEST_ASSERT_MSG_LT_OR_EQ(capacity, std::max<std::size_t>(32, size + size / 2),
+                                    "Block too large for " << size);
+        NS_TEST_ASSERT_MSG_EQ(PacketAllocator::GetCapacity(capacity),
+                              capacity,
+                              "Capacity in another size class");
+    }
+
+    // blocks of all sizes, alive together, across slabs
+    std::vector<std::pair<uint8_t*, std::size_t>> blocks;
+    for (uint32_t i = 0; i < 3000; i++)
+    {
+        std::size_t size = 1 + (i * 7919) % 20000;
+        auto p = static_cast<uint8_t*>(PacketAllocator::Allocate(size));
+        std::memset(p, i & 0xff, PacketAllocator::GetCapacity(size));
+        blocks.emplace_back(p, size);
+    }
+    for (uint32_t i = 0; i < blocks.size(); i++)
+    {
+        std::size_t capacity = PacketAllocator::GetCapacity(blocks[i].second);
+        bool intact = true;
+        for (std::size_t j = 0; j < capacity; j++)
+        {
+            intact = intact && blocks[i].first[j] == (i & 0xff);
+        }
+        NS_TEST_EXPECT_MSG_EQ(intact, true, "Block " << i << " overwritten");
+        PacketAllocator::Deallocate(blocks[i].first, blocks[i].second);
+    }
+
+    // blocks deallocated by another thread
+    std::vector<void*> others(500);
+    for (auto& p : others)
+    {
+        p = PacketAllocator::Allocate(100);
+    }
+    PacketAllocator::Stats before = PacketAllocator::GetStats();
+    std::thread other([&others]() {
+        for (auto p : others)
+        {
+            PacketAllocator::Deallocate(p, 100);
+        }
+        others.assign(500, nullptr);
+        for (auto& p : others)
+        {
+            p = PacketAllocator::Allocate(100);
+        }
+    });
+    other.join();
+    for (auto p : others)
+    {
+        PacketAllocator::Deallocate(p, 100);
+    }
+    PacketAllocator::Stats after = PacketAllocator::GetStats();
+    NS_TEST_EXPECT_MSG_EQ(after.allocations - before.allocations, 500, "Wrong allocations");
+    NS_TEST_EXPECT_MSG_EQ(after.deallocations - before.deallocations,
+                          1000,
+                          "Wrong deallocations");
+}
+
+/**
+ * \ingroup network-test
+ * \ingroup tests
+ *
+ * A packet tag for the PacketAllocator test.
+ */
+class PacketAllocatorTag : public Tag
+{
+  public:
+    /**
+     * \brief Get the type ID.
+     * \return the object TypeId
+     */
+    static TypeId GetTypeId()
+    {
+        static TypeId tid = TypeId("ns3::PacketAllocatorTag")
+                                .SetParent<Tag>()
+                                .SetGroupName("Network")
+                                .AddConstructor<PacketAllocatorTag>();
+        return tid;
+    }
+
+    TypeId GetInstanceTypeId() const override
+    {
+        return GetTypeId();
+    }
+
+    uint32_t GetSerializedSize() const override
+    {
+        return 8;
+    }
+
+    void Serialize(TagBuffer i) const override
+    {
+        i.WriteU64(m_value);
+    }
+
+    void Deserialize(TagBuffer i) override
+    {
+        m_value = i.ReadU64();
+    }
+
+    void Print(std::ostream& os) const override
+    {
+        os << m_value;
+    }
+
+    uint64_t m_value{0}; //!< The tag value.
+};
+
+/**
+ * \ingroup network-test
+ * \ingroup tests
+ *
+ * Check that creating, copying and destroying packets does not take new
+ * slabs in steady state.
+ */
+class PacketAllocatorSteadyStateTest : public TestCase
+{
+  public:
+    PacketAllocatorSteadyStateTest();
+
+  private:
+    void DoRun() override;
+
+    /** Create, copy and destroy packets. */
+    void Churn();
+};
+
+PacketAllocatorSteadyStateTest::PacketAllocatorSteadyStateTest()
+    : TestCase("Check that packets reuse the memory of the PacketAllocator")
+{
+}
+
+void
+PacketAllocatorSteadyStateTest::Churn()
+{
+    std::vector<Ptr<Packet>> packets;
+    for (uint32_t i = 0; i < 1000; i++)
+    {
+        Ptr<Packet> p = Create<Packet>(1000 + i % 500);
+        PacketAllocatorTag tag;
+        tag.m_value = i;
+        p->AddPacketTag(tag);
+        p->AddByteTag(tag);
+        Ptr<Packet> copy = p->Copy();
+        copy->AddAtEnd(Create<Packet>(100));
+        packets.push_back(copy);
+        if (packets.size() > 100)
+        {
+            packets.erase(packets.begin());
+        }
+    }
+}
+
+void
+PacketAllocatorSteadyStateTest::DoRun()
+{
+    Churn();
+    PacketAllocator::Stats before = PacketAllocator::GetStats();
+    Churn();
+    PacketAllocator::Stats after = PacketAllocator::GetStats();
+    NS_TEST_EXPECT_MSG_GT(after.allocations, before.allocations, "No allocations");
+    NS_TEST_EXPECT_MSG_EQ(after.allocations - before.allocations,
+                          after.deallocations - before.deallocations,
+                          "Blocks leaked");
+    NS_TEST_EXPECT_MSG_EQ(after.slabs, before.slabs, "New slabs in steady state");
+    NS_TEST_EXPECT_MSG_EQ(after.largeAllocations,
+                          before.largeAllocations,
+                          "System allocations in steady state");
+}
+
+/**
+ * \ingroup network-test
+ * \ingroup tests
+ *
+ * \brief PacketAllocator TestSuite
+ */
+class PacketAllocatorTestSuite : public TestSuite
+{
+  public:
+    PacketAllocatorTestSuite();
+};
+
+PacketAllocatorTestSuite::PacketAllocatorTestSuite()
+    : TestSuite("packet-allocator", UNIT)
+{
+    AddTestCase(new PacketAllocatorBlocksTest, TestCase::QUICK);
+    AddTestCase(new PacketAllocatorSteadyStateTest, TestCase::QUICK);
+}
+
+static PacketAllocatorTestSuite g_packetAllocatorTestSuite; //!< Static variable for test init
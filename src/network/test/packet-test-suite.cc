@@ -26,6 +26,7 @@
 #include <iostream>
 #include <limits> // std:numeric_limits
 #include <string>
+#include <vector>
 
 using namespace ns3;
 
@@ -1198,6 +1199,70 @@ PacketTagListTest::DoRun()
     ReplaceCheck(7);
 }
 
+{ // Inline slots and large tags
+    std::cout << GetName() << "check copy-on-write of inline and large tags" << std::endl;
+    ATestTag<1> s1(1);
+    ATestTag<20> l20(1); // larger than PacketTagList::INLINE_SIZE
+    ATestTag<30> l30(1);
+    PacketTagList small;
+    small.Add(s1);
+    small.Add(l20);
+
+    PacketTagList copy = small;
+    s1.m_data = 2;
+    copy.Replace(s1);
+    l20.m_data = 2;
+    copy.Replace(l20);
+    copy.Add(l30);
+    // beyond the inline slots
+    copy.Add(t2);
+    copy.Add(t3);
+    copy.Add(t4);
+    const char* msg = "inline and large, copy";
+    CheckRef(copy, s1, msg);
+    CheckRef(copy, l20, msg);
+    CheckRef(copy, l30, msg);
+    CheckRef(copy, t4, msg);
+    NS_TEST_EXPECT_MSG_EQ(l20.m_error, false, msg << ": large tag data");
+
+    msg = "inline and large, orig";
+    s1.m_data = 1;
+    l20.m_data = 1;
+    CheckRef(small, s1, msg);
+    CheckRef(small, l20, msg);
+    CheckRef(small, l30, msg, true);
+    CheckRef(small, t2, msg, true);
+
+    PacketTagList shared = copy;
+    shared.Remove(l20);
+    l30.m_data = 3;
+    shared.Replace(l30);
+    msg = "shared slots, copy";
+    CheckRef(shared, l20, msg, true);
+    CheckRef(shared, l30, msg);
+    CheckRef(shared, t2, msg);
+    msg = "shared slots, orig";
+    l20.m_data = 2;
+    l30.m_data = 1;
+    CheckRef(copy, l20, msg);
+    CheckRef(copy, l30, msg);
+
+    // the most recent tag first, as the tags were added
+    Ptr<Packet> p = Create<Packet>();
+    p->AddPacketTag(t3);
+    p->AddPacketTag(l20);
+    p->AddPacketTag(t1);
+    std::vector<TypeId> tids;
+    PacketTagIterator i = p->GetPacketTagIterator();
+    while (i.HasNext())
+    {
+        tids.push_back(i.Next().GetTypeId());
+    }
+    NS_TEST_EXPECT_MSG_EQ(tids.size(), 3U, "iterated tags");
+    NS_TEST_EXPECT_MSG_EQ(tids.front(), t1.GetInstanceTypeId(), "first iterated tag");
+    NS_TEST_EXPECT_MSG_EQ(tids.back(), t3.GetInstanceTypeId(), "last iterated tag");
+}
+
 { // Timing
     std::cout << GetName() << "add+remove timing" << std::endl;
     int flm = std::numeric_limits<int>::max();
@@ -1260,6 +1325,93 @@ PacketTagListTest::DoRun()
 } // Timing
 }
 
+/**
+ * \ingroup network-test
+ * \ingroup tests
+ *
+ * Packet lazy printing unit tests.
+ */
+class PacketLazyPrintingTest : public TestCase
+{
+  public:
+    PacketLazyPrintingTest();
+
+  private:
+    void DoRun() override;
+    /**
+     * Parser of ATestHeader<2>, followed by ATestHeader<3>.
+     * \param header The header.
+     * \return The type of the next header.
+     */
+    static TypeId GetNextHeader2(const Header& header);
+};
+
+PacketLazyPrintingTest::PacketLazyPrintingTest()
+    : TestCase("Packet lazy printing")
+{
+}
+
+TypeId
+PacketLazyPrintingTest::GetNextHeader2(const Header& header)
+{
+    return ATestHeader<3>::GetTypeId();
+}
+
+void
+PacketLazyPrintingTest::DoRun()
+{
+    // whether or not other suites of this process enabled the metadata
+    // before us, lazy printing takes over
+    Packet::EnableLazyPrinting();
+    Packet::EnablePrinting();
+    Packet::RegisterHeaderParser(ATestHeader<2>::GetTypeId(),
+                                 MakeCallback(&PacketLazyPrintingTest::GetNextHeader2));
+
+    Ptr<Packet> p = Create<Packet>(10);
+    NS_TEST_EXPECT_MSG_EQ(p->ToString(), "Payload (size=10)", "Payload only");
+    p->AddHeader(ATestHeader<3>());
+    p->AddHeader(ATestHeader<2>());
+    NS_TEST_EXPECT_MSG_EQ(p->ToString(),
+                          "anon::ATestHeader<2> () anon::ATestHeader<3> () Payload (size=10)",
+                          "Headers found through the parsers");
+    Ptr<Packet> copy = p->Copy();
+    ATestHeader<2> h2;
+    copy->RemoveHeader(h2);
+    NS_TEST_EXPECT_MSG_EQ(copy->ToString(),
+                          "anon::ATestHeader<3> () Payload (size=10)",
+                          "Next header after a removal");
+    NS_TEST_EXPECT_MSG_EQ(p->ToString(),
+                          "anon::ATestHeader<2> () anon::ATestHeader<3> () Payload (size=10)",
+                          "Removal in a copy");
+    ATestHeader<3> h3;
+    copy->RemoveHeader(h3);
+    NS_TEST_EXPECT_MSG_EQ(copy->ToString(), "Payload (size=10)", "No parser for ATestHeader<3>");
+
+    NS_TEST_EXPECT_MSG_EQ(p->CreateFragment(0, 7)->ToString(),
+                          "anon::ATestHeader<2> () anon::ATestHeader<3> () Payload (size=2)",
+                          "First fragment");
+    NS_TEST_EXPECT_MSG_EQ(p->CreateFragment(0, 3)->ToString(),
+                          "anon::ATestHeader<2> () Payload (size=1)",
+                          "Truncated header");
+    NS_TEST_EXPECT_MSG_EQ(p->CreateFragment(2, 5)->ToString(),
+                          "Payload (size=5)",
+                          "Other fragment");
+
+    Ptr<Packet> q = Create<Packet>();
+    q->AddAtEnd(p);
+    NS_TEST_EXPECT_MSG_EQ(q->ToString(), p->ToString(), "Added to an empty packet");
+    copy = p->Copy();
+    copy->RemoveAtStart(1);
+    NS_TEST_EXPECT_MSG_EQ(copy->ToString(), "Payload (size=14)", "Removed bytes");
+
+    p->AddHeader(ATestHeader<4>());
+    NS_TEST_EXPECT_MSG_EQ(p->ToString(),
+                          "anon::ATestHeader<4> () Payload (size=15)",
+                          "No parser for ATestHeader<4>");
+
+    Packet::DisableLazyPrinting();
+}
+
 /**
  * \ingroup network-test
  * \ingroup tests
@@ -1277,6 +1429,7 @@ PacketTestSuite::PacketTestSuite()
 {
     AddTestCase(new PacketTest, TestCase::QUICK);
     AddTestCase(new PacketTagListTest, TestCase::QUICK);
+    AddTestCase(new PacketLazyPrintingTest, TestCase::QUICK);
 }
 
 static PacketTestSuite g_packetTestSuite; //!< Static variable for test initialization
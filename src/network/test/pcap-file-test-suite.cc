@@ -17,11 +17,13 @@
 
 #include "ns3/log.h"
 #include "ns3/pcap-file.h"
+#include "ns3/pcapng-file.h"
 #include "ns3/test.h"
 
 #include <cstdio>
 #include <cstdlib>
 #include <cstring>
+#include <fstream>
 #include <iostream>
 #include <sstream>
 
@@ -1373,6 +1375,179 @@ DiffTestCase::DoRun()
     NS_TEST_EXPECT_MSG_EQ(usec, 3696, "Files are different from 2.3696 seconds");
 }
 
+/**
+ * \ingroup network-test
+ * \ingroup tests
+ *
+ * \brief Test case to make sure that the batched writes of PcapFile
+ * produce the same file as the unbatched ones.
+ */
+class BatchedWriteTestCase : public TestCase
+{
+  public:
+    BatchedWriteTestCase();
+
+  private:
+    void DoRun() override;
+
+    /**
+     * Write the same packets to a file, with the given batching.
+     *
+     * \param filename The file name.
+     * \param batchSize The size of the batches.
+     * \param background Whether a background thread writes the batches.
+     */
+    void WriteFile(std::string filename, uint32_t batchSize, bool background);
+    /**
+     * \param filename The file name.
+     * \returns The content of the file.
+     */
+    std::string ReadFile(std::string filename);
+};
+
+BatchedWriteTestCase::BatchedWriteTestCase()
+    : TestCase("Check that PcapFile::SetBatching does not change the file written")
+{
+}
+
+void
+BatchedWriteTestCase::WriteFile(std::string filename, uint32_t batchSize, bool background)
+{
+    PcapFile f;
+    f.Open(filename, std::ios::out);
+    NS_TEST_ASSERT_MSG_EQ(f.Fail(), false, "Open (" << filename << ") returns error");
+    f.Init(1, 100);
+    f.SetBatching(batchSize, background);
+
+    uint8_t data[200];
+    for (uint32_t i = 0; i < 1000; ++i)
+    {
+        // Packet sizes from 0 to 199 bytes, some of them truncated
+        uint32_t size = (i * 37) % 200;
+        for (uint32_t j = 0; j < size; ++j)
+        {
+            data[j] = i + j;
+        }
+        f.Write(i / 100, i % 100, data, size);
+    }
+    NS_TEST_EXPECT_MSG_EQ(f.Fail(), false, "Write must not fail");
+    f.Close();
+}
+
+std::string
+BatchedWriteTestCase::ReadFile(std::string filename)
+{
+    std::ifstream file(filename, std::ios::binary);
+    std::ostringstream content;
+    content << file.rdbuf();
+    return content.str();
+}
+
+void
+BatchedWriteTestCase::DoRun()
+{
+    std::string unbatched = CreateTempDirFilename("unbatched.pcap");
+    std::string batched = CreateTempDirFilename("batched.pcap");
+    std::string background = CreateTempDirFilename("background.pcap");
+
+    WriteFile(unbatched, 0, false);
+    WriteFile(batched, 1000, false);
+    WriteFile(background, 1000, true);
+
+    std::string expected = ReadFile(unbatched);
+    NS_TEST_ASSERT_MSG_EQ(expected.size(), 24 + 1000 * 16 + 74750, "Unexpected file size");
+    NS_TEST_EXPECT_MSG_EQ((ReadFile(batched) == expected), true, "Batched file differs");
+    NS_TEST_EXPECT_MSG_EQ((ReadFile(background) == expected), true, "Background file differs");
+
+    remove(unbatched.c_str());
+    remove(batched.c_str());
+    remove(background.c_str());
+}
+
+/**
+ * \ingroup network-test
+ * \ingroup tests
+ *
+ * \brief Test case to make sure that PcapNgFile writes the blocks
+ * of its interfaces as expected.
+ */
+class PcapNgFileTestCase : public TestCase
+{
+  public:
+    PcapNgFileTestCase();
+
+  private:
+    void DoRun() override;
+};
+
+PcapNgFileTestCase::PcapNgFileTestCase()
+    : TestCase("Check that PcapNgFile writes the packets of many interfaces")
+{
+}
+
+void
+PcapNgFileTestCase::DoRun()
+{
+    std::string filename = CreateTempDirFilename("merged.pcapng");
+    {
+        Ptr<PcapNgFile> f = PcapNgFile::Open(filename, 64, true);
+        NS_TEST_ASSERT_MSG_EQ(f->Fail(), false, "Open (" << filename << ") returns error");
+        NS_TEST_EXPECT_MSG_EQ(PcapNgFile::Open(filename, 0, false),
+                              f,
+                              "Files of the same name must be shared");
+        NS_TEST_EXPECT_MSG_EQ(f->AddInterface(1, 65535, "a"), 0, "First interface is 0");
+        NS_TEST_EXPECT_MSG_EQ(f->AddInterface(9, 4, "device"), 1, "Second interface is 1");
+        NS_TEST_EXPECT_MSG_EQ(f->GetDataLinkType(1), 9, "Wrong data link type");
+        NS_TEST_EXPECT_MSG_EQ(f->GetSnapLen(1), 4, "Wrong snap length");
+
+        const uint8_t data[] = {1, 2, 3, 4, 5, 6};
+        f->Write(0, 0x100000002ULL, data, 6);
+        f->Write(1, 3, data, 6);
+        NS_TEST_EXPECT_MSG_EQ(f->Fail(), false, "Write must not fail");
+    }
+
+    std::ifstream file(filename, std::ios::binary);
+    std::ostringstream stream;
+    stream << file.rdbuf();
+    std::string content = stream.str();
+
+    // Section header, 2 interfaces with their names and resolution,
+    // 2 packets padded to 8 bytes, and the second one truncated to 4
+    NS_TEST_ASSERT_MSG_EQ(content.size(), 28 + 40 + 44 + 40 + 36, "Unexpected file size");
+    auto word = [&content](uint32_t offset) {
+        uint32_t value;
+        memcpy(&value, content.data() + offset, sizeof(value));
+        return value;
+    };
+    NS_TEST_EXPECT_MSG_EQ(word(0), 0x0a0d0d0a, "Wrong section header block type");
+    NS_TEST_EXPECT_MSG_EQ(word(8), 0x1a2b3c4d, "Wrong byte-order magic");
+    NS_TEST_EXPECT_MSG_EQ(word(28), 1, "Wrong interface description block type");
+    NS_TEST_EXPECT_MSG_EQ(word(32), 40, "Wrong interface description block length");
+    NS_TEST_EXPECT_MSG_EQ(content.substr(48, 1), "a", "Wrong interface name");
+    NS_TEST_EXPECT_MSG_EQ((word(68 + 8) & 0xffff), 9, "Wrong data link type");
+    NS_TEST_EXPECT_MSG_EQ(content.substr(68 + 20, 6), "device", "Wrong interface name");
+
+    uint32_t packet = 28 + 40 + 44;
+    NS_TEST_EXPECT_MSG_EQ(word(packet), 6, "Wrong enhanced packet block type");
+    NS_TEST_EXPECT_MSG_EQ(word(packet + 4), 40, "Wrong enhanced packet block length");
+    NS_TEST_EXPECT_MSG_EQ(word(packet + 8), 0, "Wrong interface");
+    NS_TEST_EXPECT_MSG_EQ(word(packet + 12), 1, "Wrong timestamp");
+    NS_TEST_EXPECT_MSG_EQ(word(packet + 16), 2, "Wrong timestamp");
+    NS_TEST_EXPECT_MSG_EQ(word(packet + 20), 6, "Wrong captured length");
+    NS_TEST_EXPECT_MSG_EQ(word(packet + 24), 6, "Wrong original length");
+    NS_TEST_EXPECT_MSG_EQ(content[packet + 33], 6, "Wrong packet data");
+    NS_TEST_EXPECT_MSG_EQ(word(packet + 36), 40, "Wrong trailing block length");
+
+    packet += 40;
+    NS_TEST_EXPECT_MSG_EQ(word(packet + 8), 1, "Wrong interface");
+    NS_TEST_EXPECT_MSG_EQ(word(packet + 16), 3, "Wrong timestamp");
+    NS_TEST_EXPECT_MSG_EQ(word(packet + 20), 4, "Wrong captured length");
+    NS_TEST_EXPECT_MSG_EQ(word(packet + 24), 6, "Wrong original length");
+    NS_TEST_EXPECT_MSG_EQ(word(packet + 32), 36, "Wrong trailing block length");
+
+    remove(filename.c_str());
+}
+
 /**
  * \ingroup network-test
  * \ingroup tests
@@ -1394,6 +1569,9 @@ PcapFileTestSuite::PcapFileTestSuite()
     // AddTestCase (new AppendModeCreateTestCase, TestCase::QUICK);
     AddTestCase(new FileHeaderTestCase, TestCase::QUICK);
     AddTestCase(new RecordHeaderTestCase, TestCase::QUICK);
+    AddTestCase(new BatchedWriteTestCase, TestCase::QUICK);
+    AddTestCase(new PcapNgFileTestCase, TestCase::QUICK);
+    // these two read known.pcap from the data directory
     AddTestCase(new ReadFileTestCase, TestCase::QUICK);
     AddTestCase(new DiffTestCase, TestCase::QUICK);
 }
@@ -20,10 +20,12 @@
 #include "ethernet-header.h"
 
 #include "address-utils.h"
+#include "llc-snap-header.h"
 
 #include "ns3/assert.h"
 #include "ns3/header.h"
 #include "ns3/log.h"
+#include "ns3/packet.h"
 
 #include <iomanip>
 #include <iostream>
@@ -196,4 +198,55 @@ EthernetHeader::Deserialize(Buffer::Iterator start)
     return GetSerializedSize();
 }
 
+namespace
+{
+
+/**
+ * \ingroup network
+ * Parser of the EthernetHeader, for lazy printing (see Packet::EnableLazyPrinting)
+ */
+class EthernetHeaderParser
+{
+  public:
+    EthernetHeaderParser()
+    {
+        Packet::RegisterHeaderParser(EthernetHeader::GetTypeId(),
+                                     MakeCallback(&EthernetHeaderParser::GetNextHeader));
+    }
+
+    /**
+     * \param [in] header An EthernetHeader.
+     * \returns The type of the header following it.
+     */
+    static TypeId GetNextHeader(const Header& header)
+    {
+        uint16_t lengthType = static_cast<const EthernetHeader&>(header).GetLengthType();
+        if (lengthType <= 1500)
+        {
+            // a length: the frame carries an LLC header
+            return LlcSnapHeader::GetTypeId();
+        }
+        std::string name;
+        switch (lengthType)
+        {
+        case 0x0800:
+            name = "ns3::Ipv4Header";
+            break;
+        case 0x0806:
+            name = "ns3::ArpHeader";
+            break;
+        case 0x86DD:
+            name = "ns3::Ipv6Header";
+            break;
+        default:
+            return TypeId();
+        }
+        TypeId tid;
+        TypeId::LookupByNameFailSafe(name, &tid);
+        return tid;
+    }
+} g_ethernetHeaderParser; ///< the parser of EthernetHeader
+
+} // namespace
+
 } // namespace ns3
@@ -0,0 +1,216 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "ip-checksum.h"
+
+#include <algorithm>
+
+#if defined(__x86_64__) && defined(__GNUC__)
+#define IP_CHECKSUM_X86
+#include <immintrin.h>
+#endif
+
+/**
+ * \file
+ * \ingroup network
+ * ns3::OnesComplementSum implementation.
+ */
+
+namespace ns3
+{
+
+/**
+ * \ingroup network
+ * Adds the 16-bit words of a buffer.
+ * \param data buffer to sum
+ * \param length the length of the buffer (bytes)
+ * \returns the sum, not folded.
+ */
+typedef uint64_t (*SumFunction)(const uint8_t* data, uint32_t length);
+
+/**
+ * \ingroup network
+ * Folds a sum of 16-bit words to 16 bits, in one's complement arithmetic.
+ * \param sum the sum
+ * \returns the folded sum.
+ */
+static uint16_t
+Fold(uint64_t sum)
+{
+    while (sum >> 16)
+    {
+        sum = (sum & 0xffff) + (sum >> 16);
+    }
+    return sum;
+}
+
+/**
+ * \ingroup network
+ * Adds the 16-bit words of a buffer one at a time.
+ * \param data buffer to sum
+ * \param length the length of the buffer (bytes)
+ * \returns the sum, not folded.
+ */
+static uint64_t
+SumScalar(const uint8_t* data, uint32_t length)
+{
+    uint64_t sum = 0;
+    for (uint32_t i = 1; i < length; i += 2)
+    {
+        sum += data[i - 1] | (data[i] << 8);
+    }
+    if (length & 1)
+    {
+        sum += data[length - 1];
+    }
+    return sum;
+}
+
+#ifdef IP_CHECKSUM_X86
+
+/**
+ * \ingroup network
+ * Maximum number of vectors added in 32-bit lanes before they are
+ * added to the 64-bit sum: each lane adds one 16-bit word per vector,
+ * and 65536 words cannot overflow it.
+ */
+static const uint32_t MAX_VECTORS = 65536;
+
+/**
+ * \ingroup network
+ * Adds the 16-bit words of a buffer 16 bytes at a time, with SSE2.
+ * \param data buffer to sum
+ * \param length the length of the buffer (bytes)
+ * \returns the sum, not folded.
+ */
+static uint64_t
+SumSse2(const uint8_t* data, uint32_t length)
+{
+    const __m128i zero = _mm_setzero_si128();
+    uint64_t sum = 0;
+    while (length >= 16)
+    {
+        uint32_t vectors = std::min(length / 16, MAX_VECTORS);
+        __m128i lo = zero;
+        __m128i hi = zero;
+        for (uint32_t i = 0; i < vectors; i++)
+        {
+            __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data));
+            lo = _mm_add_epi32(lo, _mm_unpacklo_epi16(v, zero));
+            hi = _mm_add_epi32(hi, _mm_unpackhi_epi16(v, zero));
+            data += 16;
+        }
+        length -= vectors * 16;
+        uint32_t lanes[8];
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(lanes), lo);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(lanes + 4), hi);
+        for (uint32_t lane : lanes)
+        {
+            sum += lane;
+        }
+    }
+    return sum + SumScalar(data, length);
+}
+
+/**
+ * \ingroup network
+ * Adds the 16-bit words of a buffer 32 bytes at a time, with AVX2.
+ * \param data buffer to sum
+ * \param length the length of the buffer (bytes)
+ * \returns the sum, not folded.
+ */
+__attribute__((target("avx2"))) static uint64_t
+SumAvx2(const uint8_t* data, uint32_t length)
+{
+    const __m256i zero = _mm256_setzero_si256();
+    uint64_t sum = 0;
+    while (length >= 32)
+    {
+        uint32_t vectors = std::min(length / 32, MAX_VECTORS);
+        __m256i lo = zero;
+        __m256i hi = zero;
+        for (uint32_t i = 0; i < vectors; i++)
+        {
+            __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data));
+            lo = _mm256_add_epi32(lo, _mm256_unpacklo_epi16(v, zero));
+            hi = _mm256_add_epi32(hi, _mm256_unpackhi_epi16(v, zero));
+            data += 32;
+        }
+        length -= vectors * 32;
+        uint32_t lanes[16];
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(lanes), lo);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(lanes + 8), hi);
+        for (uint32_t lane : lanes)
+        {
+            sum += lane;
+        }
+    }
+    return sum + SumScalar(data, length);
+}
+
+#endif /* IP_CHECKSUM_X86 */
+
+/**
+ * \ingroup network
+ * The implementation of OnesComplementSum.
+ */
+struct SumKernel
+{
+    SumFunction sum;  //!< The function adding the words
+    const char* name; //!< The name of the instructions used
+};
+
+/**
+ * \ingroup network
+ * \returns the fastest implementation supported by the processor,
+ * selected on first use.
+ */
+static const SumKernel&
+GetSumKernel()
+{
+    static const SumKernel kernel = []() -> SumKernel {
+#ifdef IP_CHECKSUM_X86
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx2"))
+        {
+            return {&SumAvx2, "avx2"};
+        }
+        return {&SumSse2, "sse2"};
+#else
+        return {&SumScalar, "scalar"};
+#endif
+    }();
+    return kernel;
+}
+
+uint16_t
+OnesComplementSum(const uint8_t* data, uint32_t length)
+{
+    return Fold(GetSumKernel().sum(data, length));
+}
+
+uint16_t
+OnesComplementSumScalar(const uint8_t* data, uint32_t length)
+{
+    return Fold(SumScalar(data, length));
+}
+
+const char*
+GetOnesComplementSumKernel()
+{
+    return GetSumKernel().name;
+}
+
+} // namespace ns3
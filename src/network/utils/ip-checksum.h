@@ -0,0 +1,57 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+#ifndef IP_CHECKSUM_H
+#define IP_CHECKSUM_H
+#include <stdint.h>
+
+namespace ns3
+{
+
+/**
+ * \ingroup network
+ * Calculates the one's complement sum used by the Internet checksum (RFC 1071).
+ *
+ * The bytes are summed as 16-bit words whose first byte is the least
+ * significant one, the way Buffer::Iterator::ReadU16 reads them.  An odd
+ * last byte is the least significant byte of a word.  The checksum is the
+ * complement of the sum, written back with Buffer::Iterator::WriteU16.
+ *
+ * The sum is vectorized with AVX2 or SSE2 when the processor supports them.
+ *
+ * \param data buffer to calculate the sum for
+ * \param length the length of the buffer (bytes)
+ * \returns the sum, folded to 16 bits.
+ */
+uint16_t OnesComplementSum(const uint8_t* data, uint32_t length);
+
+/**
+ * Calculates the one's complement sum of OnesComplementSum one word at a
+ * time, without vector instructions.
+ *
+ * \param data buffer to calculate the sum for
+ * \param length the length of the buffer (bytes)
+ * \returns the sum, folded to 16 bits.
+ */
+uint16_t OnesComplementSumScalar(const uint8_t* data, uint32_t length);
+
+/**
+ * \returns the name of the instructions used by OnesComplementSum:
+ * "avx2", "sse2" or "scalar".
+ */
+const char* GetOnesComplementSumKernel();
+
+} // namespace ns3
+
+#endif
@@ -21,6 +21,7 @@
 
 #include "ns3/assert.h"
 #include "ns3/log.h"
+#include "ns3/packet.h"
 
 #include <string>
 
@@ -103,4 +104,50 @@ LlcSnapHeader::Deserialize(Buffer::Iterator start)
     return GetSerializedSize();
 }
 
+namespace
+{
+
+/**
+ * \ingroup network
+ * Parser of the LlcSnapHeader, for lazy printing (see Packet::EnableLazyPrinting)
+ */
+class LlcSnapHeaderParser
+{
+  public:
+    LlcSnapHeaderParser()
+    {
+        Packet::RegisterHeaderParser(LlcSnapHeader::GetTypeId(),
+                                     MakeCallback(&LlcSnapHeaderParser::GetNextHeader));
+    }
+
+    /**
+     * \param [in] header An LlcSnapHeader.
+     * \returns The type of the header following it.
+     */
+    static TypeId GetNextHeader(const Header& header)
+    {
+        LlcSnapHeader llc = static_cast<const LlcSnapHeader&>(header);
+        std::string name;
+        switch (llc.GetType())
+        {
+        case 0x0800:
+            name = "ns3::Ipv4Header";
+            break;
+        case 0x0806:
+            name = "ns3::ArpHeader";
+            break;
+        case 0x86DD:
+            name = "ns3::Ipv6Header";
+            break;
+        default:
+            return TypeId();
+        }
+        TypeId tid;
+        TypeId::LookupByNameFailSafe(name, &tid);
+        return tid;
+    }
+} g_llcSnapHeaderParser; ///< the parser of LlcSnapHeader
+
+} // namespace
+
 } // namespace ns3
@@ -0,0 +1,838 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "multithreaded-simulator-impl.h"
+
+#include "ns3/abort.h"
+#include "ns3/assert.h"
+#include "ns3/channel-list.h"
+#include "ns3/channel.h"
+#include "ns3/log.h"
+#include "ns3/net-device.h"
+#include "ns3/node-list.h"
+#include "ns3/node.h"
+#include "ns3/nstime.h"
+#include "ns3/packet.h"
+#include "ns3/simulator.h"
+#include "ns3/uinteger.h"
+
+#include <algorithm>
+#include <limits>
+#include <numeric>
+
+/**
+ * \file
+ * \ingroup simulator
+ * ns3::MultithreadedSimulatorImpl implementation.
+ */
+
+namespace ns3
+{
+
+// Note:  Logging in this file is largely avoided due to the
+// number of calls that are made to these functions and the possibility
+// of causing recursions leading to stack overflow
+NS_LOG_COMPONENT_DEFINE("MultithreadedSimulatorImpl");
+
+NS_OBJECT_ENSURE_REGISTERED(MultithreadedSimulatorImpl);
+
+/** Timestamp meaning "no event". */
+static const uint64_t NO_TS = std::numeric_limits<uint64_t>::max();
+
+/**
+ * \param [in] channel A channel.
+ * \return Whether the devices of the channel only reach each other through
+ * events scheduled with the channel delay, so their nodes can run apart.
+ */
+static bool
+IsSeparable(Ptr<Channel> channel)
+{
+    TypeId tid = channel->GetInstanceTypeId();
+    for (const char* name : {"ns3::PointToPointChannel", "ns3::SimpleChannel"})
+    {
+        TypeId separable;
+        if (TypeId::LookupByNameFailSafe(name, &separable) &&
+            (tid == separable || tid.IsChildOf(separable)))
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+thread_local MultithreadedSimulatorImpl::Partition* MultithreadedSimulatorImpl::m_current =
+    nullptr;
+
+TypeId
+MultithreadedSimulatorImpl::GetTypeId()
+{
+    static TypeId tid =
+        TypeId("ns3::MultithreadedSimulatorImpl")
+            .SetParent<SimulatorImpl>()
+            .SetGroupName("Network")
+            .AddConstructor<MultithreadedSimulatorImpl>()
+            .AddAttribute("MaxThreads",
+                          "The largest number of threads, and partitions, to use; "
+                          "a build without NS3_MTP always uses one",
+                          UintegerValue(1),
+                          MakeUintegerAccessor(&MultithreadedSimulatorImpl::m_maxThreads),
+                          MakeUintegerChecker<uint32_t>(1));
+    return tid;
+}
+
+MultithreadedSimulatorImpl::MultithreadedSimulatorImpl()
+    : m_global(new Partition),
+      m_nPartitionedNodes(0),
+      m_nPartitionedChannels(0),
+      m_lookahead(NO_TS),
+      m_windowEnd(NO_TS),
+      m_uidStride(1),
+      m_maxThreads(1),
+      m_stop(false),
+      m_stopTs(NO_TS),
+      m_generation(0),
+      m_busyWorkers(0),
+      m_exit(false),
+      m_mainThreadId(std::this_thread::get_id())
+{
+    NS_LOG_FUNCTION(this);
+}
+
+MultithreadedSimulatorImpl::~MultithreadedSimulatorImpl()
+{
+    NS_LOG_FUNCTION(this);
+}
+
+void
+MultithreadedSimulatorImpl::DoDispose()
+{
+    NS_LOG_FUNCTION(this);
+    StopWorkers();
+    MergeOutboxes();
+
+    for (auto& partition : m_partitions)
+    {
+        while (!partition->events->IsEmpty())
+        {
+            Scheduler::Event next = partition->events->RemoveNext();
+            next.impl->Unref();
+        }
+    }
+    m_partitions.clear();
+    if (m_global->events)
+    {
+        while (!m_global->events->IsEmpty())
+        {
+            Scheduler::Event next = m_global->events->RemoveNext();
+            next.impl->Unref();
+        }
+        m_global->events = nullptr;
+    }
+    SimulatorImpl::DoDispose();
+}
+
+void
+MultithreadedSimulatorImpl::Destroy()
+{
+    NS_LOG_FUNCTION(this);
+    while (!m_destroyEvents.empty())
+    {
+        Ptr<EventImpl> ev = m_destroyEvents.front().PeekEventImpl();
+        m_destroyEvents.pop_front();
+        NS_LOG_LOGIC("handle destroy " << ev);
+        if (!ev->IsCancelled())
+        {
+            ev->Invoke();
+        }
+    }
+}
+
+void
+MultithreadedSimulatorImpl::SetScheduler(ObjectFactory schedulerFactory)
+{
+    NS_LOG_FUNCTION(this << schedulerFactory);
+    m_schedulerFactory = schedulerFactory;
+
+    std::vector<Partition*> partitions{m_global.get()};
+    for (auto& partition : m_partitions)
+    {
+        partitions.push_back(partition.get());
+    }
+    for (auto partition : partitions)
+    {
+        Ptr<Scheduler> scheduler = schedulerFactory.Create<Scheduler>();
+        if (partition->events)
+        {
+            while (!partition->events->IsEmpty())
+            {
+                scheduler->Insert(partition->events->RemoveNext());
+            }
+        }
+        partition->events = scheduler;
+    }
+}
+
+// System ID for non-distributed simulation is always zero
+uint32_t
+MultithreadedSimulatorImpl::GetSystemId() const
+{
+    return 0;
+}
+
+MultithreadedSimulatorImpl::Partition*
+MultithreadedSimulatorImpl::GetPartition(uint32_t context) const
+{
+    if (context == Simulator::NO_CONTEXT || m_partitions.empty())
+    {
+        return m_global.get();
+    }
+    // contexts that are not node ids stay with the first partition
+    if (context >= m_partitionOf.size())
+    {
+        return m_partitions.front().get();
+    }
+    return m_partitions[m_partitionOf[context]].get();
+}
+
+MultithreadedSimulatorImpl::Partition*
+MultithreadedSimulatorImpl::GetCurrent() const
+{
+    return m_current ? m_current : m_global.get();
+}
+
+uint64_t
+MultithreadedSimulatorImpl::GetNextTs(const Partition* partition) const
+{
+    if (partition->events->IsEmpty())
+    {
+        return NO_TS;
+    }
+    return partition->events->PeekNext().key.m_ts;
+}
+
+EventId
+MultithreadedSimulatorImpl::Insert(Partition* partition,
+                                   uint64_t ts,
+                                   uint32_t context,
+                                   EventImpl* event)
+{
+    Scheduler::Event ev;
+    ev.impl = event;
+    ev.key.m_ts = ts;
+    ev.key.m_context = context;
+    ev.key.m_uid = partition->uid;
+    partition->uid += m_uidStride;
+    partition->unscheduledEvents++;
+    partition->events->Insert(ev);
+    return EventId(event, ev.key.m_ts, ev.key.m_context, ev.key.m_uid);
+}
+
+bool
+MultithreadedSimulatorImpl::TopologyChanged() const
+{
+    return NodeList::GetNNodes() != m_nPartitionedNodes ||
+           ChannelList::GetNChannels() != m_nPartitionedChannels;
+}
+
+void
+MultithreadedSimulatorImpl::DoPartition()
+{
+    NS_LOG_FUNCTION(this);
+
+    // take all events back, the node to partition mapping may change
+    uint32_t base = m_global->uid;
+    for (auto& partition : m_partitions)
+    {
+        while (!partition->events->IsEmpty())
+        {
+            m_global->events->Insert(partition->events->RemoveNext());
+        }
+        m_global->unscheduledEvents += partition->unscheduledEvents;
+        m_global->eventCount += partition->eventCount;
+        m_global->currentTs = std::max(m_global->currentTs, partition->currentTs);
+        base = std::max(base, partition->uid);
+    }
+    m_partitions.clear();
+    m_global->uid = base;
+    m_uidStride = 1;
+
+    uint32_t nNodes = NodeList::GetNNodes();
+    m_nPartitionedNodes = nNodes;
+    m_nPartitionedChannels = ChannelList::GetNChannels();
+    if (nNodes == 0)
+    {
+        m_partitionOf.clear();
+        m_lookahead = NO_TS;
+        return;
+    }
+
+    // nodes that cannot run apart are joined into components
+    std::vector<uint32_t> parent(nNodes);
+    std::iota(parent.begin(), parent.end(), 0);
+    auto find = [&parent](uint32_t node) {
+        while (parent[node] != node)
+        {
+            parent[node] = parent[parent[node]];
+            node = parent[node];
+        }
+        return node;
+    };
+
+    std::vector<std::pair<std::vector<uint32_t>, uint64_t>> links;
+    for (auto it = ChannelList::Begin(); it != ChannelList::End(); ++it)
+    {
+        Ptr<Channel> channel = *it;
+        std::vector<uint32_t> nodes;
+        for (std::size_t i = 0; i < channel->GetNDevices(); i++)
+        {
+            Ptr<NetDevice> device = channel->GetDevice(i);
+            if (device && device->GetNode())
+            {
+                nodes.push_back(device->GetNode()->GetId());
+            }
+        }
+
+        TimeValue delay;
+        if (nodes.size() == 2 && IsSeparable(channel) &&
+            channel->GetAttributeFailSafe("Delay", delay) && delay.Get().IsStrictlyPositive())
+        {
+            links.emplace_back(nodes, delay.Get().GetTimeStep());
+            continue;
+        }
+        // shared media and instantaneous channels are read by all their nodes
+        for (uint32_t node : nodes)
+        {
+            parent[find(node)] = find(nodes.front());
+        }
+    }
+
+    std::vector<std::vector<uint32_t>> components(nNodes);
+    for (uint32_t node = 0; node < nNodes; node++)
+    {
+        components[find(node)].push_back(node);
+    }
+    components.erase(std::remove_if(components.begin(),
+                                    components.end(),
+                                    [](const std::vector<uint32_t>& c) { return c.empty(); }),
+                     components.end());
+    // largest first, ties by lowest node id, so the result is reproducible
+    std::stable_sort(components.begin(),
+                     components.end(),
+                     [](const std::vector<uint32_t>& a, const std::vector<uint32_t>& b) {
+                         return a.size() > b.size();
+                     });
+
+    uint32_t nPartitions = std::min<uint32_t>(m_maxThreads, components.size());
+#ifndef NS3_MTP
+    if (nPartitions > 1)
+    {
+        // packets and reference counts are not thread-safe without NS3_MTP
+        NS_LOG_WARN("MaxThreads " << m_maxThreads << " needs a build with NS3_MTP, "
+                                  << "running on a single thread");
+        nPartitions = 1;
+    }
+#endif
+
+    std::vector<uint32_t> load(nPartitions, 0);
+    m_partitionOf.assign(nNodes, 0);
+    for (auto& component : components)
+    {
+        uint32_t target = std::min_element(load.begin(), load.end()) - load.begin();
+        load[target] += component.size();
+        for (uint32_t node : component)
+        {
+            m_partitionOf[node] = target;
+        }
+    }
+
+    m_lookahead = NO_TS;
+    for (auto& link : links)
+    {
+        if (m_partitionOf[link.first[0]] != m_partitionOf[link.first[1]])
+        {
+            m_lookahead = std::min(m_lookahead, link.second);
+        }
+    }
+
+    // partition i hands out uids base + i + k * stride and the global queue
+    // the last slot, so uids stay unique when events move between them
+    for (uint32_t i = 0; i < nPartitions; i++)
+    {
+        auto partition = std::make_unique<Partition>();
+        partition->events = m_schedulerFactory.Create<Scheduler>();
+        partition->currentTs = m_global->currentTs;
+        partition->index = i;
+        partition->uid = base + i;
+        partition->outbox.resize(nPartitions + 1);
+        m_partitions.push_back(std::move(partition));
+    }
+    m_global->index = nPartitions;
+    m_global->uid = base + nPartitions;
+    m_uidStride = nPartitions + 1;
+
+#ifdef NS3_MTP
+    // partition i numbers its packets from (i + 1) << 32, above the system
+    // id of the global counter; the counters outlive the partitions so that
+    // no uid is handed out twice
+    for (uint32_t i = m_packetUids.size(); i < nPartitions; i++)
+    {
+        m_packetUids.push_back(static_cast<uint64_t>(i + 1) << 32);
+    }
+#endif
+
+    std::vector<Scheduler::Event> global;
+    while (!m_global->events->IsEmpty())
+    {
+        Scheduler::Event ev = m_global->events->RemoveNext();
+        Partition* partition = GetPartition(ev.key.m_context);
+        if (partition == m_global.get())
+        {
+            global.push_back(ev);
+            continue;
+        }
+        partition->events->Insert(ev);
+        partition->unscheduledEvents++;
+        m_global->unscheduledEvents--;
+    }
+    for (auto& ev : global)
+    {
+        m_global->events->Insert(ev);
+    }
+
+    NS_LOG_INFO(nNodes << " nodes in " << components.size() << " components, "
+                       << nPartitions << " partitions, lookahead "
+                       << (m_lookahead == NO_TS ? Time::Max() : TimeStep(m_lookahead)));
+}
+
+void
+MultithreadedSimulatorImpl::ProcessOneEvent(Partition* partition)
+{
+    Scheduler::Event next = partition->events->RemoveNext();
+
+    PreEventHook(EventId(next.impl, next.key.m_ts, next.key.m_context, next.key.m_uid));
+
+    NS_ASSERT(next.key.m_ts >= partition->currentTs);
+    partition->unscheduledEvents--;
+    partition->eventCount++;
+
+    partition->currentTs = next.key.m_ts;
+    partition->currentContext = next.key.m_context;
+    partition->currentUid = next.key.m_uid;
+    next.impl->Invoke();
+    next.impl->Unref();
+}
+
+void
+MultithreadedSimulatorImpl::ProcessWindow(Partition* partition)
+{
+    m_current = partition;
+#ifdef NS3_MTP
+    // a single partition keeps the uids of a sequential run
+    if (m_partitions.size() > 1)
+    {
+        Packet::SetUidCounter(&m_packetUids[partition->index]);
+    }
+#endif
+    while (!partition->events->IsEmpty() && !m_stop.load(std::memory_order_relaxed) &&
+           partition->events->PeekNext().key.m_ts < m_windowEnd)
+    {
+        ProcessOneEvent(partition);
+    }
+#ifdef NS3_MTP
+    Packet::SetUidCounter(nullptr);
+#endif
+    m_current = nullptr;
+}
+
+void
+MultithreadedSimulatorImpl::MergeOutboxes()
+{
+    // a fixed order keeps the uids, and so the runs, reproducible
+    for (std::size_t dst = 0; dst <= m_partitions.size(); dst++)
+    {
+        Partition* target = dst < m_partitions.size() ? m_partitions[dst].get() : m_global.get();
+        for (auto& source : m_partitions)
+        {
+            for (auto& ev : source->outbox[dst])
+            {
+                Insert(target, ev.ts, ev.context, ev.event);
+            }
+            source->outbox[dst].clear();
+        }
+    }
+}
+
+void
+MultithreadedSimulatorImpl::WorkerLoop(uint32_t index)
+{
+    Partition* partition = m_partitions[index].get();
+    uint32_t seen = 0;
+    while (true)
+    {
+        uint32_t generation;
+        while ((generation = m_generation.load(std::memory_order_acquire)) == seen)
+        {
+            std::this_thread::yield();
+        }
+        seen = generation;
+        if (m_exit.load(std::memory_order_relaxed))
+        {
+            return;
+        }
+        ProcessWindow(partition);
+        m_busyWorkers.fetch_sub(1, std::memory_order_release);
+    }
+}
+
+void
+MultithreadedSimulatorImpl::StartWorkers()
+{
+    m_exit = false;
+    for (uint32_t i = 1; i < m_partitions.size(); i++)
+    {
+        m_workers.emplace_back(&MultithreadedSimulatorImpl::WorkerLoop, this, i);
+    }
+}
+
+void
+MultithreadedSimulatorImpl::StopWorkers()
+{
+    if (m_workers.empty())
+    {
+        return;
+    }
+    m_exit.store(true, std::memory_order_relaxed);
+    m_generation.fetch_add(1, std::memory_order_release);
+    for (auto& worker : m_workers)
+    {
+        worker.join();
+    }
+    m_workers.clear();
+}
+
+bool
+MultithreadedSimulatorImpl::IsFinished() const
+{
+    if (m_stop)
+    {
+        return true;
+    }
+    for (auto& partition : m_partitions)
+    {
+        if (!partition->events->IsEmpty())
+        {
+            return false;
+        }
+    }
+    return m_global->events->IsEmpty();
+}
+
+void
+MultithreadedSimulatorImpl::Run()
+{
+    NS_LOG_FUNCTION(this);
+    // Set the current threadId as the main threadId
+    m_mainThreadId = std::this_thread::get_id();
+    if (m_partitions.empty() || TopologyChanged())
+    {
+        DoPartition();
+    }
+    m_stop = false;
+    StartWorkers();
+
+    while (!m_stop)
+    {
+        uint64_t next = NO_TS;
+        for (auto& partition : m_partitions)
+        {
+            next = std::min(next, GetNextTs(partition.get()));
+        }
+        uint64_t nextGlobal = GetNextTs(m_global.get());
+        uint64_t first = std::min(next, nextGlobal);
+
+        // a requested stop time acts like an event after those at the same time
+        uint64_t stopTs = m_stopTs.load();
+        if (stopTs < first)
+        {
+            std::unique_lock lock{m_stopMutex};
+            m_stopTimes.erase(m_stopTimes.begin());
+            m_stopTs = m_stopTimes.empty() ? NO_TS : *m_stopTimes.begin();
+            m_global->currentTs = std::max(m_global->currentTs, stopTs);
+            m_stop = true;
+            break;
+        }
+        if (first == NO_TS)
+        {
+            break;
+        }
+
+        // global events run alone, every partition waits at their time
+        if (nextGlobal == first)
+        {
+            ProcessOneEvent(m_global.get());
+            continue;
+        }
+
+        m_windowEnd = m_lookahead == NO_TS ? NO_TS : first + m_lookahead;
+        m_windowEnd = std::min({m_windowEnd, nextGlobal, stopTs == NO_TS ? NO_TS : stopTs + 1});
+        if (m_workers.empty())
+        {
+            // at most one partition, run by the calling thread
+            for (auto& partition : m_partitions)
+            {
+                ProcessWindow(partition.get());
+            }
+        }
+        else
+        {
+            m_busyWorkers.store(m_workers.size(), std::memory_order_relaxed);
+            m_generation.fetch_add(1, std::memory_order_release);
+            ProcessWindow(m_partitions.front().get());
+            while (m_busyWorkers.load(std::memory_order_acquire) > 0)
+            {
+                std::this_thread::yield();
+            }
+        }
+        MergeOutboxes();
+    }
+    StopWorkers();
+    m_windowEnd = NO_TS;
+
+    // the main thread continues from the latest time any partition reached
+    for (auto& partition : m_partitions)
+    {
+        m_global->currentTs = std::max(m_global->currentTs, partition->currentTs);
+    }
+
+    // If the simulator stopped naturally by lack of events, make a
+    // consistency test to check that we didn't lose any events along the way.
+    [[maybe_unused]] int unscheduledEvents = m_global->unscheduledEvents;
+    for (auto& partition : m_partitions)
+    {
+        unscheduledEvents += partition->unscheduledEvents;
+    }
+    NS_ASSERT(!IsFinished() || m_stop || unscheduledEvents == 0);
+}
+
+void
+MultithreadedSimulatorImpl::Stop()
+{
+    NS_LOG_FUNCTION(this);
+    m_stop = true;
+}
+
+void
+MultithreadedSimulatorImpl::Stop(const Time& delay)
+{
+    NS_LOG_FUNCTION(this << delay.GetTimeStep());
+    std::unique_lock lock{m_stopMutex};
+    m_stopTimes.insert(GetCurrent()->currentTs + delay.GetTimeStep());
+    m_stopTs = *m_stopTimes.begin();
+}
+
+//
+// Schedule an event for a _relative_ time in the future.
+//
+EventId
+MultithreadedSimulatorImpl::Schedule(const Time& delay, EventImpl* event)
+{
+    NS_ASSERT_MSG(delay.IsPositive(), "MultithreadedSimulatorImpl::Schedule(): Negative delay");
+    Partition* current = GetCurrent();
+    NS_ASSERT_MSG(current != m_global.get() || m_mainThreadId == std::this_thread::get_id(),
+                  "Simulator::Schedule Thread-unsafe invocation!");
+
+    uint64_t ts = current->currentTs + delay.GetTimeStep();
+    return Insert(current, ts, current->currentContext, event);
+}
+
+void
+MultithreadedSimulatorImpl::ScheduleWithContext(uint32_t context,
+                                                const Time& delay,
+                                                EventImpl* event)
+{
+    Partition* current = GetCurrent();
+    NS_ASSERT_MSG(current != m_global.get() || m_mainThreadId == std::this_thread::get_id(),
+                  "Simulator::ScheduleWithContext Thread-unsafe invocation!");
+
+    uint64_t ts = current->currentTs + delay.GetTimeStep();
+    Partition* target = GetPartition(context);
+
+    // the partitions are stopped while the main thread runs
+    if (target == current || current == m_global.get())
+    {
+        Insert(target, ts, context, event);
+        return;
+    }
+
+    NS_ABORT_MSG_IF(ts < m_windowEnd,
+                    "Event for node " << context << " scheduled " << delay.As(Time::US)
+                                      << " ahead, below the lookahead of "
+                                      << TimeStep(m_lookahead).As(Time::US)
+                                      << "; connect the nodes with a channel");
+    current->outbox[target->index].push_back({ts, context, event});
+}
+
+EventId
+MultithreadedSimulatorImpl::ScheduleNow(EventImpl* event)
+{
+    return Schedule(Time(0), event);
+}
+
+EventId
+MultithreadedSimulatorImpl::ScheduleDestroy(EventImpl* event)
+{
+    NS_ASSERT_MSG(m_mainThreadId == std::this_thread::get_id() && !m_current,
+                  "Simulator::ScheduleDestroy Thread-unsafe invocation!");
+
+    EventId id(Ptr<EventImpl>(event, false), m_global->currentTs, 0xffffffff, 2);
+    m_destroyEvents.push_back(id);
+    return id;
+}
+
+Time
+MultithreadedSimulatorImpl::Now() const
+{
+    // Do not add function logging here, to avoid stack overflow
+    return TimeStep(GetCurrent()->currentTs);
+}
+
+Time
+MultithreadedSimulatorImpl::GetDelayLeft(const EventId& id) const
+{
+    if (IsExpired(id))
+    {
+        return TimeStep(0);
+    }
+    else
+    {
+        return TimeStep(id.GetTs() - GetCurrent()->currentTs);
+    }
+}
+
+void
+MultithreadedSimulatorImpl::Remove(const EventId& id)
+{
+    if (id.GetUid() == EventId::UID::DESTROY)
+    {
+        // destroy events.
+        for (auto i = m_destroyEvents.begin(); i != m_destroyEvents.end(); i++)
+        {
+            if (*i == id)
+            {
+                m_destroyEvents.erase(i);
+                break;
+            }
+        }
+        return;
+    }
+    if (IsExpired(id))
+    {
+        return;
+    }
+    Partition* partition = GetPartition(id.GetContext());
+    NS_ASSERT_MSG(partition == GetCurrent() || !m_current,
+                  "Simulator::Remove of an event of another partition");
+
+    Scheduler::Event event;
+    event.impl = id.PeekEventImpl();
+    event.key.m_ts = id.GetTs();
+    event.key.m_context = id.GetContext();
+    event.key.m_uid = id.GetUid();
+    partition->events->Remove(event);
+    event.impl->Cancel();
+    // whenever we remove an event from the event list, we have to unref it.
+    event.impl->Unref();
+
+    partition->unscheduledEvents--;
+}
+
+void
+MultithreadedSimulatorImpl::Cancel(const EventId& id)
+{
+    if (!IsExpired(id))
+    {
+        id.PeekEventImpl()->Cancel();
+    }
+}
+
+bool
+MultithreadedSimulatorImpl::IsExpired(const EventId& id) const
+{
+    if (id.GetUid() == EventId::UID::DESTROY)
+    {
+        if (id.PeekEventImpl() == nullptr || id.PeekEventImpl()->IsCancelled())
+        {
+            return true;
+        }
+        // destroy events.
+        for (auto i = m_destroyEvents.begin(); i != m_destroyEvents.end(); i++)
+        {
+            if (*i == id)
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+    // an event is compared with the clock of the partition it runs in
+    const Partition* partition = GetPartition(id.GetContext());
+    if (id.PeekEventImpl() == nullptr || id.GetTs() < partition->currentTs ||
+        (id.GetTs() == partition->currentTs && id.GetUid() <= partition->currentUid) ||
+        id.PeekEventImpl()->IsCancelled())
+    {
+        return true;
+    }
+    else
+    {
+        return false;
+    }
+}
+
+Time
+MultithreadedSimulatorImpl::GetMaximumSimulationTime() const
+{
+    return TimeStep(0x7fffffffffffffffLL);
+}
+
+uint32_t
+MultithreadedSimulatorImpl::GetContext() const
+{
+    return GetCurrent()->currentContext;
+}
+
+uint64_t
+MultithreadedSimulatorImpl::GetEventCount() const
+{
+    uint64_t count = m_global->eventCount;
+    for (auto& partition : m_partitions)
+    {
+        count += partition->eventCount;
+    }
+    return count;
+}
+
+uint32_t
+MultithreadedSimulatorImpl::GetNPartitions() const
+{
+    return m_partitions.size();
+}
+
+Time
+MultithreadedSimulatorImpl::GetLookahead() const
+{
+    return m_lookahead == NO_TS ? Time::Max() : TimeStep(m_lookahead);
+}
+
+} // namespace ns3
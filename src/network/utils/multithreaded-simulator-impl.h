@@ -0,0 +1,257 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef MULTITHREADED_SIMULATOR_IMPL_H
+#define MULTITHREADED_SIMULATOR_IMPL_H
+
+#include "ns3/event-id.h"
+#include "ns3/object-factory.h"
+#include "ns3/scheduler.h"
+#include "ns3/simulator-impl.h"
+
+#include <atomic>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <vector>
+
+/**
+ * \file
+ * \ingroup simulator
+ * ns3::MultithreadedSimulatorImpl declaration.
+ */
+
+namespace ns3
+{
+
+/**
+ * \ingroup simulator
+ *
+ * \brief Parallel simulator running the nodes of one process on several
+ * threads, without MPI.
+ *
+ * When Run() is called the nodes are split into partitions, one per thread.
+ * Partitions only talk to each other over PointToPointChannel and
+ * SimpleChannel links between two devices with a positive "Delay"; nodes
+ * joined by any other channel, such as a shared medium, always share a
+ * partition. The smallest delay of the links between partitions is the
+ * lookahead.
+ *
+ * Each partition has its own scheduler. The partitions advance in
+ * conservative windows: if T is the earliest pending event anywhere, every
+ * partition runs its events before T + lookahead in parallel, since no
+ * event scheduled by another partition can land in that window. Events for
+ * other partitions are appended to a per (source, destination) outbox that
+ * only the source thread writes, so scheduling needs neither locks nor
+ * atomics; the outboxes are merged in a fixed order between windows.
+ *
+ * Events without a context (scheduled from the main program or from other
+ * events without context) are global: they run alone, between windows, with
+ * every partition stopped at their timestamp.
+ *
+ * Existing programs run in parallel by selecting this class with the
+ * "SimulatorImplementationType" global value and raising MaxThreads, one
+ * by default, in a build configured with NS3_MTP, which makes packets and
+ * reference counts thread-safe. Without NS3_MTP the nodes stay in a single
+ * partition whatever MaxThreads is.
+ *
+ * With a single partition a run is identical to a DefaultSimulatorImpl
+ * run. With several, runs are reproducible for a given MaxThreads, as
+ * every partition numbers its events and packets on its own, but they are
+ * not identical to a sequential run:
+ * - an event received from another partition is numbered when the window
+ *   it was sent in ends, so it runs after the simultaneous events its
+ *   node's partition scheduled during that window, while a sequential run
+ *   orders all of them by the time they were scheduled at;
+ * - Packet uids are taken from a counter of each partition, not from the
+ *   global one.
+ *
+ * Models whose results do not depend on the order of simultaneous events
+ * or on Packet uids get the same results as in a sequential run.
+ *
+ * A ScheduleWithContext() towards a node of another partition with a delay
+ * below the lookahead is a fatal error; such nodes need to be connected by
+ * a channel so that they share a partition. Nodes created while the
+ * simulation runs belong to the first partition until the next Run().
+ */
+class MultithreadedSimulatorImpl : public SimulatorImpl
+{
+  public:
+    /**
+     *  Register this type.
+     *  \return The object TypeId.
+     */
+    static TypeId GetTypeId();
+
+    /** Constructor. */
+    MultithreadedSimulatorImpl();
+    /** Destructor. */
+    ~MultithreadedSimulatorImpl() override;
+
+    // Inherited
+    void Destroy() override;
+    bool IsFinished() const override;
+    void Stop() override;
+    void Stop(const Time& delay) override;
+    EventId Schedule(const Time& delay, EventImpl* event) override;
+    void ScheduleWithContext(uint32_t context, const Time& delay, EventImpl* event) override;
+    EventId ScheduleNow(EventImpl* event) override;
+    EventId ScheduleDestroy(EventImpl* event) override;
+    void Remove(const EventId& id) override;
+    void Cancel(const EventId& id) override;
+    bool IsExpired(const EventId& id) const override;
+    void Run() override;
+    Time Now() const override;
+    Time GetDelayLeft(const EventId& id) const override;
+    Time GetMaximumSimulationTime() const override;
+    void SetScheduler(ObjectFactory schedulerFactory) override;
+    uint32_t GetSystemId() const override;
+    uint32_t GetContext() const override;
+    uint64_t GetEventCount() const override;
+
+    /**
+     * \return The number of partitions the nodes were split into by the
+     * last Run(), zero before that.
+     */
+    uint32_t GetNPartitions() const;
+    /**
+     * \return The lookahead found by the last Run().
+     */
+    Time GetLookahead() const;
+
+  private:
+    void DoDispose() override;
+
+    /** An event for another partition, waiting in an outbox. */
+    struct CrossEvent
+    {
+        uint64_t ts;      //!< Absolute timestamp.
+        uint32_t context; //!< Execution context.
+        EventImpl* event; //!< The event implementation.
+    };
+
+    /** The events and the clock of one thread of execution. */
+    struct Partition
+    {
+        uint32_t index{0};                         //!< Position, global last.
+        Ptr<Scheduler> events;                     //!< Pending events.
+        uint64_t currentTs{0};                     //!< Timestamp of the current event.
+        uint32_t currentUid{EventId::UID::INVALID}; //!< Uid of the current event.
+        uint32_t currentContext{0xffffffff};       //!< Context of the current event.
+        uint32_t uid{EventId::UID::VALID};         //!< Next event uid.
+        uint64_t eventCount{0};                    //!< Events run.
+        int unscheduledEvents{0};                  //!< Events inserted but not yet run.
+        std::vector<std::vector<CrossEvent>> outbox; //!< Per destination, global last.
+    };
+
+    /**
+     * \param [in] context An event context.
+     * \return The partition whose thread runs the events of this context.
+     */
+    Partition* GetPartition(uint32_t context) const;
+    /** \return The partition of the calling thread. */
+    Partition* GetCurrent() const;
+    /** \return The timestamp of the next event of a partition, or the maximum. */
+    uint64_t GetNextTs(const Partition* partition) const;
+    /**
+     * Insert an event into a partition.
+     * \param [in] partition The partition.
+     * \param [in] ts The absolute timestamp.
+     * \param [in] context The execution context.
+     * \param [in] event The event implementation.
+     * \return The event id.
+     */
+    EventId Insert(Partition* partition, uint64_t ts, uint32_t context, EventImpl* event);
+
+    /** Split the nodes into partitions and hand them their events. */
+    void DoPartition();
+    /** \return Whether nodes or channels were added since DoPartition(). */
+    bool TopologyChanged() const;
+    /** Run the next event of a partition. */
+    void ProcessOneEvent(Partition* partition);
+    /** Run the events of a partition before the current window end. */
+    void ProcessWindow(Partition* partition);
+    /** Move the outboxes into the destination schedulers. */
+    void MergeOutboxes();
+    /** Start the worker threads, one per partition but the first. */
+    void StartWorkers();
+    /** Stop and join the worker threads. */
+    void StopWorkers();
+    /**
+     * Main loop of a worker thread.
+     * \param [in] index The partition run by the worker.
+     */
+    void WorkerLoop(uint32_t index);
+
+    /** Partition run by the calling thread, null outside of windows. */
+    static thread_local Partition* m_current;
+
+    /** Events without a context; before the first Run() all events. */
+    std::unique_ptr<Partition> m_global;
+    /** The partitions, one per thread. */
+    std::vector<std::unique_ptr<Partition>> m_partitions;
+    /** Partition index of each node. */
+    std::vector<uint32_t> m_partitionOf;
+    /** Number of nodes when the partitions were made. */
+    uint32_t m_nPartitionedNodes;
+    /** Number of channels when the partitions were made. */
+    uint32_t m_nPartitionedChannels;
+    /** Smallest delay of the links between partitions. */
+    uint64_t m_lookahead;
+    /** Exclusive end of the current window. */
+    uint64_t m_windowEnd;
+    /** Distance between the uids handed out by one partition. */
+    uint32_t m_uidStride;
+    /** Maximum number of threads, only one without NS3_MTP. */
+    uint32_t m_maxThreads;
+#ifdef NS3_MTP
+    /** Next packet uid of each partition, kept across DoPartition(). */
+    std::vector<uint64_t> m_packetUids;
+#endif
+    /** Creates the schedulers of the partitions. */
+    ObjectFactory m_schedulerFactory;
+
+    /** Container type for the events to run at Simulator::Destroy() */
+    typedef std::list<EventId> DestroyEvents;
+    /** The container of events to run at Destroy. */
+    DestroyEvents m_destroyEvents;
+
+    /** Flag calling for the end of the simulation. */
+    std::atomic<bool> m_stop;
+    /** Times requested with Stop(delay); the run ends after the first. */
+    std::multiset<uint64_t> m_stopTimes;
+    /** Protects m_stopTimes. */
+    std::mutex m_stopMutex;
+    /** First of m_stopTimes, readable without the lock. */
+    std::atomic<uint64_t> m_stopTs;
+
+    /** The worker threads. */
+    std::vector<std::thread> m_workers;
+    /** Bumped by the main thread to start a window. */
+    std::atomic<uint32_t> m_generation;
+    /** Workers still running the current window. */
+    std::atomic<uint32_t> m_busyWorkers;
+    /** Tells the workers to exit. */
+    std::atomic<bool> m_exit;
+
+    /** Main execution thread. */
+    std::thread::id m_mainThreadId;
+};
+
+} // namespace ns3
+
+#endif /* MULTITHREADED_SIMULATOR_IMPL_H */
@@ -17,10 +17,12 @@
 
 #include "pcap-file-wrapper.h"
 
+#include "ns3/abort.h"
 #include "ns3/boolean.h"
 #include "ns3/buffer.h"
 #include "ns3/header.h"
 #include "ns3/log.h"
+#include "ns3/string.h"
 #include "ns3/uinteger.h"
 
 namespace ns3
@@ -48,11 +50,31 @@ PcapFileWrapper::GetTypeId()
                           "microseconds(default).",
                           BooleanValue(false),
                           MakeBooleanAccessor(&PcapFileWrapper::m_nanosecMode),
-                          MakeBooleanChecker());
+                          MakeBooleanChecker())
+            .AddAttribute("BatchSize",
+                          "Size of the batches of packets written to the file at once, "
+                          "in bytes, or 0 to write each packet as it comes.",
+                          UintegerValue(0),
+                          MakeUintegerAccessor(&PcapFileWrapper::m_batchSize),
+                          MakeUintegerChecker<uint32_t>())
+            .AddAttribute("BackgroundWrite",
+                          "Whether the batches of packets are written by a background "
+                          "thread.  Only used if BatchSize is not 0.",
+                          BooleanValue(true),
+                          MakeBooleanAccessor(&PcapFileWrapper::m_backgroundWrite),
+                          MakeBooleanChecker())
+            .AddAttribute("MergedFile",
+                          "If not empty, the name of a pcapng file where the packets of "
+                          "all the files opened for writing are merged, as one interface "
+                          "per file.",
+                          StringValue(""),
+                          MakeStringAccessor(&PcapFileWrapper::m_mergedFilename),
+                          MakeStringChecker());
     return tid;
 }
 
 PcapFileWrapper::PcapFileWrapper()
+    : m_interface(0)
 {
     NS_LOG_FUNCTION(this);
 }
@@ -67,6 +89,10 @@ bool
 PcapFileWrapper::Fail() const
 {
     NS_LOG_FUNCTION(this);
+    if (IsMerged())
+    {
+        return m_merged->Fail();
+    }
     return m_file.Fail();
 }
 
@@ -74,6 +100,10 @@ bool
 PcapFileWrapper::Eof() const
 {
     NS_LOG_FUNCTION(this);
+    if (IsMerged())
+    {
+        return false;
+    }
     return m_file.Eof();
 }
 
@@ -88,6 +118,7 @@ void
 PcapFileWrapper::Close()
 {
     NS_LOG_FUNCTION(this);
+    m_merged = nullptr;
     m_file.Close();
 }
 
@@ -95,7 +126,17 @@ void
 PcapFileWrapper::Open(const std::string& filename, std::ios::openmode mode)
 {
     NS_LOG_FUNCTION(this << filename << mode);
+    if ((mode & std::ios::out) && !m_mergedFilename.empty())
+    {
+        m_merged = PcapNgFile::Open(m_mergedFilename, m_batchSize, m_backgroundWrite);
+        m_interfaceName = filename;
+        return;
+    }
     m_file.Open(filename, mode);
+    if (mode & std::ios::out)
+    {
+        m_file.SetBatching(m_batchSize, m_backgroundWrite);
+    }
 }
 
 void
@@ -107,6 +148,15 @@ PcapFileWrapper::Init(uint32_t dataLinkType, uint32_t snapLen, int32_t tzCorrect
     // a snaplen, we use the one provided.
     //
     NS_LOG_FUNCTION(this << dataLinkType << snapLen << tzCorrection);
+    if (IsMerged())
+    {
+        if (snapLen == std::numeric_limits<uint32_t>::max())
+        {
+            snapLen = m_snapLen;
+        }
+        m_interface = m_merged->AddInterface(dataLinkType, snapLen, m_interfaceName);
+        return;
+    }
     if (snapLen != std::numeric_limits<uint32_t>::max())
     {
         m_file.Init(dataLinkType, snapLen, tzCorrection, false, m_nanosecMode);
@@ -121,6 +171,11 @@ void
 PcapFileWrapper::Write(Time t, Ptr<const Packet> p)
 {
     NS_LOG_FUNCTION(this << t << p);
+    if (IsMerged())
+    {
+        m_merged->Write(m_interface, t.GetNanoSeconds(), p);
+        return;
+    }
     if (m_file.IsNanoSecMode())
     {
         uint64_t current = t.GetNanoSeconds();
@@ -141,6 +196,11 @@ void
 PcapFileWrapper::Write(Time t, const Header& header, Ptr<const Packet> p)
 {
     NS_LOG_FUNCTION(this << t << &header << p);
+    if (IsMerged())
+    {
+        m_merged->Write(m_interface, t.GetNanoSeconds(), header, p);
+        return;
+    }
     if (m_file.IsNanoSecMode())
     {
         uint64_t current = t.GetNanoSeconds();
@@ -161,6 +221,11 @@ void
 PcapFileWrapper::Write(Time t, const uint8_t* buffer, uint32_t length)
 {
     NS_LOG_FUNCTION(this << t << &buffer << length);
+    if (IsMerged())
+    {
+        m_merged->Write(m_interface, t.GetNanoSeconds(), buffer, length);
+        return;
+    }
     if (m_file.IsNanoSecMode())
     {
         uint64_t current = t.GetNanoSeconds();
@@ -180,6 +245,7 @@ PcapFileWrapper::Write(Time t, const uint8_t* buffer, uint32_t length)
 Ptr<Packet>
 PcapFileWrapper::Read(Time& t)
 {
+    NS_ABORT_MSG_IF(IsMerged(), "Cannot read from the merged file " << m_mergedFilename);
     uint32_t tsSec;
     uint32_t tsUsec;
     uint32_t inclLen;
@@ -211,6 +277,7 @@ uint32_t
 PcapFileWrapper::GetMagic()
 {
     NS_LOG_FUNCTION(this);
+    NS_ABORT_MSG_IF(IsMerged(), "No pcap header in the merged file " << m_mergedFilename);
     return m_file.GetMagic();
 }
 
@@ -218,6 +285,7 @@ uint16_t
 PcapFileWrapper::GetVersionMajor()
 {
     NS_LOG_FUNCTION(this);
+    NS_ABORT_MSG_IF(IsMerged(), "No pcap header in the merged file " << m_mergedFilename);
     return m_file.GetVersionMajor();
 }
 
@@ -225,6 +293,7 @@ uint16_t
 PcapFileWrapper::GetVersionMinor()
 {
     NS_LOG_FUNCTION(this);
+    NS_ABORT_MSG_IF(IsMerged(), "No pcap header in the merged file " << m_mergedFilename);
     return m_file.GetVersionMinor();
 }
 
@@ -232,6 +301,7 @@ int32_t
 PcapFileWrapper::GetTimeZoneOffset()
 {
     NS_LOG_FUNCTION(this);
+    NS_ABORT_MSG_IF(IsMerged(), "No pcap header in the merged file " << m_mergedFilename);
     return m_file.GetTimeZoneOffset();
 }
 
@@ -239,6 +309,7 @@ uint32_t
 PcapFileWrapper::GetSigFigs()
 {
     NS_LOG_FUNCTION(this);
+    NS_ABORT_MSG_IF(IsMerged(), "No pcap header in the merged file " << m_mergedFilename);
     return m_file.GetSigFigs();
 }
 
@@ -246,6 +317,10 @@ uint32_t
 PcapFileWrapper::GetSnapLen()
 {
     NS_LOG_FUNCTION(this);
+    if (IsMerged())
+    {
+        return m_merged->GetSnapLen(m_interface);
+    }
     return m_file.GetSnapLen();
 }
 
@@ -253,7 +328,17 @@ uint32_t
 PcapFileWrapper::GetDataLinkType()
 {
     NS_LOG_FUNCTION(this);
+    if (IsMerged())
+    {
+        return m_merged->GetDataLinkType(m_interface);
+    }
     return m_file.GetDataLinkType();
 }
 
+bool
+PcapFileWrapper::IsMerged() const
+{
+    return m_merged != nullptr;
+}
+
 } // namespace ns3
@@ -19,6 +19,7 @@
 #define PCAP_FILE_WRAPPER_H
 
 #include "pcap-file.h"
+#include "pcapng-file.h"
 
 #include "ns3/nstime.h"
 #include "ns3/object.h"
@@ -37,6 +38,14 @@ namespace ns3
  * ns-3 interface to the low-level public methods of PcapFile.  Users are
  * encouraged to use this object instead of class ns3::PcapFile in ns-3
  * public APIs.
+ *
+ * The "BatchSize" and "BackgroundWrite" attributes make the files write
+ * their packets in large batches, possibly from a background thread (see
+ * PcapFile::SetBatching).  The "MergedFile" attribute redirects the
+ * packets of all the wrappers opened for writing to a single pcapng file,
+ * with one interface per wrapper, named after the file the wrapper would
+ * otherwise have opened.  A simulation tracing thousands of devices then
+ * keeps a single file open.
  */
 class PcapFileWrapper : public Object
 {
@@ -75,6 +84,9 @@ class PcapFileWrapper : public Object
      *
      * \param mode String containing the access mode for the file.
      *
+     * If the "MergedFile" attribute is set and the file is opened for writing,
+     * no file is opened: the packets are written to the merged pcapng file, as
+     * an interface named \pname{filename}, which is added by #Init.
      */
     void Open(const std::string& filename, std::ios::openmode mode);
 
@@ -222,9 +234,20 @@ class PcapFileWrapper : public Object
     uint32_t GetDataLinkType();
 
   private:
-    PcapFile m_file;    //!< Pcap file
-    uint32_t m_snapLen; //!< max length of saved packets
-    bool m_nanosecMode; //!< Timestamps in nanosecond mode
+    /**
+     * \returns Whether the packets go to the merged pcapng file.
+     */
+    bool IsMerged() const;
+
+    PcapFile m_file;              //!< Pcap file
+    uint32_t m_snapLen;           //!< max length of saved packets
+    bool m_nanosecMode;           //!< Timestamps in nanosecond mode
+    uint32_t m_batchSize;         //!< Size of the batches of packets written at once
+    bool m_backgroundWrite;       //!< Whether a background thread writes the batches
+    std::string m_mergedFilename; //!< Name of the merged pcapng file, if any
+    Ptr<PcapNgFile> m_merged;     //!< Merged pcapng file, once opened
+    std::string m_interfaceName;  //!< Name of the interface in the merged file
+    uint32_t m_interface;         //!< Index of the interface in the merged file
 };
 
 } // namespace ns3
@@ -21,7 +21,6 @@
 
 #include "ns3/assert.h"
 #include "ns3/buffer.h"
-#include "ns3/build-profile.h"
 #include "ns3/fatal-error.h"
 #include "ns3/fatal-impl.h"
 #include "ns3/header.h"
@@ -54,7 +53,8 @@ const uint16_t VERSION_MINOR = 4; /**< Minor version of supported pcap file form
 PcapFile::PcapFile()
     : m_file(),
       m_swapMode(false),
-      m_nanosecMode(false)
+      m_nanosecMode(false),
+      m_writer(m_file)
 {
     NS_LOG_FUNCTION(this);
     FatalImpl::RegisterStream(&m_file);
@@ -71,6 +71,7 @@ bool
 PcapFile::Fail() const
 {
     NS_LOG_FUNCTION(this);
+    m_writer.Wait();
     return m_file.fail();
 }
 
@@ -78,6 +79,7 @@ bool
 PcapFile::Eof() const
 {
     NS_LOG_FUNCTION(this);
+    m_writer.Wait();
     return m_file.eof();
 }
 
@@ -85,6 +87,7 @@ void
 PcapFile::Clear()
 {
     NS_LOG_FUNCTION(this);
+    m_writer.Wait();
     m_file.clear();
 }
 
@@ -92,6 +95,7 @@ void
 PcapFile::Close()
 {
     NS_LOG_FUNCTION(this);
+    m_writer.Flush();
     m_file.close();
 }
 
@@ -355,6 +359,7 @@ PcapFile::Init(uint32_t dataLinkType,
                bool nanosecMode)
 {
     NS_LOG_FUNCTION(this << dataLinkType << snapLen << timeZoneCorrection << swapMode);
+    m_writer.Flush();
 
     //
     // Initialize the magic number and nanosecond mode flag
@@ -409,11 +414,26 @@ PcapFile::Init(uint32_t dataLinkType,
     WriteFileHeader();
 }
 
+void
+PcapFile::SetBatching(uint32_t batchSize, bool background)
+{
+    NS_LOG_FUNCTION(this << batchSize << background);
+    m_writer.SetBatching(batchSize, background);
+}
+
+void
+PcapFile::Flush()
+{
+    NS_LOG_FUNCTION(this);
+    m_writer.Flush();
+    m_file.flush();
+}
+
 uint32_t
 PcapFile::WritePacketHeader(uint32_t tsSec, uint32_t tsUsec, uint32_t totalLen)
 {
     NS_LOG_FUNCTION(this << tsSec << tsUsec << totalLen);
-    NS_ASSERT(m_file.good());
+    NS_ASSERT(m_writer.GetBatchSize() > 0 || m_file.good());
 
     uint32_t inclLen = totalLen > m_fileHeader.m_snapLen ? m_fileHeader.m_snapLen : totalLen;
 
@@ -432,11 +452,10 @@ PcapFile::WritePacketHeader(uint32_t tsSec, uint32_t tsUsec, uint32_t totalLen)
     // Watch out for memory alignment differences between machines, so write
     // them all individually.
     //
-    m_file.write((const char*)&header.m_tsSec, sizeof(header.m_tsSec));
-    m_file.write((const char*)&header.m_tsUsec, sizeof(header.m_tsUsec));
-    m_file.write((const char*)&header.m_inclLen, sizeof(header.m_inclLen));
-    m_file.write((const char*)&header.m_origLen, sizeof(header.m_origLen));
-    NS_BUILD_DEBUG(m_file.flush());
+    m_writer.Write(&header.m_tsSec, sizeof(header.m_tsSec));
+    m_writer.Write(&header.m_tsUsec, sizeof(header.m_tsUsec));
+    m_writer.Write(&header.m_inclLen, sizeof(header.m_inclLen));
+    m_writer.Write(&header.m_origLen, sizeof(header.m_origLen));
     return inclLen;
 }
 
@@ -445,8 +464,8 @@ PcapFile::Write(uint32_t tsSec, uint32_t tsUsec, const uint8_t* const data, uint
 {
     NS_LOG_FUNCTION(this << tsSec << tsUsec << &data << totalLen);
     uint32_t inclLen = WritePacketHeader(tsSec, tsUsec, totalLen);
-    m_file.write((const char*)data, inclLen);
-    NS_BUILD_DEBUG(m_file.flush());
+    m_writer.Write(data, inclLen);
+    m_writer.EndRecord();
 }
 
 void
@@ -454,8 +473,8 @@ PcapFile::Write(uint32_t tsSec, uint32_t tsUsec, Ptr<const Packet> p)
 {
     NS_LOG_FUNCTION(this << tsSec << tsUsec << p);
     uint32_t inclLen = WritePacketHeader(tsSec, tsUsec, p->GetSize());
-    p->CopyData(&m_file, inclLen);
-    NS_BUILD_DEBUG(m_file.flush());
+    m_writer.Write(p, inclLen);
+    m_writer.EndRecord();
 }
 
 void
@@ -470,9 +489,10 @@ PcapFile::Write(uint32_t tsSec, uint32_t tsUsec, const Header& header, Ptr<const
     headerBuffer.AddAtStart(headerSize);
     header.Serialize(headerBuffer.Begin());
     uint32_t toCopy = std::min(headerSize, inclLen);
-    headerBuffer.CopyData(&m_file, toCopy);
+    m_writer.Write(headerBuffer, toCopy);
     inclLen -= toCopy;
-    p->CopyData(&m_file, inclLen);
+    m_writer.Write(p, inclLen);
+    m_writer.EndRecord();
 }
 
 void
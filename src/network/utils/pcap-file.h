@@ -20,6 +20,8 @@
 #ifndef PCAP_FILE_H
 #define PCAP_FILE_H
 
+#include "pcap-writer.h"
+
 #include "ns3/ptr.h"
 
 #include <fstream>
@@ -121,6 +123,24 @@ class PcapFile
               bool swapMode = false,
               bool nanosecMode = false);
 
+    /**
+     * \brief Collect the packets written to the file in batches.
+     *
+     * The batches are written to the file when they are full, and when
+     * the file is flushed or closed.  This turns the small writes of
+     * each packet into large sequential ones.  See PcapWriter.
+     *
+     * \param batchSize The size of the batches, in bytes, or 0 to write
+     * each packet as it comes (the default).
+     * \param background Whether a background thread writes the batches.
+     */
+    void SetBatching(uint32_t batchSize, bool background);
+
+    /**
+     * \brief Write the packets collected in the current batch to the file.
+     */
+    void Flush();
+
     /**
      * \brief Write next packet to file
      *
@@ -378,6 +398,7 @@ class PcapFile
     PcapFileHeader m_fileHeader; //!< file header
     bool m_swapMode;             //!< swap mode
     bool m_nanosecMode;          //!< nanosecond timestamp mode
+    PcapWriter m_writer;         //!< packet records writer
 };
 
 } // namespace ns3
@@ -0,0 +1,307 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "pcap-writer.h"
+
+#include "ns3/buffer.h"
+#include "ns3/build-profile.h"
+#include "ns3/log.h"
+#include "ns3/packet.h"
+
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <thread>
+
+/**
+ * \file
+ * \ingroup network
+ * ns3::PcapWriter implementation.
+ */
+
+namespace ns3
+{
+
+NS_LOG_COMPONENT_DEFINE("PcapWriter");
+
+namespace
+{
+
+/** A batch of records. */
+typedef std::vector<uint8_t> Batch;
+
+/**
+ * \ingroup network
+ * The queue of the batches and the thread writing them.
+ */
+class PcapWriterThread
+{
+  public:
+    /** \returns The instance, started on first use. */
+    static PcapWriterThread& Get();
+
+    /**
+     * Get an empty batch.
+     * \param [in] capacity The capacity to reserve.
+     * \returns The batch.
+     */
+    Batch GetBatch(std::size_t capacity);
+    /**
+     * Queue a batch.
+     * \param [in] stream The stream.
+     * \param [in] batch The batch.
+     */
+    void Submit(std::ostream* stream, Batch& batch);
+    /**
+     * Wait for the batches of a stream.
+     * \param [in] stream The stream.
+     */
+    void Wait(const std::ostream* stream);
+
+  private:
+    PcapWriterThread();
+    /** Main loop of the thread. */
+    void Loop();
+
+    /** A batch waiting to be written. */
+    struct Job
+    {
+        std::ostream* stream; //!< The stream to write to.
+        Batch batch;          //!< The records.
+    };
+
+    /** Maximum number of written batches kept for reuse. */
+    static constexpr std::size_t MAX_FREE = 8;
+
+    std::mutex m_mutex;                                //!< Protects the members below.
+    std::condition_variable m_work;                    //!< Signals a new job.
+    std::condition_variable m_done;                    //!< Signals a written job.
+    std::deque<Job> m_jobs;                            //!< The batches to write.
+    std::map<const std::ostream*, uint32_t> m_pending; //!< Pending batches, by stream.
+    std::vector<Batch> m_free;                         //!< Written batches, for reuse.
+};
+
+PcapWriterThread&
+PcapWriterThread::Get()
+{
+    // Never destroyed, so the streams closed during the static destruction
+    // can still wait for their batches.
+    static PcapWriterThread* writer = new PcapWriterThread();
+    return *writer;
+}
+
+PcapWriterThread::PcapWriterThread()
+{
+    NS_LOG_FUNCTION(this);
+    std::thread(&PcapWriterThread::Loop, this).detach();
+}
+
+Batch
+PcapWriterThread::GetBatch(std::size_t capacity)
+{
+    Batch batch;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (!m_free.empty())
+        {
+            batch.swap(m_free.back());
+            m_free.pop_back();
+        }
+    }
+    batch.reserve(capacity);
+    return batch;
+}
+
+void
+PcapWriterThread::Submit(std::ostream* stream, Batch& batch)
+{
+    NS_LOG_FUNCTION(this << stream << batch.size());
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_jobs.push_back({stream, Batch()});
+        m_jobs.back().batch.swap(batch);
+        m_pending[stream]++;
+    }
+    m_work.notify_one();
+}
+
+void
+PcapWriterThread::Wait(const std::ostream* stream)
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_done.wait(lock, [this, stream]() { return m_pending.count(stream) == 0; });
+}
+
+void
+PcapWriterThread::Loop()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (true)
+    {
+        m_work.wait(lock, [this]() { return !m_jobs.empty(); });
+        Job job = std::move(m_jobs.front());
+        m_jobs.pop_front();
+
+        lock.unlock();
+        job.stream->write(reinterpret_cast<const char*>(job.batch.data()), job.batch.size());
+        job.batch.clear();
+        lock.lock();
+
+        if (m_free.size() < MAX_FREE)
+        {
+            m_free.push_back(std::move(job.batch));
+        }
+        auto it = m_pending.find(job.stream);
+        if (--it->second == 0)
+        {
+            m_pending.erase(it);
+        }
+        m_done.notify_all();
+    }
+}
+
+} // unnamed namespace
+
+PcapWriter::PcapWriter(std::ostream& stream)
+    : m_stream(stream),
+      m_batchSize(0),
+      m_background(false),
+      m_pending(false)
+{
+    NS_LOG_FUNCTION(this << &stream);
+}
+
+PcapWriter::~PcapWriter()
+{
+    NS_LOG_FUNCTION(this);
+    Flush();
+}
+
+void
+PcapWriter::SetBatching(uint32_t batchSize, bool background)
+{
+    NS_LOG_FUNCTION(this << batchSize << background);
+    Flush();
+    m_batchSize = batchSize;
+    m_background = background && batchSize > 0;
+    if (m_background)
+    {
+        m_batch = PcapWriterThread::Get().GetBatch(m_batchSize);
+    }
+    else
+    {
+        m_batch = Batch();
+        m_batch.reserve(m_batchSize);
+    }
+}
+
+uint32_t
+PcapWriter::GetBatchSize() const
+{
+    return m_batchSize;
+}
+
+void
+PcapWriter::Write(const void* data, uint32_t size)
+{
+    if (m_batchSize == 0)
+    {
+        m_stream.write(static_cast<const char*>(data), size);
+        return;
+    }
+    auto bytes = static_cast<const uint8_t*>(data);
+    m_batch.insert(m_batch.end(), bytes, bytes + size);
+}
+
+void
+PcapWriter::Write(const Buffer& buffer, uint32_t size)
+{
+    if (m_batchSize == 0)
+    {
+        buffer.CopyData(&m_stream, size);
+        return;
+    }
+    std::size_t offset = m_batch.size();
+    m_batch.resize(offset + size);
+    buffer.CopyData(m_batch.data() + offset, size);
+}
+
+void
+PcapWriter::Write(Ptr<const Packet> p, uint32_t size)
+{
+    if (m_batchSize == 0)
+    {
+        p->CopyData(&m_stream, size);
+        return;
+    }
+    std::size_t offset = m_batch.size();
+    m_batch.resize(offset + size);
+    p->CopyData(m_batch.data() + offset, size);
+}
+
+void
+PcapWriter::EndRecord()
+{
+    if (m_batchSize == 0)
+    {
+        NS_BUILD_DEBUG(m_stream.flush());
+    }
+    else if (m_batch.size() >= m_batchSize)
+    {
+        WriteBatch();
+    }
+}
+
+void
+PcapWriter::WriteBatch()
+{
+    NS_LOG_FUNCTION(this << m_batch.size());
+    if (m_batch.empty())
+    {
+        return;
+    }
+    if (m_background)
+    {
+        PcapWriterThread::Get().Submit(&m_stream, m_batch);
+        m_batch = PcapWriterThread::Get().GetBatch(m_batchSize);
+        m_pending = true;
+    }
+    else
+    {
+        m_stream.write(reinterpret_cast<const char*>(m_batch.data()), m_batch.size());
+        m_batch.clear();
+    }
+}
+
+void
+PcapWriter::Flush()
+{
+    NS_LOG_FUNCTION(this);
+    WriteBatch();
+    Wait();
+}
+
+void
+PcapWriter::Wait() const
+{
+    if (m_pending)
+    {
+        PcapWriterThread::Get().Wait(&m_stream);
+        m_pending = false;
+    }
+}
+
+} // namespace ns3
@@ -0,0 +1,132 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef PCAP_WRITER_H
+#define PCAP_WRITER_H
+
+#include "ns3/ptr.h"
+
+#include <ostream>
+#include <stdint.h>
+#include <vector>
+
+namespace ns3
+{
+
+class Buffer;
+class Packet;
+
+/**
+ * \ingroup network
+ *
+ * \brief Writes the records of a trace file, optionally in batches.
+ *
+ * By default each record goes straight to the stream.  With batching
+ * enabled, the records are collected in memory and the stream sees
+ * one large write per batch instead of a few small ones per record.
+ * The full batches can also be handed to a background thread shared
+ * by all the writers, so the simulation does not wait for the file
+ * system.
+ *
+ * The batches of a stream are written in the order they were
+ * completed.  The owner of the stream must call #Wait before using
+ * the stream directly, for instance to check its state or to close it.
+ */
+class PcapWriter
+{
+  public:
+    /**
+     * \param [in] stream The stream to write to.
+     */
+    explicit PcapWriter(std::ostream& stream);
+    /**
+     * Flushes the records still in the batch.
+     */
+    ~PcapWriter();
+
+    // Delete copy constructor and assignment operator to avoid misuse
+    PcapWriter(const PcapWriter&) = delete;
+    PcapWriter& operator=(const PcapWriter&) = delete;
+
+    /**
+     * \brief Set how the records are written.
+     *
+     * The records collected so far are flushed first.
+     *
+     * \param [in] batchSize The size of the batches, in bytes, or 0 to
+     *             write each record as it comes.
+     * \param [in] background Whether the batches are written by the
+     *             background thread, rather than by the caller.
+     */
+    void SetBatching(uint32_t batchSize, bool background);
+    /**
+     * \returns The size of the batches, or 0 if batching is disabled.
+     */
+    uint32_t GetBatchSize() const;
+
+    /**
+     * \brief Write raw bytes of the current record.
+     *
+     * \param [in] data The bytes.
+     * \param [in] size The number of bytes.
+     */
+    void Write(const void* data, uint32_t size);
+    /**
+     * \brief Write the start of a buffer as part of the current record.
+     *
+     * \param [in] buffer The buffer.
+     * \param [in] size The number of bytes to write.
+     */
+    void Write(const Buffer& buffer, uint32_t size);
+    /**
+     * \brief Write the start of a packet as part of the current record.
+     *
+     * \param [in] p The packet.
+     * \param [in] size The number of bytes to write.
+     */
+    void Write(Ptr<const Packet> p, uint32_t size);
+    /**
+     * \brief Mark the end of a record.
+     *
+     * A full batch is handed to the stream, or to the background thread.
+     */
+    void EndRecord();
+    /**
+     * \brief Write all the records so far to the stream,
+     * and wait until they are written.
+     */
+    void Flush();
+    /**
+     * \brief Wait until the background thread has written all the
+     * batches handed to it.
+     */
+    void Wait() const;
+
+  private:
+    /**
+     * \brief Hand the batch to the stream, or to the background thread.
+     */
+    void WriteBatch();
+
+    std::ostream& m_stream;       //!< The stream written to
+    std::vector<uint8_t> m_batch; //!< The records not yet written
+    uint32_t m_batchSize;         //!< The size of the batches
+    bool m_background;            //!< Whether the background thread writes the batches
+    mutable bool m_pending;       //!< Whether batches may be pending in the background
+};
+
+} // namespace ns3
+
+#endif /* PCAP_WRITER_H */
@@ -0,0 +1,263 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include "pcapng-file.h"
+
+#include "ns3/assert.h"
+#include "ns3/buffer.h"
+#include "ns3/header.h"
+#include "ns3/log.h"
+#include "ns3/packet.h"
+
+#include <algorithm>
+#include <map>
+
+/**
+ * \file
+ * \ingroup network
+ * ns3::PcapNgFile implementation.
+ */
+
+namespace ns3
+{
+
+NS_LOG_COMPONENT_DEFINE("PcapNgFile");
+
+/** Section Header Block type */
+const uint32_t SECTION_HEADER_BLOCK = 0x0a0d0d0a;
+/** Interface Description Block type */
+const uint32_t INTERFACE_DESCRIPTION_BLOCK = 0x00000001;
+/** Enhanced Packet Block type */
+const uint32_t ENHANCED_PACKET_BLOCK = 0x00000006;
+/** Byte-order magic number of the Section Header Block */
+const uint32_t BYTE_ORDER_MAGIC = 0x1a2b3c4d;
+/** End of the options of a block */
+const uint16_t OPT_ENDOFOPT = 0;
+/** Interface name option */
+const uint16_t IF_NAME = 2;
+/** Interface timestamp resolution option */
+const uint16_t IF_TSRESOL = 9;
+
+/**
+ * \ingroup network
+ * \param [in] len A length, in bytes.
+ * \returns The length rounded up to a multiple of 4 bytes.
+ */
+static uint32_t
+Pad4(uint32_t len)
+{
+    return (len + 3) & ~3U;
+}
+
+/**
+ * \ingroup network
+ * \returns The open pcapng files, by name.
+ */
+static std::map<std::string, PcapNgFile*>&
+GetOpenFiles()
+{
+    static std::map<std::string, PcapNgFile*> files;
+    return files;
+}
+
+Ptr<PcapNgFile>
+PcapNgFile::Open(const std::string& filename, uint32_t batchSize, bool background)
+{
+    NS_LOG_FUNCTION(filename << batchSize << background);
+    auto& files = GetOpenFiles();
+    auto it = files.find(filename);
+    if (it != files.end())
+    {
+        return Ptr<PcapNgFile>(it->second);
+    }
+    Ptr<PcapNgFile> file(new PcapNgFile(filename, batchSize, background), false);
+    files[filename] = PeekPointer(file);
+    return file;
+}
+
+PcapNgFile::PcapNgFile(const std::string& filename, uint32_t batchSize, bool background)
+    : m_filename(filename),
+      m_file(filename, std::ios::out | std::ios::binary),
+      m_writer(m_file)
+{
+    NS_LOG_FUNCTION(this << filename << batchSize << background);
+    m_writer.SetBatching(batchSize, background);
+
+    uint32_t blockLen = 28;
+    uint16_t versionMajor = 1;
+    uint16_t versionMinor = 0;
+    int64_t sectionLen = -1; // not specified
+    m_writer.Write(&SECTION_HEADER_BLOCK, sizeof(SECTION_HEADER_BLOCK));
+    m_writer.Write(&blockLen, sizeof(blockLen));
+    m_writer.Write(&BYTE_ORDER_MAGIC, sizeof(BYTE_ORDER_MAGIC));
+    m_writer.Write(&versionMajor, sizeof(versionMajor));
+    m_writer.Write(&versionMinor, sizeof(versionMinor));
+    m_writer.Write(&sectionLen, sizeof(sectionLen));
+    m_writer.Write(&blockLen, sizeof(blockLen));
+    m_writer.EndRecord();
+}
+
+PcapNgFile::~PcapNgFile()
+{
+    NS_LOG_FUNCTION(this);
+    GetOpenFiles().erase(m_filename);
+    m_writer.Flush();
+    m_file.close();
+}
+
+bool
+PcapNgFile::Fail() const
+{
+    NS_LOG_FUNCTION(this);
+    m_writer.Wait();
+    return m_file.fail();
+}
+
+uint32_t
+PcapNgFile::AddInterface(uint32_t dataLinkType, uint32_t snapLen, const std::string& name)
+{
+    NS_LOG_FUNCTION(this << dataLinkType << snapLen << name);
+#ifdef NS3_MTP
+    std::lock_guard<std::mutex> lock(m_mutex);
+#endif
+    uint16_t linkType = dataLinkType;
+    uint16_t reserved = 0;
+    uint16_t nameLen = std::min<std::size_t>(name.size(), UINT16_MAX);
+    uint16_t resolLen = 1;
+    uint8_t resol = 9; // nanoseconds
+    uint16_t endLen = 0;
+
+    // name option, timestamp resolution option, end of options
+    uint32_t optionsLen = 4 + Pad4(nameLen) + 4 + Pad4(resolLen) + 4;
+    uint32_t blockLen = 20 + optionsLen;
+    m_writer.Write(&INTERFACE_DESCRIPTION_BLOCK, sizeof(INTERFACE_DESCRIPTION_BLOCK));
+    m_writer.Write(&blockLen, sizeof(blockLen));
+    m_writer.Write(&linkType, sizeof(linkType));
+    m_writer.Write(&reserved, sizeof(reserved));
+    m_writer.Write(&snapLen, sizeof(snapLen));
+    m_writer.Write(&IF_NAME, sizeof(IF_NAME));
+    m_writer.Write(&nameLen, sizeof(nameLen));
+    m_writer.Write(name.data(), nameLen);
+    m_writer.Write("\0\0\0", Pad4(nameLen) - nameLen);
+    m_writer.Write(&IF_TSRESOL, sizeof(IF_TSRESOL));
+    m_writer.Write(&resolLen, sizeof(resolLen));
+    m_writer.Write(&resol, sizeof(resol));
+    m_writer.Write("\0\0\0", Pad4(resolLen) - resolLen);
+    m_writer.Write(&OPT_ENDOFOPT, sizeof(OPT_ENDOFOPT));
+    m_writer.Write(&endLen, sizeof(endLen));
+    m_writer.Write(&blockLen, sizeof(blockLen));
+    m_writer.EndRecord();
+
+    m_interfaces.push_back({dataLinkType, snapLen});
+    return m_interfaces.size() - 1;
+}
+
+uint32_t
+PcapNgFile::GetDataLinkType(uint32_t interface) const
+{
+    NS_LOG_FUNCTION(this << interface);
+    return m_interfaces.at(interface).dataLinkType;
+}
+
+uint32_t
+PcapNgFile::GetSnapLen(uint32_t interface) const
+{
+    NS_LOG_FUNCTION(this << interface);
+    return m_interfaces.at(interface).snapLen;
+}
+
+uint32_t
+PcapNgFile::WritePacketBlockHeader(uint32_t interface, uint64_t ts, uint32_t totalLen)
+{
+    NS_ASSERT_MSG(interface < m_interfaces.size(), "Unknown interface " << interface);
+    uint32_t snapLen = m_interfaces[interface].snapLen;
+    uint32_t inclLen = totalLen > snapLen ? snapLen : totalLen;
+    uint32_t blockLen = 32 + Pad4(inclLen);
+    uint32_t tsHigh = ts >> 32;
+    uint32_t tsLow = ts & 0xffffffff;
+    m_writer.Write(&ENHANCED_PACKET_BLOCK, sizeof(ENHANCED_PACKET_BLOCK));
+    m_writer.Write(&blockLen, sizeof(blockLen));
+    m_writer.Write(&interface, sizeof(interface));
+    m_writer.Write(&tsHigh, sizeof(tsHigh));
+    m_writer.Write(&tsLow, sizeof(tsLow));
+    m_writer.Write(&inclLen, sizeof(inclLen));
+    m_writer.Write(&totalLen, sizeof(totalLen));
+    return inclLen;
+}
+
+void
+PcapNgFile::WriteBlockTrailer(uint32_t dataLen, uint32_t blockLen)
+{
+    m_writer.Write("\0\0\0", Pad4(dataLen) - dataLen);
+    m_writer.Write(&blockLen, sizeof(blockLen));
+    m_writer.EndRecord();
+}
+
+void
+PcapNgFile::Write(uint32_t interface, uint64_t ts, const uint8_t* data, uint32_t totalLen)
+{
+    NS_LOG_FUNCTION(this << interface << ts << &data << totalLen);
+#ifdef NS3_MTP
+    std::lock_guard<std::mutex> lock(m_mutex);
+#endif
+    uint32_t inclLen = WritePacketBlockHeader(interface, ts, totalLen);
+    m_writer.Write(data, inclLen);
+    WriteBlockTrailer(inclLen, 32 + Pad4(inclLen));
+}
+
+void
+PcapNgFile::Write(uint32_t interface, uint64_t ts, Ptr<const Packet> p)
+{
+    NS_LOG_FUNCTION(this << interface << ts << p);
+#ifdef NS3_MTP
+    std::lock_guard<std::mutex> lock(m_mutex);
+#endif
+    uint32_t inclLen = WritePacketBlockHeader(interface, ts, p->GetSize());
+    m_writer.Write(p, inclLen);
+    WriteBlockTrailer(inclLen, 32 + Pad4(inclLen));
+}
+
+void
+PcapNgFile::Write(uint32_t interface, uint64_t ts, const Header& header, Ptr<const Packet> p)
+{
+    NS_LOG_FUNCTION(this << interface << ts << &header << p);
+#ifdef NS3_MTP
+    std::lock_guard<std::mutex> lock(m_mutex);
+#endif
+    uint32_t headerSize = header.GetSerializedSize();
+    uint32_t totalSize = headerSize + p->GetSize();
+    uint32_t inclLen = WritePacketBlockHeader(interface, ts, totalSize);
+
+    Buffer headerBuffer;
+    headerBuffer.AddAtStart(headerSize);
+    header.Serialize(headerBuffer.Begin());
+    uint32_t toCopy = std::min(headerSize, inclLen);
+    m_writer.Write(headerBuffer, toCopy);
+    m_writer.Write(p, inclLen - toCopy);
+    WriteBlockTrailer(inclLen, 32 + Pad4(inclLen));
+}
+
+void
+PcapNgFile::Flush()
+{
+    NS_LOG_FUNCTION(this);
+#ifdef NS3_MTP
+    std::lock_guard<std::mutex> lock(m_mutex);
+#endif
+    m_writer.Flush();
+    m_file.flush();
+}
+
+} // namespace ns3
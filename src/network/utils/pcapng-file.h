@@ -0,0 +1,181 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef PCAPNG_FILE_H
+#define PCAPNG_FILE_H
+
+#include "pcap-writer.h"
+
+#include "ns3/ptr.h"
+#include "ns3/simple-ref-count.h"
+
+#include <fstream>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+#ifdef NS3_MTP
+#include <mutex>
+#endif
+
+namespace ns3
+{
+
+class Header;
+class Packet;
+
+/**
+ * \ingroup network
+ *
+ * \brief A pcapng file holding the packets of many interfaces.
+ *
+ * Each source of packets, typically a device which would otherwise
+ * have its own pcap file, registers an interface with #AddInterface
+ * and writes its packets with the interface index.  The file starts
+ * with a Section Header Block, each interface is described by an
+ * Interface Description Block carrying its name, data link type and
+ * snap length, and each packet is an Enhanced Packet Block with a
+ * nanosecond timestamp.  The blocks are written in the byte order of
+ * the host, as allowed by the format.
+ *
+ * The files are shared by name: all the callers of #Open with the same
+ * file name get the same object, and the file is closed when the last
+ * reference to it is dropped.  So a simulation tracing thousands of
+ * devices keeps a single file open.
+ *
+ * See the PCAP Next Generation (pcapng) Capture File Format specification.
+ */
+class PcapNgFile : public SimpleRefCount<PcapNgFile>
+{
+  public:
+    /**
+     * \brief Get the pcapng file of the given name, creating it if needed.
+     *
+     * \param filename The file name.
+     * \param batchSize The size of the batches of blocks written at once,
+     * in bytes, or 0 to write each block as it comes.  Only used when the
+     * file is created.
+     * \param background Whether a background thread writes the batches.
+     * Only used when the file is created.
+     * \returns The file.
+     */
+    static Ptr<PcapNgFile> Open(const std::string& filename, uint32_t batchSize, bool background);
+
+    ~PcapNgFile();
+
+    /**
+     * \return true if the 'fail' bit is set in the underlying stream, false otherwise.
+     */
+    bool Fail() const;
+
+    /**
+     * \brief Add an interface to the file.
+     *
+     * \param dataLinkType A data link type as defined in the pcap library.
+     * \param snapLen The maximum size of the packets written for this interface.
+     * \param name The name of the interface.
+     * \returns The index of the interface.
+     */
+    uint32_t AddInterface(uint32_t dataLinkType, uint32_t snapLen, const std::string& name);
+
+    /**
+     * \param interface The index of an interface.
+     * \returns The data link type of the interface.
+     */
+    uint32_t GetDataLinkType(uint32_t interface) const;
+    /**
+     * \param interface The index of an interface.
+     * \returns The snap length of the interface.
+     */
+    uint32_t GetSnapLen(uint32_t interface) const;
+
+    /**
+     * \brief Write a packet of an interface.
+     *
+     * \param interface   The index of the interface.
+     * \param ts          Packet timestamp, nanoseconds
+     * \param data        Data buffer
+     * \param totalLen    Total packet length
+     */
+    void Write(uint32_t interface, uint64_t ts, const uint8_t* data, uint32_t totalLen);
+    /**
+     * \brief Write a packet of an interface.
+     *
+     * \param interface   The index of the interface.
+     * \param ts          Packet timestamp, nanoseconds
+     * \param p           Packet to write
+     */
+    void Write(uint32_t interface, uint64_t ts, Ptr<const Packet> p);
+    /**
+     * \brief Write a packet of an interface.
+     *
+     * \param interface   The index of the interface.
+     * \param ts          Packet timestamp, nanoseconds
+     * \param header      Header to write, in front of packet
+     * \param p           Packet to write
+     */
+    void Write(uint32_t interface, uint64_t ts, const Header& header, Ptr<const Packet> p);
+
+    /**
+     * \brief Write the blocks collected in the current batch to the file.
+     */
+    void Flush();
+
+  private:
+    /**
+     * \brief Create the file and write its Section Header Block.
+     *
+     * \param filename The file name.
+     * \param batchSize The size of the batches.
+     * \param background Whether a background thread writes the batches.
+     */
+    PcapNgFile(const std::string& filename, uint32_t batchSize, bool background);
+
+    /**
+     * \brief Write the header of an Enhanced Packet Block.
+     *
+     * \param interface The index of the interface.
+     * \param ts The timestamp, nanoseconds.
+     * \param totalLen The total packet length.
+     * \returns the length of the packet data to write.
+     */
+    uint32_t WritePacketBlockHeader(uint32_t interface, uint64_t ts, uint32_t totalLen);
+    /**
+     * \brief Write the padding and the trailer of a block.
+     *
+     * \param dataLen The length of the variable-length data of the block.
+     * \param blockLen The total length of the block.
+     */
+    void WriteBlockTrailer(uint32_t dataLen, uint32_t blockLen);
+
+    /** \brief An interface of the file. */
+    struct Interface
+    {
+        uint32_t dataLinkType; //!< Data link type
+        uint32_t snapLen;      //!< Maximum length of the packets
+    };
+
+    std::string m_filename;              //!< file name
+    std::ofstream m_file;                //!< file stream
+    std::vector<Interface> m_interfaces; //!< interfaces, by index
+    PcapWriter m_writer;                 //!< blocks writer
+#ifdef NS3_MTP
+    std::mutex m_mutex; //!< Serializes the blocks written by different partitions
+#endif
+};
+
+} // namespace ns3
+
+#endif /* PCAPNG_FILE_H */
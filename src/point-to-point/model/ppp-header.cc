@@ -21,6 +21,7 @@
 #include "ns3/assert.h"
 #include "ns3/header.h"
 #include "ns3/log.h"
+#include "ns3/packet.h"
 
 #include <iostream>
 
@@ -105,4 +106,47 @@ PppHeader::GetProtocol()
     return m_protocol;
 }
 
+namespace
+{
+
+/**
+ * \ingroup point-to-point
+ * Parser of the PppHeader, for lazy printing (see Packet::EnableLazyPrinting)
+ */
+class PppHeaderParser
+{
+  public:
+    PppHeaderParser()
+    {
+        Packet::RegisterHeaderParser(PppHeader::GetTypeId(),
+                                     MakeCallback(&PppHeaderParser::GetNextHeader));
+    }
+
+    /**
+     * \param [in] header A PppHeader.
+     * \returns The type of the header following it.
+     */
+    static TypeId GetNextHeader(const Header& header)
+    {
+        PppHeader ppp = static_cast<const PppHeader&>(header);
+        std::string name;
+        switch (ppp.GetProtocol())
+        {
+        case 0x0021: /* IPv4 */
+            name = "ns3::Ipv4Header";
+            break;
+        case 0x0057: /* IPv6 */
+            name = "ns3::Ipv6Header";
+            break;
+        default:
+            return TypeId();
+        }
+        TypeId tid;
+        TypeId::LookupByNameFailSafe(name, &tid);
+        return tid;
+    }
+} g_pppHeaderParser; ///< the parser of PppHeader
+
+} // namespace
+
 } // namespace ns3
@@ -104,6 +104,10 @@ JakesProcess::ConstructOscillators()
     double phi = m_jakes->GetUniformRandomVariable()->GetValue();
     // Theta is common for all oscillators:
     double theta = m_jakes->GetUniformRandomVariable()->GetValue();
+    // Phases of the complex amplitudes, drawn at once:
+    std::vector<double> psis(m_nOscillators);
+    m_jakes->GetUniformRandomVariable()->GetValues(psis.data(), psis.size());
+    m_oscillators.reserve(m_nOscillators);
     for (unsigned int i = 0; i < m_nOscillators; i++)
     {
         unsigned int n = i + 1;
@@ -114,7 +118,7 @@ JakesProcess::ConstructOscillators()
         /// 1b. Initiate rotation speed:
         double omega = m_omegaDopplerMax * std::cos(alpha);
         /// 2. Initiate complex amplitude:
-        double psi = m_jakes->GetUniformRandomVariable()->GetValue();
+        double psi = psis[i];
         std::complex<double> amplitude =
             std::complex<double>(std::cos(psi), std::sin(psi)) * 2.0 / std::sqrt(m_nOscillators);
         /// 3. Construct oscillator:
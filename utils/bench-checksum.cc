@@ -0,0 +1,201 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+// This program measures the cost of the Internet checksum of MTU-sized
+// and jumbo-sized packets, as computed by the TCP and UDP headers over
+// their segment, with and without the vectorized one's complement sum.
+// Sample usage:  ./ns3 run 'bench-checksum --n=1000000'
+
+#include "ns3/buffer.h"
+#include "ns3/command-line.h"
+#include "ns3/ip-checksum.h"
+#include "ns3/system-wall-clock-ms.h"
+
+#include <algorithm>
+#include <iostream>
+#include <limits>
+#include <stdlib.h>
+#include <string>
+
+using namespace ns3;
+
+/** Sum of the checksums, so that they are not optimized away. */
+static uint32_t g_sum = 0;
+
+/** Size of the headers written in front of the zero-filled payloads. */
+static const uint32_t HEADER_SIZE = 40;
+
+/**
+ * Make a buffer whose bytes are all written.
+ * \param [in] size The size of the buffer.
+ * \returns The buffer.
+ */
+static Buffer
+MakeWrittenBuffer(uint32_t size)
+{
+    Buffer buffer;
+    buffer.AddAtStart(size);
+    Buffer::Iterator i = buffer.Begin();
+    for (uint32_t j = 0; j < size; j++)
+    {
+        i.WriteU8(rand());
+    }
+    return buffer;
+}
+
+/**
+ * Make a buffer with written headers in front of a payload which is
+ * still a zero area, as for a packet made by Packet(size).
+ * \param [in] size The size of the buffer.
+ * \returns The buffer.
+ */
+static Buffer
+MakeZeroPayloadBuffer(uint32_t size)
+{
+    uint32_t headerSize = std::min(size, HEADER_SIZE);
+    Buffer buffer(size - headerSize);
+    buffer.AddAtStart(headerSize);
+    Buffer::Iterator i = buffer.Begin();
+    for (uint32_t j = 0; j < headerSize; j++)
+    {
+        i.WriteU8(rand());
+    }
+    return buffer;
+}
+
+/**
+ * Checksum a buffer one word at a time through the iterator, the way
+ * Buffer::Iterator::CalculateIpChecksum used to.
+ * \param [in] buffer The buffer.
+ * \param [in] n The number of checksums.
+ */
+static void
+ChecksumReadU16(const Buffer& buffer, uint32_t n)
+{
+    for (uint32_t k = 0; k < n; k++)
+    {
+        Buffer::Iterator i = buffer.Begin();
+        uint32_t size = i.GetSize();
+        uint32_t sum = 0;
+        for (uint32_t j = 0; j < size / 2; j++)
+        {
+            sum += i.ReadU16();
+        }
+        if (size & 1)
+        {
+            sum += i.ReadU8();
+        }
+        while (sum >> 16)
+        {
+            sum = (sum & 0xffff) + (sum >> 16);
+        }
+        g_sum += static_cast<uint16_t>(~sum);
+    }
+}
+
+/**
+ * Checksum a buffer with the scalar one's complement sum.
+ * \param [in] buffer The buffer, which must have no zero area.
+ * \param [in] n The number of checksums.
+ */
+static void
+ChecksumScalar(const Buffer& buffer, uint32_t n)
+{
+    for (uint32_t k = 0; k < n; k++)
+    {
+        uint16_t sum = OnesComplementSumScalar(buffer.PeekData(), buffer.GetSize());
+        g_sum += static_cast<uint16_t>(~sum);
+    }
+}
+
+/**
+ * Checksum a buffer with Buffer::Iterator::CalculateIpChecksum.
+ * \param [in] buffer The buffer.
+ * \param [in] n The number of checksums.
+ */
+static void
+ChecksumIterator(const Buffer& buffer, uint32_t n)
+{
+    for (uint32_t k = 0; k < n; k++)
+    {
+        Buffer::Iterator i = buffer.Begin();
+        g_sum += i.CalculateIpChecksum(i.GetSize());
+    }
+}
+
+/**
+ * Run a benchmark a few times and print the best time.
+ * \param [in] checksum The benchmark.
+ * \param [in] buffer The buffer to checksum.
+ * \param [in] n The number of checksums.
+ * \param [in] runs The number of runs to take the best time over.
+ * \param [in] name The name of the benchmark.
+ */
+static void
+RunBench(void (*checksum)(const Buffer&, uint32_t),
+         const Buffer& buffer,
+         uint32_t n,
+         uint32_t runs,
+         const std::string& name)
+{
+    uint64_t minDelay = std::numeric_limits<uint64_t>::max();
+    for (uint32_t i = 0; i < runs; i++)
+    {
+        SystemWallClockMs time;
+        time.Start();
+        checksum(buffer, n);
+        minDelay = std::min<uint64_t>(minDelay, time.End());
+    }
+    minDelay = std::max<uint64_t>(minDelay, 1);
+    double bits = 8.0 * buffer.GetSize() * n;
+    std::cout << n * 1000.0 / minDelay << " checksums/s (" << minDelay * 1e6 / n
+              << " ns/checksum, " << bits / minDelay / 1e6 << " Gbit/s, " << minDelay
+              << " ms elapsed)\t" << buffer.GetSize() << " bytes, " << name << std::endl;
+}
+
+int
+main(int argc, char* argv[])
+{
+    uint32_t n = 1000000;
+    uint32_t runs = 3;
+    uint32_t mtu = 1500;
+    uint32_t jumbo = 9000;
+
+    CommandLine cmd(__FILE__);
+    cmd.Usage("Benchmark the Internet checksum of packets");
+    cmd.AddValue("n", "number of checksums", n);
+    cmd.AddValue("runs", "number of runs to take the best time over", runs);
+    cmd.AddValue("mtu", "size of the MTU-sized packets", mtu);
+    cmd.AddValue("jumbo", "size of the jumbo packets", jumbo);
+    cmd.Parse(argc, argv);
+
+    std::cout << "One's complement sum: " << GetOnesComplementSumKernel() << std::endl;
+    for (uint32_t size : {mtu, jumbo})
+    {
+        Buffer written = MakeWrittenBuffer(size);
+        Buffer zeroPayload = MakeZeroPayloadBuffer(size);
+        RunBench(&ChecksumReadU16, written, n, runs, "ReadU16 loop");
+        RunBench(&ChecksumScalar, written, n, runs, "scalar sum");
+        RunBench(&ChecksumIterator, written, n, runs, "CalculateIpChecksum");
+        RunBench(&ChecksumReadU16, zeroPayload, n, runs, "ReadU16 loop, zero-filled payload");
+        RunBench(&ChecksumIterator,
+                 zeroPayload,
+                 n,
+                 runs,
+                 "CalculateIpChecksum, zero-filled payload");
+    }
+
+    return 0;
+}
@@ -0,0 +1,294 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+// This program measures the cost of scheduling and running an event,
+// and of creating, running and releasing an event without the scheduler,
+// with the recycled event objects made by MakeEvent and with event
+// objects taken from the global allocator.
+// Sample usage:  ./ns3 run 'bench-events --n=10000000'
+
+#include "ns3/command-line.h"
+#include "ns3/event-impl.h"
+#include "ns3/make-event.h"
+#include "ns3/simulator.h"
+#include "ns3/system-wall-clock-ms.h"
+
+#include <algorithm>
+#include <iostream>
+#include <limits>
+#include <new>
+#include <string>
+#include <vector>
+
+using namespace ns3;
+
+/** Number of events left to run. */
+static uint64_t g_left = 0;
+/** Sum of the arguments of the events run without the scheduler. */
+static uint64_t g_sum = 0;
+
+/**
+ * An event taken from the global allocator, as all events were before
+ * they were recycled.
+ */
+class HeapEvent : public EventImpl
+{
+  public:
+    /**
+     * Constructor.
+     * \param [in] flow The flow index bound to the event.
+     * \param [in] payload A second bound argument.
+     */
+    HeapEvent(uint32_t flow, uint64_t payload)
+        : m_flow(flow),
+          m_payload(payload)
+    {
+    }
+
+    /**
+     * \param [in] size The size of the event object.
+     * \returns The memory for the event.
+     */
+    static void* operator new(std::size_t size)
+    {
+        return ::operator new(size);
+    }
+
+    /**
+     * \param [in] p The memory of the event.
+     */
+    static void operator delete(void* p)
+    {
+        ::operator delete(p);
+    }
+
+  private:
+    void Notify() override;
+
+    uint32_t m_flow;    //!< The flow index.
+    uint64_t m_payload; //!< The second argument.
+};
+
+/**
+ * Reschedule a flow with a recycled event.
+ * \param [in] flow The flow index.
+ * \param [in] payload A second argument, passed along.
+ */
+static void
+PooledStep(uint32_t flow, uint64_t payload)
+{
+    if (g_left > 0)
+    {
+        g_left--;
+        Simulator::Schedule(NanoSeconds(1 + flow), &PooledStep, flow, payload + 1);
+    }
+}
+
+/**
+ * Reschedule a flow with an event from the global allocator.
+ * \param [in] flow The flow index.
+ * \param [in] payload A second argument, passed along.
+ */
+static void
+HeapStep(uint32_t flow, uint64_t payload)
+{
+    if (g_left > 0)
+    {
+        g_left--;
+        Simulator::Schedule(NanoSeconds(1 + flow),
+                            Ptr<EventImpl>(new HeapEvent(flow, payload + 1), false));
+    }
+}
+
+/**
+ * Event function of the runs without the scheduler.
+ * \param [in] flow The flow index.
+ * \param [in] payload A second argument.
+ */
+static void
+Sum(uint32_t flow, uint64_t payload)
+{
+    g_sum += flow + payload;
+}
+
+void
+HeapEvent::Notify()
+{
+    if (m_payload == 0)
+    {
+        Sum(m_flow, m_payload);
+    }
+    else
+    {
+        HeapStep(m_flow, m_payload);
+    }
+}
+
+/**
+ * Create, run and release recycled events, a few at a time.
+ * \param [in] n The number of events.
+ * \param [in] flows The number of events alive at once.
+ */
+static void
+PooledCreate(uint64_t n, uint32_t flows)
+{
+    std::vector<EventImpl*> events(flows);
+    for (uint64_t i = 0; i < n; i += flows)
+    {
+        for (uint32_t j = 0; j < flows; j++)
+        {
+            events[j] = MakeEvent(&Sum, j, i);
+        }
+        for (EventImpl* ev : events)
+        {
+            ev->Invoke();
+            ev->Unref();
+        }
+    }
+}
+
+/**
+ * Create, run and release events from the global allocator, a few at a time.
+ * \param [in] n The number of events.
+ * \param [in] flows The number of events alive at once.
+ */
+static void
+HeapCreate(uint64_t n, uint32_t flows)
+{
+    std::vector<EventImpl*> events(flows);
+    for (uint64_t i = 0; i < n; i += flows)
+    {
+        for (uint32_t j = 0; j < flows; j++)
+        {
+            events[j] = new HeapEvent(j, 0);
+        }
+        for (EventImpl* ev : events)
+        {
+            ev->Invoke();
+            ev->Unref();
+        }
+    }
+}
+
+/**
+ * Run a number of events spread over flows that reschedule themselves.
+ * \param [in] step The event function.
+ * \param [in] n The number of events.
+ * \param [in] flows The number of flows, hence of pending events.
+ * \returns The elapsed time in ms.
+ */
+static uint64_t
+RunOnce(void (*step)(uint32_t, uint64_t), uint64_t n, uint32_t flows)
+{
+    SystemWallClockMs time;
+    time.Start();
+    g_left = n;
+    for (uint32_t i = 0; i < flows; i++)
+    {
+        step(i, 1);
+    }
+    Simulator::Run();
+    uint64_t deltaMs = time.End();
+    Simulator::Destroy();
+    return deltaMs;
+}
+
+/**
+ * Create, run and release a number of events without the scheduler.
+ * \param [in] create The benchmark function.
+ * \param [in] n The number of events.
+ * \param [in] flows The number of events alive at once.
+ * \returns The elapsed time in ms.
+ */
+static uint64_t
+CreateOnce(void (*create)(uint64_t, uint32_t), uint64_t n, uint32_t flows)
+{
+    SystemWallClockMs time;
+    time.Start();
+    create(n, flows);
+    return time.End();
+}
+
+/**
+ * Print the rate of a benchmark.
+ * \param [in] n The number of events.
+ * \param [in] minDelay The best time, in ms.
+ * \param [in] name The benchmark name.
+ */
+static void
+Report(uint64_t n, uint64_t minDelay, const std::string& name)
+{
+    minDelay = std::max<uint64_t>(minDelay, 1);
+    std::cout << n * 1000.0 / minDelay << " events/s (" << minDelay * 1e6 / n << " ns/event, "
+              << minDelay << " ms elapsed)\t" << name << std::endl;
+}
+
+/**
+ * Run the benchmarks of one kind of event several times and print the
+ * best times.
+ * \param [in] step The event function rescheduling a flow.
+ * \param [in] create The benchmark function without the scheduler.
+ * \param [in] n The number of events.
+ * \param [in] flows The number of flows.
+ * \param [in] runs The number of runs.
+ * \param [in] name The name of the kind of event.
+ */
+static void
+RunBench(void (*step)(uint32_t, uint64_t),
+         void (*create)(uint64_t, uint32_t),
+         uint64_t n,
+         uint32_t flows,
+         uint32_t runs,
+         const std::string& name)
+{
+    uint64_t minDelay = std::numeric_limits<uint64_t>::max();
+    for (uint32_t i = 0; i < runs; i++)
+    {
+        minDelay = std::min(minDelay, RunOnce(step, n, flows));
+    }
+    Report(n, minDelay, "schedule and run, " + name);
+
+    minDelay = std::numeric_limits<uint64_t>::max();
+    for (uint32_t i = 0; i < runs; i++)
+    {
+        minDelay = std::min(minDelay, CreateOnce(create, n, flows));
+    }
+    Report(n, minDelay, "create, run and release, " + name);
+}
+
+int
+main(int argc, char* argv[])
+{
+    uint64_t n = 1000000;
+    uint32_t flows = 64;
+    uint32_t runs = 3;
+
+    CommandLine cmd(__FILE__);
+    cmd.Usage("Benchmark the cost of scheduling and running an event");
+    cmd.AddValue("n", "number of events", n);
+    cmd.AddValue("flows", "number of flows rescheduling themselves", flows);
+    cmd.AddValue("runs", "number of runs to take the best time over", runs);
+    cmd.Parse(argc, argv);
+    flows = std::max<uint32_t>(flows, 1);
+
+#ifdef EVENT_IMPL_FREE_LIST
+    RunBench(&PooledStep, &PooledCreate, n, flows, runs, "MakeEvent, recycled");
+#else
+    RunBench(&PooledStep, &PooledCreate, n, flows, runs, "MakeEvent");
+#endif
+    RunBench(&HeapStep, &HeapCreate, n, flows, runs, "global allocator");
+
+    return 0;
+}
@@ -22,6 +22,7 @@
 // Sample usage:  ./ns3 run 'bench-packets --n=10000'
 
 #include "ns3/command-line.h"
+#include "ns3/packet-allocator.h"
 #include "ns3/packet-metadata.h"
 #include "ns3/packet.h"
 #include "ns3/system-wall-clock-ms.h"
@@ -382,6 +383,7 @@ main(int argc, char* argv[])
     uint32_t n = 0;
     uint32_t minIterations = 1;
     bool enablePrinting = false;
+    bool allocatorStats = false;
 
     CommandLine cmd(__FILE__);
     cmd.Usage("Benchmark Packet class");
@@ -390,6 +392,7 @@ main(int argc, char* argv[])
                  "number of subiterations to minimize iteration time over",
                  minIterations);
     cmd.AddValue("enable-printing", "enable packet printing", enablePrinting);
+    cmd.AddValue("allocator-stats", "print the packet allocator statistics", allocatorStats);
     cmd.Parse(argc, argv);
 
     if (n == 0)
@@ -408,5 +411,10 @@ main(int argc, char* argv[])
     runBench(&benchFragment, n, minIterations, "Fragmentation and concatenation");
     runBench(&benchByteTags, n, minIterations, "Benchmark byte tags");
 
+    if (allocatorStats)
+    {
+        PacketAllocator::PrintStats(std::cout);
+    }
+
     return 0;
 }
@@ -385,23 +385,75 @@ BenchSuite::Log() const
 
 } // BenchSuite::Log()
 
+/**
+ *  Create a trace of next event delays mimicking a network simulation.
+ *
+ *  Most events are PHY and link events a few microseconds apart, on slot
+ *  boundaries so that many share a timestamp; some are packet
+ *  serializations; the rest are protocol timers of a fixed length, such
+ *  as retransmission timeouts and delayed acks, which pile up far in the
+ *  future.
+ *
+ *  \param [in] size The number of delays in the trace.
+ *  \returns The delays, in ns.
+ */
+std::vector<double>
+GetBurstyTrace(uint64_t size)
+{
+    auto uniform = CreateObject<UniformRandomVariable>();
+    auto serialization = CreateObject<ExponentialRandomVariable>();
+    serialization->SetAttribute("Mean", DoubleValue(1200));
+    const double timers[] = {40e6, 200e6, 1e9};
+
+    std::vector<double> nsValues;
+    nsValues.reserve(size);
+    for (uint64_t i = 0; i < size; i++)
+    {
+        double kind = uniform->GetValue();
+        if (kind < 0.6)
+        {
+            // slot-aligned PHY events: 9 us slots after a 16 us SIFS
+            nsValues.push_back(16000 + 9000 * uniform->GetInteger(0, 15));
+        }
+        else if (kind < 0.85)
+        {
+            nsValues.push_back(std::round(serialization->GetValue()));
+        }
+        else
+        {
+            nsValues.push_back(timers[uniform->GetInteger(0, 2)]);
+        }
+    }
+    return nsValues;
+}
+
 /**
  *  Create a RandomVariableStream to generate next event delays.
  *
  *  If the \p filename parameter is empty a default exponential time
- *  distribution will be used, with mean delay of 100 ns.
+ *  distribution will be used, with mean delay of 100 ns, unless
+ *  \p bursty is set.
  *
  *  If the \p filename is `-` standard input will be used.
  *
  *  \param [in] filename The delay interval source file name.
+ *  \param [in] bursty Whether to use the GetBurstyTrace() delays.
  *  \returns The RandomVariableStream.
  */
 Ptr<RandomVariableStream>
-GetRandomStream(std::string filename)
+GetRandomStream(std::string filename, bool bursty)
 {
     Ptr<RandomVariableStream> stream = nullptr;
 
-    if (filename == "")
+    if (filename == "" && bursty)
+    {
+        LOG("  Event time distribution:      bursty network trace");
+        std::vector<double> nsValues = GetBurstyTrace(1000000);
+        auto drv = CreateObject<DeterministicRandomVariable>();
+        drv->SetValueArray(&nsValues[0], nsValues.size());
+        stream = drv;
+    }
+    else if (filename == "")
     {
         LOG("  Event time distribution:      default exponential");
         auto erv = CreateObject<ExponentialRandomVariable>();
@@ -458,18 +510,21 @@ main(int argc, char* argv[])
     bool schedList = false;
     bool schedMap = false; // default scheduler
     bool schedPQ = false;
+    bool schedLadder = false;
 
     uint64_t pop = 100000;
     uint64_t total = 1000000;
     uint64_t runs = 1;
     std::string filename = "";
     bool calRev = false;
+    bool bursty = false;
 
     CommandLine cmd(__FILE__);
     cmd.Usage("Benchmark the simulator scheduler.\n"
               "\n"
               "Event intervals are taken from one of:\n"
               "  an exponential distribution, with mean 100 ns,\n"
+              "  a built-in trace of bursty network events, by the --bursty argument,\n"
               "  an ascii file, given by the --file=\"<filename>\" argument,\n"
               "  or standard input, by the argument --file=\"-\"\n"
               "In the case of either --file form, the input is expected\n"
@@ -480,6 +535,7 @@ main(int argc, char* argv[])
     cmd.AddValue("cal", "use CalendarSheduler", schedCal);
     cmd.AddValue("calrev", "reverse ordering in the CalendarScheduler", calRev);
     cmd.AddValue("heap", "use HeapScheduler", schedHeap);
+    cmd.AddValue("ladder", "use LadderScheduler", schedLadder);
     cmd.AddValue("list", "use ListSheduler", schedList);
     cmd.AddValue("map", "use MapScheduler (default)", schedMap);
     cmd.AddValue("pri", "use PriorityQueue", schedPQ);
@@ -488,6 +544,7 @@ main(int argc, char* argv[])
     cmd.AddValue("total", "total number of events to run", total);
     cmd.AddValue("runs", "number of runs", runs);
     cmd.AddValue("file", "file of relative event times", filename);
+    cmd.AddValue("bursty", "use the built-in bursty network trace", bursty);
     cmd.AddValue("prec", "printed output precision", g_fwidth);
     cmd.Parse(argc, argv);
 
@@ -503,15 +560,15 @@ main(int argc, char* argv[])
 
     if (allSched)
     {
-        schedCal = schedHeap = schedList = schedMap = schedPQ = true;
+        schedCal = schedHeap = schedList = schedMap = schedPQ = schedLadder = true;
     }
     // Set the default case if nothing else is set
-    if (!(schedCal || schedHeap || schedList || schedMap || schedPQ))
+    if (!(schedCal || schedHeap || schedList || schedMap || schedPQ || schedLadder))
     {
         schedMap = true;
     }
 
-    auto eventStream = GetRandomStream(filename);
+    auto eventStream = GetRandomStream(filename, bursty);
 
     ObjectFactory factory("ns3::MapScheduler");
     if (schedCal)
@@ -551,6 +608,11 @@ main(int argc, char* argv[])
         factory.SetTypeId("ns3::PriorityQueueScheduler");
         BenchSuite(factory, pop, total, runs, eventStream, calRev).Log();
     }
+    if (schedLadder)
+    {
+        factory.SetTypeId("ns3::LadderScheduler");
+        BenchSuite(factory, pop, total, runs, eventStream, calRev).Log();
+    }
 
     return 0;
 }
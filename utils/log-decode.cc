@@ -0,0 +1,209 @@
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+// This program prints a binary log file, written with NS_LOG_BINARY or
+// LogSetBinaryFile(), in the text format of the log messages on std::clog.
+// Sample usage:
+//   ./ns3 run 'log-decode --file=run.log --component=Ipv4L3Protocol --level=warn|debug'
+
+#include "ns3/command-line.h"
+#include "ns3/log.h"
+#include "ns3/nstime.h"
+#include "ns3/simulator.h"
+
+#include <cstdlib>
+#include <iostream>
+#include <limits>
+#include <set>
+#include <string>
+
+using namespace ns3;
+
+/**
+ * Split a list of names separated by ':'.
+ * \param [in] list The list.
+ * \return The names.
+ */
+static std::set<std::string>
+Split(const std::string& list)
+{
+    std::set<std::string> names;
+    std::string::size_type cur = 0;
+    while (cur <= list.size())
+    {
+        std::string::size_type next = list.find(':', cur);
+        if (next == std::string::npos)
+        {
+            next = list.size();
+        }
+        if (next > cur)
+        {
+            names.insert(list.substr(cur, next - cur));
+        }
+        cur = next + 1;
+    }
+    return names;
+}
+
+/**
+ * Parse a list of log levels separated by '|', as in NS_LOG.
+ * \param [in] list The list.
+ * \return The log levels.
+ */
+static uint32_t
+ParseLevels(const std::string& list)
+{
+    uint32_t levels = 0;
+    std::string::size_type cur = 0;
+    while (cur <= list.size())
+    {
+        std::string::size_type next = list.find('|', cur);
+        if (next == std::string::npos)
+        {
+            next = list.size();
+        }
+        std::string level = list.substr(cur, next - cur);
+        cur = next + 1;
+        if (level.empty())
+        {
+            continue;
+        }
+        else if (level == "error")
+        {
+            levels |= LOG_ERROR;
+        }
+        else if (level == "warn")
+        {
+            levels |= LOG_WARN;
+        }
+        else if (level == "debug")
+        {
+            levels |= LOG_DEBUG;
+        }
+        else if (level == "info")
+        {
+            levels |= LOG_INFO;
+        }
+        else if (level == "function" || level == "func")
+        {
+            levels |= LOG_FUNCTION;
+        }
+        else if (level == "logic")
+        {
+            levels |= LOG_LOGIC;
+        }
+        else if (level == "all" || level == "level_all")
+        {
+            levels |= LOG_LEVEL_ALL;
+        }
+        else if (level == "level_error")
+        {
+            levels |= LOG_LEVEL_ERROR;
+        }
+        else if (level == "level_warn")
+        {
+            levels |= LOG_LEVEL_WARN;
+        }
+        else if (level == "level_debug")
+        {
+            levels |= LOG_LEVEL_DEBUG;
+        }
+        else if (level == "level_info")
+        {
+            levels |= LOG_LEVEL_INFO;
+        }
+        else if (level == "level_function")
+        {
+            levels |= LOG_LEVEL_FUNCTION;
+        }
+        else if (level == "level_logic")
+        {
+            levels |= LOG_LEVEL_LOGIC;
+        }
+        else
+        {
+            std::cerr << "Unknown log level \"" << level << "\"" << std::endl;
+            std::exit(1);
+        }
+    }
+    return levels;
+}
+
+int
+main(int argc, char* argv[])
+{
+    std::string file;
+    std::string components;
+    std::string levels = "all";
+    std::string node;
+    double start = 0;
+    double stop = std::numeric_limits<double>::infinity();
+
+    CommandLine cmd(__FILE__);
+    cmd.Usage("Print a binary log file written with NS_LOG_BINARY as text.");
+    cmd.AddValue("file", "binary log file", file);
+    cmd.AddValue("component", "only these log components, separated by ':'", components);
+    cmd.AddValue("level", "only these log levels, separated by '|', as in NS_LOG", levels);
+    cmd.AddValue("node", "only this context, -1 for none", node);
+    cmd.AddValue("start", "only from this simulation time, in seconds", start);
+    cmd.AddValue("stop", "only before this simulation time, in seconds", stop);
+    cmd.Parse(argc, argv);
+
+    LogBinaryReader reader;
+    if (file.empty() || !reader.Open(file))
+    {
+        std::cerr << "Cannot read the binary log file \"" << file << "\"" << std::endl;
+        return 1;
+    }
+    std::set<std::string> componentSet = Split(components);
+    uint32_t levelMask = ParseLevels(levels);
+    uint32_t context = Simulator::NO_CONTEXT;
+    if (!node.empty() && node != "-1")
+    {
+        context = std::stoul(node);
+    }
+
+    LogBinaryReader::Message message;
+    while (reader.Read(message))
+    {
+        if (!componentSet.empty() && componentSet.count(message.component) == 0)
+        {
+            continue;
+        }
+        if ((message.level & levelMask & ~LOG_PREFIX_ALL) == 0)
+        {
+            continue;
+        }
+        if (!node.empty() && message.context != context)
+        {
+            continue;
+        }
+        if (message.flags & LogRecord::HAS_TIME)
+        {
+            auto resolution = static_cast<Time::Unit>(message.resolution);
+            if (Time::GetResolution() != resolution)
+            {
+                Time::SetResolution(resolution);
+            }
+            double seconds = TimeStep(message.time).GetSeconds();
+            if (seconds < start || seconds >= stop)
+            {
+                continue;
+            }
+        }
+        std::cout << LogBinaryReader::Format(message) << "\n";
+    }
+    return 0;
+}